@@ -40,6 +40,7 @@
 #define X_RecordEnableContext   5     /* Enable interception and reporting */
 #define X_RecordDisableContext  6     /* Disable interception and reporting */
 #define X_RecordFreeContext     7     /* Free client RC */
+#define X_RecordEnableContextShm 8    /* Enable, reporting into MIT-SHM */
 
 #define sz_XRecordRange		32
 #define sz_XRecordClientInfo 	12
@@ -299,6 +300,46 @@ typedef struct
 } xRecordFreeContextReq;
 #define sz_xRecordFreeContextReq 	8
 
+/*
+ * Enable data interception, reporting into a shared memory ring
+ *
+ * The segment holds an xRecordShmRing at offset followed by size - 32
+ * bytes of ring data.  The server appends the same replies
+ * EnableContext would send, whole replies only, and advances head past
+ * each; the client consumes them and advances tail.  Both count bytes
+ * modulo 2^32, the data position of a count is count % (size - 32).
+ * So that positions stay continuous when the counts wrap, size - 32
+ * must be a power of two of at least 32 bytes, other sizes are a
+ * BadValue error.
+ * Replies that do not fit are dropped and counted in lost and
+ * lostBytes instead of waiting for the client.  The ring header is in
+ * the server's byte order.
+ */
+typedef struct
+{
+    CARD8     	reqType;
+    CARD8     	recordReqType;
+    CARD16    	length;
+    RECORD_RC	context;
+    CARD32	shmseg;
+    CARD32	offset;
+    CARD32	size;
+} xRecordEnableContextShmReq;
+#define sz_xRecordEnableContextShmReq 	20
+
+typedef struct
+{
+    CARD32	head;		/* bytes written, set by the server */
+    CARD32	tail;		/* bytes consumed, set by the client */
+    CARD32	sequence;	/* replies written */
+    CARD32	lost;		/* replies dropped */
+    CARD32	lostBytes;	/* bytes in the dropped replies */
+    CARD32	pad1;
+    CARD32	pad2;
+    CARD32	pad3;
+} xRecordShmRing;
+#define sz_xRecordShmRing 	32
+
 #undef RECORD_RC
 #undef RECORD_XIDBASE
 #undef RECORD_ELEMENT_HEADER
@@ -552,9 +552,18 @@
 /* Have posix_fallocate() */
 #undef HAVE_POSIX_FALLOCATE
 
+/* Have posix_spawn() */
+#undef HAVE_POSIX_SPAWN
+
 /* Use input thread */
 #undef INPUTTHREAD
 
+/* Run large fb fills and composites on worker threads */
+#define FB_THREADS 1
+
+/* Support -dispatchthreads, experimental and not built by default */
+#undef DISPATCH_THREADS
+
 /* Have poll() */
 #undef HAVE_POLL
 
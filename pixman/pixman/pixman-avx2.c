@@ -0,0 +1,1099 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* 256-bit versions of the most used SSE2 paths.  The arithmetic is the
+ * same as in pixman-sse2.c, eight pixels at a time instead of four, so
+ * the results are bit for bit identical.  Everything not handled here
+ * falls through to the SSE2 implementation.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <pixman-config.h>
+#endif
+
+#include <immintrin.h>
+#include "pixman-private.h"
+#include "pixman-combine32.h"
+#include "pixman-inlines.h"
+
+static force_inline __m256i
+load_256_unaligned (const void *src)
+{
+    return _mm256_loadu_si256 ((const __m256i *)src);
+}
+
+static force_inline __m256i
+load_256_aligned (const void *src)
+{
+    return _mm256_load_si256 ((const __m256i *)src);
+}
+
+static force_inline void
+save_256_aligned (void *dst, __m256i data)
+{
+    _mm256_store_si256 ((__m256i *)dst, data);
+}
+
+/* Spans are walked eight, four or one pixel at a time, the way the SSE2
+ * code walks them four or one at a time: single pixels until dst is
+ * 16-byte aligned, then four more if that doesn't make it 32-byte
+ * aligned.  With fewer than eight pixels only the low lanes of a
+ * register are defined, and only those are tested and stored.
+ */
+static force_inline __m256i
+load_pixels (const uint32_t *src, int n)
+{
+    if (n == 8)
+	return load_256_unaligned (src);
+    else if (n == 4)
+	return _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *)src));
+    else
+	return _mm256_castsi128_si256 (_mm_cvtsi32_si128 (*src));
+}
+
+static force_inline __m256i
+load_pixels_aligned (const uint32_t *src, int n)
+{
+    if (n == 8)
+	return load_256_aligned (src);
+    else if (n == 4)
+	return _mm256_castsi128_si256 (_mm_load_si128 ((const __m128i *)src));
+    else
+	return _mm256_castsi128_si256 (_mm_cvtsi32_si128 (*src));
+}
+
+static force_inline void
+save_pixels_aligned (uint32_t *dst, __m256i data, int n)
+{
+    if (n == 8)
+	save_256_aligned (dst, data);
+    else if (n == 4)
+	_mm_store_si128 ((__m128i *)dst, _mm256_castsi256_si128 (data));
+    else
+	*dst = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (data));
+}
+
+/* Up to eight a8 mask values, each in the low byte of a 32-bit lane */
+static force_inline uint64_t
+load_mask_8 (const uint8_t *mask, int n)
+{
+    uint64_t m = 0;
+
+    memcpy (&m, mask, n);
+
+    return m;
+}
+
+static force_inline __m256i
+expand_mask_8 (uint64_t m)
+{
+    return _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *)&m));
+}
+
+static force_inline uint32_t
+lane_bits (int n)
+{
+    return n == 8 ? 0xffffffff : n == 4 ? 0xffff : 0xf;
+}
+
+static force_inline void
+unpack_256_2x256 (__m256i data, __m256i *data_lo, __m256i *data_hi)
+{
+    *data_lo = _mm256_unpacklo_epi8 (data, _mm256_setzero_si256 ());
+    *data_hi = _mm256_unpackhi_epi8 (data, _mm256_setzero_si256 ());
+}
+
+static force_inline __m256i
+pack_2x256_256 (__m256i lo, __m256i hi)
+{
+    return _mm256_packus_epi16 (lo, hi);
+}
+
+static force_inline int
+is_opaque_256 (__m256i x, int n)
+{
+    __m256i ffs = _mm256_cmpeq_epi8 (x, x);
+    uint32_t alpha = 0x88888888 & lane_bits (n);
+
+    return ((uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (x, ffs)) &
+	    alpha) == alpha;
+}
+
+static force_inline int
+is_zero_256 (__m256i x, int n)
+{
+    uint32_t lanes = lane_bits (n);
+
+    if (n == 8)
+	return _mm256_testz_si256 (x, x);
+
+    return ((uint32_t)_mm256_movemask_epi8 (
+		_mm256_cmpeq_epi8 (x, _mm256_setzero_si256 ())) & lanes) == lanes;
+}
+
+static force_inline int
+is_transparent_256 (__m256i x, int n)
+{
+    uint32_t alpha = 0x88888888 & lane_bits (n);
+
+    return ((uint32_t)_mm256_movemask_epi8 (
+		_mm256_cmpeq_epi8 (x, _mm256_setzero_si256 ())) & alpha) == alpha;
+}
+
+static force_inline __m256i
+expand_alpha_1x256 (__m256i data)
+{
+    return _mm256_shufflehi_epi16 (
+	_mm256_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3)),
+	_MM_SHUFFLE (3, 3, 3, 3));
+}
+
+static force_inline __m256i
+expand_alpha_rev_1x256 (__m256i data)
+{
+    return _mm256_shufflehi_epi16 (
+	_mm256_shufflelo_epi16 (data, _MM_SHUFFLE (0, 0, 0, 0)),
+	_MM_SHUFFLE (0, 0, 0, 0));
+}
+
+/* A solid pixel unpacked to 16 bits per channel, in every position */
+static force_inline __m256i
+expand_pixel_32_1x256 (uint32_t data)
+{
+    return _mm256_unpacklo_epi8 (_mm256_set1_epi32 (data),
+				 _mm256_setzero_si256 ());
+}
+
+static force_inline __m256i
+pix_multiply_1x256 (__m256i data, __m256i alpha)
+{
+    return _mm256_mulhi_epu16 (
+	_mm256_adds_epu16 (_mm256_mullo_epi16 (data, alpha),
+			   _mm256_set1_epi16 (0x0080)),
+	_mm256_set1_epi16 (0x0101));
+}
+
+static force_inline __m256i
+over_1x256 (__m256i src, __m256i alpha, __m256i dst)
+{
+    __m256i ialpha = _mm256_xor_si256 (alpha, _mm256_set1_epi16 (0x00ff));
+
+    return _mm256_adds_epu8 (src, pix_multiply_1x256 (dst, ialpha));
+}
+
+static force_inline __m256i
+in_over_1x256 (__m256i src, __m256i alpha, __m256i mask, __m256i dst)
+{
+    return over_1x256 (pix_multiply_1x256 (src, mask),
+		       pix_multiply_1x256 (alpha, mask),
+		       dst);
+}
+
+/* OVER of eight premultiplied pixels */
+static force_inline __m256i
+over_8_pixels (__m256i src, __m256i dst)
+{
+    __m256i src_lo, src_hi, dst_lo, dst_hi;
+
+    unpack_256_2x256 (src, &src_lo, &src_hi);
+    unpack_256_2x256 (dst, &dst_lo, &dst_hi);
+
+    dst_lo = over_1x256 (src_lo, expand_alpha_1x256 (src_lo), dst_lo);
+    dst_hi = over_1x256 (src_hi, expand_alpha_1x256 (src_hi), dst_hi);
+
+    return pack_2x256_256 (dst_lo, dst_hi);
+}
+
+/* Eight pixels multiplied by the alpha of eight mask pixels */
+static force_inline __m256i
+in_8_pixels (__m256i src, __m256i mask)
+{
+    __m256i src_lo, src_hi, mask_lo, mask_hi;
+
+    unpack_256_2x256 (src, &src_lo, &src_hi);
+    unpack_256_2x256 (mask, &mask_lo, &mask_hi);
+
+    src_lo = pix_multiply_1x256 (src_lo, expand_alpha_1x256 (mask_lo));
+    src_hi = pix_multiply_1x256 (src_hi, expand_alpha_1x256 (mask_hi));
+
+    return pack_2x256_256 (src_lo, src_hi);
+}
+
+static force_inline void
+core_combine_over_u_avx2_n (uint32_t *       pd,
+			    const uint32_t * ps,
+			    const uint32_t * pm,
+			    int              n)
+{
+    __m256i src;
+
+    if (pm)
+    {
+	__m256i mask = load_pixels (pm, n);
+
+	if (is_zero_256 (mask, n))
+	    return;
+
+	src = load_pixels (ps, n);
+
+	if (is_opaque_256 (_mm256_and_si256 (src, mask), n))
+	{
+	    save_pixels_aligned (pd, src, n);
+	    return;
+	}
+
+	src = in_8_pixels (src, mask);
+    }
+    else
+    {
+	src = load_pixels (ps, n);
+
+	if (is_zero_256 (src, n))
+	    return;
+
+	if (is_opaque_256 (src, n))
+	{
+	    save_pixels_aligned (pd, src, n);
+	    return;
+	}
+    }
+
+    save_pixels_aligned (
+	pd, over_8_pixels (src, load_pixels_aligned (pd, n)), n);
+}
+
+static force_inline void
+core_combine_over_u_avx2 (uint32_t *       pd,
+			  const uint32_t * ps,
+			  const uint32_t * pm,
+			  int              w)
+{
+#define COMBINE(n)							\
+    do {								\
+	core_combine_over_u_avx2_n (pd, ps, pm, n);			\
+	pd += n;							\
+	ps += n;							\
+	if (pm)								\
+	    pm += n;							\
+	w -= n;								\
+    } while (0)
+
+    /* Align dst on a 32-byte boundary */
+    while (w && ((uintptr_t)pd & 15))
+	COMBINE (1);
+    if (w >= 4 && ((uintptr_t)pd & 31))
+	COMBINE (4);
+
+    while (w >= 8)
+	COMBINE (8);
+
+    if (w >= 4)
+	COMBINE (4);
+    while (w)
+	COMBINE (1);
+
+#undef COMBINE
+}
+
+static void
+avx2_combine_over_u (pixman_implementation_t *imp,
+		     pixman_op_t              op,
+		     uint32_t *               pd,
+		     const uint32_t *         ps,
+		     const uint32_t *         pm,
+		     int                      w)
+{
+    if (pm)
+	core_combine_over_u_avx2 (pd, ps, pm, w);
+    else
+	core_combine_over_u_avx2 (pd, ps, NULL, w);
+}
+
+static force_inline void
+core_combine_add_u_avx2_n (uint32_t *       pd,
+			   const uint32_t * ps,
+			   const uint32_t * pm,
+			   int              n)
+{
+    __m256i s = load_pixels (ps, n);
+
+    if (pm)
+    {
+	__m256i m = load_pixels (pm, n);
+
+	if (is_transparent_256 (m, n))
+	    return;
+
+	s = in_8_pixels (s, m);
+    }
+
+    save_pixels_aligned (
+	pd, _mm256_adds_epu8 (s, load_pixels_aligned (pd, n)), n);
+}
+
+static force_inline void
+core_combine_add_u_avx2 (uint32_t *       pd,
+			 const uint32_t * ps,
+			 const uint32_t * pm,
+			 int              w)
+{
+#define COMBINE(n)							\
+    do {								\
+	core_combine_add_u_avx2_n (pd, ps, pm, n);			\
+	pd += n;							\
+	ps += n;							\
+	if (pm)								\
+	    pm += n;							\
+	w -= n;								\
+    } while (0)
+
+    while (w && ((uintptr_t)pd & 15))
+	COMBINE (1);
+    if (w >= 4 && ((uintptr_t)pd & 31))
+	COMBINE (4);
+
+    while (w >= 8)
+	COMBINE (8);
+
+    if (w >= 4)
+	COMBINE (4);
+    while (w)
+	COMBINE (1);
+
+#undef COMBINE
+}
+
+static void
+avx2_combine_add_u (pixman_implementation_t *imp,
+		    pixman_op_t              op,
+		    uint32_t *               pd,
+		    const uint32_t *         ps,
+		    const uint32_t *         pm,
+		    int                      w)
+{
+    if (pm)
+	core_combine_add_u_avx2 (pd, ps, pm, w);
+    else
+	core_combine_add_u_avx2 (pd, ps, NULL, w);
+}
+
+static void
+avx2_composite_over_8888_8888 (pixman_implementation_t *imp,
+			       pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t *dst_line;
+    uint32_t *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	core_combine_over_u_avx2 (dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_add_8888_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t *dst_line;
+    uint32_t *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	core_combine_add_u_avx2 (dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_add_8_8 (pixman_implementation_t *imp,
+			pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t *dst_line, *dst;
+    uint8_t *src_line, *src;
+    int dst_stride, src_stride;
+    int32_t w;
+    uint16_t t;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint8_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	src = src_line;
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+	w = width;
+
+	/* Small head */
+	while (w && (uintptr_t)dst & 3)
+	{
+	    t = (*dst) + (*src++);
+	    *dst++ = t | (0 - (t >> 8));
+	    w--;
+	}
+
+	core_combine_add_u_avx2 ((uint32_t*)dst, (uint32_t*)src, NULL, w >> 2);
+
+	/* Small tail */
+	dst += w & 0xfffc;
+	src += w & 0xfffc;
+
+	w &= 3;
+
+	while (w)
+	{
+	    t = (*dst) + (*src++);
+	    *dst++ = t | (0 - (t >> 8));
+	    w--;
+	}
+    }
+}
+
+static force_inline void
+core_combine_over_n_8_avx2_n (uint32_t *      dst,
+			      const uint8_t * mask,
+			      __m256i         ymm_src,
+			      __m256i         ymm_alpha,
+			      __m256i         ymm_def,
+			      pixman_bool_t   opaque,
+			      int             n)
+{
+    uint64_t m = load_mask_8 (mask, n);
+
+    if (opaque && m == 0xffffffffffffffffULL >> (64 - 8 * n))
+    {
+	save_pixels_aligned (dst, ymm_def, n);
+    }
+    else if (m)
+    {
+	__m256i ymm_mask_lo, ymm_mask_hi, ymm_dst_lo, ymm_dst_hi;
+
+	unpack_256_2x256 (expand_mask_8 (m), &ymm_mask_lo, &ymm_mask_hi);
+	unpack_256_2x256 (load_pixels_aligned (dst, n), &ymm_dst_lo, &ymm_dst_hi);
+
+	ymm_mask_lo = expand_alpha_rev_1x256 (ymm_mask_lo);
+	ymm_mask_hi = expand_alpha_rev_1x256 (ymm_mask_hi);
+
+	ymm_dst_lo = in_over_1x256 (ymm_src, ymm_alpha, ymm_mask_lo, ymm_dst_lo);
+	ymm_dst_hi = in_over_1x256 (ymm_src, ymm_alpha, ymm_mask_hi, ymm_dst_hi);
+
+	save_pixels_aligned (dst, pack_2x256_256 (ymm_dst_lo, ymm_dst_hi), n);
+    }
+}
+
+static void
+avx2_composite_over_n_8_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t *dst_line, *dst;
+    uint8_t *mask_line, *mask;
+    int dst_stride, mask_stride;
+    int32_t w;
+    pixman_bool_t opaque;
+
+    __m256i ymm_def, ymm_src, ymm_alpha;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    if (src == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    opaque = (src >> 24) == 0xff;
+    ymm_def = _mm256_set1_epi32 (src);
+    ymm_src = expand_pixel_32_1x256 (src);
+    ymm_alpha = expand_alpha_1x256 (ymm_src);
+
+#define COMBINE(n)							\
+    do {								\
+	core_combine_over_n_8_avx2_n (dst, mask, ymm_src, ymm_alpha,	\
+				      ymm_def, opaque, n);		\
+	dst += n;							\
+	mask += n;							\
+	w -= n;								\
+    } while (0)
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	mask = mask_line;
+	mask_line += mask_stride;
+	w = width;
+
+	while (w && ((uintptr_t)dst & 15))
+	    COMBINE (1);
+	if (w >= 4 && ((uintptr_t)dst & 31))
+	    COMBINE (4);
+
+	while (w >= 8)
+	    COMBINE (8);
+
+	if (w >= 4)
+	    COMBINE (4);
+	while (w)
+	    COMBINE (1);
+    }
+
+#undef COMBINE
+}
+
+static pixman_bool_t
+avx2_fill (pixman_implementation_t *imp,
+	   uint32_t *               bits,
+	   int                      stride,
+	   int                      bpp,
+	   int                      x,
+	   int                      y,
+	   int                      width,
+	   int                      height,
+	   uint32_t		    filler)
+{
+    uint32_t byte_width;
+    uint8_t *byte_line;
+
+    __m256i ymm_def;
+
+    if (bpp == 8)
+    {
+	stride = stride * (int) sizeof (uint32_t);
+	byte_line = (uint8_t *)bits + stride * y + x;
+	byte_width = width;
+
+	filler = (filler & 0xff) * 0x01010101;
+    }
+    else if (bpp == 16)
+    {
+	stride = stride * (int) sizeof (uint32_t) / 2;
+	byte_line = (uint8_t *)(((uint16_t *)bits) + stride * y + x);
+	byte_width = 2 * width;
+	stride *= 2;
+
+	filler = (filler & 0xffff) * 0x00010001;
+    }
+    else if (bpp == 32)
+    {
+	stride = stride * (int) sizeof (uint32_t) / 4;
+	byte_line = (uint8_t *)(((uint32_t *)bits) + stride * y + x);
+	byte_width = 4 * width;
+	stride *= 4;
+    }
+    else
+    {
+	return FALSE;
+    }
+
+    ymm_def = _mm256_set1_epi32 (filler);
+
+    while (height--)
+    {
+	int w;
+	uint8_t *d = byte_line;
+	byte_line += stride;
+	w = byte_width;
+
+	if (w >= 1 && ((uintptr_t)d & 1))
+	{
+	    *(uint8_t *)d = filler & 0xff;
+	    w -= 1;
+	    d += 1;
+	}
+
+	while (w >= 2 && ((uintptr_t)d & 3))
+	{
+	    *(uint16_t *)d = filler & 0xffff;
+	    w -= 2;
+	    d += 2;
+	}
+
+	while (w >= 4 && ((uintptr_t)d & 15))
+	{
+	    *(uint32_t *)d = filler;
+	    w -= 4;
+	    d += 4;
+	}
+
+	if (w >= 16 && ((uintptr_t)d & 31))
+	{
+	    save_pixels_aligned ((uint32_t *)d, ymm_def, 4);
+	    w -= 16;
+	    d += 16;
+	}
+
+	while (w >= 128)
+	{
+	    save_256_aligned (d,      ymm_def);
+	    save_256_aligned (d + 32, ymm_def);
+	    save_256_aligned (d + 64, ymm_def);
+	    save_256_aligned (d + 96, ymm_def);
+
+	    d += 128;
+	    w -= 128;
+	}
+
+	while (w >= 32)
+	{
+	    save_256_aligned (d, ymm_def);
+
+	    d += 32;
+	    w -= 32;
+	}
+
+	if (w >= 16)
+	{
+	    save_pixels_aligned ((uint32_t *)d, ymm_def, 4);
+	    w -= 16;
+	    d += 16;
+	}
+
+	while (w >= 4)
+	{
+	    *(uint32_t *)d = filler;
+	    w -= 4;
+	    d += 4;
+	}
+
+	if (w >= 2)
+	{
+	    *(uint16_t *)d = filler & 0xffff;
+	    w -= 2;
+	    d += 2;
+	}
+
+	if (w >= 1)
+	{
+	    *(uint8_t *)d = filler & 0xff;
+	    w -= 1;
+	    d += 1;
+	}
+    }
+
+    return TRUE;
+}
+
+static force_inline void
+core_combine_src_n_8_avx2_n (uint32_t *      dst,
+			     const uint8_t * mask,
+			     __m256i         ymm_src,
+			     __m256i         ymm_def,
+			     pixman_bool_t   opaque,
+			     int             n)
+{
+    uint64_t m = load_mask_8 (mask, n);
+
+    if (opaque && m == 0xffffffffffffffffULL >> (64 - 8 * n))
+    {
+	save_pixels_aligned (dst, ymm_def, n);
+    }
+    else if (m)
+    {
+	__m256i ymm_mask_lo, ymm_mask_hi;
+
+	unpack_256_2x256 (expand_mask_8 (m), &ymm_mask_lo, &ymm_mask_hi);
+
+	ymm_mask_lo = pix_multiply_1x256 (
+	    ymm_src, expand_alpha_rev_1x256 (ymm_mask_lo));
+	ymm_mask_hi = pix_multiply_1x256 (
+	    ymm_src, expand_alpha_rev_1x256 (ymm_mask_hi));
+
+	save_pixels_aligned (dst, pack_2x256_256 (ymm_mask_lo, ymm_mask_hi), n);
+    }
+    else
+    {
+	save_pixels_aligned (dst, _mm256_setzero_si256 (), n);
+    }
+}
+
+static void
+avx2_composite_src_n_8_8888 (pixman_implementation_t *imp,
+			     pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t *dst_line, *dst;
+    uint8_t *mask_line, *mask;
+    int dst_stride, mask_stride;
+    int32_t w;
+    pixman_bool_t opaque;
+
+    __m256i ymm_def, ymm_src;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    if (src == 0)
+    {
+	avx2_fill (imp, dest_image->bits.bits, dest_image->bits.rowstride,
+		   PIXMAN_FORMAT_BPP (dest_image->bits.format),
+		   dest_x, dest_y, width, height, 0);
+	return;
+    }
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    opaque = (src >> 24) == 0xff;
+    ymm_def = _mm256_set1_epi32 (src);
+    ymm_src = expand_pixel_32_1x256 (src);
+
+#define COMBINE(n)							\
+    do {								\
+	core_combine_src_n_8_avx2_n (dst, mask, ymm_src, ymm_def,	\
+				     opaque, n);			\
+	dst += n;							\
+	mask += n;							\
+	w -= n;								\
+    } while (0)
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	mask = mask_line;
+	mask_line += mask_stride;
+	w = width;
+
+	while (w && ((uintptr_t)dst & 15))
+	    COMBINE (1);
+	if (w >= 4 && ((uintptr_t)dst & 31))
+	    COMBINE (4);
+
+	while (w >= 8)
+	    COMBINE (8);
+
+	if (w >= 4)
+	    COMBINE (4);
+	while (w)
+	    COMBINE (1);
+    }
+
+#undef COMBINE
+}
+
+/***********************************************************************************/
+
+/* Bilinear scaling, two pixels per 256-bit register, one in each
+ * 128-bit lane, with the weights computed the same way as in the SSE2
+ * code: each lane of ymm_x holds the pair (-(x + 1), x) for its pixel.
+ */
+
+#define BILINEAR_DECLARE_VARIABLES						\
+    const __m256i ymm_wt = _mm256_set1_epi16 (wt);				\
+    const __m256i ymm_wb = _mm256_set1_epi16 (wb);				\
+    const __m256i ymm_addc = _mm256_set1_epi32 (1);				\
+    const __m256i ymm_ux2 = _mm256_set1_epi32 (					\
+	(int32_t)((((uint32_t)(unit_x * 2) & 0xffff) << 16) |			\
+		  ((uint32_t)(-unit_x * 2) & 0xffff)));				\
+    const __m256i ymm_zero = _mm256_setzero_si256 ();				\
+    const __m256i ymm_order = _mm256_setr_epi32 (0, 4, 1, 5, 2, 6, 3, 7);	\
+    __m256i ymm_x
+
+#define BILINEAR_X_PAIR(x)							\
+    ((int32_t)((((uint32_t)(x) & 0xffff) << 16) |				\
+	       ((uint32_t)(-((x) + 1)) & 0xffff)))
+
+/* Start the vector weights at the current position */
+#define BILINEAR_SET_X()							\
+do {										\
+    int32_t x0 = BILINEAR_X_PAIR (vx);						\
+    int32_t x1 = BILINEAR_X_PAIR (vx + unit_x);					\
+    ymm_x = _mm256_set_epi32 (x1, x1, x1, x1, x0, x0, x0, x0);			\
+} while (0)
+
+#define BILINEAR_INTERPOLATE_TWO_PIXELS_HELPER(pix)				\
+do {										\
+    __m256i ymm_wh, ymm_a, ymm_b, tltr, blbr;					\
+    /* fetch the 2x2 pixel blocks, one pixel per lane */			\
+    tltr = _mm256_inserti128_si256 (_mm256_castsi128_si256 (			\
+	_mm_loadl_epi64 ((__m128i *)&src_top[vx >> 16])),			\
+	_mm_loadl_epi64 ((__m128i *)&src_top[(vx + unit_x) >> 16]), 1);		\
+    blbr = _mm256_inserti128_si256 (_mm256_castsi128_si256 (			\
+	_mm_loadl_epi64 ((__m128i *)&src_bottom[vx >> 16])),			\
+	_mm_loadl_epi64 ((__m128i *)&src_bottom[(vx + unit_x) >> 16]), 1);	\
+    vx += unit_x * 2;								\
+    /* vertical interpolation */						\
+    ymm_a = _mm256_mullo_epi16 (_mm256_unpacklo_epi8 (tltr, ymm_zero), ymm_wt);	\
+    ymm_b = _mm256_mullo_epi16 (_mm256_unpacklo_epi8 (blbr, ymm_zero), ymm_wb);	\
+    ymm_a = _mm256_add_epi16 (ymm_a, ymm_b);					\
+    /* calculate horizontal weights */						\
+    ymm_wh = _mm256_add_epi16 (ymm_addc, _mm256_srli_epi16 (ymm_x,		\
+					16 - BILINEAR_INTERPOLATION_BITS));	\
+    ymm_x = _mm256_add_epi16 (ymm_x, ymm_ux2);					\
+    /* horizontal interpolation */						\
+    ymm_b = _mm256_unpacklo_epi64 (/* any value is fine here */ ymm_b, ymm_a);	\
+    ymm_a = _mm256_madd_epi16 (_mm256_unpackhi_epi16 (ymm_b, ymm_a), ymm_wh);	\
+    /* shift the result */							\
+    pix = _mm256_srli_epi32 (ymm_a, BILINEAR_INTERPOLATION_BITS * 2);		\
+} while (0)
+
+#define BILINEAR_INTERPOLATE_EIGHT_PIXELS(pix)					\
+do {										\
+    __m256i ymm_pix1, ymm_pix2, ymm_pix3, ymm_pix4;				\
+    BILINEAR_INTERPOLATE_TWO_PIXELS_HELPER (ymm_pix1);				\
+    BILINEAR_INTERPOLATE_TWO_PIXELS_HELPER (ymm_pix2);				\
+    BILINEAR_INTERPOLATE_TWO_PIXELS_HELPER (ymm_pix3);				\
+    BILINEAR_INTERPOLATE_TWO_PIXELS_HELPER (ymm_pix4);				\
+    /* lanes hold pixels 0 2 4 6 and 1 3 5 7 */					\
+    ymm_pix1 = _mm256_packs_epi32 (ymm_pix1, ymm_pix2);				\
+    ymm_pix3 = _mm256_packs_epi32 (ymm_pix3, ymm_pix4);				\
+    pix = _mm256_permutevar8x32_epi32 (						\
+	_mm256_packus_epi16 (ymm_pix1, ymm_pix3), ymm_order);			\
+} while (0)
+
+/* The pixels at either end use the lower half of the same registers */
+#define BILINEAR_INTERPOLATE_ONE_PIXEL(pix)					\
+do {										\
+    __m128i xmm_wh, xmm_a, xmm_b;						\
+    __m128i tltr = _mm_loadl_epi64 ((__m128i *)&src_top[vx >> 16]);		\
+    __m128i blbr = _mm_loadl_epi64 ((__m128i *)&src_bottom[vx >> 16]);		\
+    xmm_wh = _mm_add_epi16 (_mm256_castsi256_si128 (ymm_addc),			\
+			    _mm_srli_epi16 (_mm_set1_epi32 (BILINEAR_X_PAIR (vx)), \
+					    16 - BILINEAR_INTERPOLATION_BITS));	\
+    vx += unit_x;								\
+    xmm_a = _mm_mullo_epi16 (_mm_unpacklo_epi8 (tltr, _mm_setzero_si128 ()),	\
+			     _mm256_castsi256_si128 (ymm_wt));			\
+    xmm_b = _mm_mullo_epi16 (_mm_unpacklo_epi8 (blbr, _mm_setzero_si128 ()),	\
+			     _mm256_castsi256_si128 (ymm_wb));			\
+    xmm_a = _mm_add_epi16 (xmm_a, xmm_b);					\
+    xmm_b = _mm_unpacklo_epi64 (xmm_b, xmm_a);					\
+    xmm_a = _mm_madd_epi16 (_mm_unpackhi_epi16 (xmm_b, xmm_a), xmm_wh);		\
+    xmm_a = _mm_srli_epi32 (xmm_a, BILINEAR_INTERPOLATION_BITS * 2);		\
+    xmm_a = _mm_packs_epi32 (xmm_a, xmm_a);					\
+    pix = _mm_cvtsi128_si32 (_mm_packus_epi16 (xmm_a, xmm_a));			\
+} while (0)
+
+static force_inline void
+scaled_bilinear_scanline_avx2_8888_8888_SRC (uint32_t *       dst,
+					     const uint32_t * mask,
+					     const uint32_t * src_top,
+					     const uint32_t * src_bottom,
+					     int32_t          w,
+					     int              wt,
+					     int              wb,
+					     pixman_fixed_t   vx_,
+					     pixman_fixed_t   unit_x_,
+					     pixman_fixed_t   max_vx,
+					     pixman_bool_t    zero_src)
+{
+    intptr_t vx = vx_;
+    intptr_t unit_x = unit_x_;
+    BILINEAR_DECLARE_VARIABLES;
+    uint32_t pix;
+
+    while (w && ((uintptr_t)dst & 31))
+    {
+	BILINEAR_INTERPOLATE_ONE_PIXEL (pix);
+	*dst++ = pix;
+	w--;
+    }
+
+    BILINEAR_SET_X ();
+    while (w >= 8)
+    {
+	__m256i ymm_src;
+
+	BILINEAR_INTERPOLATE_EIGHT_PIXELS (ymm_src);
+	save_256_aligned (dst, ymm_src);
+	dst += 8;
+	w -= 8;
+    }
+
+    while (w)
+    {
+	BILINEAR_INTERPOLATE_ONE_PIXEL (pix);
+	*dst++ = pix;
+	w--;
+    }
+}
+
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_cover_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       COVER, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_pad_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       PAD, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_none_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       NONE, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_normal_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       NORMAL, FLAG_NONE)
+
+static force_inline void
+scaled_bilinear_scanline_avx2_8888_8888_OVER (uint32_t *       dst,
+					      const uint32_t * mask,
+					      const uint32_t * src_top,
+					      const uint32_t * src_bottom,
+					      int32_t          w,
+					      int              wt,
+					      int              wb,
+					      pixman_fixed_t   vx_,
+					      pixman_fixed_t   unit_x_,
+					      pixman_fixed_t   max_vx,
+					      pixman_bool_t    zero_src)
+{
+    intptr_t vx = vx_;
+    intptr_t unit_x = unit_x_;
+    BILINEAR_DECLARE_VARIABLES;
+    uint32_t pix;
+
+    while (w && ((uintptr_t)dst & 31))
+    {
+	BILINEAR_INTERPOLATE_ONE_PIXEL (pix);
+	core_combine_over_u_avx2_n (dst, &pix, NULL, 1);
+	dst++;
+	w--;
+    }
+
+    BILINEAR_SET_X ();
+    while (w >= 8)
+    {
+	__m256i ymm_src;
+
+	BILINEAR_INTERPOLATE_EIGHT_PIXELS (ymm_src);
+
+	if (!is_zero_256 (ymm_src, 8))
+	{
+	    if (is_opaque_256 (ymm_src, 8))
+		save_256_aligned (dst, ymm_src);
+	    else
+		save_256_aligned (dst, over_8_pixels (ymm_src,
+						      load_256_aligned (dst)));
+	}
+
+	dst += 8;
+	w -= 8;
+    }
+
+    while (w)
+    {
+	BILINEAR_INTERPOLATE_ONE_PIXEL (pix);
+	core_combine_over_u_avx2_n (dst, &pix, NULL, 1);
+	dst++;
+	w--;
+    }
+}
+
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_cover_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       COVER, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_pad_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       PAD, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_none_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       NONE, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_normal_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       NORMAL, FLAG_NONE)
+
+static const pixman_fast_path_t avx2_fast_paths[] =
+{
+    /* PIXMAN_OP_OVER */
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8b8g8r8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8b8g8r8, avx2_composite_over_n_8_8888),
+
+    /* PIXMAN_OP_ADD */
+    PIXMAN_STD_FAST_PATH (ADD, a8, null, a8, avx2_composite_add_8_8),
+    PIXMAN_STD_FAST_PATH (ADD, a8r8g8b8, null, a8r8g8b8, avx2_composite_add_8888_8888),
+    PIXMAN_STD_FAST_PATH (ADD, a8b8g8r8, null, a8b8g8r8, avx2_composite_add_8888_8888),
+
+    /* PIXMAN_OP_SRC */
+    PIXMAN_STD_FAST_PATH (SRC, solid, a8, a8r8g8b8, avx2_composite_src_n_8_8888),
+    PIXMAN_STD_FAST_PATH (SRC, solid, a8, x8r8g8b8, avx2_composite_src_n_8_8888),
+    PIXMAN_STD_FAST_PATH (SRC, solid, a8, a8b8g8r8, avx2_composite_src_n_8_8888),
+    PIXMAN_STD_FAST_PATH (SRC, solid, a8, x8b8g8r8, avx2_composite_src_n_8_8888),
+
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, a8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, x8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, a8b8g8r8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, x8b8g8r8, x8b8g8r8, avx2_8888_8888),
+
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, avx2_8888_8888),
+
+    { PIXMAN_OP_NONE },
+};
+
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp =
+	_pixman_implementation_create (fallback, avx2_fast_paths);
+
+    imp->combine_32[PIXMAN_OP_OVER] = avx2_combine_over_u;
+    imp->combine_32[PIXMAN_OP_ADD] = avx2_combine_add_u;
+
+    imp->fill = avx2_fill;
+
+    return imp;
+}
@@ -168,6 +168,12 @@ conical_get_scanline (pixman_iter_t                 *iter,
 static uint32_t *
 conical_get_scanline_narrow (pixman_iter_t *iter, const uint32_t *mask)
 {
+    if (iter->image->gradient.lut)
+    {
+	return conical_get_scanline (iter, mask, 4,
+				     _pixman_gradient_walker_write_lut);
+    }
+
     return conical_get_scanline (iter, mask, 4,
 				 _pixman_gradient_walker_write_narrow);
 }
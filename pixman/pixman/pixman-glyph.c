@@ -33,6 +33,8 @@
 
 typedef struct glyph_metrics_t glyph_metrics_t;
 typedef struct glyph_t glyph_t;
+typedef struct atlas_t atlas_t;
+typedef struct atlas_slot_t atlas_slot_t;
 
 #define TOMBSTONE ((glyph_t *)0x1)
 
@@ -43,6 +45,39 @@ typedef struct glyph_t glyph_t;
 #define HASH_SIZE (2 * N_GLYPHS_HIGH_WATER)
 #define HASH_MASK (HASH_SIZE - 1)
 
+/* Glyphs of a byte aligned format that are at most ATLAS_MAX_GLYPH pixels
+ * on each side don't get bits of their own.  They are packed, shelf by
+ * shelf, into shared atlas pages of ATLAS_SIZE x ATLAS_SIZE pixels, and
+ * their images point into those.  A page holds one format and is freed
+ * with the last glyph on it.  The slot of a glyph that goes away before
+ * that is kept on the page's free list and given to the next glyph of
+ * the format that fits in it.
+ */
+#define ATLAS_SIZE		256
+#define ATLAS_MAX_GLYPH		64
+#define ATLAS_MAX_PAGES		32
+
+struct atlas_t
+{
+    pixman_format_code_t	format;
+    uint8_t *			bits;
+    int				stride;
+    int				shelf_x;
+    int				shelf_y;
+    int				shelf_height;
+    int				n_glyphs;
+    pixman_list_t		free_slots;
+    pixman_link_t		link;
+};
+
+struct atlas_slot_t
+{
+    uint8_t *			bits;
+    int				bytes;
+    int				height;
+    pixman_link_t		link;
+};
+
 struct glyph_t
 {
     void *		font_key;
@@ -50,6 +85,9 @@ struct glyph_t
     int			origin_x;
     int			origin_y;
     pixman_image_t *	image;
+    atlas_t *		atlas;
+    int			slot_bytes;
+    int			slot_height;
     pixman_link_t	mru_link;
 };
 
@@ -58,14 +96,196 @@ struct pixman_glyph_cache_t
     int			n_glyphs;
     int			n_tombstones;
     int			freeze_count;
+    int			n_atlases;
+    pixman_list_t	atlases;
     pixman_list_t	mru;
     glyph_t *		glyphs[HASH_SIZE];
 };
 
+/* Takes the free slot that fits a bytes x height glyph with the least
+ * room to spare from the pages of a format.
+ */
+static uint8_t *
+atlas_reuse_slot (pixman_glyph_cache_t *cache,
+		  glyph_t              *glyph,
+		  pixman_format_code_t  format,
+		  int                   bytes,
+		  int                   height)
+{
+    atlas_slot_t *best = NULL;
+    atlas_t *best_atlas = NULL;
+    pixman_link_t *link, *l;
+    uint8_t *bits;
+
+    for (link = cache->atlases.head;
+	 link != (pixman_link_t *)&cache->atlases;
+	 link = link->next)
+    {
+	atlas_t *a = CONTAINER_OF (atlas_t, link, link);
+
+	if (a->format != format)
+	    continue;
+
+	for (l = a->free_slots.head;
+	     l != (pixman_link_t *)&a->free_slots;
+	     l = l->next)
+	{
+	    atlas_slot_t *slot = CONTAINER_OF (atlas_slot_t, link, l);
+
+	    if (slot->bytes < bytes || slot->height < height)
+		continue;
+
+	    if (!best || slot->bytes * slot->height < best->bytes * best->height)
+	    {
+		best = slot;
+		best_atlas = a;
+
+		if (slot->bytes == bytes && slot->height == height)
+		    goto found;
+	    }
+	}
+    }
+
+    if (!best)
+	return NULL;
+
+found:
+    pixman_list_unlink (&best->link);
+
+    bits = best->bits;
+    glyph->atlas = best_atlas;
+    glyph->slot_bytes = best->bytes;
+    glyph->slot_height = best->height;
+    best_atlas->n_glyphs++;
+
+    free (best);
+
+    return bits;
+}
+
+/* Returns the bits for a width x height glyph in an atlas page, or NULL
+ * if the glyph needs an image of its own.
+ */
+static uint8_t *
+atlas_alloc (pixman_glyph_cache_t *cache,
+	     glyph_t              *glyph,
+	     pixman_format_code_t  format,
+	     int                   width,
+	     int                   height)
+{
+    int bpp = PIXMAN_FORMAT_BPP (format);
+    int bytes = ((width * bpp / 8) + 3) & ~3;
+    atlas_t *atlas = NULL;
+    pixman_link_t *link;
+    uint8_t *bits;
+
+    if (bpp < 8 || width > ATLAS_MAX_GLYPH || height > ATLAS_MAX_GLYPH)
+	return NULL;
+
+    if ((bits = atlas_reuse_slot (cache, glyph, format, bytes, height)))
+	return bits;
+
+    /* Only the newest page of a format is filled */
+    for (link = cache->atlases.head;
+	 link != (pixman_link_t *)&cache->atlases;
+	 link = link->next)
+    {
+	atlas_t *a = CONTAINER_OF (atlas_t, link, link);
+
+	if (a->format == format)
+	{
+	    atlas = a;
+	    break;
+	}
+    }
+
+    /* The shelf being filled is the lowest one on the page, so it can
+     * grow to take a taller glyph.
+     */
+    if (atlas)
+    {
+	if (atlas->shelf_x + bytes > atlas->stride)
+	{
+	    atlas->shelf_y += atlas->shelf_height;
+	    atlas->shelf_x = 0;
+	    atlas->shelf_height = 0;
+	}
+
+	if (atlas->shelf_y + height > ATLAS_SIZE)
+	    atlas = NULL;
+    }
+
+    if (!atlas)
+    {
+	int stride = ATLAS_SIZE * bpp / 8;
+
+	if (cache->n_atlases >= ATLAS_MAX_PAGES)
+	    return NULL;
+
+	if (!(atlas = calloc (1, sizeof *atlas + stride * ATLAS_SIZE)))
+	    return NULL;
+
+	atlas->format = format;
+	atlas->bits = (uint8_t *)(atlas + 1);
+	atlas->stride = stride;
+	pixman_list_init (&atlas->free_slots);
+
+	pixman_list_prepend (&cache->atlases, &atlas->link);
+	cache->n_atlases++;
+    }
+
+    bits = atlas->bits + atlas->shelf_y * atlas->stride + atlas->shelf_x;
+
+    atlas->shelf_x += bytes;
+    atlas->shelf_height = MAX (atlas->shelf_height, height);
+    atlas->n_glyphs++;
+
+    glyph->atlas = atlas;
+    glyph->slot_bytes = bytes;
+    glyph->slot_height = height;
+    return bits;
+}
+
+/* Gives the slot of a glyph back to its page.  If there is no memory to
+ * remember the slot, its space is only reclaimed with the page.
+ */
 static void
-free_glyph (glyph_t *glyph)
+atlas_release (pixman_glyph_cache_t *cache, glyph_t *glyph, uint8_t *bits)
+{
+    atlas_t *atlas = glyph->atlas;
+    atlas_slot_t *slot;
+
+    if (--atlas->n_glyphs == 0)
+    {
+	while (atlas->free_slots.head != (pixman_link_t *)&atlas->free_slots)
+	{
+	    slot = CONTAINER_OF (atlas_slot_t, link, atlas->free_slots.head);
+
+	    pixman_list_unlink (&slot->link);
+	    free (slot);
+	}
+
+	pixman_list_unlink (&atlas->link);
+	cache->n_atlases--;
+
+	free (atlas);
+    }
+    else if ((slot = malloc (sizeof *slot)))
+    {
+	slot->bits = bits;
+	slot->bytes = glyph->slot_bytes;
+	slot->height = glyph->slot_height;
+
+	pixman_list_prepend (&atlas->free_slots, &slot->link);
+    }
+}
+
+static void
+free_glyph (pixman_glyph_cache_t *cache, glyph_t *glyph)
 {
     pixman_list_unlink (&glyph->mru_link);
+    if (glyph->atlas)
+	atlas_release (cache, glyph, (uint8_t *)glyph->image->bits.bits);
     pixman_image_unref (glyph->image);
     free (glyph);
 }
@@ -173,7 +393,7 @@ clear_table (pixman_glyph_cache_t *cache)
 	glyph_t *glyph = cache->glyphs[i];
 
 	if (glyph && glyph != TOMBSTONE)
-	    free_glyph (glyph);
+	    free_glyph (cache, glyph);
 
 	cache->glyphs[i] = NULL;
     }
@@ -194,7 +414,9 @@ pixman_glyph_cache_create (void)
     cache->n_glyphs = 0;
     cache->n_tombstones = 0;
     cache->freeze_count = 0;
+    cache->n_atlases = 0;
 
+    pixman_list_init (&cache->atlases);
     pixman_list_init (&cache->mru);
 
     return cache;
@@ -235,7 +457,7 @@ pixman_glyph_cache_thaw (pixman_glyph_cache_t  *cache)
 	    glyph_t *glyph = CONTAINER_OF (glyph_t, mru_link, cache->mru.tail);
 
 	    remove_glyph (cache, glyph);
-	    free_glyph (glyph);
+	    free_glyph (cache, glyph);
 	}
     }
 }
@@ -256,12 +478,15 @@ pixman_glyph_cache_insert (pixman_glyph_cache_t  *cache,
 			   int                    origin_y,
 			   pixman_image_t        *image)
 {
+    pixman_format_code_t format;
     glyph_t *glyph;
     int32_t width, height;
+    uint8_t *bits;
 
     return_val_if_fail (cache->freeze_count > 0, NULL);
     return_val_if_fail (image->type == BITS, NULL);
 
+    format = image->bits.format;
     width = image->bits.width;
     height = image->bits.height;
 
@@ -275,10 +500,23 @@ pixman_glyph_cache_insert (pixman_glyph_cache_t  *cache,
     glyph->glyph_key = glyph_key;
     glyph->origin_x = origin_x;
     glyph->origin_y = origin_y;
+    glyph->atlas = NULL;
 
-    if (!(glyph->image = pixman_image_create_bits (
-	      image->bits.format, width, height, NULL, -1)))
+    if ((bits = atlas_alloc (cache, glyph, format, width, height)))
     {
+	glyph->image = pixman_image_create_bits (
+	    format, width, height, (uint32_t *)bits, glyph->atlas->stride);
+    }
+    else
+    {
+	glyph->image = pixman_image_create_bits (
+	    format, width, height, NULL, -1);
+    }
+
+    if (!glyph->image)
+    {
+	if (glyph->atlas)
+	    atlas_release (cache, glyph, bits);
 	free (glyph);
 	return NULL;
     }
@@ -312,7 +550,7 @@ pixman_glyph_cache_remove (pixman_glyph_cache_t  *cache,
     {
 	remove_glyph (cache, glyph);
 
-	free_glyph (glyph);
+	free_glyph (cache, glyph);
     }
 }
 
@@ -498,6 +736,90 @@ out:
     pixman_region32_fini (&region);
 }
 
+/* Saturating add of the bytes of two 64 bit words */
+static force_inline uint64_t
+add_bytes_8x8 (uint64_t a, uint64_t b)
+{
+    const uint64_t low = 0x7f7f7f7f7f7f7f7fULL;
+    const uint64_t high = 0x8080808080808080ULL;
+    uint64_t sum, carry;
+
+    sum = (a & low) + (b & low);
+    carry = ((a & b) | ((a | b) & ~(sum ^ ((a ^ b) & high)))) & high;
+    sum ^= (a ^ b) & high;
+
+    return sum | ((carry >> 7) * 0xff);
+}
+
+static force_inline void
+add_span (uint8_t *dst, const uint8_t *src, int n)
+{
+    uint64_t d, s;
+
+    while (n >= 8)
+    {
+	memcpy (&d, dst, 8);
+	memcpy (&s, src, 8);
+	d = add_bytes_8x8 (d, s);
+	memcpy (dst, &d, 8);
+
+	dst += 8;
+	src += 8;
+	n -= 8;
+    }
+
+    if (n >= 4)
+    {
+	uint32_t d32, s32;
+
+	memcpy (&d32, dst, 4);
+	memcpy (&s32, src, 4);
+	d32 = add_bytes_8x8 (d32, s32);
+	memcpy (dst, &d32, 4);
+
+	dst += 4;
+	src += 4;
+	n -= 4;
+    }
+
+    while (n--)
+    {
+	uint32_t t = *dst + *src++;
+
+	*dst++ = t | (0 - (t >> 8));
+    }
+}
+
+/* When the glyph and the mask have the same format with 8 bit channels,
+ * ADDing the glyph is a saturating add of every byte.  This does it
+ * directly, without the setup of a composite for each glyph.
+ */
+static void
+add_glyph_bytes (pixman_image_t       *dest,
+		 pixman_image_t       *glyph_img,
+		 const pixman_box32_t *box,
+		 int                   glyph_x,
+		 int                   glyph_y)
+{
+    int bpp = PIXMAN_FORMAT_BPP (dest->bits.format) / 8;
+    int dest_stride = dest->bits.rowstride * (int) sizeof (uint32_t);
+    int glyph_stride = glyph_img->bits.rowstride * (int) sizeof (uint32_t);
+    uint8_t *d = (uint8_t *)dest->bits.bits +
+	box->y1 * dest_stride + box->x1 * bpp;
+    const uint8_t *s = (uint8_t *)glyph_img->bits.bits +
+	glyph_y * glyph_stride + glyph_x * bpp;
+    int n = (box->x2 - box->x1) * bpp;
+    int h = box->y2 - box->y1;
+
+    while (h--)
+    {
+	add_span (d, s, n);
+
+	d += dest_stride;
+	s += glyph_stride;
+    }
+}
+
 static void
 add_glyphs (pixman_glyph_cache_t *cache,
 	    pixman_image_t *dest,
@@ -514,6 +836,7 @@ add_glyphs (pixman_glyph_cache_t *cache,
     pixman_composite_info_t info;
     pixman_image_t *white_img = NULL;
     pixman_bool_t white_src = FALSE;
+    pixman_bool_t add_bytes;
     int i;
 
     _pixman_image_validate (dest);
@@ -521,6 +844,11 @@ add_glyphs (pixman_glyph_cache_t *cache,
     dest_format = dest->common.extended_format_code;
     dest_flags = dest->common.flags;
 
+    add_bytes = (dest_flags & FAST_PATH_NO_ACCESSORS)	&&
+	(dest_format == PIXMAN_a8		||
+	 dest_format == PIXMAN_a8r8g8b8	||
+	 dest_format == PIXMAN_a8b8g8r8);
+
     info.op = PIXMAN_OP_ADD;
     info.dest_image = dest;
     info.src_x = 0;
@@ -539,6 +867,24 @@ add_glyphs (pixman_glyph_cache_t *cache,
 	pixman_box32_t glyph_box;
 	pixman_box32_t composite_box;
 
+	glyph_box.x1 = glyphs[i].x - glyph->origin_x + off_x;
+	glyph_box.y1 = glyphs[i].y - glyph->origin_y + off_y;
+	glyph_box.x2 = glyph_box.x1 + glyph->image->bits.width;
+	glyph_box.y2 = glyph_box.y1 + glyph->image->bits.height;
+
+	if (add_bytes && glyph_img->common.extended_format_code == dest_format)
+	{
+	    if (box32_intersect (&composite_box, &glyph_box, &dest_box))
+	    {
+		add_glyph_bytes (dest, glyph_img, &composite_box,
+				 composite_box.x1 - glyph_box.x1,
+				 composite_box.y1 - glyph_box.y1);
+
+		pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
+	    }
+	    continue;
+	}
+
 	if (glyph_img->common.extended_format_code != glyph_format	||
 	    glyph_img->common.flags != glyph_flags)
 	{
@@ -584,11 +930,6 @@ add_glyphs (pixman_glyph_cache_t *cache,
 		&implementation, &func);
 	}
 
-	glyph_box.x1 = glyphs[i].x - glyph->origin_x + off_x;
-	glyph_box.y1 = glyphs[i].y - glyph->origin_y + off_y;
-	glyph_box.x2 = glyph_box.x1 + glyph->image->bits.width;
-	glyph_box.y2 = glyph_box.y1 + glyph->image->bits.height;
-	
 	if (box32_intersect (&composite_box, &glyph_box, &dest_box))
 	{
 	    int src_x = composite_box.x1 - glyph_box.x1;
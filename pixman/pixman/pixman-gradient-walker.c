@@ -26,6 +26,7 @@
 #ifdef HAVE_CONFIG_H
 #include <pixman-config.h>
 #endif
+#include <stdlib.h>
 #include "pixman-private.h"
 
 void
@@ -48,6 +49,9 @@ _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
     walker->repeat    = repeat;
 
     walker->need_reset = TRUE;
+
+    walker->lut       = gradient->lut;
+    walker->lut_shift = gradient->lut_shift;
 }
 
 static void
@@ -262,3 +266,105 @@ _pixman_gradient_walker_fill_wide (pixman_gradient_walker_t *walker,
     while (buffer_wide < end_wide)
 	*buffer_wide++ = color;
 }
+
+void
+_pixman_gradient_walker_write_lut (pixman_gradient_walker_t *walker,
+				   pixman_fixed_48_16_t      x,
+				   uint32_t                 *buffer)
+{
+    *buffer = walker->lut[
+	_pixman_gradient_lut_index (walker->repeat, walker->lut_shift, x)];
+}
+
+void
+_pixman_gradient_walker_fill_lut (pixman_gradient_walker_t *walker,
+				  pixman_fixed_48_16_t      x,
+				  uint32_t                 *buffer,
+				  uint32_t                 *end)
+{
+    register uint32_t color;
+
+    color = walker->lut[
+	_pixman_gradient_lut_index (walker->repeat, walker->lut_shift, x)];
+    while (buffer < end)
+	*buffer++ = color;
+}
+
+/* The lookup table samples one period of the gradient, so it can stand
+ * in for the walker whenever the color outside [0, 1] is either periodic
+ * or constant.  The latter needs all stops to lie inside [0, 1].
+ */
+pixman_bool_t
+_pixman_gradient_lut_usable (gradient_t *gradient, pixman_repeat_t repeat)
+{
+    int i;
+
+    if (!gradient->lut_size)
+	return FALSE;
+
+    if (repeat == PIXMAN_REPEAT_NORMAL || repeat == PIXMAN_REPEAT_REFLECT)
+	return TRUE;
+
+    for (i = 0; i < gradient->n_stops; ++i)
+    {
+	if (gradient->stops[i].x < 0 ||
+	    gradient->stops[i].x > pixman_fixed_1)
+	{
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+/* (Re)builds gradient->lut for gradient->lut_size entries and the
+ * current repeat mode.  Entry i holds the color at the center of
+ * [i, i + 1] / lut_size.  On allocation failure lut is left NULL and
+ * the fetchers keep using the walker.
+ */
+void
+_pixman_gradient_build_lut (gradient_t *gradient)
+{
+    pixman_repeat_t repeat = gradient->common.repeat;
+    int size = gradient->lut_size;
+    int shift = 16;
+    pixman_gradient_walker_t walker;
+    uint32_t *lut;
+    int i;
+
+    while ((1 << (16 - shift)) < size)
+	shift--;
+
+    if (gradient->lut					&&
+	gradient->lut_shift == shift			&&
+	gradient->lut_repeat == repeat)
+    {
+	return;
+    }
+
+    if (gradient->lut)
+    {
+	free (gradient->lut - 1);
+	gradient->lut = NULL;
+    }
+
+    lut = pixman_malloc_ab (size + 2, sizeof (uint32_t));
+    if (!lut)
+	return;
+    lut += 1;
+
+    _pixman_gradient_walker_init (&walker, gradient, repeat);
+
+    for (i = 0; i < size; ++i)
+    {
+	lut[i] = pixman_gradient_walker_pixel_32 (
+	    &walker, (((pixman_fixed_48_16_t)i << shift) + (1 << shift) / 2));
+    }
+
+    lut[-1] = pixman_gradient_walker_pixel_32 (&walker, -pixman_fixed_1);
+    lut[size] = pixman_gradient_walker_pixel_32 (&walker, pixman_fixed_1);
+
+    gradient->lut = lut;
+    gradient->lut_shift = shift;
+    gradient->lut_repeat = repeat;
+}
@@ -73,6 +73,16 @@ gradient_property_changed (pixman_image_t *image)
 	end->color = stops[n - 1].color;
 	break;
     }
+
+    if (_pixman_gradient_lut_usable (gradient, gradient->common.repeat))
+    {
+	_pixman_gradient_build_lut (gradient);
+    }
+    else if (gradient->lut)
+    {
+	free (gradient->lut - 1);
+	gradient->lut = NULL;
+    }
 }
 
 pixman_bool_t
@@ -101,6 +111,11 @@ _pixman_init_gradient (gradient_t *                  gradient,
     memcpy (gradient->stops, stops, n_stops * sizeof (pixman_gradient_stop_t));
     gradient->n_stops = n_stops;
 
+    gradient->lut_size = 0;
+    gradient->lut = NULL;
+    gradient->lut_shift = 0;
+    gradient->lut_repeat = PIXMAN_REPEAT_NONE;
+
     gradient->common.property_changed = gradient_property_changed;
 
     return TRUE;
@@ -161,6 +176,9 @@ _pixman_image_fini (pixman_image_t *image)
 		free (image->gradient.stops - 1);
 	    }
 
+	    if (image->gradient.lut)
+		free (image->gradient.lut - 1);
+
 	    /* This will trigger if someone adds a property_changed
 	     * method to the linear/radial/conical gradient overwriting
 	     * the general one.
@@ -512,6 +530,13 @@ compute_image_info (pixman_image_t *image)
 	break;
     }
 
+    if ((image->type == LINEAR || image->type == RADIAL ||
+	 image->type == CONICAL) &&
+	_pixman_gradient_lut_usable (&image->gradient, image->common.repeat))
+    {
+	flags |= FAST_PATH_GRADIENT_LUT;
+    }
+
     /* Alpha maps are only supported for BITS images, so it's always
      * safe to ignore their presense for non-BITS images
      */
@@ -797,6 +822,35 @@ pixman_image_set_indexed (pixman_image_t *        image,
     image_property_changed (image);
 }
 
+PIXMAN_EXPORT pixman_bool_t
+pixman_image_set_gradient_lut_size (pixman_image_t *image,
+                                    int             size)
+{
+    gradient_t *gradient = (gradient_t *)image;
+
+    if (image->type != LINEAR &&
+	image->type != RADIAL &&
+	image->type != CONICAL)
+    {
+	return FALSE;
+    }
+
+    if (size != 0 &&
+	(size < 256 || size > 4096 || (size & (size - 1)) != 0))
+    {
+	return FALSE;
+    }
+
+    if (gradient->lut_size == size)
+	return TRUE;
+
+    gradient->lut_size = size;
+
+    image_property_changed (image);
+
+    return TRUE;
+}
+
 PIXMAN_EXPORT void
 pixman_image_set_alpha_map (pixman_image_t *image,
                             pixman_image_t *alpha_map,
@@ -224,6 +224,13 @@ static uint32_t *
 linear_get_scanline_narrow (pixman_iter_t  *iter,
 			    const uint32_t *mask)
 {
+    if (iter->image->gradient.lut)
+    {
+	return linear_get_scanline (iter, mask, 4,
+				    _pixman_gradient_walker_write_lut,
+				    _pixman_gradient_walker_fill_lut);
+    }
+
     return linear_get_scanline (iter, mask, 4,
 				_pixman_gradient_walker_write_narrow,
 				_pixman_gradient_walker_fill_narrow);
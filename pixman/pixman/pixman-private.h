@@ -133,6 +133,16 @@ struct gradient
     image_common_t	    common;
     int                     n_stops;
     pixman_gradient_stop_t *stops;
+
+    /* Optional color lookup table, see pixman_image_set_gradient_lut_size().
+     * Like stops, lut points one entry past the start of the allocation:
+     * lut[-1] and lut[lut_size] hold the colors used below 0 and from 1 on
+     * with PIXMAN_REPEAT_NONE or PIXMAN_REPEAT_PAD.
+     */
+    int                     lut_size;
+    uint32_t               *lut;
+    int                     lut_shift;
+    pixman_repeat_t         lut_repeat;
 };
 
 struct linear_gradient
@@ -356,6 +366,9 @@ typedef struct
     pixman_repeat_t	    repeat;
 
     pixman_bool_t           need_reset;
+
+    const uint32_t         *lut;
+    int                     lut_shift;
 } pixman_gradient_walker_t;
 
 void
@@ -400,6 +413,54 @@ _pixman_gradient_walker_fill_wide(pixman_gradient_walker_t *walker,
 				  uint32_t                 *buffer,
 				  uint32_t                 *end);
 
+void
+_pixman_gradient_walker_write_lut(pixman_gradient_walker_t *walker,
+				  pixman_fixed_48_16_t      x,
+				  uint32_t                 *buffer);
+
+void
+_pixman_gradient_walker_fill_lut(pixman_gradient_walker_t *walker,
+				 pixman_fixed_48_16_t      x,
+				 uint32_t                 *buffer,
+				 uint32_t                 *end);
+
+pixman_bool_t
+_pixman_gradient_lut_usable (gradient_t *gradient, pixman_repeat_t repeat);
+
+void
+_pixman_gradient_build_lut (gradient_t *gradient);
+
+/* Returns the index into a gradient lookup table of 0x10000 >> shift
+ * entries for position x.  With PIXMAN_REPEAT_NONE and PIXMAN_REPEAT_PAD
+ * the result is in [-1, size], otherwise it is in [0, size - 1].
+ */
+static force_inline int
+_pixman_gradient_lut_index (pixman_repeat_t      repeat,
+			    int                  shift,
+			    pixman_fixed_48_16_t x)
+{
+    int32_t f;
+
+    switch (repeat)
+    {
+    case PIXMAN_REPEAT_NORMAL:
+	return ((int32_t)x & 0xffff) >> shift;
+
+    case PIXMAN_REPEAT_REFLECT:
+	f = (int32_t)x & 0xffff;
+	if ((int32_t)x & 0x10000)
+	    f ^= 0xffff;
+	return f >> shift;
+
+    default:
+	if (x < 0)
+	    return -1;
+	if (x > pixman_fixed_1)
+	    x = pixman_fixed_1;
+	return (int32_t)x >> shift;
+    }
+}
+
 /*
  * Edges
  */
@@ -630,6 +691,11 @@ pixman_implementation_t *
 _pixman_implementation_create_ssse3 (pixman_implementation_t *fallback);
 #endif
 
+#ifdef USE_AVX2
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback);
+#endif
+
 #ifdef USE_ARM_SIMD
 pixman_implementation_t *
 _pixman_implementation_create_arm_simd (pixman_implementation_t *fallback);
@@ -684,6 +750,21 @@ _pixman_choose_implementation (void);
 pixman_bool_t
 _pixman_disabled (const char *name);
 
+/*
+ * Threads
+ */
+typedef void (* pixman_thread_func_t) (void *data, int index);
+
+int
+_pixman_threads_get_count (void);
+
+/* Runs func on items 0 to n_items - 1 on the worker threads and the
+ * caller, and returns when all are done.  Returns FALSE without running
+ * anything if no workers are available.
+ */
+pixman_bool_t
+_pixman_threads_run (pixman_thread_func_t func, void *data, int n_items);
+
 
 /*
  * Utilities
@@ -746,6 +827,7 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 #define FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR	(1 << 24)
 #define FAST_PATH_BITS_IMAGE			(1 << 25)
 #define FAST_PATH_SEPARABLE_CONVOLUTION_FILTER  (1 << 26)
+#define FAST_PATH_GRADIENT_LUT			(1 << 27)
 
 #define FAST_PATH_PAD_REPEAT						\
     (FAST_PATH_NO_NONE_REPEAT		|				\
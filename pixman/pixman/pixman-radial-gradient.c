@@ -438,6 +438,12 @@ radial_get_scanline (pixman_iter_t                 *iter,
 static uint32_t *
 radial_get_scanline_narrow (pixman_iter_t *iter, const uint32_t *mask)
 {
+    if (iter->image->gradient.lut)
+    {
+	return radial_get_scanline (iter, mask, 4,
+				    _pixman_gradient_walker_write_lut);
+    }
+
     return radial_get_scanline (iter, mask, 4,
 				_pixman_gradient_walker_write_narrow);
 }
@@ -69,6 +69,16 @@
 #include <stdio.h>
 #include "pixman-private.h"
 
+/* The band kernels below use SSE2 where the target guarantees it (all of
+ * x86-64, and 32-bit builds that ask for it), so no runtime dispatch is
+ * needed.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) ||	\
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXREGION_SSE2
+#endif
+
 #define PIXREGION_NIL(reg) ((reg)->data && !(reg)->data->numRects)
 /* not a region */
 #define PIXREGION_NAR(reg)      ((reg)->data == pixman_broken_data)
@@ -546,6 +556,129 @@ PREFIX (_copy) (region_type_t *dst, const region_type_t *src)
  *	    Generic Region Operator
  *====================================================================*/
 
+/* Return TRUE if the n boxes at a and b have the same x coordinates */
+static force_inline pixman_bool_t
+pixman_bands_match (const box_type_t *a, const box_type_t *b, int n)
+{
+#ifdef PIXREGION_SSE2
+    /* Two boxes per step, comparing only the x1 and x2 lanes */
+    if (sizeof (box_type_t) == 8)
+    {
+	for (; n >= 2; n -= 2, a += 2, b += 2)
+	{
+	    __m128i eq = _mm_cmpeq_epi16 (_mm_loadu_si128 ((const __m128i *)a),
+					  _mm_loadu_si128 ((const __m128i *)b));
+
+	    if ((_mm_movemask_epi8 (eq) & 0x3333) != 0x3333)
+		return FALSE;
+	}
+    }
+    else if (sizeof (box_type_t) == 16)
+    {
+	for (; n >= 2; n -= 2, a += 2, b += 2)
+	{
+	    __m128i eq0 = _mm_cmpeq_epi32 (_mm_loadu_si128 ((const __m128i *)a),
+					   _mm_loadu_si128 ((const __m128i *)b));
+	    __m128i eq1 = _mm_cmpeq_epi32 (_mm_loadu_si128 ((const __m128i *)(a + 1)),
+					   _mm_loadu_si128 ((const __m128i *)(b + 1)));
+
+	    if ((_mm_movemask_epi8 (_mm_and_si128 (eq0, eq1)) & 0x0f0f) != 0x0f0f)
+		return FALSE;
+	}
+    }
+#endif
+
+    for (; n; n--, a++, b++)
+    {
+	if (a->x1 != b->x1 || a->x2 != b->x2)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Return the first box after r that is not in the same band */
+static force_inline box_type_t *
+pixman_band_end (box_type_t *r, box_type_t *r_end)
+{
+    int y1 = r->y1;
+
+    r++;
+
+#ifdef PIXREGION_SSE2
+    /* Compare the y1 of two 16-bit boxes at once */
+    if (sizeof (box_type_t) == 8)
+    {
+	__m128i vy1 = _mm_set1_epi16 (y1);
+
+	for (; r_end - r >= 2; r += 2)
+	{
+	    int eq = _mm_movemask_epi8 (
+		_mm_cmpeq_epi16 (_mm_loadu_si128 ((const __m128i *)r), vy1));
+
+	    if ((eq & 0x0c0c) != 0x0c0c)
+		return (eq & 0x000c) == 0x000c ? r + 1 : r;
+	}
+    }
+#endif
+
+    while (r != r_end && r->y1 == y1)
+	r++;
+
+    return r;
+}
+
+/* Copy the boxes [r, r_end) to dst, moved to the band y1 - y2 */
+static force_inline void
+pixman_band_copy (box_type_t *      dst,
+		  const box_type_t *r,
+		  const box_type_t *r_end,
+		  int               y1,
+		  int               y2)
+{
+#ifdef PIXREGION_SSE2
+    /* Keep the x lanes of each box and insert y1 and y2 */
+    if (sizeof (box_type_t) == 8)
+    {
+	__m128i xmask = _mm_set_epi16 (0, -1, 0, -1, 0, -1, 0, -1);
+	__m128i y = _mm_set_epi16 (y2, 0, y1, 0, y2, 0, y1, 0);
+
+	for (; r_end - r >= 2; r += 2, dst += 2)
+	{
+	    __m128i b = _mm_loadu_si128 ((const __m128i *)r);
+
+	    critical_if_fail (r[0].x1 < r[0].x2);
+	    critical_if_fail (r[1].x1 < r[1].x2);
+	    _mm_storeu_si128 ((__m128i *)dst,
+			      _mm_or_si128 (_mm_and_si128 (b, xmask), y));
+	}
+    }
+    else if (sizeof (box_type_t) == 16)
+    {
+	__m128i xmask = _mm_set_epi32 (0, -1, 0, -1);
+	__m128i y = _mm_set_epi32 (y2, 0, y1, 0);
+
+	for (; r != r_end; r++, dst++)
+	{
+	    __m128i b = _mm_loadu_si128 ((const __m128i *)r);
+
+	    critical_if_fail (r->x1 < r->x2);
+	    _mm_storeu_si128 ((__m128i *)dst,
+			      _mm_or_si128 (_mm_and_si128 (b, xmask), y));
+	}
+    }
+#endif
+
+    for (; r != r_end; r++, dst++)
+    {
+	critical_if_fail (r->x1 < r->x2);
+	dst->x1 = r->x1;
+	dst->y1 = y1;
+	dst->x2 = r->x2;
+	dst->y2 = y2;
+    }
+}
+
 /*-
  *-----------------------------------------------------------------------
  * pixman_coalesce --
@@ -596,30 +729,20 @@ pixman_coalesce (region_type_t * region,      /* Region to coalesce		 */
      * cover the most area possible. I.e. two boxes in a band must
      * have some horizontal space between them.
      */
-    y2 = cur_box->y2;
-
-    do
-    {
-	if ((prev_box->x1 != cur_box->x1) || (prev_box->x2 != cur_box->x2))
-	    return (cur_start);
-	
-	prev_box++;
-	cur_box++;
-	numRects--;
-    }
-    while (numRects);
+    if (!pixman_bands_match (prev_box, cur_box, numRects))
+	return (cur_start);
 
     /*
      * The bands may be merged, so set the bottom y of each box
      * in the previous band to the bottom y of the current band.
      */
-    numRects = cur_start - prev_start;
+    y2 = cur_box->y2;
     region->data->numRects -= numRects;
 
     do
     {
-	prev_box--;
 	prev_box->y2 = y2;
+	prev_box++;
 	numRects--;
     }
     while (numRects);
@@ -674,13 +797,7 @@ pixman_region_append_non_o (region_type_t * region,
     next_rect = PIXREGION_TOP (region);
     region->data->numRects += new_rects;
 
-    do
-    {
-	critical_if_fail (r->x1 < r->x2);
-	ADDRECT (next_rect, r->x1, y1, r->x2, y2);
-	r++;
-    }
-    while (r != r_end);
+    pixman_band_copy (next_rect, r, r_end, y1, y2);
 
     return TRUE;
 }
@@ -689,10 +806,7 @@ pixman_region_append_non_o (region_type_t * region,
     do								     \
     {								     \
 	ry1 = r->y1;						     \
-	r_band_end = r + 1;					     \
-	while ((r_band_end != r_end) && (r_band_end->y1 == ry1)) {   \
-	    r_band_end++;					     \
-	}							     \
+	r_band_end = pixman_band_end (r, r_end);		     \
     } while (0)
 
 #define APPEND_REGIONS(new_reg, r, r_end)				\
@@ -707,6 +821,69 @@ pixman_region_append_non_o (region_type_t * region,
 	}								\
     } while (0)
 
+/* Bands of one region that end above the next band of the other region
+ * pass through pixman_op unclipped, or are dropped.  Deal with all of
+ * them at once, which turns an operation between a single box and a
+ * region of many boxes into a binary search and a copy of the part that
+ * is not touched.  The source region is already coalesced, so only the
+ * last skipped band can coalesce with what comes next.
+ */
+#define SKIP_BANDS(new_reg, r_band_end, r_end, y, append, prev_band)	\
+    do									\
+    {									\
+	if (r_band_end != r_end && r_band_end->y2 <= y)			\
+	{								\
+	    box_type_t *skip_end = find_box_for_y (r_band_end, r_end, y); \
+	    if (append)							\
+	    {								\
+		box_type_t *last_band = skip_end - 1;			\
+		while (last_band != r_band_end &&			\
+		       (last_band - 1)->y1 == last_band->y1)		\
+		{							\
+		    last_band--;					\
+		}							\
+		prev_band = new_reg->data->numRects +			\
+		    (last_band - r_band_end);				\
+		APPEND_REGIONS (new_reg, r_band_end, skip_end);		\
+	    }								\
+	    r_band_end = skip_end;					\
+	}								\
+    } while (0)
+
+/* In time O(log n), locate the first box whose y2 is greater than y.
+ * Return @end if no such box exists.
+ */
+static box_type_t *
+find_box_for_y (box_type_t *begin, box_type_t *end, int y)
+{
+    box_type_t *mid;
+
+    if (end == begin)
+	return end;
+
+    if (end - begin == 1)
+    {
+	if (begin->y2 > y)
+	    return begin;
+	else
+	    return end;
+    }
+
+    mid = begin + (end - begin) / 2;
+    if (mid->y2 > y)
+    {
+	/* If no box is found in [begin, mid], the function
+	 * will return @mid, which is then known to be the
+	 * correct answer.
+	 */
+	return find_box_for_y (begin, mid, y);
+    }
+    else
+    {
+	return find_box_for_y (mid, end, y);
+    }
+}
+
 /*-
  *-----------------------------------------------------------------------
  * pixman_op --
@@ -813,8 +990,17 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
     }
 
     /* guess at new size */
-    if (numRects > new_size)
+    if ((new_size == 1 && !append_non2) || (numRects == 1 && !append_non1))
+    {
+	/* Only the boxes a single box overlaps can end up in the
+	 * result, don't allocate for the whole other region.
+	 */
+	new_size = 1;
+    }
+    else if (numRects > new_size)
+    {
 	new_size = numRects;
+    }
 
     new_size <<= 1;
 
@@ -896,6 +1082,8 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
                     COALESCE (new_reg, prev_band, cur_band);
 		}
 	    }
+            if (r1->y2 <= r2y1)
+		SKIP_BANDS (new_reg, r1_band_end, r1_end, r2y1, append_non1, prev_band);
             ytop = r2y1;
 	}
         else if (r2y1 < r1y1)
@@ -915,6 +1103,8 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
                     COALESCE (new_reg, prev_band, cur_band);
 		}
 	    }
+            if (r2->y2 <= r1y1)
+		SKIP_BANDS (new_reg, r2_band_end, r2_end, r1y1, append_non2, prev_band);
             ytop = r1y1;
 	}
         else
@@ -1075,6 +1265,29 @@ pixman_set_extents (region_type_t *region)
 
     critical_if_fail (region->extents.y1 < region->extents.y2);
 
+#ifdef PIXREGION_SSE2
+    /* Two 16-bit boxes at a time; the y lanes are computed and ignored */
+    if (sizeof (box_type_t) == 8 && box_end - box >= 2)
+    {
+	__m128i vmin = _mm_loadu_si128 ((const __m128i *)box);
+	__m128i vmax = vmin;
+	int16_t lanes[8];
+
+	for (box += 2; box_end - box >= 1; box += 2)
+	{
+	    __m128i b = _mm_loadu_si128 ((const __m128i *)box);
+
+	    vmin = _mm_min_epi16 (vmin, b);
+	    vmax = _mm_max_epi16 (vmax, b);
+	}
+
+	_mm_storeu_si128 ((__m128i *)lanes, vmin);
+	region->extents.x1 = MIN (lanes[0], lanes[4]);
+	_mm_storeu_si128 ((__m128i *)lanes, vmax);
+	region->extents.x2 = MAX (lanes[2], lanes[6]);
+    }
+#endif
+
     while (box <= box_end)
     {
         if (box->x1 < region->extents.x1)
@@ -1117,11 +1330,48 @@ pixman_region_intersect_o (region_type_t *region,
     int x2;
     box_type_t *        next_rect;
 
-    next_rect = PIXREGION_TOP (region);
-
     critical_if_fail (y1 < y2);
     critical_if_fail (r1 != r1_end && r2 != r2_end);
 
+    /*
+     * A band of a single box, like a clip rectangle, keeps a run of
+     * the other band and clips its ends.
+     */
+    if (r1_end - r1 == 1 || r2_end - r2 == 1)
+    {
+	box_type_t *box = r1, *r = r2, *r_end = r2_end, *run;
+	int n;
+
+	if (r2_end - r2 == 1)
+	{
+	    box = r2;
+	    r = r1;
+	    r_end = r1_end;
+	}
+
+	while (r != r_end && r->x2 <= box->x1)
+	    r++;
+	run = r;
+	while (r != r_end && r->x1 < box->x2)
+	    r++;
+
+	if ((n = r - run))
+	{
+	    if (!pixman_region_append_non_o (region, run, r, y1, y2))
+		return FALSE;
+
+	    next_rect = PIXREGION_TOP (region);
+	    if (next_rect[-n].x1 < box->x1)
+		next_rect[-n].x1 = box->x1;
+	    if (next_rect[-1].x2 > box->x2)
+		next_rect[-1].x2 = box->x2;
+	}
+
+	return TRUE;
+    }
+
+    next_rect = PIXREGION_TOP (region);
+
     do
     {
         x1 = MAX (r1->x1, r2->x1);
@@ -1272,6 +1522,45 @@ pixman_region_union_o (region_type_t *region,
     critical_if_fail (y1 < y2);
     critical_if_fail (r1 != r1_end && r2 != r2_end);
 
+    /*
+     * A band of a single box, like appended damage, leaves the boxes of
+     * the other band on either side of it alone.
+     */
+    if (r1_end - r1 == 1 || r2_end - r2 == 1)
+    {
+	box_type_t *box = r1, *r = r2, *r_end = r2_end, *run = r2;
+
+	if (r2_end - r2 == 1)
+	{
+	    box = r2;
+	    r = run = r1;
+	    r_end = r1_end;
+	}
+
+	while (r != r_end && r->x2 < box->x1)
+	    r++;
+	if (r != run && !pixman_region_append_non_o (region, run, r, y1, y2))
+	    return FALSE;
+
+	x1 = box->x1;
+	x2 = box->x2;
+	if (r != r_end && r->x1 < x1)
+	    x1 = r->x1;
+	while (r != r_end && r->x1 <= x2)
+	{
+	    if (x2 < r->x2)
+		x2 = r->x2;
+	    r++;
+	}
+	next_rect = PIXREGION_TOP (region);
+	NEWRECT (region, next_rect, x1, y1, x2, y2);
+
+	if (r != r_end && !pixman_region_append_non_o (region, r, r_end, y1, y2))
+	    return FALSE;
+
+	return TRUE;
+    }
+
     next_rect = PIXREGION_TOP (region);
 
     /* Start off current rectangle */
@@ -1839,11 +2128,37 @@ pixman_region_subtract_o (region_type_t * region,
     box_type_t *        next_rect;
     int x1;
 
-    x1 = r1->x1;
-
     critical_if_fail (y1 < y2);
     critical_if_fail (r1 != r1_end && r2 != r2_end);
 
+    /*
+     * Subtracting a single box only cuts the minuends it overlaps.
+     */
+    if (r2_end - r2 == 1)
+    {
+	box_type_t *run = r1;
+
+	while (r1 != r1_end && r1->x2 <= r2->x1)
+	    r1++;
+	if (r1 != run && !pixman_region_append_non_o (region, run, r1, y1, y2))
+	    return FALSE;
+
+	next_rect = PIXREGION_TOP (region);
+	for (; r1 != r1_end && r1->x1 < r2->x2; r1++)
+	{
+	    if (r1->x1 < r2->x1)
+		NEWRECT (region, next_rect, r1->x1, y1, r2->x1, y2);
+	    if (r1->x2 > r2->x2)
+		NEWRECT (region, next_rect, r2->x2, y1, r1->x2, y2);
+	}
+
+	if (r1 != r1_end && !pixman_region_append_non_o (region, r1, r1_end, y1, y2))
+	    return FALSE;
+
+	return TRUE;
+    }
+
+    x1 = r1->x1;
     next_rect = PIXREGION_TOP (region);
 
     do
@@ -2062,40 +2377,6 @@ PREFIX (_inverse) (region_type_t *      new_reg,  /* Destination region */
     return TRUE;
 }
 
-/* In time O(log n), locate the first box whose y2 is greater than y.
- * Return @end if no such box exists.
- */
-static box_type_t *
-find_box_for_y (box_type_t *begin, box_type_t *end, int y)
-{
-    box_type_t *mid;
-
-    if (end == begin)
-	return end;
-
-    if (end - begin == 1)
-    {
-	if (begin->y2 > y)
-	    return begin;
-	else
-	    return end;
-    }
-
-    mid = begin + (end - begin) / 2;
-    if (mid->y2 > y)
-    {
-	/* If no box is found in [begin, mid], the function
-	 * will return @mid, which is then known to be the
-	 * correct answer.
-	 */
-	return find_box_for_y (begin, mid, y);
-    }
-    else
-    {
-	return find_box_for_y (mid, end, y);
-    }
-}
-
 /*
  *   rect_in(region, rect)
  *   This routine takes a pointer to a region and a pointer to a box
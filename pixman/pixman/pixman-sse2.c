@@ -35,6 +35,7 @@
 
 #include <xmmintrin.h> /* for _mm_shuffle_pi16 and _MM_SHUFFLE */
 #include <emmintrin.h> /* for SSE2 intrinsics */
+#include <math.h>
 #include "pixman-private.h"
 #include "pixman-combine32.h"
 #include "pixman-inlines.h"
@@ -6430,6 +6431,823 @@ sse2_fetch_a8 (pixman_iter_t *iter, const uint32_t *mask)
     return iter->buffer;
 }
 
+/* Separable convolution of scaled 8888 sources.
+ *
+ * With a scale transform, every destination row samples the same source
+ * columns with the same horizontal phases, and all pixels of a row share
+ * one vertical phase.  So each source row is filtered horizontally once,
+ * for all destination columns, and kept for as long as destination rows
+ * still need it.  A destination row is then a vertical pass over cheight
+ * of those rows.
+ *
+ * Weights are converted to 2.14 so that pmaddwd can apply two taps at a
+ * time, and the horizontally filtered rows are stored as 16 bit values
+ * with CONVOLUTION_ROW_BITS fractional bits, which leaves room for the
+ * overshoot of sharpening kernels.  Because the two passes round
+ * separately, results can be off by one from the C fetcher, which rounds
+ * the product of the two weights instead.
+ */
+#define CONVOLUTION_WEIGHT_BITS		14
+#define CONVOLUTION_ROW_BITS		6
+
+typedef struct
+{
+    int			y;
+    int16_t *		buffer;
+} convolution_row_t;
+
+typedef struct
+{
+    pixman_fixed_t	y;
+    int			y_off;
+    int			y_phase_shift;
+    int			cheight;
+    int			x_pairs;
+    int			y_pairs;
+    int			x_min;
+    int			x_end;
+    uint32_t *		line;
+    int32_t *		x_start;
+    int32_t *		x_weights;
+    int32_t *		x_table;
+    int32_t *		y_table;
+    const int16_t **	row_ptrs;
+    convolution_row_t	rows[1];
+} convolution_info_t;
+
+static int16_t
+convolution_weight (pixman_fixed_t f)
+{
+    int shift = 16 - CONVOLUTION_WEIGHT_BITS;
+
+    f = (f + (1 << (shift - 1))) >> shift;
+
+    return CLIP (f, -32768, 32767);
+}
+
+/* Converts the weights of each phase to pairs of 2.14 values, padding an
+ * odd number of taps with a zero weight.  The rounding error of a phase
+ * goes to its largest tap, so that weights that sum to one still do.
+ */
+static void
+convolution_convert_weights (int32_t *table, const pixman_fixed_t *params,
+			     int n_phases, int n_taps)
+{
+    int p, i;
+
+    for (p = 0; p < n_phases; p++)
+    {
+	const pixman_fixed_t *f = params + p * n_taps;
+	int32_t sum = 0, total = 0;
+	int max = 0;
+	int16_t w[2];
+
+	for (i = 0; i < n_taps; i++)
+	{
+	    sum += f[i];
+	    total += convolution_weight (f[i]);
+	    if (abs (f[i]) > abs (f[max]))
+		max = i;
+	}
+	sum = convolution_weight (sum) - total;
+
+	for (i = 0; i < n_taps; i += 2)
+	{
+	    w[0] = convolution_weight (f[i]) + (i == max ? sum : 0);
+	    w[1] = i + 1 < n_taps ?
+		convolution_weight (f[i + 1]) + (i + 1 == max ? sum : 0) : 0;
+
+	    *table++ = (uint16_t)w[0] | ((uint32_t)(uint16_t)w[1] << 16);
+	}
+    }
+}
+
+/* Fetches the source pixels that the horizontal pass reads from row y,
+ * applying the repeat mode.  Returns NULL for a row that is all zero.
+ */
+static const uint32_t *
+convolution_fetch_line (bits_image_t *image, convolution_info_t *info, int y)
+{
+    pixman_repeat_t repeat_mode = image->common.repeat;
+    uint32_t alpha = PIXMAN_FORMAT_A (image->format) ? 0 : 0xff000000;
+    int width = image->width;
+    const uint32_t *row;
+    uint32_t *d = info->line;
+    int x, x0, x1;
+
+    if (!repeat (repeat_mode, &y, image->height))
+	return NULL;
+
+    row = image->bits + y * image->rowstride;
+
+    if (!alpha && info->x_min >= 0 && info->x_end <= width)
+	return row + info->x_min;
+
+    /* [x0, x1) is the part of the span inside the image, which may be
+     * empty and lie at either end of the span when it misses the image
+     */
+    x0 = CLIP (0, info->x_min, info->x_end);
+    x1 = CLIP (width, x0, info->x_end);
+
+    for (x = info->x_min; x < x0; x++)
+    {
+	int rx = x;
+
+	*d++ = repeat (repeat_mode, &rx, width) ? row[rx] | alpha : 0;
+    }
+
+    for (; x < x1; x++)
+	*d++ = row[x] | alpha;
+
+    for (; x < info->x_end; x++)
+    {
+	int rx = x;
+
+	*d++ = repeat (repeat_mode, &rx, width) ? row[rx] | alpha : 0;
+    }
+
+    return info->line;
+}
+
+static void
+convolution_filter_row (pixman_iter_t *iter, convolution_info_t *info,
+			int16_t *dst, int y)
+{
+    const uint32_t *src = convolution_fetch_line (&iter->image->bits, info, y);
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i round = _mm_set1_epi32 (
+	1 << (CONVOLUTION_WEIGHT_BITS - CONVOLUTION_ROW_BITS - 1));
+    int k, j;
+
+    if (!src)
+    {
+	memset (dst, 0, ((iter->width + 1) & ~1) * 4 * sizeof (int16_t));
+	return;
+    }
+
+    for (k = 0; k < iter->width; k += 2)
+    {
+	__m128i acc[2];
+	int n;
+
+	for (n = 0; n < 2; n++)
+	{
+	    const uint32_t *s = src + info->x_start[k + n];
+	    const int32_t *w = info->x_table + info->x_weights[k + n];
+
+	    acc[n] = round;
+
+	    for (j = 0; j < info->x_pairs; j++)
+	    {
+		__m128i p = _mm_unpacklo_epi8 (
+		    _mm_loadl_epi64 ((__m128i *)(s + 2 * j)), zero);
+
+		/* p: b0 b1 g0 g1 r0 r1 a0 a1 */
+		p = _mm_unpacklo_epi16 (p, _mm_srli_si128 (p, 8));
+
+		acc[n] = _mm_add_epi32 (
+		    acc[n], _mm_madd_epi16 (p, _mm_set1_epi32 (w[j])));
+	    }
+
+	    acc[n] = _mm_srai_epi32 (
+		acc[n], CONVOLUTION_WEIGHT_BITS - CONVOLUTION_ROW_BITS);
+	}
+
+	_mm_store_si128 ((__m128i *)(dst + 4 * k),
+			 _mm_packs_epi32 (acc[0], acc[1]));
+    }
+}
+
+static uint32_t *
+sse2_fetch_separable_convolution (pixman_iter_t *iter, const uint32_t *mask)
+{
+    convolution_info_t *info = iter->data;
+    int shift = info->y_phase_shift;
+    __m128i round = _mm_set1_epi32 (
+	1 << (CONVOLUTION_WEIGHT_BITS + CONVOLUTION_ROW_BITS - 1));
+    const int16_t **rows = info->row_ptrs;
+    const int32_t *w;
+    uint32_t *b = iter->buffer;
+    pixman_fixed_t y;
+    int y1, i, k;
+
+    /* Round to the middle of the phase, as the C fetcher does */
+    y = ((info->y >> shift) << shift) + ((1 << shift) >> 1);
+    y1 = pixman_fixed_to_int (y - pixman_fixed_e - info->y_off);
+    w = info->y_table + ((y & 0xffff) >> shift) * info->y_pairs;
+
+    for (i = 0; i < info->cheight; i++)
+    {
+	int ry = y1 + i;
+	convolution_row_t *row = &info->rows[MOD (ry, info->cheight)];
+
+	if (row->y != ry)
+	{
+	    convolution_filter_row (iter, info, row->buffer, ry);
+	    row->y = ry;
+	}
+
+	rows[i] = row->buffer;
+    }
+    rows[i] = rows[i - 1];
+
+    for (k = 0; k < iter->width; k += 2)
+    {
+	__m128i lo = round, hi = round;
+	__m128i p;
+
+	for (i = 0; i < info->y_pairs; i++)
+	{
+	    __m128i t = _mm_load_si128 ((__m128i *)(rows[2 * i] + 4 * k));
+	    __m128i u = _mm_load_si128 ((__m128i *)(rows[2 * i + 1] + 4 * k));
+	    __m128i vw = _mm_set1_epi32 (w[i]);
+
+	    lo = _mm_add_epi32 (lo, _mm_madd_epi16 (_mm_unpacklo_epi16 (t, u), vw));
+	    hi = _mm_add_epi32 (hi, _mm_madd_epi16 (_mm_unpackhi_epi16 (t, u), vw));
+	}
+
+	lo = _mm_srai_epi32 (lo, CONVOLUTION_WEIGHT_BITS + CONVOLUTION_ROW_BITS);
+	hi = _mm_srai_epi32 (hi, CONVOLUTION_WEIGHT_BITS + CONVOLUTION_ROW_BITS);
+	p = _mm_packs_epi32 (lo, hi);
+	p = _mm_packus_epi16 (p, p);
+
+	if (iter->width - k == 1)
+	    b[k] = _mm_cvtsi128_si32 (p);
+	else
+	    _mm_storel_epi64 ((__m128i *)(b + k), p);
+    }
+
+    info->y += iter->image->common.transform->matrix[1][1];
+
+    return iter->buffer;
+}
+
+static void
+sse2_separable_convolution_iter_fini (pixman_iter_t *iter)
+{
+    free (iter->data);
+}
+
+#define ALIGN(addr)							\
+    ((void *)((((uintptr_t)(addr)) + 15) & (~15)))
+
+static void
+sse2_separable_convolution_iter_init (pixman_iter_t *iter,
+				      const pixman_iter_info_t *iter_info)
+{
+    pixman_image_t *image = iter->image;
+    pixman_fixed_t *params = image->common.filter_params;
+    int cwidth = pixman_fixed_to_int (params[0]);
+    int cheight = pixman_fixed_to_int (params[1]);
+    int x_phase_bits = pixman_fixed_to_int (params[2]);
+    int y_phase_bits = pixman_fixed_to_int (params[3]);
+    int x_phase_shift = 16 - x_phase_bits;
+    int x_off = ((cwidth << 16) - pixman_fixed_1) >> 1;
+    int x_pairs = (cwidth + 1) / 2;
+    int y_pairs = (cheight + 1) / 2;
+    int width = iter->width;
+    int padded = (width + 1) & ~1;
+    int x_min = INT32_MAX, x_end = INT32_MIN;
+    convolution_info_t *info;
+    pixman_fixed_t ux, vx;
+    pixman_vector_t v;
+    uint8_t *p;
+    size_t size;
+    int i, k;
+
+    /* Reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	goto fail;
+
+    ux = image->common.transform->matrix[0][0];
+
+#define CONVOLUTION_X1(vx)						\
+    pixman_fixed_to_int (						\
+	(((vx) >> x_phase_shift) << x_phase_shift) +			\
+	((1 << x_phase_shift) >> 1) - pixman_fixed_e - x_off)
+
+    for (k = 0, vx = v.vector[0]; k < width; k++, vx += ux)
+    {
+	int x1 = CONVOLUTION_X1 (vx);
+
+	x_min = MIN (x_min, x1);
+	x_end = MAX (x_end, x1 + 2 * x_pairs);
+    }
+
+    if (width <= 0)
+	x_min = x_end = 0;
+
+    size = sizeof (convolution_info_t) +
+	(cheight - 1) * sizeof (convolution_row_t) +
+	(cheight + 1) * sizeof (int16_t *) +
+	2 * padded * sizeof (int32_t) +
+	((1 << x_phase_bits) * x_pairs + (1 << y_phase_bits) * y_pairs) * sizeof (int32_t) +
+	(x_end - x_min) * sizeof (uint32_t) +
+	cheight * (padded * 4 * sizeof (int16_t) + 16);
+
+    info = malloc (size);
+    if (!info)
+	goto fail;
+
+    p = (uint8_t *)&info->rows[cheight];
+    info->row_ptrs = (const int16_t **)p;
+    p += (cheight + 1) * sizeof (int16_t *);
+    info->x_start = (int32_t *)p;
+    p += padded * sizeof (int32_t);
+    info->x_weights = (int32_t *)p;
+    p += padded * sizeof (int32_t);
+    info->x_table = (int32_t *)p;
+    p += (1 << x_phase_bits) * x_pairs * sizeof (int32_t);
+    info->y_table = (int32_t *)p;
+    p += (1 << y_phase_bits) * y_pairs * sizeof (int32_t);
+    info->line = (uint32_t *)p;
+    p += (x_end - x_min) * sizeof (uint32_t);
+
+    for (i = 0; i < cheight; i++)
+    {
+	info->rows[i].y = INT32_MIN;
+	info->rows[i].buffer = ALIGN (p);
+	p = (uint8_t *)(info->rows[i].buffer + padded * 4);
+    }
+
+    for (k = 0, vx = v.vector[0]; k < width; k++, vx += ux)
+    {
+	info->x_start[k] = CONVOLUTION_X1 (vx) - x_min;
+	info->x_weights[k] = ((vx & 0xffff) >> x_phase_shift) * x_pairs;
+    }
+
+    /* The odd pixel at the end is filtered like its neighbour */
+    if (width & 1)
+    {
+	info->x_start[width] = info->x_start[width - 1];
+	info->x_weights[width] = info->x_weights[width - 1];
+    }
+
+#undef CONVOLUTION_X1
+
+    convolution_convert_weights (info->x_table, params + 4,
+				 1 << x_phase_bits, cwidth);
+    convolution_convert_weights (info->y_table,
+				 params + 4 + (1 << x_phase_bits) * cwidth,
+				 1 << y_phase_bits, cheight);
+
+    info->y = v.vector[1];
+    info->y_off = ((cheight << 16) - pixman_fixed_1) >> 1;
+    info->y_phase_shift = 16 - y_phase_bits;
+    info->cheight = cheight;
+    info->x_pairs = x_pairs;
+    info->y_pairs = y_pairs;
+    info->x_min = x_min;
+    info->x_end = x_end;
+
+    iter->get_scanline = sse2_fetch_separable_convolution;
+    iter->fini = sse2_separable_convolution_iter_fini;
+
+    iter->data = info;
+    return;
+
+fail:
+    /* Something went wrong, either a bad matrix or OOM; in such cases,
+     * we don't guarantee any particular rendering.
+     */
+    _pixman_log_error (
+	FUNC, "Allocation failure or bad matrix, skipping rendering\n");
+
+    iter->get_scanline = _pixman_iter_get_scanline_noop;
+    iter->fini = NULL;
+}
+
+/* Fetchers for linear and radial gradients that have a color lookup
+ * table (see pixman_image_set_gradient_lut_size()).  The gradient
+ * parameter is computed for four pixels at a time the same way the C
+ * fetchers do it, turned into table indices in 32 bits, and the colors
+ * are then read from the table.
+ */
+static force_inline __m128i
+gradient_lut_index_4 (__m128i pos, pixman_repeat_t repeat, __m128i shift)
+{
+    const __m128i mask_ffff = _mm_set1_epi32 (0xffff);
+    const __m128i mask_10000 = _mm_set1_epi32 (0x10000);
+    __m128i f, m;
+
+    switch (repeat)
+    {
+    case PIXMAN_REPEAT_NORMAL:
+	return _mm_srl_epi32 (_mm_and_si128 (pos, mask_ffff), shift);
+
+    case PIXMAN_REPEAT_REFLECT:
+	f = _mm_and_si128 (pos, mask_ffff);
+	m = _mm_cmpeq_epi32 (_mm_and_si128 (pos, mask_10000), mask_10000);
+	f = _mm_xor_si128 (f, _mm_and_si128 (m, mask_ffff));
+	return _mm_srl_epi32 (f, shift);
+
+    default:
+	pos = _mm_or_si128 (pos, _mm_cmplt_epi32 (pos, _mm_setzero_si128 ()));
+	m = _mm_cmpgt_epi32 (pos, mask_10000);
+	pos = _mm_or_si128 (_mm_andnot_si128 (m, pos),
+			    _mm_and_si128 (m, mask_10000));
+	return _mm_sra_epi32 (pos, shift);
+    }
+}
+
+static force_inline __m128i
+gradient_lut_lookup_4 (const uint32_t *lut, __m128i idx)
+{
+    return _mm_set_epi32 (lut[_mm_cvtsi128_si32 (_mm_shuffle_epi32 (idx, 0xff))],
+			  lut[_mm_cvtsi128_si32 (_mm_shuffle_epi32 (idx, 0xaa))],
+			  lut[_mm_cvtsi128_si32 (_mm_shuffle_epi32 (idx, 0x55))],
+			  lut[_mm_cvtsi128_si32 (idx)]);
+}
+
+static uint32_t *
+sse2_fetch_linear_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    linear_gradient_t *linear = (linear_gradient_t *)image;
+    pixman_repeat_t repeat = image->common.repeat;
+    const uint32_t *lut = image->gradient.lut;
+    int shift = image->gradient.lut_shift;
+    int width = iter->width;
+    uint32_t *buffer = iter->buffer;
+    pixman_fixed_32_32_t l, t;
+    pixman_fixed_48_16_t dx, dy;
+    pixman_vector_t v, unit;
+    __m128i xmm_shift = _mm_cvtsi32_si128 (shift);
+    __m128i xmm_t;
+    __m128d xmm_inc, xmm_i01, xmm_i23;
+    double inc;
+    int i;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (image->common.transform)
+    {
+	if (!pixman_transform_point_3d (image->common.transform, &v))
+	    return buffer;
+
+	unit.vector[0] = image->common.transform->matrix[0][0];
+	unit.vector[1] = image->common.transform->matrix[1][0];
+    }
+    else
+    {
+	unit.vector[0] = pixman_fixed_1;
+	unit.vector[1] = 0;
+    }
+
+    dx = linear->p2.x - linear->p1.x;
+    dy = linear->p2.y - linear->p1.y;
+
+    l = dx * dx + dy * dy;
+
+    if (l == 0)
+    {
+	t = 0;
+	inc = 0;
+    }
+    else
+    {
+	double invden, v2;
+
+	invden = pixman_fixed_1 * (double) pixman_fixed_1 /
+	    (l * (double) v.vector[2]);
+	v2 = v.vector[2] * (1. / pixman_fixed_1);
+	t = ((dx * v.vector[0] + dy * v.vector[1]) -
+	     (dx * linear->p1.x + dy * linear->p1.y) * v2) * invden;
+	inc = (dx * unit.vector[0] + dy * unit.vector[1]) * invden;
+    }
+
+    /* The repeating modes only look at the low 17 bits of the position,
+     * and pad or none only need it clamped to [-1, 1], so as long as the
+     * increments fit the positions can be computed in 32 bits.
+     */
+    if (repeat == PIXMAN_REPEAT_NORMAL || repeat == PIXMAN_REPEAT_REFLECT)
+	t &= 0x1ffff;
+    else if (t < -(1 << 30) || t > (1 << 30))
+	width = 0;
+
+    if (inc * width < -(1 << 30) || inc * width > (1 << 30))
+	width = 0;
+
+    xmm_t = _mm_set1_epi32 ((int32_t)t);
+    xmm_inc = _mm_set1_pd (inc);
+    xmm_i01 = _mm_set_pd (1., 0.);
+    xmm_i23 = _mm_set_pd (3., 2.);
+
+    for (i = 0; i + 4 <= width; i += 4)
+    {
+	__m128i pos = _mm_unpacklo_epi64 (
+	    _mm_cvttpd_epi32 (_mm_mul_pd (xmm_i01, xmm_inc)),
+	    _mm_cvttpd_epi32 (_mm_mul_pd (xmm_i23, xmm_inc)));
+
+	pos = _mm_add_epi32 (pos, xmm_t);
+
+	_mm_storeu_si128 ((__m128i *)(buffer + i), gradient_lut_lookup_4 (
+			      lut, gradient_lut_index_4 (pos, repeat, xmm_shift)));
+
+	xmm_i01 = _mm_add_pd (xmm_i01, _mm_set1_pd (4.));
+	xmm_i23 = _mm_add_pd (xmm_i23, _mm_set1_pd (4.));
+    }
+
+    for (; i < iter->width; ++i)
+    {
+	buffer[i] = lut[_pixman_gradient_lut_index (
+		repeat, shift, t + (pixman_fixed_32_32_t)(inc * i))];
+    }
+
+    iter->y++;
+
+    return buffer;
+}
+
+/* Returns the color of a radial gradient pixel, following
+ * radial_write_color() in pixman-radial-gradient.c for a != 0.
+ */
+static uint32_t
+radial_lut_pixel (const radial_gradient_t *radial,
+		  pixman_repeat_t          repeat,
+		  double                   b,
+		  double                   c)
+{
+    const uint32_t *lut = radial->common.lut;
+    int shift = radial->common.lut_shift;
+    double discr = b * b - radial->a * c;
+
+    if (discr >= 0)
+    {
+	double sqrtdiscr = sqrt (discr);
+	double t0 = (b + sqrtdiscr) * radial->inva;
+	double t1 = (b - sqrtdiscr) * radial->inva;
+	double dr = radial->delta.radius;
+
+	if (repeat == PIXMAN_REPEAT_NONE)
+	{
+	    if (0 <= t0 && t0 <= pixman_fixed_1)
+		return lut[_pixman_gradient_lut_index (repeat, shift, t0)];
+	    else if (0 <= t1 && t1 <= pixman_fixed_1)
+		return lut[_pixman_gradient_lut_index (repeat, shift, t1)];
+	}
+	else
+	{
+	    if (t0 * dr >= radial->mindr)
+		return lut[_pixman_gradient_lut_index (repeat, shift, t0)];
+	    else if (t1 * dr >= radial->mindr)
+		return lut[_pixman_gradient_lut_index (repeat, shift, t1)];
+	}
+    }
+
+    return 0;
+}
+
+/* Computes the gradient parameters of two pixels in the low half of the
+ * result, following radial_lut_pixel().  Pixels without one are marked
+ * in valid and get 0.  big is set when a parameter does not fit in 32
+ * bits for the repeating modes.
+ */
+static force_inline __m128i
+radial_parameter_2 (const radial_gradient_t *radial,
+		    pixman_repeat_t          repeat,
+		    __m128d                  b,
+		    __m128d                  c,
+		    __m128i                 *valid,
+		    int                     *big)
+{
+    __m128d zero = _mm_setzero_pd ();
+    __m128d discr, sqrtdiscr, t0, t1, ok0, ok1, t;
+
+    discr = _mm_sub_pd (_mm_mul_pd (b, b),
+			_mm_mul_pd (_mm_set1_pd (radial->a), c));
+    sqrtdiscr = _mm_sqrt_pd (_mm_max_pd (discr, zero));
+    t0 = _mm_mul_pd (_mm_add_pd (b, sqrtdiscr), _mm_set1_pd (radial->inva));
+    t1 = _mm_mul_pd (_mm_sub_pd (b, sqrtdiscr), _mm_set1_pd (radial->inva));
+
+    if (repeat == PIXMAN_REPEAT_NONE)
+    {
+	__m128d one = _mm_set1_pd (pixman_fixed_1);
+
+	ok0 = _mm_and_pd (_mm_cmple_pd (zero, t0), _mm_cmple_pd (t0, one));
+	ok1 = _mm_and_pd (_mm_cmple_pd (zero, t1), _mm_cmple_pd (t1, one));
+    }
+    else
+    {
+	__m128d dr = _mm_set1_pd (radial->delta.radius);
+	__m128d mindr = _mm_set1_pd (radial->mindr);
+
+	ok0 = _mm_cmpge_pd (_mm_mul_pd (t0, dr), mindr);
+	ok1 = _mm_cmpge_pd (_mm_mul_pd (t1, dr), mindr);
+    }
+
+    t = _mm_or_pd (_mm_and_pd (ok0, t0), _mm_andnot_pd (ok0, t1));
+    ok1 = _mm_and_pd (_mm_or_pd (ok0, ok1), _mm_cmpge_pd (discr, zero));
+
+    if (repeat == PIXMAN_REPEAT_NORMAL || repeat == PIXMAN_REPEAT_REFLECT)
+    {
+	__m128d abs = _mm_castsi128_pd (
+	    _mm_set_epi32 (0x7fffffff, -1, 0x7fffffff, -1));
+
+	*big |= _mm_movemask_pd (
+	    _mm_and_pd (ok1, _mm_cmpge_pd (_mm_and_pd (t, abs),
+					   _mm_set1_pd (2147483647.))));
+    }
+    else if (repeat == PIXMAN_REPEAT_PAD)
+    {
+	t = _mm_min_pd (_mm_max_pd (t, _mm_set1_pd (-pixman_fixed_1)),
+			_mm_set1_pd (2 * pixman_fixed_1));
+    }
+
+    *valid = _mm_shuffle_epi32 (_mm_castpd_si128 (ok1), _MM_SHUFFLE (2, 0, 2, 0));
+
+    return _mm_cvttpd_epi32 (_mm_and_pd (ok1, t));
+}
+
+static uint32_t *
+sse2_fetch_radial_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    radial_gradient_t *radial = (radial_gradient_t *)image;
+    pixman_repeat_t repeat = image->common.repeat;
+    const uint32_t *lut = image->gradient.lut;
+    int width = iter->width;
+    uint32_t *buffer = iter->buffer;
+    pixman_fixed_32_32_t b, db, c, dc, ddc;
+    pixman_vector_t v, unit;
+    double w = width;
+    int i = 0;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (image->common.transform)
+    {
+	if (!pixman_transform_point_3d (image->common.transform, &v))
+	    return buffer;
+
+	unit.vector[0] = image->common.transform->matrix[0][0];
+	unit.vector[1] = image->common.transform->matrix[1][0];
+    }
+    else
+    {
+	unit.vector[0] = pixman_fixed_1;
+	unit.vector[1] = 0;
+    }
+
+    /* B and C are computed exactly, as in radial_get_scanline() */
+    v.vector[0] -= radial->c1.x;
+    v.vector[1] -= radial->c1.y;
+
+    b = (pixman_fixed_48_16_t)v.vector[0] * radial->delta.x +
+	(pixman_fixed_48_16_t)v.vector[1] * radial->delta.y +
+	(pixman_fixed_48_16_t)radial->c1.radius * radial->delta.radius;
+    db = (pixman_fixed_48_16_t)unit.vector[0] * radial->delta.x +
+	(pixman_fixed_48_16_t)unit.vector[1] * radial->delta.y;
+
+    c = (pixman_fixed_48_16_t)v.vector[0] * v.vector[0] +
+	(pixman_fixed_48_16_t)v.vector[1] * v.vector[1] -
+	(pixman_fixed_48_16_t)radial->c1.radius * radial->c1.radius;
+    dc = (2 * (pixman_fixed_48_16_t)v.vector[0] + unit.vector[0]) * unit.vector[0] +
+	(2 * (pixman_fixed_48_16_t)v.vector[1] + unit.vector[1]) * unit.vector[1];
+    ddc = 2 * ((pixman_fixed_48_16_t)unit.vector[0] * unit.vector[0] +
+	       (pixman_fixed_48_16_t)unit.vector[1] * unit.vector[1]);
+
+    /* The vector loop steps B and C in doubles, which stays exact as
+     * long as they are integers well below 2^53.
+     */
+    if (fabs ((double)b) + w * fabs ((double)db) < 1125899906842624.	&&
+	fabs ((double)c) + w * fabs ((double)dc) +
+	w * w * fabs ((double)ddc) < 1125899906842624.)
+    {
+	__m128i xmm_shift = _mm_cvtsi32_si128 (image->gradient.lut_shift);
+	__m128d xmm_b01 = _mm_set_pd ((double)(b + db), (double)b);
+	__m128d xmm_b23 = _mm_set_pd ((double)(b + 3 * db), (double)(b + 2 * db));
+	__m128d xmm_c01 = _mm_set_pd ((double)(c + dc), (double)c);
+	__m128d xmm_c23 = _mm_set_pd ((double)(c + 3 * dc + 3 * ddc),
+				      (double)(c + 2 * dc + ddc));
+	__m128d xmm_dc01 = _mm_set_pd ((double)(dc + ddc), (double)dc);
+	__m128d xmm_dc23 = _mm_set_pd ((double)(dc + 3 * ddc), (double)(dc + 2 * ddc));
+	__m128d xmm_db4 = _mm_set1_pd ((double)(4 * db));
+	__m128d xmm_ddc4 = _mm_set1_pd ((double)(4 * ddc));
+	__m128d xmm_ddc6 = _mm_set1_pd ((double)(6 * ddc));
+	__m128d xmm_4 = _mm_set1_pd (4.);
+	int n = width & ~3;
+
+	for (; i < n; i += 4)
+	{
+	    __m128i pos01, pos23, valid01, valid23, pixels;
+	    int big = 0;
+
+	    pos01 = radial_parameter_2 (radial, repeat, xmm_b01, xmm_c01,
+					&valid01, &big);
+	    pos23 = radial_parameter_2 (radial, repeat, xmm_b23, xmm_c23,
+					&valid23, &big);
+
+	    if (big)
+	    {
+		double bb[4], cc[4];
+		int k;
+
+		/* A parameter does not fit in 32 bits */
+		_mm_storeu_pd (bb, xmm_b01);
+		_mm_storeu_pd (bb + 2, xmm_b23);
+		_mm_storeu_pd (cc, xmm_c01);
+		_mm_storeu_pd (cc + 2, xmm_c23);
+
+		for (k = 0; k < 4; ++k)
+		    buffer[i + k] = radial_lut_pixel (radial, repeat, bb[k], cc[k]);
+	    }
+	    else
+	    {
+		pixels = gradient_lut_lookup_4 (
+		    lut, gradient_lut_index_4 (_mm_unpacklo_epi64 (pos01, pos23),
+					       repeat, xmm_shift));
+
+		_mm_storeu_si128 ((__m128i *)(buffer + i),
+				  _mm_and_si128 (pixels,
+						 _mm_unpacklo_epi64 (valid01, valid23)));
+	    }
+
+	    xmm_b01 = _mm_add_pd (xmm_b01, xmm_db4);
+	    xmm_b23 = _mm_add_pd (xmm_b23, xmm_db4);
+	    xmm_c01 = _mm_add_pd (xmm_c01, _mm_add_pd (
+				      _mm_mul_pd (xmm_dc01, xmm_4), xmm_ddc6));
+	    xmm_c23 = _mm_add_pd (xmm_c23, _mm_add_pd (
+				      _mm_mul_pd (xmm_dc23, xmm_4), xmm_ddc6));
+	    xmm_dc01 = _mm_add_pd (xmm_dc01, xmm_ddc4);
+	    xmm_dc23 = _mm_add_pd (xmm_dc23, xmm_ddc4);
+	}
+
+	b += n * db;
+	c += n * dc + (pixman_fixed_32_32_t)n * (n - 1) / 2 * ddc;
+	dc += n * ddc;
+    }
+
+    for (; i < width; ++i)
+    {
+	buffer[i] = radial_lut_pixel (radial, repeat, b, c);
+
+	b += db;
+	c += dc;
+	dc += ddc;
+    }
+
+    iter->y++;
+
+    return buffer;
+}
+
+static void
+sse2_gradient_lut_iter_init (pixman_iter_t *iter,
+			     const pixman_iter_info_t *iter_info)
+{
+    pixman_image_t *image = iter->image;
+
+    if (image->type == LINEAR)
+    {
+	/* The C setup takes care of gradients that are constant
+	 * along the scanline.
+	 */
+	_pixman_linear_gradient_iter_init (image, iter);
+
+	if (image->gradient.lut &&
+	    iter->get_scanline != _pixman_iter_get_scanline_noop)
+	{
+	    iter->get_scanline = sse2_fetch_linear_gradient;
+	}
+    }
+    else if (image->type == RADIAL)
+    {
+	_pixman_radial_gradient_iter_init (image, iter);
+
+	if (image->gradient.lut && image->radial.a != 0)
+	    iter->get_scanline = sse2_fetch_radial_gradient;
+    }
+    else
+    {
+	/* Conical gradients have no SSE2 fetcher, the C one reads
+	 * the table.
+	 */
+	_pixman_conical_gradient_iter_init (image, iter);
+    }
+}
+
+#define GRADIENT_LUT_FLAGS						\
+    (FAST_PATH_GRADIENT_LUT | FAST_PATH_AFFINE_TRANSFORM)
+
+#define SEPARABLE_CONVOLUTION_FLAGS					\
+    (FAST_PATH_NO_ALPHA_MAP			|			\
+     FAST_PATH_NO_ACCESSORS			|			\
+     FAST_PATH_HAS_TRANSFORM			|			\
+     FAST_PATH_AFFINE_TRANSFORM			|			\
+     FAST_PATH_SCALE_TRANSFORM			|			\
+     FAST_PATH_SEPARABLE_CONVOLUTION_FILTER)
+
 #define IMAGE_FLAGS							\
     (FAST_PATH_STANDARD_FLAGS | FAST_PATH_ID_TRANSFORM |		\
      FAST_PATH_BITS_IMAGE | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
@@ -6445,6 +7263,15 @@ static const pixman_iter_info_t sse2_iters[] =
     { PIXMAN_a8, IMAGE_FLAGS, ITER_NARROW,
       _pixman_iter_init_bits_stride, sse2_fetch_a8, NULL
     },
+    { PIXMAN_a8r8g8b8, SEPARABLE_CONVOLUTION_FLAGS, ITER_NARROW | ITER_SRC,
+      sse2_separable_convolution_iter_init, NULL, NULL
+    },
+    { PIXMAN_x8r8g8b8, SEPARABLE_CONVOLUTION_FLAGS, ITER_NARROW | ITER_SRC,
+      sse2_separable_convolution_iter_init, NULL, NULL
+    },
+    { PIXMAN_any, GRADIENT_LUT_FLAGS, ITER_NARROW | ITER_SRC,
+      sse2_gradient_lut_iter_init, NULL, NULL
+    },
     { PIXMAN_null },
 };
 
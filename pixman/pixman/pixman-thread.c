@@ -0,0 +1,299 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <pixman-config.h>
+#endif
+
+#include <stdlib.h>
+#include "pixman-private.h"
+
+/* The worker threads that pixman_image_composite32() hands stripes of
+ * large composites to.  There is a single job slot: a composite that
+ * finds it taken, because another application thread is using the pool,
+ * simply runs on its own thread.  The submitting thread works on the
+ * job too, so n_threads counts it.  Workers are started when the count
+ * is raised and are never stopped; lowering the count only idles them.
+ */
+
+#define MAX_THREADS 64
+
+#if defined (HAVE_PTHREADS)
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_mutex_t pool_mutex_t;
+typedef pthread_cond_t pool_cond_t;
+
+#define POOL_MUTEX_INIT		PTHREAD_MUTEX_INITIALIZER
+#define POOL_COND_INIT		PTHREAD_COND_INITIALIZER
+#define pool_lock(m)		pthread_mutex_lock (m)
+#define pool_unlock(m)		pthread_mutex_unlock (m)
+#define pool_wait(c, m)		pthread_cond_wait (c, m)
+#define pool_signal(c)		pthread_cond_signal (c)
+#define pool_broadcast(c)	pthread_cond_broadcast (c)
+
+#elif defined (_WIN32)
+
+#define _NO_W32_PSEUDO_MODIFIERS
+#include <windows.h>
+#ifdef IN
+#undef IN
+#endif
+
+typedef SRWLOCK pool_mutex_t;
+typedef CONDITION_VARIABLE pool_cond_t;
+
+#define POOL_MUTEX_INIT		SRWLOCK_INIT
+#define POOL_COND_INIT		CONDITION_VARIABLE_INIT
+#define pool_lock(m)		AcquireSRWLockExclusive (m)
+#define pool_unlock(m)		ReleaseSRWLockExclusive (m)
+#define pool_wait(c, m)		SleepConditionVariableSRW (c, m, INFINITE, 0)
+#define pool_signal(c)		WakeConditionVariable (c)
+#define pool_broadcast(c)	WakeAllConditionVariable (c)
+
+#endif
+
+#if defined (HAVE_PTHREADS) || defined (_WIN32)
+
+static struct
+{
+    pool_mutex_t	mutex;
+    pool_cond_t		work;
+    pool_cond_t		done;
+
+    int			n_threads;
+    int			n_workers;
+    pixman_bool_t	busy;
+
+    /* The current job, protected by mutex */
+    unsigned int	generation;
+    pixman_thread_func_t func;
+    void *		data;
+    int			n_items;
+    int			next;
+    int			n_done;
+} pool = { POOL_MUTEX_INIT, POOL_COND_INIT, POOL_COND_INIT, 1 };
+
+/* Runs items of the current job until there are none left.  Called and
+ * returns with the mutex held.
+ */
+static void
+run_items (void)
+{
+    while (pool.next < pool.n_items)
+    {
+	pixman_thread_func_t func = pool.func;
+	void *data = pool.data;
+	int i = pool.next++;
+
+	pool_unlock (&pool.mutex);
+	func (data, i);
+	pool_lock (&pool.mutex);
+
+	if (++pool.n_done == pool.n_items)
+	    pool_signal (&pool.done);
+    }
+}
+
+static void
+worker_main (int index)
+{
+    unsigned int seen = 0;
+
+    pool_lock (&pool.mutex);
+    for (;;)
+    {
+	while (pool.generation == seen || index >= pool.n_threads - 1)
+	{
+	    seen = pool.generation;
+	    pool_wait (&pool.work, &pool.mutex);
+	}
+	seen = pool.generation;
+
+	run_items ();
+    }
+}
+
+#ifdef HAVE_PTHREADS
+
+static void *
+worker_thread (void *data)
+{
+    worker_main ((int)(intptr_t)data);
+    return NULL;
+}
+
+static pixman_bool_t
+start_worker (int index)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    int ret;
+
+    pthread_attr_init (&attr);
+    pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+    ret = pthread_create (&thread, &attr, worker_thread, (void *)(intptr_t)index);
+    pthread_attr_destroy (&attr);
+
+    return ret == 0;
+}
+
+static int
+n_processors (void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+
+    if (n > 0)
+	return n;
+#endif
+    return 1;
+}
+
+#else
+
+static DWORD WINAPI
+worker_thread (LPVOID data)
+{
+    worker_main ((int)(intptr_t)data);
+    return 0;
+}
+
+static pixman_bool_t
+start_worker (int index)
+{
+    HANDLE thread = CreateThread (NULL, 0, worker_thread,
+				  (LPVOID)(intptr_t)index, 0, NULL);
+
+    if (!thread)
+	return FALSE;
+
+    CloseHandle (thread);
+    return TRUE;
+}
+
+static int
+n_processors (void)
+{
+    SYSTEM_INFO info;
+
+    GetSystemInfo (&info);
+
+    return info.dwNumberOfProcessors;
+}
+
+#endif
+
+int
+_pixman_threads_get_count (void)
+{
+    return pool.n_threads;
+}
+
+pixman_bool_t
+_pixman_threads_run (pixman_thread_func_t func, void *data, int n_items)
+{
+    if (n_items < 2 || pool.n_threads < 2)
+	return FALSE;
+
+    pool_lock (&pool.mutex);
+
+    if (pool.busy)
+    {
+	pool_unlock (&pool.mutex);
+	return FALSE;
+    }
+
+    pool.busy = TRUE;
+    pool.func = func;
+    pool.data = data;
+    pool.n_items = n_items;
+    pool.next = 0;
+    pool.n_done = 0;
+    pool.generation++;
+    pool_broadcast (&pool.work);
+
+    run_items ();
+
+    while (pool.n_done < pool.n_items)
+	pool_wait (&pool.done, &pool.mutex);
+
+    pool.busy = FALSE;
+    pool_unlock (&pool.mutex);
+
+    return TRUE;
+}
+
+PIXMAN_EXPORT pixman_bool_t
+pixman_image_composite_set_threads (int n_threads)
+{
+    pixman_bool_t ret = TRUE;
+
+    if (n_threads <= 0)
+	n_threads = n_processors ();
+    if (n_threads > MAX_THREADS)
+	n_threads = MAX_THREADS;
+
+    pool_lock (&pool.mutex);
+
+    while (pool.n_workers < n_threads - 1)
+    {
+	if (!start_worker (pool.n_workers))
+	{
+	    ret = FALSE;
+	    break;
+	}
+	pool.n_workers++;
+    }
+
+    pool.n_threads = pool.n_workers + 1 < n_threads ?
+	pool.n_workers + 1 : n_threads;
+
+    pool_unlock (&pool.mutex);
+
+    return ret;
+}
+
+#else
+
+int
+_pixman_threads_get_count (void)
+{
+    return 1;
+}
+
+pixman_bool_t
+_pixman_threads_run (pixman_thread_func_t func, void *data, int n_items)
+{
+    return FALSE;
+}
+
+PIXMAN_EXPORT pixman_bool_t
+pixman_image_composite_set_threads (int n_threads)
+{
+    return n_threads == 1;
+}
+
+#endif
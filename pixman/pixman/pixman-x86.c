@@ -25,7 +25,8 @@
 
 #include "pixman-private.h"
 
-#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3)
+#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3) || \
+    defined (USE_AVX2)
 
 /* The CPU detection code needs to be in a file not compiled with
  * "-mmmx -msse", as gcc would generate CMOV instructions otherwise
@@ -40,7 +41,8 @@ typedef enum
     X86_SSE			= (1 << 2) | X86_MMX_EXTENSIONS,
     X86_SSE2			= (1 << 3),
     X86_CMOV			= (1 << 4),
-    X86_SSSE3			= (1 << 5)
+    X86_SSSE3			= (1 << 5),
+    X86_AVX2			= (1 << 6)
 } cpu_features_t;
 
 #ifdef HAVE_GETISAX
@@ -69,6 +71,15 @@ detect_cpu_features (void)
 	    features |= X86_SSSE3;
     }
 
+#ifdef AV_386_2_AVX2
+    {
+	uint32_t results[2] = { 0, 0 };
+
+	if (getisax (results, 2) > 1 && (results[1] & AV_386_2_AVX2))
+	    features |= X86_AVX2;
+    }
+#endif
+
     return features;
 }
 
@@ -101,6 +112,40 @@ pixman_cpuid (uint32_t feature,
 #endif
 }
 
+/* AVX2 needs leaf 7, and the OS has to save the ymm registers */
+static pixman_bool_t
+have_avx2 (uint32_t c)
+{
+    uint32_t a, b, d;
+    uint32_t xcr0;
+
+    if ((c & ((1 << 27) | (1 << 28))) != ((1 << 27) | (1 << 28)))
+	return FALSE;
+
+#if defined (__GNUC__)
+    __asm__ (".byte 0x0f, 0x01, 0xd0" : "=a" (xcr0), "=d" (d) : "c" (0));
+#else
+    xcr0 = (uint32_t)_xgetbv (0);
+#endif
+    if ((xcr0 & 6) != 6)
+	return FALSE;
+
+#if defined (__GNUC__)
+    a = b = c = d = 0;
+    if (!__get_cpuid_count (7, 0, &a, &b, &c, &d))
+	return FALSE;
+#else
+    {
+	int info[4];
+
+	__cpuidex (info, 7, 0);
+	b = info[1];
+    }
+#endif
+
+    return (b & (1 << 5)) != 0;
+}
+
 static cpu_features_t
 detect_cpu_features (void)
 {
@@ -119,6 +164,8 @@ detect_cpu_features (void)
 	features |= X86_SSE2;
     if (c & (1 << 9))
 	features |= X86_SSSE3;
+    if (have_avx2 (c))
+	features |= X86_AVX2;
 
     /* Check for AMD specific features */
     if ((features & X86_MMX) && !(features & X86_SSE))
@@ -176,6 +223,7 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 #define MMX_BITS  (X86_MMX | X86_MMX_EXTENSIONS)
 #define SSE2_BITS (X86_MMX | X86_MMX_EXTENSIONS | X86_SSE | X86_SSE2)
 #define SSSE3_BITS (X86_SSE | X86_SSE2 | X86_SSSE3)
+#define AVX2_BITS (X86_SSE | X86_SSE2 | X86_SSSE3 | X86_AVX2)
 
 #ifdef USE_X86_MMX
     if (!_pixman_disabled ("mmx") && have_feature (MMX_BITS))
@@ -192,5 +240,10 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 	imp = _pixman_implementation_create_ssse3 (imp);
 #endif
 
+#ifdef USE_AVX2
+    if (!_pixman_disabled ("avx2") && have_feature (AVX2_BITS))
+	imp = _pixman_implementation_create_avx2 (imp);
+#endif
+
     return imp;
 }
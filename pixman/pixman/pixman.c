@@ -555,6 +555,204 @@ analyze_extent (pixman_image_t       *image,
     return TRUE;
 }
 
+/* Composites covering at least THREAD_MIN_AREA pixels go to the worker
+ * threads, with each box that is that big on its own cut into stripes
+ * of at least THREAD_MIN_STRIPE rows.
+ */
+#define THREAD_MIN_AREA		(256 * 256)
+#define THREAD_MIN_STRIPE	16
+#define N_STACK_STRIPES		64
+
+typedef struct
+{
+    pixman_implementation_t *		imp;
+    pixman_composite_func_t		func;
+    const pixman_composite_info_t *	info;
+    const pixman_box32_t *		stripes;
+    int32_t				src_dx, src_dy;
+    int32_t				mask_dx, mask_dy;
+} composite_job_t;
+
+static void
+composite_stripe (void *data, int index)
+{
+    const composite_job_t *job = data;
+    const pixman_box32_t *box = &job->stripes[index];
+    pixman_composite_info_t info = *job->info;
+
+    info.src_x = box->x1 + job->src_dx;
+    info.src_y = box->y1 + job->src_dy;
+    info.mask_x = box->x1 + job->mask_dx;
+    info.mask_y = box->y1 + job->mask_dy;
+    info.dest_x = box->x1;
+    info.dest_y = box->y1;
+    info.width = box->x2 - box->x1;
+    info.height = box->y2 - box->y1;
+
+    job->func (job->imp, &info);
+}
+
+static int
+box_stripes (const pixman_box32_t *box, int n_threads)
+{
+    int width = box->x2 - box->x1;
+    int height = box->y2 - box->y1;
+    int n = height / THREAD_MIN_STRIPE;
+
+    if ((uint64_t)width * height < THREAD_MIN_AREA || n < 2)
+	return 1;
+
+    return n < 2 * n_threads ? n : 2 * n_threads;
+}
+
+/* The bytes holding the pixels of a bits image; rows may go up */
+static void
+bits_range (const bits_image_t *bits, uintptr_t *start, uintptr_t *end)
+{
+    intptr_t stride = (intptr_t)bits->rowstride * sizeof (uint32_t);
+    intptr_t last = stride * (bits->height - 1);
+
+    *start = (uintptr_t)bits->bits + MIN (0, last);
+    *end = (uintptr_t)bits->bits + MAX (0, last) + (stride < 0 ? -stride : stride);
+}
+
+/* Do the pixels of two bits images share any memory?  Sub-images of one
+ * buffer have different bits pointers, so compare the byte ranges.
+ */
+static pixman_bool_t
+bits_overlap (const bits_image_t *a, const bits_image_t *b)
+{
+    uintptr_t a_start, a_end, b_start, b_end;
+
+    if (!a || !b || !a->bits || !b->bits || a->height <= 0 || b->height <= 0)
+	return FALSE;
+
+    bits_range (a, &a_start, &a_end);
+    bits_range (b, &b_start, &b_end);
+
+    return a_start < b_end && b_start < a_end;
+}
+
+/* Does image, or its alpha map, read memory that compositing to dest, or
+ * to its alpha map, writes?
+ */
+static pixman_bool_t
+image_reads_dest (pixman_image_t *image, pixman_image_t *dest)
+{
+    const bits_image_t *reads[2], *writes[2];
+    int i, j;
+
+    if (!image)
+	return FALSE;
+
+    reads[0] = image->type == BITS ? &image->bits : NULL;
+    reads[1] = image->common.alpha_map;
+    writes[0] = &dest->bits;
+    writes[1] = dest->common.alpha_map;
+
+    for (i = 0; i < 2; i++)
+    {
+	for (j = 0; j < 2; j++)
+	{
+	    if (bits_overlap (reads[i], writes[j]))
+		return TRUE;
+	}
+    }
+
+    return FALSE;
+}
+
+/* Runs the composite on the worker threads if it is big enough and safe
+ * to split.  Accessors may not be reentrant, and the stripes must not
+ * read what another stripe writes.
+ */
+static pixman_bool_t
+composite_threaded (pixman_implementation_t *       imp,
+		    pixman_composite_func_t         func,
+		    const pixman_composite_info_t * info,
+		    const pixman_box32_t *          boxes,
+		    int                             n_boxes,
+		    int32_t                         src_dx,
+		    int32_t                         src_dy,
+		    int32_t                         mask_dx,
+		    int32_t                         mask_dy)
+{
+    pixman_box32_t stack_stripes[N_STACK_STRIPES];
+    pixman_box32_t *stripes = stack_stripes;
+    pixman_image_t *mask = info->mask_image;
+    int n_threads = _pixman_threads_get_count ();
+    uint64_t area = 0;
+    int n_stripes = 0;
+    int i, j, k;
+    composite_job_t job;
+    pixman_bool_t ret;
+
+    if (n_threads < 2)
+	return FALSE;
+
+    if (!(info->src_image->common.flags & FAST_PATH_NO_ACCESSORS)	||
+	(mask && !(mask->common.flags & FAST_PATH_NO_ACCESSORS))	||
+	!(info->dest_image->common.flags & FAST_PATH_NO_ACCESSORS))
+    {
+	return FALSE;
+    }
+
+    if (image_reads_dest (info->src_image, info->dest_image)	||
+	image_reads_dest (mask, info->dest_image)		||
+	bits_overlap (&info->dest_image->bits,
+		      info->dest_image->common.alpha_map))
+    {
+	return FALSE;
+    }
+
+    for (i = 0; i < n_boxes; i++)
+    {
+	area += (uint64_t)(boxes[i].x2 - boxes[i].x1) * (boxes[i].y2 - boxes[i].y1);
+	n_stripes += box_stripes (&boxes[i], n_threads);
+    }
+
+    if (area < THREAD_MIN_AREA || n_stripes < 2)
+	return FALSE;
+
+    if (n_stripes > N_STACK_STRIPES)
+    {
+	stripes = pixman_malloc_ab (n_stripes, sizeof (pixman_box32_t));
+	if (!stripes)
+	    return FALSE;
+    }
+
+    for (i = 0, k = 0; i < n_boxes; i++)
+    {
+	const pixman_box32_t *box = &boxes[i];
+	int height = box->y2 - box->y1;
+	int n = box_stripes (box, n_threads);
+
+	for (j = 0; j < n; j++, k++)
+	{
+	    stripes[k].x1 = box->x1;
+	    stripes[k].x2 = box->x2;
+	    stripes[k].y1 = box->y1 + height * j / n;
+	    stripes[k].y2 = box->y1 + height * (j + 1) / n;
+	}
+    }
+
+    job.imp = imp;
+    job.func = func;
+    job.info = info;
+    job.stripes = stripes;
+    job.src_dx = src_dx;
+    job.src_dy = src_dy;
+    job.mask_dx = mask_dx;
+    job.mask_dy = mask_dy;
+
+    ret = _pixman_threads_run (composite_stripe, &job, n_stripes);
+
+    if (stripes != stack_stripes)
+	free (stripes);
+
+    return ret;
+}
+
 /*
  * Work around GCC bug causing crashes in Mozilla with SSE2
  *
@@ -701,6 +899,13 @@ pixman_image_composite32 (pixman_op_t      op,
 
     pbox = pixman_region32_rectangles (&region, &n);
 
+    if (composite_threaded (imp, func, &info, pbox, n,
+			    src_x - dest_x, src_y - dest_y,
+			    mask_x - dest_x, mask_y - dest_y))
+    {
+	goto out;
+    }
+
     while (n--)
     {
 	info.src_x = pbox->x1 + src_x - dest_x;
@@ -1074,6 +1074,15 @@ PIXMAN_API
 void		pixman_image_set_indexed	     (pixman_image_t		   *image,
 						      const pixman_indexed_t	   *indexed);
 
+/* Lets narrow fetches of a gradient read its colors from a table of size
+ * entries, a power of two from 256 to 4096, instead of interpolating the
+ * stops for every pixel.  0, the default, turns the table off.  Returns
+ * FALSE for other sizes and for images that are not gradients.
+ */
+PIXMAN_API
+pixman_bool_t	pixman_image_set_gradient_lut_size   (pixman_image_t		   *image,
+						      int			    size);
+
 PIXMAN_API
 uint32_t       *pixman_image_get_data                (pixman_image_t               *image);
 
@@ -1177,6 +1186,15 @@ void          pixman_image_composite32        (pixman_op_t        op,
 					       int32_t            width,
 					       int32_t            height);
 
+/* Large composites are split into horizontal stripes that run on up to
+ * n_threads threads, the calling thread included.  The default of 1
+ * runs everything on the calling thread; 0 or less means one thread per
+ * processor.  Returns FALSE if threads are not supported or could not
+ * all be started.
+ */
+PIXMAN_API
+pixman_bool_t pixman_image_composite_set_threads (int n_threads);
+
 /* Executive Summary: This function is a no-op that only exists
  * for historical reasons.
  *
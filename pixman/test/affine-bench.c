@@ -36,8 +36,13 @@
 #include <time.h>
 #endif
 
+/* Build with -DWIDTH=3840 -DHEIGHT=2160 to measure at 4K */
+#ifndef WIDTH
 #define WIDTH  1920
+#endif
+#ifndef HEIGHT
 #define HEIGHT 1080
+#endif
 
 /* How much data to read to flush all cached data to RAM */
 #define MAX_L2CACHE_SIZE (8 * 1024 * 1024)
@@ -374,14 +379,23 @@ main (int argc, char *argv[])
         --argc;
     }
 
+    if (*argv && (*argv)[0] == '-' && (*argv)[1] == 't' && argv[1])
+    {
+        if (!pixman_image_composite_set_threads (atoi (argv[1])))
+            printf ("Could not use %s threads\n", argv[1]);
+        argv += 2;
+        argc -= 2;
+    }
+
     if (argc == 1 ||
         !parse_arguments (argc, argv, &binfo.transform, &binfo.op,
                           &src_format, &mask_format, &dest_format))
     {
-        printf ("Usage: affine-bench [-n] [-b] axx [axy] [ayx] [ayy] [combine type]\n");
-        printf ("                    [src format] [mask format] [dest format]\n");
+        printf ("Usage: affine-bench [-n] [-b] [-t threads] axx [axy] [ayx] [ayy]\n");
+        printf ("                    [combine type] [src format] [mask format] [dest format]\n");
         printf ("  -n : nearest scaling (default)\n");
         printf ("  -b : bilinear scaling\n");
+        printf ("  -t : number of composite threads, 0 for one per CPU (default 1)\n");
         printf ("  axx : x_out:x_in factor\n");
         printf ("  axy : x_out:y_in factor (default 0)\n");
         printf ("  ayx : y_out:x_in factor (default 0)\n");
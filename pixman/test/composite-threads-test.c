@@ -0,0 +1,199 @@
+/*
+ * Checks that composites split over worker threads produce the same
+ * results as when they run on a single thread.
+ */
+#include "utils.h"
+
+#if !defined (HAVE_PTHREADS) && !defined (_WIN32)
+
+int main ()
+{
+    printf ("Skipped composite-threads-test - pthreads or Windows Threads not supported\n");
+    return 0;
+}
+
+#else
+
+#include <stdlib.h>
+
+#define WIDTH  701
+#define HEIGHT 523
+
+static pixman_image_t *
+create_random_image (pixman_format_code_t format, int width, int height)
+{
+    pixman_image_t *image = pixman_image_create_bits (format, width, height, NULL, 0);
+
+    prng_randmemset (pixman_image_get_data (image),
+		     pixman_image_get_stride (image) * height, 0);
+
+    return image;
+}
+
+static pixman_image_t *
+create_gradient (void)
+{
+    pixman_gradient_stop_t stops[] =
+    {
+	{ pixman_int_to_fixed (0), { 0xffff, 0x0000, 0x0000, 0xffff } },
+	{ pixman_double_to_fixed (0.4), { 0x0000, 0x8000, 0xffff, 0x8000 } },
+	{ pixman_int_to_fixed (1), { 0x2000, 0xffff, 0x4000, 0xc000 } },
+    };
+    pixman_point_fixed_t p1 = { pixman_int_to_fixed (13), pixman_int_to_fixed (7) };
+    pixman_point_fixed_t p2 = { pixman_int_to_fixed (600), pixman_int_to_fixed (400) };
+    pixman_image_t *image;
+
+    image = pixman_image_create_linear_gradient (&p1, &p2, stops, ARRAY_LENGTH (stops));
+    pixman_image_set_repeat (image, PIXMAN_REPEAT_REFLECT);
+
+    return image;
+}
+
+static uint32_t
+run_case (int test, int n_threads)
+{
+    pixman_image_t *src, *mask = NULL, *dest;
+    pixman_op_t op = PIXMAN_OP_OVER;
+    pixman_transform_t transform;
+    pixman_region32_t clip;
+    pixman_image_t *alpha;
+    uint32_t *bits;
+    int stride, src_x = 5, src_y = 3, height = HEIGHT;
+    uint32_t crc;
+
+    pixman_image_composite_set_threads (n_threads);
+    prng_srand (test);
+
+    dest = create_random_image (PIXMAN_a8r8g8b8, WIDTH, HEIGHT);
+
+    switch (test)
+    {
+    case 0:
+	/* Fast path over the whole destination */
+	src = create_random_image (PIXMAN_a8r8g8b8, WIDTH, HEIGHT);
+	break;
+
+    case 1:
+	/* Scaled and rotated bilinear fetch through the general path */
+	src = create_random_image (PIXMAN_a8r8g8b8, 300, 200);
+	pixman_transform_init_rotate (&transform,
+				      pixman_double_to_fixed (0.8),
+				      pixman_double_to_fixed (0.6));
+	pixman_transform_scale (&transform, NULL,
+				pixman_double_to_fixed (0.4),
+				pixman_double_to_fixed (0.4));
+	pixman_image_set_transform (src, &transform);
+	pixman_image_set_filter (src, PIXMAN_FILTER_BILINEAR, NULL, 0);
+	pixman_image_set_repeat (src, PIXMAN_REPEAT_PAD);
+	op = PIXMAN_OP_SRC;
+	break;
+
+    case 2:
+	/* Gradient through an a8 mask, clipped to several boxes */
+	src = create_gradient ();
+	mask = create_random_image (PIXMAN_a8, WIDTH, HEIGHT);
+	pixman_region32_init_rect (&clip, 0, 0, 300, 200);
+	pixman_region32_union_rect (&clip, &clip, 250, 150, 451, 373);
+	pixman_region32_union_rect (&clip, &clip, 10, 400, 20, 20);
+	pixman_image_set_clip_region32 (dest, &clip);
+	pixman_region32_fini (&clip);
+	break;
+
+    case 3:
+	/* Source reading the destination itself, which must not be split */
+	src = pixman_image_ref (dest);
+	op = PIXMAN_OP_ADD;
+	src_x = 0;
+	height = HEIGHT - 3;
+	break;
+
+    case 4:
+	/* Source that is a sub-image of the destination's buffer, starting
+	 * a few rows further down */
+	bits = pixman_image_get_data (dest);
+	stride = pixman_image_get_stride (dest);
+	src = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT - 3,
+					bits + 3 * stride / 4, stride);
+	op = PIXMAN_OP_ADD;
+	src_x = src_y = 0;
+	height = HEIGHT - 3;
+	break;
+
+    case 5:
+	/* Source whose alpha map is a sub-image of the destination */
+	src = create_random_image (PIXMAN_a8r8g8b8, WIDTH, HEIGHT);
+	bits = pixman_image_get_data (dest);
+	stride = pixman_image_get_stride (dest);
+	alpha = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT - 40,
+					  bits + 40 * stride / 4, stride);
+	pixman_image_set_alpha_map (src, alpha, 0, 0);
+	pixman_image_unref (alpha);
+	break;
+
+    default:
+	/* Destination whose alpha map is a sub-image of the mask */
+	src = create_gradient ();
+	mask = create_random_image (PIXMAN_a8, WIDTH, HEIGHT);
+	bits = pixman_image_get_data (mask);
+	stride = pixman_image_get_stride (mask);
+	alpha = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT - 40,
+					  bits + 40 * stride / 4, stride);
+	pixman_image_set_alpha_map (dest, alpha, 0, 0);
+	pixman_image_unref (alpha);
+	break;
+    }
+
+    pixman_image_composite32 (op, src, mask, dest, src_x, src_y,
+			      0, 0, 0, 0, WIDTH, height);
+
+    if (test == 6)
+    {
+	crc = compute_crc32_for_image (0, mask);
+	pixman_image_set_alpha_map (dest, NULL, 0, 0);
+    }
+    else
+    {
+	crc = 0;
+    }
+
+    pixman_image_set_clip_region32 (dest, NULL);
+    crc = compute_crc32_for_image (crc, dest);
+
+    pixman_image_unref (src);
+    if (mask)
+	pixman_image_unref (mask);
+    pixman_image_unref (dest);
+
+    return crc;
+}
+
+int
+main (void)
+{
+    static const int n_threads[] = { 2, 3, 8 };
+    int test, i;
+    int ret = 0;
+
+    for (test = 0; test < 7; test++)
+    {
+	uint32_t expected = run_case (test, 1);
+
+	for (i = 0; i < ARRAY_LENGTH (n_threads); i++)
+	{
+	    uint32_t crc = run_case (test, n_threads[i]);
+
+	    if (crc != expected)
+	    {
+		printf ("Test %d with %d threads: crc %08x, expected %08x\n",
+			test, n_threads[i], crc, expected);
+		ret = 1;
+	    }
+	}
+    }
+
+    pixman_image_composite_set_threads (1);
+
+    return ret;
+}
+
+#endif
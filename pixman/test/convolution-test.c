@@ -0,0 +1,242 @@
+/*
+ * Compares separable convolution of scaled 8888 sources against the C
+ * fetcher, with the sampled span partly or entirely outside the source
+ * image in every repeat mode.
+ *
+ * The test runs itself a second time with PIXMAN_DISABLE=sse2 and
+ * --dump <file>, which makes it write the images it renders to file,
+ * and compares those to what it rendered in this process.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define N_CASES 4000
+#define MAX_DEST_WIDTH 40
+#define MAX_DEST_HEIGHT 12
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const pixman_kernel_t kernels[] =
+{
+    PIXMAN_KERNEL_IMPULSE,
+    PIXMAN_KERNEL_BOX,
+    PIXMAN_KERNEL_LINEAR,
+    PIXMAN_KERNEL_CUBIC,
+    PIXMAN_KERNEL_GAUSSIAN,
+    PIXMAN_KERNEL_LANCZOS2,
+    PIXMAN_KERNEL_LANCZOS3,
+};
+
+static const double scales[] = { 0.1, 0.35, 0.5, 0.75, 1.25, 2.0, 3.5 };
+
+/* Destination offsets, small ones just around the source image and
+ * large ones far away from it
+ */
+static const int offsets[] =
+{
+    -20000, -3000, -517, -60, -17, -5, -1, 0, 1, 3, 16, 45, 700, 4001, 20000,
+};
+
+static const pixman_fixed_t translations[] =
+{
+    0, 0, 0, 0,
+    pixman_fixed_1 / 3,
+    -pixman_fixed_1 * 7,
+    pixman_int_to_fixed (-6000),
+    pixman_int_to_fixed (6000),
+};
+
+/* Renders case i into dest, which is MAX_DEST_WIDTH x MAX_DEST_HEIGHT */
+static void
+render (int i, pixman_image_t *dest, char *description, size_t len)
+{
+    pixman_format_code_t format;
+    pixman_image_t *src;
+    pixman_transform_t transform;
+    pixman_fixed_t *params;
+    pixman_repeat_t repeat;
+    pixman_kernel_t reconstruct, sample;
+    double sx, sy;
+    int src_width, src_height, width, height, src_x, src_y, n_params;
+    uint32_t *bits;
+
+    prng_srand (i);
+
+    format = prng_rand_n (2) ? PIXMAN_a8r8g8b8 : PIXMAN_x8r8g8b8;
+    src_width = 1 + prng_rand_n (24);
+    src_height = 1 + prng_rand_n (24);
+    bits = malloc (src_width * src_height * 4);
+    prng_randmemset (bits, src_width * src_height * 4, 0);
+    src = pixman_image_create_bits (
+	format, src_width, src_height, bits, src_width * 4);
+
+    repeat = repeats[prng_rand_n (ARRAY_LENGTH (repeats))];
+    pixman_image_set_repeat (src, repeat);
+
+    sx = scales[prng_rand_n (ARRAY_LENGTH (scales))];
+    sy = scales[prng_rand_n (ARRAY_LENGTH (scales))];
+    pixman_transform_init_scale (&transform,
+				 pixman_double_to_fixed (sx),
+				 pixman_double_to_fixed (sy));
+    transform.matrix[0][2] =
+	translations[prng_rand_n (ARRAY_LENGTH (translations))];
+    transform.matrix[1][2] =
+	translations[prng_rand_n (ARRAY_LENGTH (translations))];
+    pixman_image_set_transform (src, &transform);
+
+    reconstruct = kernels[prng_rand_n (ARRAY_LENGTH (kernels))];
+    sample = kernels[prng_rand_n (ARRAY_LENGTH (kernels))];
+    params = pixman_filter_create_separable_convolution (
+	&n_params,
+	pixman_double_to_fixed (sx < 1 ? 1 : sx),
+	pixman_double_to_fixed (sy < 1 ? 1 : sy),
+	reconstruct, reconstruct, sample, sample,
+	prng_rand_n (5), prng_rand_n (5));
+    pixman_image_set_filter (src, PIXMAN_FILTER_SEPARABLE_CONVOLUTION,
+			     params, n_params);
+    free (params);
+
+    /* Keep the sampled positions within the range of pixman_fixed_t */
+    src_x = offsets[prng_rand_n (ARRAY_LENGTH (offsets))];
+    src_y = offsets[prng_rand_n (ARRAY_LENGTH (offsets))];
+    if (sx * abs (src_x) > 20000)
+	src_x /= 4;
+    if (sy * abs (src_y) > 20000)
+	src_y /= 4;
+
+    width = 1 + prng_rand_n (MAX_DEST_WIDTH);
+    height = 1 + prng_rand_n (MAX_DEST_HEIGHT);
+
+    snprintf (description, len,
+	      "case %d: %s %dx%d, repeat %d, kernels %d/%d, scale %g x %g, "
+	      "translation %g, %g, offset %d, %d, %dx%d",
+	      i, format_name (format), src_width, src_height, repeat,
+	      reconstruct, sample, sx, sy,
+	      pixman_fixed_to_double (transform.matrix[0][2]),
+	      pixman_fixed_to_double (transform.matrix[1][2]),
+	      src_x, src_y, width, height);
+
+    memset (pixman_image_get_data (dest), 0,
+	    MAX_DEST_WIDTH * MAX_DEST_HEIGHT * 4);
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      src_x, src_y, 0, 0, 0, 0, width, height);
+
+    pixman_image_unref (src);
+    free (bits);
+}
+
+static int
+max_difference (const uint32_t *a, const uint32_t *b, int n)
+{
+    int max = 0;
+    int i, j;
+
+    for (i = 0; i < n; ++i)
+    {
+	for (j = 0; j < 32; j += 8)
+	{
+	    int d = (int)((a[i] >> j) & 0xff) - (int)((b[i] >> j) & 0xff);
+
+	    if (d < 0)
+		d = -d;
+	    if (d > max)
+		max = d;
+	}
+    }
+
+    return max;
+}
+
+int
+main (int argc, char **argv)
+{
+    int n_pixels = MAX_DEST_WIDTH * MAX_DEST_HEIGHT;
+    char description[256], filename[4096], command[2 * 4096 + 16];
+    pixman_image_t *dest;
+    uint32_t *reference;
+    FILE *f;
+    int i, d, max = 0, n_different = 0;
+    int ret = 0;
+
+    dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, MAX_DEST_WIDTH, MAX_DEST_HEIGHT, NULL, 0);
+
+    if (argc > 2 && strcmp (argv[1], "--dump") == 0)
+    {
+	if (!(f = fopen (argv[2], "wb")))
+	    return 1;
+
+	for (i = 0; i < N_CASES; ++i)
+	{
+	    render (i, dest, description, sizeof (description));
+	    fwrite (pixman_image_get_data (dest), 4, n_pixels, f);
+	}
+
+	pixman_image_unref (dest);
+	return fclose (f) != 0;
+    }
+
+#ifdef HAVE_SETENV
+    if (strchr (argv[0], '"'))
+	return 77;
+
+    snprintf (filename, sizeof (filename), "%s.ref", argv[0]);
+    snprintf (command, sizeof (command),
+	      "\"%s\" --dump \"%s\"", argv[0], filename);
+    setenv ("PIXMAN_DISABLE", "sse2", 1);
+    if (system (command) != 0 || !(f = fopen (filename, "rb")))
+    {
+	printf ("reference run '%s' failed\n", command);
+	return 1;
+    }
+#else
+    /* Automake return code for test SKIP. */
+    return 77;
+#endif
+
+    reference = malloc (n_pixels * 4);
+
+    for (i = 0; i < N_CASES; ++i)
+    {
+	render (i, dest, description, sizeof (description));
+
+	if (fread (reference, 4, n_pixels, f) != n_pixels)
+	{
+	    printf ("reference output ends before case %d\n", i);
+	    ret = 1;
+	    break;
+	}
+
+	d = max_difference (pixman_image_get_data (dest), reference, n_pixels);
+	if (d > max)
+	    max = d;
+	if (d)
+	    n_different++;
+
+	/* The two passes round separately, see pixman-sse2.c */
+	if (d > 1)
+	{
+	    printf ("%s differs by %d\n", description, d);
+	    ret = 1;
+	}
+    }
+
+    fclose (f);
+    remove (filename);
+
+    if (getenv ("VERBOSE") != NULL)
+	printf ("%d of %d cases differ, by at most %d\n", n_different, N_CASES, max);
+
+    free (reference);
+    pixman_image_unref (dest);
+
+    return ret;
+}
@@ -323,9 +323,254 @@ test_glyphs (int testnum, int verbose)
     return crc32;
 }
 
+/* Keeps replacing glyphs of a live set in one cache, so that new glyphs
+ * land in the atlas slots of removed ones, and checks now and then that
+ * every live glyph still draws its own pixels.
+ */
+#define REUSE_GLYPHS	600
+#define REUSE_ROUNDS	20000
+
+static pixman_image_t *
+create_a8_glyph (void)
+{
+    int width = 1 + prng_rand_n (72);
+    int height = 1 + prng_rand_n (72);
+    pixman_image_t *img = pixman_image_create_bits (
+	PIXMAN_a8, width, height, NULL, -1);
+
+    prng_randmemset (pixman_image_get_data (img),
+		     pixman_image_get_stride (img) * height, 0);
+
+    return img;
+}
+
+static void
+check_glyph (pixman_glyph_cache_t *cache, pixman_image_t *dest,
+	     pixman_image_t *white, pixman_image_t *img, void *key)
+{
+    pixman_glyph_t glyph;
+    uint8_t *expected = (uint8_t *)pixman_image_get_data (img);
+    uint8_t *result = (uint8_t *)pixman_image_get_data (dest);
+    int width = pixman_image_get_width (img);
+    int height = pixman_image_get_height (img);
+    int y;
+
+    glyph.glyph = pixman_glyph_cache_lookup (cache, cache, key);
+    glyph.x = 0;
+    glyph.y = 0;
+    assert (glyph.glyph);
+
+    pixman_composite_glyphs_no_mask (PIXMAN_OP_SRC, white, dest,
+				     0, 0, 0, 0, cache, 1, &glyph);
+
+    for (y = 0; y < height; ++y)
+    {
+	if (memcmp (result + y * pixman_image_get_stride (dest),
+		    expected + y * pixman_image_get_stride (img), width) != 0)
+	{
+	    printf ("glyph %p lost its pixels\n", key);
+	    exit (1);
+	}
+    }
+}
+
+static void
+test_reuse (void)
+{
+    static const pixman_color_t white_color = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *images[REUSE_GLYPHS];
+    uintptr_t keys[REUSE_GLYPHS];
+    pixman_glyph_cache_t *cache;
+    pixman_image_t *dest, *white;
+    int i, round;
+
+    prng_srand (0);
+
+    cache = pixman_glyph_cache_create ();
+    white = pixman_image_create_solid_fill (&white_color);
+    dest = pixman_image_create_bits (PIXMAN_a8, 72, 72, NULL, -1);
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = 0; i < REUSE_GLYPHS; ++i)
+    {
+	images[i] = create_a8_glyph ();
+	keys[i] = i + 1;
+	assert (pixman_glyph_cache_insert (
+		    cache, cache, (void *)keys[i], 0, 0, images[i]));
+    }
+
+    for (round = 0; round < REUSE_ROUNDS; ++round)
+    {
+	i = prng_rand_n (REUSE_GLYPHS);
+
+	pixman_glyph_cache_remove (cache, cache, (void *)keys[i]);
+	pixman_image_unref (images[i]);
+
+	images[i] = create_a8_glyph ();
+	keys[i] = REUSE_GLYPHS + round + 1;
+	assert (pixman_glyph_cache_insert (
+		    cache, cache, (void *)keys[i], 0, 0, images[i]));
+
+	if (round % 2000 == 0 || round == REUSE_ROUNDS - 1)
+	{
+	    for (i = 0; i < REUSE_GLYPHS; ++i)
+		check_glyph (cache, dest, white, images[i], (void *)keys[i]);
+	}
+    }
+
+    pixman_glyph_cache_thaw (cache);
+
+    for (i = 0; i < REUSE_GLYPHS; ++i)
+	pixman_image_unref (images[i]);
+
+    pixman_image_unref (white);
+    pixman_image_unref (dest);
+    pixman_glyph_cache_destroy (cache);
+}
+
+/* Throughput mode: draws a screen of terminal text, 80 x 25 cells from
+ * a 95 glyph a8 font, one line per call like a terminal does, through
+ * both glyph entry points.  The last run also replaces a few glyphs of
+ * the font before each screen, the way a cache that is being evicted
+ * and refilled sees them.
+ */
+#define TEXT_COLUMNS	80
+#define TEXT_ROWS	25
+#define CELL_WIDTH	8
+#define CELL_HEIGHT	16
+#define FONT_GLYPHS	95
+#define CHURN_GLYPHS	4
+
+static int
+test_throughput (void)
+{
+    static const char *names[] = {
+	"pixman_composite_glyphs",
+	"pixman_composite_glyphs_no_mask",
+	"pixman_composite_glyphs, churn",
+    };
+    static const pixman_color_t grey = { 0xc000, 0xc000, 0xc000, 0xffff };
+    pixman_image_t *font_images[FONT_GLYPHS];
+    uintptr_t font_keys[FONT_GLYPHS];
+    int cells[TEXT_ROWS * TEXT_COLUMNS];
+    pixman_glyph_t glyphs[TEXT_ROWS * TEXT_COLUMNS];
+    pixman_glyph_cache_t *cache;
+    pixman_image_t *source, *dest;
+    pixman_format_code_t mask_format;
+    uintptr_t next_key = 1;
+    int i, mode;
+
+    prng_srand (0);
+
+    cache = pixman_glyph_cache_create ();
+    source = pixman_image_create_solid_fill (&grey);
+    dest = pixman_image_create_bits (PIXMAN_x8r8g8b8,
+				     TEXT_COLUMNS * CELL_WIDTH,
+				     TEXT_ROWS * CELL_HEIGHT, NULL, -1);
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = 0; i < FONT_GLYPHS; ++i)
+    {
+	font_images[i] = pixman_image_create_bits (
+	    PIXMAN_a8, CELL_WIDTH, CELL_HEIGHT, NULL, -1);
+
+	prng_randmemset (pixman_image_get_data (font_images[i]),
+			 pixman_image_get_stride (font_images[i]) * CELL_HEIGHT,
+			 RANDMEMSET_MORE_00_AND_FF);
+
+	font_keys[i] = next_key++;
+	pixman_glyph_cache_insert (cache, cache, (void *)font_keys[i],
+				   0, CELL_HEIGHT, font_images[i]);
+    }
+
+    for (i = 0; i < TEXT_ROWS * TEXT_COLUMNS; ++i)
+    {
+	cells[i] = prng_rand_n (FONT_GLYPHS);
+	glyphs[i].x = (i % TEXT_COLUMNS) * CELL_WIDTH;
+	glyphs[i].y = (i / TEXT_COLUMNS + 1) * CELL_HEIGHT;
+    }
+
+    for (mode = 0; mode < 3; ++mode)
+    {
+	double t, t0 = gettime ();
+	int n = 0;
+
+	do
+	{
+	    if (mode == 2)
+	    {
+		for (i = 0; i < CHURN_GLYPHS; ++i)
+		{
+		    int g = prng_rand_n (FONT_GLYPHS);
+
+		    pixman_glyph_cache_remove (cache, cache,
+					       (void *)font_keys[g]);
+		    font_keys[g] = next_key++;
+		    pixman_glyph_cache_insert (cache, cache,
+					       (void *)font_keys[g],
+					       0, CELL_HEIGHT, font_images[g]);
+		}
+	    }
+
+	    for (i = 0; i < TEXT_ROWS * TEXT_COLUMNS; ++i)
+	    {
+		glyphs[i].glyph = pixman_glyph_cache_lookup (
+		    cache, cache, (void *)font_keys[cells[i]]);
+	    }
+
+	    mask_format = pixman_glyph_get_mask_format (
+		cache, TEXT_ROWS * TEXT_COLUMNS, glyphs);
+
+	    for (i = 0; i < TEXT_ROWS; ++i)
+	    {
+		const pixman_glyph_t *line = glyphs + i * TEXT_COLUMNS;
+		int y = i * CELL_HEIGHT;
+
+		if (mode != 1)
+		{
+		    pixman_composite_glyphs (
+			PIXMAN_OP_OVER, source, dest, mask_format,
+			0, y, 0, y, 0, y,
+			TEXT_COLUMNS * CELL_WIDTH, CELL_HEIGHT,
+			cache, TEXT_COLUMNS, line);
+		}
+		else
+		{
+		    pixman_composite_glyphs_no_mask (
+			PIXMAN_OP_OVER, source, dest, 0, 0, 0, 0,
+			cache, TEXT_COLUMNS, line);
+		}
+	    }
+
+	    n += TEXT_ROWS * TEXT_COLUMNS;
+	}
+	while ((t = gettime () - t0) < 2.0);
+
+	printf ("%-32s %8.2f Mglyphs/s\n", names[mode], n / t / 1000000.);
+    }
+
+    pixman_glyph_cache_thaw (cache);
+
+    for (i = 0; i < FONT_GLYPHS; ++i)
+	pixman_image_unref (font_images[i]);
+
+    pixman_image_unref (source);
+    pixman_image_unref (dest);
+    pixman_glyph_cache_destroy (cache);
+
+    return 0;
+}
+
 int
 main (int argc, const char *argv[])
 {
+    if (argc == 2 && strcmp (argv[1], "-t") == 0)
+	return test_throughput ();
+
+    test_reuse ();
+
     return fuzzer_test_main ("glyph", 30000,	
 			     0xFA478A79,
 			     test_glyphs, argc, argv);
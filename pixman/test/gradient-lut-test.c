@@ -0,0 +1,201 @@
+/*
+ * Checks that gradients rendered through a color lookup table stay
+ * within the expected quantization error of the ones computed exactly.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+#define WIDTH 97
+#define HEIGHT 61
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const int lut_sizes[] = { 256, 1024, 4096 };
+
+static pixman_image_t *
+create_gradient (int type)
+{
+    pixman_gradient_stop_t stops[8];
+    pixman_point_fixed_t p1, p2;
+    int n_stops = 2 + prng_rand_n (7);
+    int i;
+
+    /* Evenly spaced stops, with the last color equal to the first so
+     * that repeating gradients are continuous.
+     */
+    for (i = 0; i < n_stops; ++i)
+    {
+	stops[i].x = pixman_int_to_fixed (i) / (n_stops - 1);
+	stops[i].color.alpha = prng_rand_n (0x10000);
+	stops[i].color.red = prng_rand_n (0x10000);
+	stops[i].color.green = prng_rand_n (0x10000);
+	stops[i].color.blue = prng_rand_n (0x10000);
+    }
+    stops[n_stops - 1].color = stops[0].color;
+
+    p1.x = pixman_int_to_fixed (prng_rand_n (WIDTH));
+    p1.y = pixman_int_to_fixed (prng_rand_n (HEIGHT));
+    p2.x = p1.x + pixman_int_to_fixed (prng_rand_n (200) - 100);
+    p2.y = p1.y + pixman_int_to_fixed (prng_rand_n (200) - 100);
+
+    switch (type)
+    {
+    case 0:
+	return pixman_image_create_linear_gradient (&p1, &p2, stops, n_stops);
+
+    case 1:
+	return pixman_image_create_radial_gradient (
+	    &p1, &p2,
+	    pixman_int_to_fixed (prng_rand_n (20)),
+	    pixman_int_to_fixed (prng_rand_n (80)),
+	    stops, n_stops);
+
+    default:
+	return pixman_image_create_conical_gradient (
+	    &p1, pixman_int_to_fixed (prng_rand_n (360)), stops, n_stops);
+    }
+}
+
+static void
+set_random_transform (pixman_image_t *image)
+{
+    pixman_transform_t transform;
+
+    switch (prng_rand_n (3))
+    {
+    case 0:
+	break;
+
+    case 1:
+	pixman_transform_init_rotate (&transform,
+				      pixman_double_to_fixed (0.6),
+				      pixman_double_to_fixed (0.8));
+	pixman_transform_scale (&transform, NULL,
+				pixman_double_to_fixed (1.5),
+				pixman_double_to_fixed (0.7));
+	pixman_image_set_transform (image, &transform);
+	break;
+
+    default:
+	pixman_transform_init_identity (&transform);
+	transform.matrix[2][0] = pixman_double_to_fixed (0.001);
+	pixman_image_set_transform (image, &transform);
+	break;
+    }
+}
+
+static void
+render (pixman_image_t *src, pixman_image_t *dest)
+{
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+}
+
+static int
+compare (pixman_image_t *a, pixman_image_t *b, int tolerance)
+{
+    uint32_t *pa = pixman_image_get_data (a);
+    uint32_t *pb = pixman_image_get_data (b);
+    int max = 0;
+    int i, j;
+
+    for (i = 0; i < WIDTH * HEIGHT; ++i)
+    {
+	for (j = 0; j < 32; j += 8)
+	{
+	    int d = (int)((pa[i] >> j) & 0xff) - (int)((pb[i] >> j) & 0xff);
+
+	    if (d < 0)
+		d = -d;
+	    if (d > max)
+		max = d;
+	}
+    }
+
+    return max <= tolerance;
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_image_t *bits, *exact, *lut;
+    int i, r, s, type;
+    int ret = 0;
+
+    exact = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, 0);
+    lut = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, 0);
+
+    /* Only gradients take a lookup table, and only of supported sizes */
+    if (pixman_image_set_gradient_lut_size (exact, 256) ||
+	pixman_image_set_gradient_lut_size (exact, 0))
+    {
+	printf ("lookup table accepted for a bits image\n");
+	ret = 1;
+    }
+
+    prng_srand (0);
+
+    for (i = 0; i < 60; ++i)
+    {
+	type = i % 3;
+	bits = create_gradient (type);
+	set_random_transform (bits);
+
+	if (pixman_image_set_gradient_lut_size (bits, 100)	||
+	    pixman_image_set_gradient_lut_size (bits, 128)	||
+	    pixman_image_set_gradient_lut_size (bits, 8192))
+	{
+	    printf ("unsupported lookup table size accepted\n");
+	    ret = 1;
+	}
+
+	for (r = 0; r < ARRAY_LENGTH (repeats); ++r)
+	{
+	    pixman_image_set_repeat (bits, repeats[r]);
+
+	    pixman_image_set_gradient_lut_size (bits, 0);
+	    render (bits, exact);
+
+	    for (s = 0; s < ARRAY_LENGTH (lut_sizes); ++s)
+	    {
+		/* Stops are at most 1/7 apart, so a channel, which is
+		 * the product of two interpolated values, changes by at
+		 * most 2 * 255 * 7 over the gradient.  Half a table entry
+		 * of that, plus one for rounding.
+		 */
+		int tolerance = 1 + (2 * 255 * 7 + lut_sizes[s]) / (2 * lut_sizes[s]);
+
+		if (!pixman_image_set_gradient_lut_size (bits, lut_sizes[s]))
+		{
+		    printf ("lookup table size %d rejected\n", lut_sizes[s]);
+		    ret = 1;
+		    continue;
+		}
+
+		render (bits, lut);
+
+		if (!compare (exact, lut, tolerance))
+		{
+		    printf ("gradient %d (type %d), repeat %d, lookup table size %d "
+			    "differs by more than %d\n",
+			    i, type, repeats[r], lut_sizes[s], tolerance);
+		    ret = 1;
+		}
+	    }
+	}
+
+	pixman_image_unref (bits);
+    }
+
+    pixman_image_unref (exact);
+    pixman_image_unref (lut);
+
+    return ret;
+}
@@ -0,0 +1,61 @@
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WIDTH		1024
+#define HEIGHT		768
+#define N_COMPOSITE	200
+
+static const char *repeat_names[] = { "none", "normal", "pad", "reflect" };
+
+int
+main (int argc, char **argv)
+{
+    static const pixman_point_fixed_t p1 = { 0x0000, 0x0000 };
+    static const pixman_point_fixed_t p2 = { 300 << 16, 200 << 16 };
+    static const pixman_gradient_stop_t stops[] = {
+	{ 0x00000, { 0xffff, 0x0000, 0x0000, 0xffff } },
+	{ 0x05555, { 0x0000, 0xffff, 0x0000, 0xc000 } },
+	{ 0x0aaaa, { 0x0000, 0x0000, 0xffff, 0xffff } },
+	{ 0x10000, { 0xffff, 0xffff, 0x0000, 0x8000 } }
+    };
+    int lut_size = argc > 1 ? atoi (argv[1]) : 0;
+    pixman_image_t *dest, *linear;
+    pixman_repeat_t repeat;
+    double before, after;
+    int i;
+
+    dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, -1);
+    linear = pixman_image_create_linear_gradient (
+	&p1, &p2, stops, ARRAY_LENGTH (stops));
+
+    /* An optional argument selects the size of the color lookup table */
+    if (!pixman_image_set_gradient_lut_size (linear, lut_size))
+    {
+	printf ("Unsupported lookup table size %d\n", lut_size);
+	return 1;
+    }
+
+    for (repeat = PIXMAN_REPEAT_NONE; repeat <= PIXMAN_REPEAT_REFLECT; ++repeat)
+    {
+	pixman_image_set_repeat (linear, repeat);
+
+	before = gettime ();
+	for (i = 0; i < N_COMPOSITE; ++i)
+	{
+	    pixman_image_composite32 (
+		PIXMAN_OP_SRC, linear, NULL, dest,
+		-100, -50, 0, 0, 0, 0, WIDTH, HEIGHT);
+	}
+	after = gettime ();
+
+	printf ("%-8s %8.2f Mpix/s\n", repeat_names[repeat],
+		(double)WIDTH * HEIGHT * N_COMPOSITE / (after - before) / 1000000.);
+    }
+
+    pixman_image_unref (linear);
+    pixman_image_unref (dest);
+
+    return 0;
+}
@@ -1,8 +1,9 @@
 #include "utils.h"
 #include <stdio.h>
+#include <stdlib.h>
 
 int
-main ()
+main (int argc, char **argv)
 {
     static const pixman_point_fixed_t inner = { 0x0000, 0x0000 };
     static const pixman_point_fixed_t outer = { 0x0000, 0x0000 };
@@ -31,6 +32,13 @@ main ()
     pixman_image_set_transform (radial, &transform);
     pixman_image_set_repeat (radial, PIXMAN_REPEAT_PAD);
 
+    /* An optional argument selects the size of the color lookup table */
+    if (argc > 1 && !pixman_image_set_gradient_lut_size (radial, atoi (argv[1])))
+    {
+	printf ("Unsupported lookup table size %s\n", argv[1]);
+	return 1;
+    }
+
 #define N_COMPOSITE	500
 
     before = gettime();
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+/* Region operation benchmark.  The clip lists are grids of separated
+ * boxes, which is roughly what a window clipped by many overlapping
+ * windows looks like, and they are combined with a single window-sized
+ * box (clipping a drawing request, appending damage, exposing a window)
+ * and with a shifted copy of themselves.
+ */
+
+#define CLIP_SIZE 1000
+#define MIN_TIME 0.1
+#define MIN_BATCH_TIME 0.005
+
+static void
+make_clip (pixman_region16_t *region, int n_boxes, int offset)
+{
+    pixman_box16_t *boxes = malloc (n_boxes * sizeof (pixman_box16_t));
+    int rows, cols, cell_w, cell_h, i;
+
+    for (rows = 1; rows * rows < n_boxes; rows++)
+	;
+    cols = (n_boxes + rows - 1) / rows;
+    cell_w = CLIP_SIZE / cols;
+    cell_h = CLIP_SIZE / rows;
+
+    for (i = 0; i < n_boxes; i++)
+    {
+	boxes[i].x1 = (i % cols) * cell_w + offset;
+	boxes[i].y1 = (i / cols) * cell_h + offset;
+	boxes[i].x2 = boxes[i].x1 + cell_w - 1;
+	boxes[i].y2 = boxes[i].y1 + cell_h - 1;
+    }
+
+    pixman_region_init_rects (region, boxes, n_boxes);
+    free (boxes);
+}
+
+typedef pixman_bool_t (* region_op_t) (pixman_region16_t *dest,
+				       const pixman_region16_t *reg1,
+				       const pixman_region16_t *reg2);
+
+/* Best time of several batches, each long enough for the timer */
+static double
+bench_op (region_op_t op,
+	  const pixman_region16_t *reg1,
+	  const pixman_region16_t *reg2)
+{
+    pixman_region16_t dest;
+    double start, t, best = -1;
+    int batch = 1, i;
+
+    pixman_region_init (&dest);
+    start = gettime ();
+    do
+    {
+	t = gettime ();
+	for (i = 0; i < batch; i++)
+	    op (&dest, reg1, reg2);
+	t = gettime () - t;
+	if (t < MIN_BATCH_TIME)
+	{
+	    batch *= 2;
+	    continue;
+	}
+	t /= batch;
+	if (best < 0 || t < best)
+	    best = t;
+    }
+    while (best < 0 || gettime () - start < MIN_TIME);
+    pixman_region_fini (&dest);
+
+    return best * 1e9;
+}
+
+int
+main (int argc, char **argv)
+{
+    static const int sizes[] = { 1, 10, 100, 1000, 10000 };
+    pixman_region16_t clip, shifted, rect;
+    int i;
+
+    pixman_region_init_rect (&rect, 100, 100, 300, 200);
+
+    printf ("# time per operation / ns\n");
+    printf ("# %-7s %10s %10s %10s %10s %10s %10s\n", "boxes",
+	    "isect box", "union box", "sub box",
+	    "isect", "union", "sub");
+
+    for (i = 0; i < ARRAY_LENGTH (sizes); i++)
+    {
+	make_clip (&clip, sizes[i], 0);
+	make_clip (&shifted, sizes[i], 3);
+
+	printf ("%9d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", sizes[i],
+		bench_op (pixman_region_intersect, &clip, &rect),
+		bench_op (pixman_region_union, &clip, &rect),
+		bench_op (pixman_region_subtract, &clip, &rect),
+		bench_op (pixman_region_intersect, &clip, &shifted),
+		bench_op (pixman_region_union, &clip, &shifted),
+		bench_op (pixman_region_subtract, &clip, &shifted));
+
+	pixman_region_fini (&clip);
+	pixman_region_fini (&shifted);
+    }
+
+    pixman_region_fini (&rect);
+
+    return 0;
+}
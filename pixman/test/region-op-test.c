@@ -0,0 +1,319 @@
+/*
+ * Checks union, intersect and subtract against a per-pixel reference.
+ *
+ * The region code takes shortcuts when one operand is a single box or
+ * when whole runs of bands of one region lie above the other.  Every
+ * result is rasterized and compared with the same operation done pixel
+ * by pixel, and checked for being a well-formed region: y-x banded,
+ * coalesced, with no empty or touching boxes and correct extents.  The
+ * 16-bit regions, which go through different band kernels, must give
+ * exactly the same boxes as the 32-bit ones.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "utils.h"
+
+#define SIZE 48
+
+typedef unsigned char bitmap_t[SIZE][SIZE];
+
+typedef enum
+{
+    OP_UNION,
+    OP_INTERSECT,
+    OP_SUBTRACT,
+    N_OPS
+} op_t;
+
+static const char *op_names[] = { "union", "intersect", "subtract" };
+
+/* A single box, a handful of random boxes, or a grid of many small
+ * boxes like a clip list, possibly with holes */
+static void
+make_random_region (pixman_region32_t *region)
+{
+    int i, n, x, y, step;
+
+    pixman_region32_init (region);
+
+    switch (prng_rand_n (4))
+    {
+    case 0:
+	x = prng_rand_n (SIZE);
+	y = prng_rand_n (SIZE);
+	pixman_region32_union_rect (region, region, x, y,
+				    prng_rand_n (SIZE - x) + 1,
+				    prng_rand_n (SIZE - y) + 1);
+	break;
+
+    case 1:
+	n = prng_rand_n (12);
+	for (i = 0; i < n; i++)
+	{
+	    x = prng_rand_n (SIZE);
+	    y = prng_rand_n (SIZE);
+	    pixman_region32_union_rect (region, region, x, y,
+					prng_rand_n (SIZE - x) + 1,
+					prng_rand_n (SIZE - y) + 1);
+	}
+	break;
+
+    default:
+	step = 2 + prng_rand_n (4);
+	for (y = prng_rand_n (step); y < SIZE; y += step)
+	{
+	    for (x = prng_rand_n (step); x < SIZE; x += step)
+	    {
+		int w = 1 + prng_rand_n (step - 1);
+		int h = 1 + prng_rand_n (step - 1);
+
+		if (prng_rand_n (8))
+		    pixman_region32_union_rect (region, region, x, y,
+						MIN (w, SIZE - x),
+						MIN (h, SIZE - y));
+	    }
+	}
+	break;
+    }
+}
+
+static void
+rasterize (pixman_region32_t *region, bitmap_t bits)
+{
+    pixman_box32_t *b;
+    int n, x, y;
+
+    memset (bits, 0, sizeof (bitmap_t));
+
+    b = pixman_region32_rectangles (region, &n);
+    while (n--)
+    {
+	for (y = b[n].y1; y < b[n].y2; y++)
+	{
+	    for (x = b[n].x1; x < b[n].x2; x++)
+	    {
+		assert (x >= 0 && x < SIZE && y >= 0 && y < SIZE);
+		assert (!bits[y][x]);
+		bits[y][x] = 1;
+	    }
+	}
+    }
+}
+
+static void
+check_well_formed (pixman_region32_t *region)
+{
+    pixman_box32_t *b, *extents;
+    pixman_box32_t bounds = { SIZE, SIZE, 0, 0 };
+    int n, i, band, prev_band;
+
+    assert (pixman_region32_selfcheck (region));
+
+    b = pixman_region32_rectangles (region, &n);
+    extents = pixman_region32_extents (region);
+
+    if (!n)
+    {
+	assert (extents->x1 == extents->x2 && extents->y1 == extents->y2);
+	return;
+    }
+
+    prev_band = -1;
+    for (band = 0; band < n; band = i)
+    {
+	for (i = band; i < n && b[i].y1 == b[band].y1; i++)
+	{
+	    assert (b[i].x1 < b[i].x2);
+	    assert (b[i].y1 < b[i].y2);
+	    assert (b[i].y2 == b[band].y2);
+	    if (i > band)
+		assert (b[i - 1].x2 < b[i].x1);
+
+	    bounds.x1 = MIN (bounds.x1, b[i].x1);
+	    bounds.x2 = MAX (bounds.x2, b[i].x2);
+	}
+
+	if (prev_band >= 0)
+	{
+	    assert (b[prev_band].y2 <= b[band].y1);
+
+	    /* touching bands with the same boxes must have been coalesced */
+	    if (b[prev_band].y2 == b[band].y1 && i - band == band - prev_band)
+	    {
+		int k;
+
+		for (k = 0; k < i - band; k++)
+		{
+		    if (b[prev_band + k].x1 != b[band + k].x1 ||
+			b[prev_band + k].x2 != b[band + k].x2)
+			break;
+		}
+		assert (k < i - band);
+	    }
+	}
+	prev_band = band;
+    }
+
+    bounds.y1 = b[0].y1;
+    bounds.y2 = b[n - 1].y2;
+    assert (extents->x1 == bounds.x1 && extents->y1 == bounds.y1 &&
+	    extents->x2 == bounds.x2 && extents->y2 == bounds.y2);
+}
+
+static void
+region32_op (op_t op, pixman_region32_t *dst,
+	     pixman_region32_t *r1, pixman_region32_t *r2)
+{
+    switch (op)
+    {
+    case OP_UNION:
+	pixman_region32_union (dst, r1, r2);
+	break;
+    case OP_INTERSECT:
+	pixman_region32_intersect (dst, r1, r2);
+	break;
+    default:
+	pixman_region32_subtract (dst, r1, r2);
+	break;
+    }
+}
+
+static void
+region16_op (op_t op, pixman_region16_t *dst,
+	     pixman_region16_t *r1, pixman_region16_t *r2)
+{
+    switch (op)
+    {
+    case OP_UNION:
+	pixman_region_union (dst, r1, r2);
+	break;
+    case OP_INTERSECT:
+	pixman_region_intersect (dst, r1, r2);
+	break;
+    default:
+	pixman_region_subtract (dst, r1, r2);
+	break;
+    }
+}
+
+static void
+region16_from_region32 (pixman_region16_t *dst, pixman_region32_t *src)
+{
+    pixman_box32_t *b;
+    pixman_box16_t *boxes;
+    int n, i;
+
+    b = pixman_region32_rectangles (src, &n);
+    boxes = malloc ((n + 1) * sizeof (pixman_box16_t));
+    assert (boxes);
+    for (i = 0; i < n; i++)
+    {
+	boxes[i].x1 = b[i].x1;
+	boxes[i].y1 = b[i].y1;
+	boxes[i].x2 = b[i].x2;
+	boxes[i].y2 = b[i].y2;
+    }
+    assert (pixman_region_init_rects (dst, boxes, n));
+    free (boxes);
+}
+
+static void
+check_same_boxes (pixman_region16_t *r16, pixman_region32_t *r32)
+{
+    pixman_box16_t *b16;
+    pixman_box32_t *b32;
+    int n16, n32, i;
+
+    b16 = pixman_region_rectangles (r16, &n16);
+    b32 = pixman_region32_rectangles (r32, &n32);
+
+    assert (n16 == n32);
+    for (i = 0; i < n32; i++)
+    {
+	assert (b16[i].x1 == b32[i].x1 && b16[i].y1 == b32[i].y1 &&
+		b16[i].x2 == b32[i].x2 && b16[i].y2 == b32[i].y2);
+    }
+}
+
+static void
+test_op (op_t op, pixman_region32_t *r1, pixman_region32_t *r2, int seed)
+{
+    static bitmap_t b1, b2, expected, result;
+    pixman_region32_t dst;
+    pixman_region16_t s1, s2, dst16;
+    int x, y;
+
+    rasterize (r1, b1);
+    rasterize (r2, b2);
+    for (y = 0; y < SIZE; y++)
+    {
+	for (x = 0; x < SIZE; x++)
+	{
+	    if (op == OP_UNION)
+		expected[y][x] = b1[y][x] | b2[y][x];
+	    else if (op == OP_INTERSECT)
+		expected[y][x] = b1[y][x] & b2[y][x];
+	    else
+		expected[y][x] = b1[y][x] & !b2[y][x];
+	}
+    }
+
+    pixman_region32_init (&dst);
+    region32_op (op, &dst, r1, r2);
+    rasterize (&dst, result);
+    if (memcmp (expected, result, sizeof (bitmap_t)) != 0)
+    {
+	printf ("%s differs from the reference for seed %d\n",
+		op_names[op], seed);
+	exit (1);
+    }
+    check_well_formed (&dst);
+
+    /* the result may also be one of the operands */
+    pixman_region32_copy (&dst, r1);
+    region32_op (op, &dst, &dst, r2);
+    rasterize (&dst, result);
+    assert (memcmp (expected, result, sizeof (bitmap_t)) == 0);
+
+    region16_from_region32 (&s1, r1);
+    region16_from_region32 (&s2, r2);
+    pixman_region_init (&dst16);
+    region16_op (op, &dst16, &s1, &s2);
+    check_same_boxes (&dst16, &dst);
+
+    pixman_region_fini (&dst16);
+    pixman_region_fini (&s2);
+    pixman_region_fini (&s1);
+    pixman_region32_fini (&dst);
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int seed, n_seeds;
+    op_t op;
+
+    n_seeds = argc > 1 ? atoi (argv[1]) : 20000;
+
+    for (seed = 0; seed < n_seeds; seed++)
+    {
+	pixman_region32_t r1, r2;
+
+	prng_srand (seed);
+	make_random_region (&r1);
+	make_random_region (&r2);
+
+	for (op = 0; op < N_OPS; op++)
+	{
+	    test_op (op, &r1, &r2, seed);
+	    test_op (op, &r2, &r1, seed);
+	}
+
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+    }
+
+    return 0;
+}
@@ -24,12 +24,45 @@ make_source (void)
     return source;
 }
 
+/* Sets up the filter that high quality downscaling uses: the box filter
+ * of the destination pixel, sampled from a box reconstruction of the
+ * source.
+ */
+static void
+set_convolution_filter (pixman_image_t *src, pixman_fixed_t s)
+{
+    pixman_fixed_t *params;
+    int n_params;
+
+    params = pixman_filter_create_separable_convolution (
+	&n_params, s, s,
+	PIXMAN_KERNEL_BOX, PIXMAN_KERNEL_BOX,
+	PIXMAN_KERNEL_BOX, PIXMAN_KERNEL_BOX, 4, 4);
+
+    pixman_image_set_filter (
+	src, PIXMAN_FILTER_SEPARABLE_CONVOLUTION, params, n_params);
+
+    free (params);
+}
+
 int
-main ()
+main (int argc, char *argv[])
 {
+    pixman_bool_t convolution = FALSE;
     double scale;
     pixman_image_t *src;
 
+    if (argc == 2 && strcmp (argv[1], "-c") == 0)
+    {
+	convolution = TRUE;
+    }
+    else if (argc != 1)
+    {
+	printf ("Usage: scaling-bench [-c]\n");
+	printf ("  -c : separable convolution rather than bilinear filtering\n");
+	return EXIT_FAILURE;
+    }
+
     prng_srand (23874);
     
     src = make_source ();
@@ -53,6 +86,8 @@ main ()
 
 	pixman_transform_init_scale (&transform, s, s);
 	pixman_image_set_transform (src, &transform);
+	if (convolution)
+	    set_convolution_filter (src, s);
 	
 	dest = pixman_image_create_bits (
 	    PIXMAN_a8r8g8b8, dest_width, dest_height, dest_buf, dest_byte_stride);
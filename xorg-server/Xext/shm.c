@@ -105,6 +105,9 @@ typedef struct _ShmScrPrivateRec {
 
 Bool noMITShmExtension = FALSE;
 
+/* -shmprefault */
+Bool ShmPrefaultSegments = FALSE;
+
 static PixmapPtr fbShmCreatePixmap(XSHM_CREATE_PIXMAP_ARGS);
 static int ShmDetachSegment(void *value, XID shmseg);
 static void ShmResetProc(ExtensionEntry *extEntry);
@@ -470,6 +473,13 @@ ShmDetachSegment(void *value, /* must conform to DeleteType */
     return Success;
 }
 
+/* Drop a reference taken with shmdesc->refcnt++ */
+void
+ShmReleaseSegment(ShmDescPtr shmdesc)
+{
+    ShmDetachSegment(shmdesc, 0);
+}
+
 static int
 ProcShmDetach(ClientPtr client)
 {
@@ -1150,6 +1160,46 @@ ProcShmCreatePixmap(ClientPtr client)
 
 #ifdef SHM_FD_PASSING
 
+/*
+ * A segment whose size is sealed cannot be truncated by the client, so
+ * touching it can never raise SIGBUS and it needs no busfault handler.
+ */
+static Bool
+ShmFdSealed(int fd)
+{
+#ifdef F_GET_SEALS
+    int seals = fcntl(fd, F_GET_SEALS);
+
+    return seals != -1 && (seals & F_SEAL_SHRINK);
+#else
+    return FALSE;
+#endif
+}
+
+/*
+ * Segments of a few megabytes and up are video frames and the like:
+ * back them with transparent huge pages where shmem allows it.  With
+ * -shmprefault writable ones are also faulted in up front rather than
+ * one page at a time as the client first writes them.  That costs the
+ * memory of the whole segment at once, which a client that only draws
+ * part of it never pays otherwise, so it is not the default.
+ */
+#define SHM_LARGE_SEGMENT (2 * 1024 * 1024)
+
+static void
+ShmAdviseSegment(void *addr, size_t size, Bool writable)
+{
+    if (size < SHM_LARGE_SEGMENT)
+        return;
+#ifdef MADV_HUGEPAGE
+    madvise(addr, size, MADV_HUGEPAGE);
+#endif
+#ifdef MADV_POPULATE_WRITE
+    if (writable && ShmPrefaultSegments)
+        madvise(addr, size, MADV_POPULATE_WRITE);
+#endif
+}
+
 static void
 ShmBusfaultNotify(void *context)
 {
@@ -1169,6 +1219,7 @@ ProcShmAttachFd(ClientPtr client)
     ShmDescPtr shmdesc;
     REQUEST(xShmAttachFdReq);
     struct stat statb;
+    Bool sealed;
 
     SetReqFds(client, 1);
     REQUEST_SIZE_MATCH(xShmAttachFdReq);
@@ -1185,6 +1236,7 @@ ProcShmAttachFd(ClientPtr client)
         close(fd);
         return BadMatch;
     }
+    sealed = ShmFdSealed(fd);
 
     shmdesc = malloc(sizeof(ShmDescRec));
     if (!shmdesc) {
@@ -1208,11 +1260,14 @@ ProcShmAttachFd(ClientPtr client)
     shmdesc->size = statb.st_size;
     shmdesc->resource = stuff->shmseg;
 
-    shmdesc->busfault = busfault_register_mmap(shmdesc->addr, shmdesc->size, ShmBusfaultNotify, shmdesc);
-    if (!shmdesc->busfault) {
-        munmap(shmdesc->addr, shmdesc->size);
-        free(shmdesc);
-        return BadAlloc;
+    shmdesc->busfault = NULL;
+    if (!sealed) {
+        shmdesc->busfault = busfault_register_mmap(shmdesc->addr, shmdesc->size, ShmBusfaultNotify, shmdesc);
+        if (!shmdesc->busfault) {
+            munmap(shmdesc->addr, shmdesc->size);
+            free(shmdesc);
+            return BadAlloc;
+        }
     }
 
     shmdesc->next = Shmsegs;
@@ -1303,6 +1358,10 @@ ProcShmCreateSegment(ClientPtr client)
         close(fd);
         return BadAlloc;
     }
+#ifdef F_SEAL_GROW
+    /* memfds come with F_SEAL_SHRINK already, fix the size for good */
+    fcntl(fd, F_ADD_SEALS, F_SEAL_GROW | F_SEAL_SEAL);
+#endif
     shmdesc = malloc(sizeof(ShmDescRec));
     if (!shmdesc) {
         close(fd);
@@ -1323,13 +1382,19 @@ ProcShmCreateSegment(ClientPtr client)
     shmdesc->refcnt = 1;
     shmdesc->writable = !stuff->readOnly;
     shmdesc->size = stuff->size;
+    shmdesc->resource = stuff->shmseg;
 
-    shmdesc->busfault = busfault_register_mmap(shmdesc->addr, shmdesc->size, ShmBusfaultNotify, shmdesc);
-    if (!shmdesc->busfault) {
-        close(fd);
-        munmap(shmdesc->addr, shmdesc->size);
-        free(shmdesc);
-        return BadAlloc;
+    ShmAdviseSegment(shmdesc->addr, shmdesc->size, shmdesc->writable);
+
+    shmdesc->busfault = NULL;
+    if (!ShmFdSealed(fd)) {
+        shmdesc->busfault = busfault_register_mmap(shmdesc->addr, shmdesc->size, ShmBusfaultNotify, shmdesc);
+        if (!shmdesc->busfault) {
+            close(fd);
+            munmap(shmdesc->addr, shmdesc->size);
+            free(shmdesc);
+            return BadAlloc;
+        }
     }
 
     shmdesc->next = Shmsegs;
@@ -31,6 +31,12 @@
 #include "protocol-versions.h"
 #include "extinit_priv.h"
 #include "dixstruct_priv.h"
+#include "servermd.h"
+#include "xace.h"
+
+#ifdef MITSHM
+#include "shmint.h"
+#endif
 
 #ifdef XINERAMA
 #include "panoramiX.h"
@@ -240,6 +246,8 @@ DamageExtCreate(DrawablePtr pDrawable, DamageReportLevel level,
     pDamageExt->pDrawable = pDrawable;
     pDamageExt->level = level;
     pDamageExt->pClient = client;
+    pDamageExt->tileHash = NULL;
+    pDamageExt->tileSize = 0;
     pDamageExt->pDamage = DamageCreate(DamageExtReport, DamageExtDestroy, level,
                                        FALSE, pDrawable->pScreen, pDamageExt);
     if (!pDamageExt->pDamage) {
@@ -460,6 +468,294 @@ ProcDamageAdd(ClientPtr client)
     return Success;
 }
 
+#ifdef MITSHM
+/*
+ * Hash of a tile as copied into the segment.  Zero marks tiles that have
+ * not been returned since the tile grid was set up.
+ */
+static uint64_t
+DamageExtTileHash(const CARD32 *data, unsigned long n)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (n--)
+        h = (h ^ *data++) * 0x100000001b3ULL;
+    return h | 1;
+}
+
+/*
+ * Round the damage out to tiles of the grid laid over the readable area,
+ * returning the damaged tiles in row-major order, clipped to the area.
+ * The grid, and the hashes along with it, starts over whenever the tile
+ * size or the area changes.
+ */
+static BoxPtr
+DamageExtTiles(DamageExtPtr pDamageExt, RegionPtr pDamage, BoxPtr pArea,
+               int tileSize, int *nTiles)
+{
+    int cols = (pArea->x2 - pArea->x1 + tileSize - 1) / tileSize;
+    int rows = (pArea->y2 - pArea->y1 + tileSize - 1) / tileSize;
+    BoxPtr pBox = RegionRects(pDamage);
+    int nBox = RegionNumRects(pDamage);
+    unsigned char *dirty;
+    BoxPtr tiles;
+    int i, n, x, y;
+
+    if (pDamageExt->tileSize != tileSize ||
+        memcmp(&pDamageExt->tileArea, pArea, sizeof(BoxRec))) {
+        free(pDamageExt->tileHash);
+        pDamageExt->tileHash = calloc((size_t) cols * rows, sizeof(uint64_t));
+        if (!pDamageExt->tileHash) {
+            pDamageExt->tileSize = 0;
+            return NULL;
+        }
+        pDamageExt->tileSize = tileSize;
+        pDamageExt->tileArea = *pArea;
+    }
+
+    dirty = calloc((size_t) cols * rows, 1);
+    if (!dirty)
+        return NULL;
+
+    n = 0;
+    for (i = 0; i < nBox; i++) {
+        int col1 = (pBox[i].x1 - pArea->x1) / tileSize;
+        int col2 = (pBox[i].x2 - pArea->x1 - 1) / tileSize;
+        int row1 = (pBox[i].y1 - pArea->y1) / tileSize;
+        int row2 = (pBox[i].y2 - pArea->y1 - 1) / tileSize;
+
+        for (y = row1; y <= row2; y++)
+            for (x = col1; x <= col2; x++)
+                if (!dirty[y * cols + x]) {
+                    dirty[y * cols + x] = 1;
+                    n++;
+                }
+    }
+
+    tiles = xallocarray(n, sizeof(BoxRec));
+    if (!tiles) {
+        free(dirty);
+        return NULL;
+    }
+
+    n = 0;
+    for (y = 0; y < rows; y++)
+        for (x = 0; x < cols; x++)
+            if (dirty[y * cols + x]) {
+                tiles[n].x1 = pArea->x1 + x * tileSize;
+                tiles[n].y1 = pArea->y1 + y * tileSize;
+                tiles[n].x2 = min(tiles[n].x1 + tileSize, pArea->x2);
+                tiles[n].y2 = min(tiles[n].y1 + tileSize, pArea->y2);
+                n++;
+            }
+
+    free(dirty);
+    *nTiles = n;
+    return tiles;
+}
+
+/* Record the new contents of a tile, returning FALSE if they are the same */
+static Bool
+DamageExtTileChanged(DamageExtPtr pDamageExt, BoxPtr pTile,
+                     const char *data, unsigned long len)
+{
+    BoxPtr pArea = &pDamageExt->tileArea;
+    int tileSize = pDamageExt->tileSize;
+    int cols = (pArea->x2 - pArea->x1 + tileSize - 1) / tileSize;
+    uint64_t *slot = &pDamageExt->tileHash[(pTile->y1 - pArea->y1) / tileSize *
+                                           cols +
+                                           (pTile->x1 - pArea->x1) / tileSize];
+    uint64_t hash = DamageExtTileHash((const CARD32 *) data, len / 4);
+
+    if (*slot == hash)
+        return FALSE;
+    *slot = hash;
+    return TRUE;
+}
+
+static int
+ProcDamageGetImage(ClientPtr client)
+{
+    REQUEST(xDamageGetImageReq);
+    DamageExtPtr pDamageExt;
+    DrawablePtr pDraw;
+    ScreenPtr pScreen;
+    ShmDescPtr shmdesc;
+    RegionPtr pVisible = NULL;
+    RegionRec damage, done;
+    BoxRec area;
+    BoxPtr pBox;
+    xRectangle *rects;
+    unsigned long offset, end;
+    int nBox, nRects, i, rc;
+    Bool more = FALSE;
+
+    REQUEST_SIZE_MATCH(xDamageGetImageReq);
+    VERIFY_DAMAGEEXT(pDamageExt, stuff->damage, client, DixWriteAccess);
+    rc = dixLookupResourceByType((void **) &shmdesc, stuff->shmseg,
+                                 ShmSegType, client, DixWriteAccess);
+    if (rc != Success)
+        return rc;
+    if ((stuff->offset & 3) || stuff->offset > shmdesc->size) {
+        client->errorValue = stuff->offset;
+        return BadValue;
+    }
+    if (!shmdesc->writable || stuff->size > shmdesc->size - stuff->offset)
+        return BadAccess;
+    if (stuff->tileSize && stuff->tileSize < 8) {
+        client->errorValue = stuff->tileSize;
+        return BadValue;
+    }
+
+    /* Raw damage is never accumulated, and the Xinerama protocol view
+     * spans screens that GetImage cannot read in one go */
+    if (pDamageExt->level == DamageReportRawRegion)
+        return BadMatch;
+#ifdef XINERAMA
+    if (!noPanoramiXExtension)
+        return BadMatch;
+#endif /* XINERAMA */
+
+    rc = dixLookupDrawable(&pDraw, pDamageExt->drawable, client, 0,
+                           DixReadAccess);
+    if (rc != Success)
+        return rc;
+    pScreen = pDraw->pScreen;
+
+    /* Only the part of the drawable GetImage would accept can be read */
+    if (pDraw->type == DRAWABLE_WINDOW) {
+        WindowPtr pWin = (WindowPtr) pDraw;
+        int bw = wBorderWidth(pWin);
+
+        if (!pWin->realized)
+            return BadMatch;
+        area.x1 = max(-bw, -pDraw->x);
+        area.y1 = max(-bw, -pDraw->y);
+        area.x2 = min(pDraw->width + bw, pScreen->width - pDraw->x);
+        area.y2 = min(pDraw->height + bw, pScreen->height - pDraw->y);
+        pVisible = &pWin->borderClip;
+    }
+    else {
+        area.x1 = 0;
+        area.y1 = 0;
+        area.x2 = pDraw->width;
+        area.y2 = pDraw->height;
+    }
+
+    if (area.x1 < area.x2 && area.y1 < area.y2) {
+        RegionInit(&damage, &area, 1);
+        RegionIntersect(&damage, &damage, DamageRegion(pDamageExt->pDamage));
+    }
+    else
+        RegionNull(&damage);
+
+    if (stuff->tileSize && RegionNotEmpty(&damage)) {
+        pBox = DamageExtTiles(pDamageExt, &damage, &area, stuff->tileSize,
+                              &nBox);
+        if (!pBox) {
+            RegionUninit(&damage);
+            return BadAlloc;
+        }
+    }
+    else {
+        pBox = RegionRects(&damage);
+        nBox = RegionNumRects(&damage);
+    }
+
+    rects = xallocarray(nBox, sizeof(xRectangle));
+    if (nBox && !rects) {
+        if (pBox != RegionRects(&damage))
+            free(pBox);
+        RegionUninit(&damage);
+        return BadAlloc;
+    }
+
+    offset = stuff->offset;
+    end = offset + stuff->size;
+    nRects = 0;
+    for (i = 0; i < nBox; i++) {
+        int w = pBox[i].x2 - pBox[i].x1;
+        int h = pBox[i].y2 - pBox[i].y1;
+        unsigned long stride = PixmapBytePad(w, pDraw->depth);
+        char *data = shmdesc->addr + offset;
+
+        if (stride * h > end - offset) {
+            more = TRUE;
+            break;
+        }
+
+        if (pDraw->type == DRAWABLE_WINDOW)
+            pScreen->SourceValidate(pDraw, pBox[i].x1, pBox[i].y1, w, h,
+                                    IncludeInferiors);
+        (*pScreen->GetImage) (pDraw, pBox[i].x1, pBox[i].y1, w, h,
+                              ZPixmap, ~0, data);
+        if (pVisible)
+            XaceCensorImage(client, pVisible, stride, pDraw,
+                            pBox[i].x1, pBox[i].y1, w, h, ZPixmap, data);
+
+        if (stuff->tileSize &&
+            !DamageExtTileChanged(pDamageExt, &pBox[i], data, stride * h))
+            continue;
+
+        rects[nRects].x = pBox[i].x1;
+        rects[nRects].y = pBox[i].y1;
+        rects[nRects].width = w;
+        rects[nRects].height = h;
+        nRects++;
+        offset += stride * h;
+    }
+
+    /* Whatever was read, changed or not, is no longer damaged */
+    if (i) {
+        RegionInitBoxes(&done, pBox, i);
+        if (DamageExtSubtract(pDamageExt, &done))
+            DamageExtReport(pDamageExt->pDamage,
+                            DamageRegion(pDamageExt->pDamage),
+                            (void *) pDamageExt);
+        RegionUninit(&done);
+    }
+
+    if (pBox != RegionRects(&damage))
+        free(pBox);
+    RegionUninit(&damage);
+
+    {
+        xDamageGetImageReply rep = {
+            .type = X_Reply,
+            .depth = pDraw->depth,
+            .sequenceNumber = client->sequence,
+            .length = bytes_to_int32(nRects * sizeof(xRectangle)),
+            .visual = pDraw->type == DRAWABLE_WINDOW ?
+                wVisual((WindowPtr) pDraw) : None,
+            .size = offset - stuff->offset,
+            .nRects = nRects,
+            .more = more,
+        };
+
+        if (client->swapped) {
+            swaps(&rep.sequenceNumber);
+            swapl(&rep.length);
+            swapl(&rep.visual);
+            swapl(&rep.size);
+            swapl(&rep.nRects);
+            SwapShorts((short *) rects, nRects * 4);
+        }
+        WriteToClient(client, sizeof(xDamageGetImageReply), &rep);
+        if (nRects)
+            WriteToClient(client, nRects * sizeof(xRectangle), rects);
+    }
+
+    free(rects);
+    return Success;
+}
+#else                           /* !MITSHM */
+static int
+ProcDamageGetImage(ClientPtr client)
+{
+    return BadImplementation;
+}
+#endif                          /* MITSHM */
+
 /* Major version controls available requests */
 static const int version_requests[] = {
     X_DamageQueryVersion,       /* before client sends QueryVersion */
@@ -484,6 +780,9 @@ ProcDamageDispatch(ClientPtr client)
 
     if (pDamageClient->major_version >= ARRAY_SIZE(version_requests))
         return BadRequest;
+    if (stuff->damageReqType == X_DamageGetImage &&
+        pDamageClient->major_version > 0)
+        return ProcDamageGetImage(client);
     if (stuff->damageReqType > version_requests[pDamageClient->major_version])
         return BadRequest;
     return (*ProcDamageVector[stuff->damageReqType]) (client);
@@ -539,6 +838,19 @@ SProcDamageAdd(ClientPtr client)
     return (*ProcDamageVector[stuff->damageReqType]) (client);
 }
 
+static int _X_COLD
+SProcDamageGetImage(ClientPtr client)
+{
+    REQUEST(xDamageGetImageReq);
+    REQUEST_SIZE_MATCH(xDamageGetImageReq);
+    swapl(&stuff->damage);
+    swapl(&stuff->shmseg);
+    swapl(&stuff->offset);
+    swapl(&stuff->size);
+    swaps(&stuff->tileSize);
+    return ProcDamageGetImage(client);
+}
+
 static int (*SProcDamageVector[XDamageNumberRequests]) (ClientPtr) = {
     /*************** Version 1 ******************/
     SProcDamageQueryVersion,
@@ -557,6 +869,9 @@ SProcDamageDispatch(ClientPtr client)
 
     if (pDamageClient->major_version >= ARRAY_SIZE(version_requests))
         return BadRequest;
+    if (stuff->damageReqType == X_DamageGetImage &&
+        pDamageClient->major_version > 0)
+        return SProcDamageGetImage(client);
     if (stuff->damageReqType > version_requests[pDamageClient->major_version])
         return BadRequest;
     return (*SProcDamageVector[stuff->damageReqType]) (client);
@@ -574,6 +889,7 @@ FreeDamageExt(void *value, XID did)
     if (pDamageExt->pDamage) {
         DamageDestroy(pDamageExt->pDamage);
     }
+    free(pDamageExt->tileHash);
     free(pDamageExt);
     return Success;
 }
@@ -40,6 +40,55 @@
 #include "damage.h"
 #include "xfixes.h"
 
+/*
+ * DamageGetImage is not part of the DAMAGE protocol but specific to this
+ * server, so it is defined here rather than in damageproto.h and the
+ * protocol version is left alone.  It has a request number far above
+ * those the protocol assigns, and clients may use it once they have sent
+ * QueryVersion; one that gets BadRequest is talking to another server.
+ *
+ * It copies the damaged part of the drawable into a shared memory
+ * segment and subtracts it from the damage.  Each rectangle in the reply
+ * is stored at offset in turn as a ZPixmap image with scanlines padded
+ * as for PutImage.  With a non-zero tileSize the damage is rounded out
+ * to tiles of that many pixels and tiles whose contents are unchanged
+ * since they were last returned are left out.  more is set when the
+ * segment filled up before all the damage was copied; what was not
+ * copied remains in the damage.
+ */
+#define X_DamageGetImage		128
+
+typedef struct {
+    CARD8	reqType;
+    CARD8	damageReqType;
+    CARD16	length;
+    CARD32	damage;
+    CARD32	shmseg;
+    CARD32	offset;
+    CARD32	size;
+    CARD16	tileSize;
+    CARD16	pad;
+} xDamageGetImageReq;
+
+#define sz_xDamageGetImageReq		24
+
+typedef struct {
+    BYTE	type;   /* X_Reply */
+    CARD8	depth;
+    CARD16	sequenceNumber;
+    CARD32	length;
+    VisualID	visual;
+    CARD32	size;
+    CARD32	nRects;
+    BOOL	more;
+    CARD8	pad1;
+    CARD16	pad2;
+    CARD32	pad3;
+    CARD32	pad4;
+} xDamageGetImageReply;
+
+#define sz_xDamageGetImageReply		32
+
 typedef struct _DamageClient {
     CARD32 major_version;
     CARD32 minor_version;
@@ -55,6 +104,10 @@ typedef struct _DamageExt {
     ClientPtr pClient;
     XID id;
     XID drawable;
+    /* contents of the tiles last returned by DamageGetImage */
+    uint64_t *tileHash;
+    BoxRec tileArea;
+    int tileSize;
 } DamageExtRec, *DamageExtPtr;
 
 #define VERIFY_DAMAGEEXT(pDamageExt, rid, client, mode) { \
@@ -57,106 +57,225 @@ SOFTWARE.
 #include "resource.h"
 #include "dix.h"
 
-#define InitialTableSize 256
+/*
+ * Atoms are kept in a two level table indexed by the atom value, with the
+ * names packed into a string arena, and found by name through an
+ * open-addressing hash of atom values.  Nothing is ever moved or freed
+ * before FreeAllAtoms: the tables are replaced rather than resized, so
+ * ValidAtom, NameForAtom and MakeAtom(..., FALSE) may be called without
+ * the server lock (e.g. from the input thread).  Creating atoms still
+ * requires the lock, there is only ever one writer.
+ */
 
-typedef struct _Node {
-    struct _Node *left, *right;
-    Atom a;
-    unsigned int fingerPrint;
+#define AtomChunkShift 8
+#define AtomChunkSize (1 << AtomChunkShift)
+#define InitialChunks 16
+#define InitialHashSize 1024
+#define ArenaBlockSize 4096
+
+#if defined(__GNUC__)
+#define LoadAcquire(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define StoreRelease(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+/* MSVC gives volatile accesses acquire and release semantics */
+#define LoadAcquire(p)          (*(p))
+#define StoreRelease(p, v)      (*(p) = (v))
+#endif
+
+typedef struct _AtomRec {
     const char *string;
-} NodeRec, *NodePtr;
+    unsigned int hash;
+    unsigned int len;
+} AtomRec;
 
-static Atom lastAtom = None;
-static NodePtr atomRoot = NULL;
-static unsigned long tableLength;
-static NodePtr *nodeTable;
+typedef struct _AtomDir {
+    struct _AtomDir *retired;
+    unsigned int numChunks;
+    AtomRec *volatile chunks[];
+} AtomDirRec, *AtomDirPtr;
 
-Atom
-MakeAtom(const char *string, unsigned len, Bool makeit)
+typedef struct _AtomHash {
+    struct _AtomHash *retired;
+    unsigned int mask;
+    volatile Atom slots[];
+} AtomHashRec, *AtomHashPtr;
+
+typedef struct _ArenaBlock {
+    struct _ArenaBlock *next;
+    size_t size, used;
+    char data[];
+} ArenaBlockRec, *ArenaBlockPtr;
+
+static volatile Atom lastAtom = None;
+static AtomDirPtr volatile atomDir;
+static AtomHashPtr volatile atomHash;
+static ArenaBlockPtr atomArena;
+
+static unsigned int
+HashAtomName(const char *string, unsigned len)
 {
-    NodePtr *np;
+    unsigned int hash = 2166136261U;
     unsigned i;
-    int comp;
-    unsigned int fp = 0;
 
-    np = &atomRoot;
-    for (i = 0; i < (len + 1) / 2; i++) {
-        fp = fp * 27 + string[i];
-        fp = fp * 27 + string[len - 1 - i];
-    }
-    while (*np != NULL) {
-        if (fp < (*np)->fingerPrint)
-            np = &((*np)->left);
-        else if (fp > (*np)->fingerPrint)
-            np = &((*np)->right);
-        else {                  /* now start testing the strings */
-            comp = strncmp(string, (*np)->string, (int) len);
-            if ((comp < 0) || ((comp == 0) && (len < strlen((*np)->string))))
-                np = &((*np)->left);
-            else if (comp > 0)
-                np = &((*np)->right);
-            else
-                return (*np)->a;
-        }
+    for (i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char) string[i]) * 16777619U;
+    return hash;
+}
+
+static inline AtomRec *
+AtomRecord(AtomDirPtr dir, Atom atom)
+{
+    return &dir->chunks[atom >> AtomChunkShift][atom & (AtomChunkSize - 1)];
+}
+
+static Atom
+LookupAtom(const char *string, unsigned len, unsigned int hash)
+{
+    AtomHashPtr table = LoadAcquire(&atomHash);
+    AtomRec *rec;
+    unsigned int i;
+    Atom a;
+
+    if (!table)
+        return None;
+    for (i = hash & table->mask;; i = (i + 1) & table->mask) {
+        a = LoadAcquire(&table->slots[i]);
+        if (a == None)
+            return None;
+        rec = AtomRecord(LoadAcquire(&atomDir), a);
+        if (rec->hash == hash && rec->len == len &&
+            memcmp(rec->string, string, len) == 0)
+            return a;
     }
-    if (makeit) {
-        NodePtr nd;
+}
 
-        nd = malloc(sizeof(NodeRec));
-        if (!nd)
-            return BAD_RESOURCE;
-        if (lastAtom < XA_LAST_PREDEFINED) {
-            nd->string = string;
+static char *
+ArenaCopy(const char *string, unsigned len)
+{
+    ArenaBlockPtr block = atomArena;
+    char *copy;
+
+    if (!block || block->used + len + 1 > block->size) {
+        /* long names get a block of their own, behind the current one */
+        Bool dedicated = len + 1 > ArenaBlockSize / 4;
+        size_t size = dedicated ? len + 1 : ArenaBlockSize;
+
+        block = malloc(sizeof(ArenaBlockRec) + size);
+        if (!block)
+            return NULL;
+        block->size = size;
+        block->used = 0;
+        if (dedicated && atomArena) {
+            block->next = atomArena->next;
+            atomArena->next = block;
         }
         else {
-            nd->string = strndup(string, len);
-            if (!nd->string) {
-                free(nd);
-                return BAD_RESOURCE;
-            }
-        }
-        if ((lastAtom + 1) >= tableLength) {
-            NodePtr *table;
-
-            table = reallocarray(nodeTable, tableLength, 2 * sizeof(NodePtr));
-            if (!table) {
-                if (nd->string != string) {
-                    /* nd->string has been strdup'ed */
-                    free((char *) nd->string);
-                }
-                free(nd);
-                return BAD_RESOURCE;
-            }
-            tableLength <<= 1;
-            nodeTable = table;
+            block->next = atomArena;
+            atomArena = block;
         }
-        *np = nd;
-        nd->left = nd->right = NULL;
-        nd->fingerPrint = fp;
-        nd->a = ++lastAtom;
-        nodeTable[lastAtom] = nd;
-        return nd->a;
     }
-    else
-        return None;
+    copy = block->data + block->used;
+    memcpy(copy, string, len);
+    copy[len] = '\0';
+    block->used += len + 1;
+    return copy;
+}
+
+static void
+HashInsert(AtomHashPtr table, Atom a, unsigned int hash)
+{
+    unsigned int i;
+
+    for (i = hash & table->mask; table->slots[i] != None;
+         i = (i + 1) & table->mask)
+        ;
+    StoreRelease(&table->slots[i], a);
+}
+
+/* Make room for atom a, replacing the tables that are too small. */
+static Bool
+GrowAtomTables(Atom a)
+{
+    AtomDirPtr dir = atomDir, newDir;
+    AtomHashPtr table = atomHash, newTable;
+    unsigned int size, chunk = a >> AtomChunkShift;
+    Atom i;
+
+    if (chunk >= dir->numChunks) {
+        size = dir->numChunks * 2;
+        newDir = calloc(1, sizeof(AtomDirRec) + size * sizeof(AtomRec *));
+        if (!newDir)
+            return FALSE;
+        newDir->numChunks = size;
+        memcpy((void *) newDir->chunks, (void *) dir->chunks,
+               dir->numChunks * sizeof(AtomRec *));
+        newDir->retired = dir;
+        StoreRelease(&atomDir, newDir);
+        dir = newDir;
+    }
+    if (!dir->chunks[chunk]) {
+        AtomRec *recs = calloc(AtomChunkSize, sizeof(AtomRec));
+
+        if (!recs)
+            return FALSE;
+        StoreRelease(&dir->chunks[chunk], recs);
+    }
+    if (a * 2 > table->mask + 1) {
+        size = (table->mask + 1) * 2;
+        newTable = calloc(1, sizeof(AtomHashRec) + size * sizeof(Atom));
+        if (!newTable)
+            return FALSE;
+        newTable->mask = size - 1;
+        for (i = 1; i < a; i++)
+            HashInsert(newTable, i, AtomRecord(dir, i)->hash);
+        newTable->retired = table;
+        StoreRelease(&atomHash, newTable);
+    }
+    return TRUE;
+}
+
+Atom
+MakeAtom(const char *string, unsigned len, Bool makeit)
+{
+    unsigned int hash = HashAtomName(string, len);
+    AtomRec *rec;
+    Atom a;
+
+    a = LookupAtom(string, len, hash);
+    if (a != None || !makeit)
+        return a;
+
+    a = lastAtom + 1;
+    if (!GrowAtomTables(a))
+        return BAD_RESOURCE;
+    rec = AtomRecord(atomDir, a);
+    if (a <= XA_LAST_PREDEFINED)
+        rec->string = string;
+    else {
+        rec->string = ArenaCopy(string, len);
+        if (!rec->string)
+            return BAD_RESOURCE;
+    }
+    rec->hash = hash;
+    rec->len = len;
+    /* the record must be complete before readers can find it */
+    HashInsert(atomHash, a, hash);
+    StoreRelease(&lastAtom, a);
+    return a;
 }
 
 Bool
 ValidAtom(Atom atom)
 {
-    return (atom != None) && (atom <= lastAtom);
+    return (atom != None) && (atom <= LoadAcquire(&lastAtom));
 }
 
 const char *
 NameForAtom(Atom atom)
 {
-    NodePtr node;
-
-    if (atom > lastAtom)
-        return 0;
-    if ((node = nodeTable[atom]) == NULL)
+    if (atom == None || atom > LoadAcquire(&lastAtom))
         return 0;
-    return node->string;
+    return AtomRecord(LoadAcquire(&atomDir), atom)->string;
 }
 
 void
@@ -165,32 +284,33 @@ AtomError(void)
     FatalError("initializing atoms");
 }
 
-static void
-FreeAtom(NodePtr patom)
-{
-    if (patom->left)
-        FreeAtom(patom->left);
-    if (patom->right)
-        FreeAtom(patom->right);
-    if (patom->a > XA_LAST_PREDEFINED) {
-        /*
-         * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's safe to
-         * cast here
-         */
-        free((char *) patom->string);
-    }
-    free(patom);
-}
-
 void
 FreeAllAtoms(void)
 {
-    if (atomRoot == NULL)
+    AtomDirPtr dir, nextDir;
+    AtomHashPtr table, nextTable;
+    ArenaBlockPtr block, nextBlock;
+    unsigned int i;
+
+    if (atomDir == NULL)
         return;
-    FreeAtom(atomRoot);
-    atomRoot = NULL;
-    free(nodeTable);
-    nodeTable = NULL;
+    for (i = 0; i < atomDir->numChunks; i++)
+        free(atomDir->chunks[i]);
+    for (dir = atomDir; dir; dir = nextDir) {
+        nextDir = dir->retired;
+        free(dir);
+    }
+    for (table = atomHash; table; table = nextTable) {
+        nextTable = table->retired;
+        free(table);
+    }
+    for (block = atomArena; block; block = nextBlock) {
+        nextBlock = block->next;
+        free(block);
+    }
+    atomDir = NULL;
+    atomHash = NULL;
+    atomArena = NULL;
     lastAtom = None;
 }
 
@@ -198,11 +318,14 @@ void
 InitAtoms(void)
 {
     FreeAllAtoms();
-    tableLength = InitialTableSize;
-    nodeTable = xallocarray(InitialTableSize, sizeof(NodePtr));
-    if (!nodeTable)
+    atomDir = calloc(1, sizeof(AtomDirRec) +
+                     InitialChunks * sizeof(AtomRec *));
+    atomHash = calloc(1, sizeof(AtomHashRec) +
+                      InitialHashSize * sizeof(Atom));
+    if (!atomDir || !atomHash)
         AtomError();
-    nodeTable[None] = NULL;
+    atomDir->numChunks = InitialChunks;
+    atomHash->mask = InitialHashSize - 1;
     MakePredeclaredAtoms();
     if (lastAtom != XA_LAST_PREDEFINED)
         AtomError();
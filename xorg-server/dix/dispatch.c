@@ -590,12 +590,17 @@ void DispatchQueuedEvents(Bool wait)
                     result = XaceHookDispatch(client, client->majorOp);
                     if (result == Success) {
                         currentClient = client;
-                        result =
-                            (*client->requestVector[client->majorOp]) (client);
+                        if (!DispatchThreads || !QueueClientRequest(client))
+                            result =
+                                (*client->requestVector[client->majorOp]) (client);
                         currentClient = NULL;
                     }
                 }
-                if (!SmartScheduleSignalEnable)
+                /* requests already sitting in the input buffer are
+                 * cheap, so only look at the clock every so often
+                 * while working through a run of them */
+                if (!SmartScheduleSignalEnable &&
+                    (!ClientRequestRun(client) || !(client->sequence & 15)))
                     SmartScheduleTime = GetTimeInMillis();
 
 #ifdef XSERVER_DTRACE
@@ -1608,8 +1613,10 @@ ProcCreatePixmap(ClientPtr client)
             dixDestroyPixmap(pMap, 0);
             return rc;
         }
-        if (AddResource(stuff->pid, X11_RESTYPE_PIXMAP, (void *) pMap))
+        if (AddResource(stuff->pid, X11_RESTYPE_PIXMAP, (void *) pMap)) {
+            DispatchPixmapCreated(pMap);
             return Success;
+        }
     }
     return BadAlloc;
 }
@@ -2225,6 +2232,38 @@ ProcPutImage(ClientPtr client)
     return Success;
 }
 
+/* GetImage writes every scanline up to the byte holding its last pixel,
+ * so only the padding beyond that has to be cleared before the buffer
+ * can go to the client. */
+static char *
+AllocImageChunk(long length, long widthBytesLine, long usedBytes)
+{
+    char *pBuf = malloc(length);
+    long off;
+
+    if (pBuf && usedBytes < widthBytesLine)
+        for (off = 0; off < length; off += widthBytesLine)
+            memset(pBuf + off + usedBytes, 0, widthBytesLine - usedBytes);
+    return pBuf;
+}
+
+/* Hand a finished chunk of a multi-chunk GetImage reply to the output
+ * queue without copying it and return a fresh buffer for the next one.
+ * If that can't be allocated, fall back to copying and keep pBuf. */
+static char *
+WriteImageChunk(ClientPtr client, char *pBuf, int count, long length,
+                long widthBytesLine, long usedBytes)
+{
+    char *next = AllocImageChunk(length, widthBytesLine, usedBytes);
+
+    if (!next) {
+        WriteToClient(client, count, pBuf);
+        return pBuf;
+    }
+    WriteToClientRef(client, count, pBuf, free, pBuf);
+    return next;
+}
+
 static int
 DoGetImage(ClientPtr client, int format, Drawable drawable,
            int x, int y, int width, int height,
@@ -2236,7 +2275,7 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
 
     /* coordinates relative to the bounding drawable */
     int relx, rely;
-    long widthBytesLine, length;
+    long widthBytesLine, usedBytes, length;
     Mask plane = 0;
     char *pBuf;
     xGetImageReply xgi;
@@ -2314,11 +2353,13 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
     xgi.depth = pDraw->depth;
     if (format == ZPixmap) {
         widthBytesLine = PixmapBytePad(width, pDraw->depth);
+        usedBytes = ((long) width * BitsPerPixel(pDraw->depth)) >> 3;
         length = widthBytesLine * height;
 
     }
     else {
         widthBytesLine = BitmapBytePad(width);
+        usedBytes = width >> 3;
         plane = ((Mask) 1) << (pDraw->depth - 1);
         /* only planes asked for */
         length = widthBytesLine * height *
@@ -2351,7 +2392,7 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             length += widthBytesLine;
         }
     }
-    if (!(pBuf = calloc(1, length)))
+    if (!(pBuf = AllocImageChunk(length, widthBytesLine, usedBytes)))
         return BadAlloc;
     WriteReplyToClient(client, sizeof(xGetImageReply), &xgi);
 
@@ -2384,7 +2425,12 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             ReformatImage(pBuf, (int) (nlines * widthBytesLine),
                           BitsPerPixel(pDraw->depth), ClientOrder(client));
 
-            WriteToClient(client, (int) (nlines * widthBytesLine), pBuf);
+            if (linesPerBuf < height)
+                pBuf = WriteImageChunk(client, pBuf,
+                                       (int) (nlines * widthBytesLine), length,
+                                       widthBytesLine, usedBytes);
+            else
+                WriteToClient(client, (int) (nlines * widthBytesLine), pBuf);
             linesDone += nlines;
         }
     }
@@ -2412,7 +2458,14 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
                     ReformatImage(pBuf, (int) (nlines * widthBytesLine),
                                   1, ClientOrder(client));
 
-                    WriteToClient(client, (int)(nlines * widthBytesLine), pBuf);
+                    if (linesPerBuf < height)
+                        pBuf = WriteImageChunk(client, pBuf,
+                                               (int) (nlines * widthBytesLine),
+                                               length, widthBytesLine,
+                                               usedBytes);
+                    else
+                        WriteToClient(client, (int)(nlines * widthBytesLine),
+                                      pBuf);
                     linesDone += nlines;
                 }
             }
@@ -3576,6 +3629,9 @@ CloseDownClient(ClientPtr client)
     Bool really_close_down = client->clientGone ||
         client->closeDownMode == DestroyAll;
 
+    if (DispatchThreads)
+        WaitForClientRendering(client->index);
+
     if (!client->clientGone) {
         /* ungrab server if grabbing client dies */
         if (grabState != GrabNone && grabClient == client) {
@@ -0,0 +1,388 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Threaded dispatch of rendering to client private pixmaps (-dispatchthreads).
+ *
+ * Requests are still read, checked and looked up on the main thread, which
+ * thereby acts as the lock on all shared server state.  Only the drawing
+ * itself of PutImage (ZPixmap) and PolyFillRectangle requests into a
+ * pixmap that nobody but its owner can get at is handed to a pool of
+ * worker threads.  The requests of one client run on one worker at a time
+ * and in order, so several clients' rendering can overlap while the main
+ * thread goes on dispatching.
+ *
+ * A pixmap qualifies if it was made by core CreatePixmap and has only ever
+ * been looked up by core requests of its owner, so no extension or other
+ * client has attached any state to it, and nothing holds a reference to
+ * it.  The GC must belong to the same client, use FillSolid and already be
+ * validated for the pixmap, so the workers never run ValidateGC.
+ *
+ * Anything else that wants at a client's resources has to look them up,
+ * and every lookup waits for the owner's queued rendering first; so does
+ * closing the client down.  Nothing else is ever reordered.
+ */
+
+#include <dix-config.h>
+
+#include "dix/dix_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "resource.h"
+#include "pixmapstr.h"
+#include "gcstruct.h"
+#include "servermd.h"
+#include "privates.h"
+#include "list.h"
+
+#ifdef DISPATCH_THREADS
+
+#include <pthread.h>
+#include <signal.h>
+#include <X11/Xproto.h>
+
+#define DISPATCH_MAX_THREADS    16
+#define DISPATCH_QUEUE_JOBS     256
+#define DISPATCH_QUEUE_BYTES    (16 * 1024 * 1024)
+
+typedef struct _DispatchJob {
+    struct xorg_list entry;
+    DrawablePtr pDraw;
+    GCPtr pGC;
+    size_t length;
+    xReq req[];                 /* copy of the request */
+} DispatchJobRec, *DispatchJobPtr;
+
+typedef struct _ClientJobs {
+    struct xorg_list jobs;      /* oldest first */
+    struct xorg_list ready;     /* on dispatchReady while not running */
+    int count;
+    size_t bytes;
+    Bool running;
+    Bool queued;                /* main thread only: may have jobs */
+} ClientJobsRec, *ClientJobsPtr;
+
+int DispatchThreads;
+
+static DevPrivateKeyRec dispatchPixmapKeyRec;
+static ClientJobsRec clientJobs[MAXCLIENTS];
+static ClientPtr deferringClient;
+
+static pthread_mutex_t dispatchLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dispatchWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t dispatchDone = PTHREAD_COND_INITIALIZER;
+static struct xorg_list dispatchReady;
+static int dispatchWorkers;
+static Bool dispatchWaiting;
+
+static void
+RunJob(DispatchJobPtr job)
+{
+    GCPtr pGC = job->pGC;
+
+    switch (job->req->reqType) {
+    case X_PutImage: {
+        xPutImageReq *stuff = (xPutImageReq *) job->req;
+
+        (*pGC->ops->PutImage) (job->pDraw, pGC, stuff->depth,
+                               stuff->dstX, stuff->dstY,
+                               stuff->width, stuff->height,
+                               0, ZPixmap, (char *) &stuff[1]);
+        break;
+    }
+    case X_PolyFillRectangle:
+        (*pGC->ops->PolyFillRect) (job->pDraw, pGC,
+                                   (job->length - sizeof(xPolyFillRectangleReq)) /
+                                   sizeof(xRectangle),
+                                   (xRectangle *) ((xPolyFillRectangleReq *)
+                                                   job->req + 1));
+        break;
+    }
+}
+
+static void *
+DispatchWorker(void *arg)
+{
+    ClientJobsPtr jobs;
+    DispatchJobPtr job;
+#ifndef WIN32
+    sigset_t set;
+
+    /* Don't handle any signals on this thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+    pthread_mutex_lock(&dispatchLock);
+    for (;;) {
+        if (xorg_list_is_empty(&dispatchReady)) {
+            pthread_cond_wait(&dispatchWork, &dispatchLock);
+            continue;
+        }
+        jobs = xorg_list_first_entry(&dispatchReady, ClientJobsRec, ready);
+        xorg_list_del(&jobs->ready);
+        jobs->running = TRUE;
+
+        while (!xorg_list_is_empty(&jobs->jobs)) {
+            job = xorg_list_first_entry(&jobs->jobs, DispatchJobRec, entry);
+            pthread_mutex_unlock(&dispatchLock);
+            RunJob(job);
+            pthread_mutex_lock(&dispatchLock);
+            xorg_list_del(&job->entry);
+            jobs->count--;
+            jobs->bytes -= job->length;
+            free(job);
+            if (dispatchWaiting)
+                pthread_cond_signal(&dispatchDone);
+        }
+        jobs->running = FALSE;
+    }
+    return NULL;
+}
+
+/* Per generation, after the privates have been reset. */
+void
+InitDispatchThreads(void)
+{
+    pthread_t thread;
+    int i;
+
+    if (DispatchThreads <= 0)
+        return;
+
+    if (!dixRegisterPrivateKey(&dispatchPixmapKeyRec, PRIVATE_PIXMAP, 0))
+        FatalError("failed to register dispatch pixmap private\n");
+
+    if (dispatchWorkers)
+        return;
+    xorg_list_init(&dispatchReady);
+    for (i = 0; i < MAXCLIENTS; i++) {
+        xorg_list_init(&clientJobs[i].jobs);
+        xorg_list_init(&clientJobs[i].ready);
+    }
+    while (dispatchWorkers < min(DispatchThreads, DISPATCH_MAX_THREADS) &&
+           pthread_create(&thread, NULL, DispatchWorker, NULL) == 0) {
+        pthread_detach(thread);
+        dispatchWorkers++;
+    }
+    if (!dispatchWorkers) {
+        ErrorF("dispatch: could not start any threads\n");
+        DispatchThreads = 0;
+    }
+}
+
+/* Wait until all rendering queued for client index cid is done. */
+static void
+WaitForClientJobs(int cid)
+{
+    ClientJobsPtr jobs = &clientJobs[cid];
+
+    pthread_mutex_lock(&dispatchLock);
+    dispatchWaiting = TRUE;
+    while (jobs->count)
+        pthread_cond_wait(&dispatchDone, &dispatchLock);
+    dispatchWaiting = FALSE;
+    pthread_mutex_unlock(&dispatchLock);
+    jobs->queued = FALSE;
+}
+
+void
+WaitForClientRendering(int client)
+{
+    if (clientJobs[client].queued)
+        WaitForClientJobs(client);
+}
+
+/* Called for every successful resource lookup while threads are on. */
+void
+DispatchResourceAccess(ClientPtr client, XID id, RESTYPE type, void *value)
+{
+    int cid = CLIENT_ID(id);
+
+    if (client && client == deferringClient)
+        return;
+    WaitForClientRendering(cid);
+    if (type == X11_RESTYPE_PIXMAP &&
+        (!client || client->index != cid || client->majorOp >= EXTENSION_BASE))
+        dixSetPrivate(&((PixmapPtr) value)->devPrivates,
+                      &dispatchPixmapKeyRec, NULL);
+}
+
+/* A pixmap made by core CreatePixmap starts out private to its client. */
+void
+DispatchPixmapCreated(PixmapPtr pPixmap)
+{
+    if (DispatchThreads)
+        dixSetPrivate(&pPixmap->devPrivates, &dispatchPixmapKeyRec,
+                      (void *) 1);
+}
+
+static Bool
+LookupPrivateTarget(ClientPtr client, XID drawable, XID gc,
+                    DrawablePtr *ppDraw, GCPtr *ppGC)
+{
+    DrawablePtr pDraw;
+    GCPtr pGC;
+    int rc;
+
+    if (CLIENT_ID(drawable) != client->index || CLIENT_ID(gc) != client->index)
+        return FALSE;
+
+    deferringClient = client;
+    rc = dixLookupDrawable(&pDraw, drawable, client, M_DRAWABLE_PIXMAP,
+                           DixWriteAccess);
+    if (rc == Success)
+        rc = dixLookupGC(&pGC, gc, client, DixUseAccess);
+    deferringClient = NULL;
+    if (rc != Success)
+        return FALSE;
+
+    if (((PixmapPtr) pDraw)->refcnt != 1 ||
+        !dixLookupPrivate(&((PixmapPtr) pDraw)->devPrivates,
+                          &dispatchPixmapKeyRec))
+        return FALSE;
+    if (pGC->depth != pDraw->depth || pGC->pScreen != pDraw->pScreen ||
+        pGC->serialNumber != pDraw->serialNumber || pGC->stateChanges ||
+        pGC->fillStyle != FillSolid)
+        return FALSE;
+
+    *ppDraw = pDraw;
+    *ppGC = pGC;
+    return TRUE;
+}
+
+static Bool
+QueueJob(ClientPtr client, DrawablePtr pDraw, GCPtr pGC)
+{
+    ClientJobsPtr jobs = &clientJobs[client->index];
+    size_t length = (size_t) client->req_len << 2;
+    DispatchJobPtr job;
+
+    job = malloc(sizeof(DispatchJobRec) + length);
+    if (!job)
+        return FALSE;
+    job->pDraw = pDraw;
+    job->pGC = pGC;
+    job->length = length;
+    memcpy(job->req, client->requestBuffer, length);
+
+    pthread_mutex_lock(&dispatchLock);
+    dispatchWaiting = TRUE;
+    while (jobs->count >= DISPATCH_QUEUE_JOBS ||
+           (jobs->count && jobs->bytes + length > DISPATCH_QUEUE_BYTES))
+        pthread_cond_wait(&dispatchDone, &dispatchLock);
+    dispatchWaiting = FALSE;
+    xorg_list_append(&job->entry, &jobs->jobs);
+    jobs->count++;
+    jobs->bytes += length;
+    if (!jobs->running && xorg_list_is_empty(&jobs->ready)) {
+        xorg_list_append(&jobs->ready, &dispatchReady);
+        pthread_cond_signal(&dispatchWork);
+    }
+    pthread_mutex_unlock(&dispatchLock);
+    jobs->queued = TRUE;
+    return TRUE;
+}
+
+/*
+ * Queue the current request of client for a worker if it qualifies.
+ * Returns FALSE to have it dispatched as usual; that includes requests
+ * that are in error, so that the regular handler reports them.
+ */
+Bool
+QueueClientRequest(ClientPtr client)
+{
+    DrawablePtr pDraw;
+    GCPtr pGC;
+
+    if (client->swapped)
+        return FALSE;
+
+    switch (client->majorOp) {
+    case X_PutImage: {
+        long length;
+        REQUEST(xPutImageReq);
+
+        if (client->req_len < bytes_to_int32(sizeof(xPutImageReq)) ||
+            stuff->format != ZPixmap || stuff->leftPad != 0 ||
+            !LookupPrivateTarget(client, stuff->drawable, stuff->gc,
+                                 &pDraw, &pGC) ||
+            pDraw->depth != stuff->depth)
+            return FALSE;
+        length = PixmapBytePad(stuff->width, stuff->depth);
+        if (stuff->height != 0 && length >= (INT32_MAX / stuff->height))
+            return FALSE;
+        if (bytes_to_int32(length * stuff->height) +
+            bytes_to_int32(sizeof(xPutImageReq)) != client->req_len)
+            return FALSE;
+        return QueueJob(client, pDraw, pGC);
+    }
+    case X_PolyFillRectangle: {
+        REQUEST(xPolyFillRectangleReq);
+
+        if (client->req_len < bytes_to_int32(sizeof(xPolyFillRectangleReq)) ||
+            (((client->req_len << 2) - sizeof(xPolyFillRectangleReq)) & 4) ||
+            !LookupPrivateTarget(client, stuff->drawable, stuff->gc,
+                                 &pDraw, &pGC))
+            return FALSE;
+        if (client->req_len == bytes_to_int32(sizeof(xPolyFillRectangleReq)))
+            return TRUE;        /* nothing to draw */
+        return QueueJob(client, pDraw, pGC);
+    }
+    }
+    return FALSE;
+}
+
+#else
+
+int DispatchThreads;
+
+void
+InitDispatchThreads(void)
+{
+    DispatchThreads = 0;
+}
+
+void
+WaitForClientRendering(int client)
+{
+}
+
+void
+DispatchResourceAccess(ClientPtr client, XID id, RESTYPE type, void *value)
+{
+}
+
+void
+DispatchPixmapCreated(PixmapPtr pPixmap)
+{
+}
+
+Bool
+QueueClientRequest(ClientPtr client)
+{
+    return FALSE;
+}
+
+#endif
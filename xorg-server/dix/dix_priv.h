@@ -49,6 +49,16 @@ void ProcessWorkQueue(void);
 void ProcessWorkQueueZombies(void);
 
 void CloseDownClient(ClientPtr client);
+
+/* -dispatchthreads, see dispatchthreads.c */
+extern int DispatchThreads;
+
+void InitDispatchThreads(void);
+Bool QueueClientRequest(ClientPtr client);
+void WaitForClientRendering(int client);
+void DispatchResourceAccess(ClientPtr client, XID id, RESTYPE type,
+                            void *value);
+void DispatchPixmapCreated(PixmapPtr pPixmap);
 ClientPtr GetCurrentClient(void);
 void InitClient(ClientPtr client, int i, void *ospriv);
 
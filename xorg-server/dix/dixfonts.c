@@ -121,13 +121,112 @@ LoadGlyphs(ClientPtr client, FontPtr pfont, unsigned nchars, int item_size,
         return Successful;
 }
 
+/*
+ * Fonts that are complete once opened (all but font server fonts) keep
+ * a table of the CharInfo each character code maps to, so that text
+ * requests, which look their glyphs up both for damage and for drawing,
+ * do not go back into the font library for every character.  8-bit
+ * codes have a table of their own, 16-bit codes in the font's own
+ * encoding are kept a row of 256 at a time.  Characters the font lacks
+ * map to NoCharInfo.
+ */
+typedef struct _FontCharCache {
+    CharInfoPtr linear8[256];
+    CharInfoPtr *rows[256];
+} FontCharCacheRec, *FontCharCachePtr;
+
+static CharInfoRec NoCharInfo;
+static int fontCharCacheIndex = -1;
+
+static FontCharCachePtr
+FontCharCache(FontPtr font)
+{
+    FontCharCachePtr cache;
+
+    if (fontCharCacheIndex < 0 ||
+        fpe_functions[font->fpe->type]->load_glyphs)
+        return NULL;
+
+    cache = FontGetPrivate(font, fontCharCacheIndex);
+    if (!cache) {
+        cache = calloc(1, sizeof(FontCharCacheRec));
+        if (cache && !xfont2_font_set_private(font, fontCharCacheIndex,
+                                              cache)) {
+            free(cache);
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+static void
+FreeFontCharCache(FontPtr font)
+{
+    FontCharCachePtr cache;
+    int i;
+
+    if (fontCharCacheIndex < 0 ||
+        !(cache = FontGetPrivate(font, fontCharCacheIndex)))
+        return;
+
+    for (i = 0; i < ARRAY_SIZE(cache->rows); i++)
+        free(cache->rows[i]);
+    free(cache);
+    xfont2_font_set_private(font, fontCharCacheIndex, NULL);
+}
+
+static CharInfoPtr
+FontCharLookup(FontPtr font, unsigned char *chars, FontEncoding fontEncoding)
+{
+    unsigned long n;
+    CharInfoPtr pci;
+
+    (*font->get_glyphs) (font, 1, chars, fontEncoding, &n, &pci);
+    return n ? pci : &NoCharInfo;
+}
+
 void
 GetGlyphs(FontPtr font, unsigned long count, unsigned char *chars,
           FontEncoding fontEncoding,
           unsigned long *glyphcount,    /* RETURN */
           CharInfoPtr *glyphs)          /* RETURN */
 {
-    (*font->get_glyphs) (font, count, chars, fontEncoding, glyphcount, glyphs);
+    FontEncoding encoding16 = FONTLASTROW(font) == 0 ? Linear16Bit : TwoD16Bit;
+    FontCharCachePtr cache;
+    CharInfoPtr pci, *row;
+    unsigned long i, n = 0;
+
+    if ((fontEncoding != Linear8Bit && fontEncoding != encoding16) ||
+        !(cache = FontCharCache(font))) {
+        (*font->get_glyphs) (font, count, chars, fontEncoding, glyphcount,
+                             glyphs);
+        return;
+    }
+
+    if (fontEncoding == Linear8Bit) {
+        for (i = 0; i < count; i++) {
+            if (!(pci = cache->linear8[chars[i]]))
+                pci = cache->linear8[chars[i]] =
+                    FontCharLookup(font, &chars[i], fontEncoding);
+            if (pci != &NoCharInfo)
+                glyphs[n++] = pci;
+        }
+    }
+    else {
+        for (i = 0; i < count; i++, chars += 2) {
+            row = cache->rows[chars[0]];
+            if (!row)
+                row = cache->rows[chars[0]] = calloc(256, sizeof(CharInfoPtr));
+            if (!row)
+                pci = FontCharLookup(font, chars, fontEncoding);
+            else if (!(pci = row[chars[1]]))
+                pci = row[chars[1]] = FontCharLookup(font, chars,
+                                                     fontEncoding);
+            if (pci != &NoCharInfo)
+                glyphs[n++] = pci;
+        }
+    }
+    *glyphcount = n;
 }
 
 /*
@@ -490,6 +589,7 @@ CloseFont(void *value, XID fid)
 #ifdef XF86BIGFONT
         XF86BigfontFreeFontShm(pfont);
 #endif
+        FreeFontCharCache(pfont);
         fpe = pfont->fpe;
         (*fpe_functions[fpe->type]->close_font) (fpe, pfont);
         FreeFPE(fpe);
@@ -2104,4 +2204,9 @@ InitFonts(void)
 	xfont2_free_font_pattern_cache(fontPatternCache);
     fontPatternCache = xfont2_make_font_pattern_cache();
     xfont2_init(&xfont2_client_funcs);
+
+    /* The font library hands out private indices for the life of the
+     * process */
+    if (fontCharCacheIndex < 0)
+        fontCharCacheIndex = xfont2_allocate_font_private_index();
 }
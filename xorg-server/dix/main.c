@@ -226,6 +226,7 @@ dix_main(int argc, char *argv[], char *envp[])
 
         /* Initialize privates before first allocation */
         dixResetPrivates();
+        InitDispatchThreads();
 
         /* Initialize server client devPrivates, to be reallocated as
          * more client privates are registered
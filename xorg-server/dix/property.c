@@ -46,6 +46,9 @@ SOFTWARE.
 
 #include <dix-config.h>
 
+#include <limits.h>
+#include <stdint.h>
+
 #include <X11/X.h>
 #include <X11/Xproto.h>
 
@@ -88,18 +91,171 @@ PrintPropertys(WindowPtr pWin)
 }
 #endif
 
+/*
+ * Property values are reference counted, so that a large GetProperty
+ * reply can be queued straight from the value instead of being copied
+ * into the output buffer, and the value changed or deleted before the
+ * reply has gone out.
+ */
+typedef union _PropertyData {
+    int refcnt;
+    double align;
+} PropertyDataRec, *PropertyDataPtr;
+
+#define PropertyDataHeader(data) ((PropertyDataPtr) (data) - 1)
+
+/* Replies with at least this many bytes of unswapped data are queued by
+ * reference */
+#define PROPERTY_REF_MIN 4096
+
+/* Allocate the value of a property of n elements of elemsize bytes */
+static void *
+PropertyDataAlloc(unsigned long n, int elemsize)
+{
+    PropertyDataPtr header;
+
+    if (elemsize && n > (SIZE_MAX - sizeof(PropertyDataRec)) / elemsize)
+        return NULL;
+    header = malloc(sizeof(PropertyDataRec) + (size_t) n * elemsize);
+    if (!header)
+        return NULL;
+    header->refcnt = 1;
+    return header + 1;
+}
+
+static void
+PropertyDataFree(void *data)
+{
+    if (data && --PropertyDataHeader(data)->refcnt == 0)
+        free(PropertyDataHeader(data));
+}
+
+/*
+ * A window's properties are kept in a list, and windows with many of
+ * them (top-levels of a managed desktop carry dozens of _NET_ and WM_
+ * properties) get a hash index over the list once a lookup has had to
+ * walk past PROPERTY_INDEX_MIN entries.  The index is dropped along with
+ * the last property.
+ */
+#define PROPERTY_INDEX_MIN 8
+
+typedef struct _PropertyIndex {
+    unsigned int count;
+    unsigned int mask;
+    PropertyPtr buckets[];
+} PropertyIndexRec, *PropertyIndexPtr;
+
+#define PropertyHash(index, name) (((name) * 2654435761U >> 8) & (index)->mask)
+
+static PropertyIndexPtr
+PropertyIndexCreate(PropertyPtr list, unsigned int count)
+{
+    PropertyIndexPtr index;
+    unsigned int size = 16;
+    PropertyPtr pProp;
+
+    while (size < count * 2)
+        size <<= 1;
+    index = calloc(1, sizeof(PropertyIndexRec) + size * sizeof(PropertyPtr));
+    if (!index)
+        return NULL;
+    index->count = count;
+    index->mask = size - 1;
+
+    /* Chains keep list order, so that among properties of the same name
+     * (see the SELinux polyinstantiation) the first one is still found
+     * first */
+    for (pProp = list; pProp; pProp = pProp->next) {
+        PropertyPtr *bucket = &index->buckets[PropertyHash(index,
+                                                           pProp->propertyName)];
+
+        while (*bucket)
+            bucket = &(*bucket)->hashNext;
+        pProp->hashNext = NULL;
+        *bucket = pProp;
+    }
+    return index;
+}
+
+static void
+PropertyIndexAdd(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = wPropIndex(pWin);
+    PropertyPtr *bucket;
+
+    if (!index)
+        return;
+
+    /* Keep the chains short as the window gains properties */
+    if (++index->count > index->mask + 1) {
+        PropertyIndexPtr grown = PropertyIndexCreate(wUserProps(pWin),
+                                                     index->count);
+
+        if (grown) {
+            free(index);
+            pWin->optional->propIndex = grown;
+            return;
+        }
+    }
+
+    bucket = &index->buckets[PropertyHash(index, pProp->propertyName)];
+    pProp->hashNext = *bucket;
+    *bucket = pProp;
+}
+
+/* Unlink a property from its window, before it is freed */
+static void
+RemoveProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = wPropIndex(pWin);
+    PropertyPtr *prev;
+
+    if (index) {
+        prev = &index->buckets[PropertyHash(index, pProp->propertyName)];
+        while (*prev != pProp)
+            prev = &(*prev)->hashNext;
+        *prev = pProp->hashNext;
+        index->count--;
+    }
+
+    prev = &pWin->optional->userProps;
+    while (*prev != pProp)
+        prev = &(*prev)->next;
+    *prev = pProp->next;
+
+    if (!pWin->optional->userProps) {
+        free(index);
+        pWin->optional->propIndex = NULL;
+        CheckWindowOptionalNeed(pWin);
+    }
+}
+
 int
 dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
                   ClientPtr client, Mask access_mode)
 {
+    PropertyIndexPtr index = wPropIndex(pWin);
     PropertyPtr pProp;
+    unsigned int n = 0;
     int rc = BadMatch;
 
     client->errorValue = propertyName;
 
-    for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
-        if (pProp->propertyName == propertyName)
-            break;
+    if (index) {
+        for (pProp = index->buckets[PropertyHash(index, propertyName)];
+             pProp; pProp = pProp->hashNext)
+            if (pProp->propertyName == propertyName)
+                break;
+    }
+    else {
+        for (pProp = wUserProps(pWin); pProp; pProp = pProp->next, n++)
+            if (pProp->propertyName == propertyName)
+                break;
+
+        if (!pProp && n >= PROPERTY_INDEX_MIN)
+            pWin->optional->propIndex =
+                PropertyIndexCreate(pWin->optional->userProps, n);
+    }
 
     if (pProp)
         rc = XaceHookPropertyAccess(client, pWin, &pProp, access_mode);
@@ -260,12 +416,14 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
 {
     PropertyPtr pProp;
     PropertyRec savedProp;
-    int sizeInBytes, totalSize, rc;
+    int sizeInBytes, rc;
+    size_t totalSize;
     unsigned char *data;
     Mask access_mode;
 
+    /* Only used once PropertyDataAlloc has checked it for overflow */
     sizeInBytes = format >> 3;
-    totalSize = len * sizeInBytes;
+    totalSize = (size_t) len * sizeInBytes;
     access_mode = (mode == PropModeReplace) ? DixWriteAccess : DixBlendAccess;
 
     /* first see if property already exists */
@@ -277,14 +435,12 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         pProp = dixAllocateObjectWithPrivates(PropertyRec, PRIVATE_PROPERTY);
         if (!pProp)
             return BadAlloc;
-        data = malloc(totalSize);
-        if (totalSize) {
-            if (!data) {
-                dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
-                return BadAlloc;
-            }
-            memcpy(data, value, totalSize);
+        data = PropertyDataAlloc(len, sizeInBytes);
+        if (!data) {
+            dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
+            return BadAlloc;
         }
+        memcpy(data, value, totalSize);
         pProp->propertyName = property;
         pProp->type = type;
         pProp->format = format;
@@ -293,13 +449,14 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         rc = XaceHookPropertyAccess(pClient, pWin, &pProp,
                                     DixCreateAccess | DixWriteAccess);
         if (rc != Success) {
-            free(data);
+            PropertyDataFree(data);
             dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
             pClient->errorValue = property;
             return rc;
         }
         pProp->next = pWin->optional->userProps;
         pWin->optional->userProps = pProp;
+        PropertyIndexAdd(pWin, pProp);
     }
     else if (rc == Success) {
         /* To append or prepend to a property the request format and type
@@ -316,12 +473,10 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         savedProp = *pProp;
 
         if (mode == PropModeReplace) {
-            data = malloc(totalSize);
-            if (totalSize) {
-                if (!data)
-                    return BadAlloc;
-                memcpy(data, value, totalSize);
-            }
+            data = PropertyDataAlloc(len, sizeInBytes);
+            if (!data)
+                return BadAlloc;
+            memcpy(data, value, totalSize);
             pProp->data = data;
             pProp->size = len;
             pProp->type = type;
@@ -330,8 +485,11 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         else if (len == 0) {
             /* do nothing */
         }
+        else if (len > ULONG_MAX - pProp->size) {
+            return BadAlloc;
+        }
         else if (mode == PropModeAppend) {
-            data = xallocarray(pProp->size + len, sizeInBytes);
+            data = PropertyDataAlloc(pProp->size + len, sizeInBytes);
             if (!data)
                 return BadAlloc;
             memcpy(data, pProp->data, pProp->size * sizeInBytes);
@@ -340,7 +498,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             pProp->size += len;
         }
         else if (mode == PropModePrepend) {
-            data = xallocarray(len + pProp->size, sizeInBytes);
+            data = PropertyDataAlloc(len + pProp->size, sizeInBytes);
             if (!data)
                 return BadAlloc;
             memcpy(data + totalSize, pProp->data, pProp->size * sizeInBytes);
@@ -354,11 +512,11 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         rc = XaceHookPropertyAccess(pClient, pWin, &pProp, access_mode);
         if (rc == Success) {
             if (savedProp.data != pProp->data)
-                free(savedProp.data);
+                PropertyDataFree(savedProp.data);
         }
         else {
             if (savedProp.data != pProp->data)
-                free(pProp->data);
+                PropertyDataFree(pProp->data);
             *pProp = savedProp;
             return rc;
         }
@@ -375,7 +533,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
 int
 DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     int rc;
 
     rc = dixLookupProperty(&pProp, pWin, propName, client, DixDestroyAccess);
@@ -383,21 +541,9 @@ DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
         return Success;         /* Succeed if property does not exist */
 
     if (rc == Success) {
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
-
+        RemoveProperty(pWin, pProp);
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
-        free(pProp->data);
+        PropertyDataFree(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
     }
     return rc;
@@ -412,13 +558,16 @@ DeleteAllWindowProperties(WindowPtr pWin)
     while (pProp) {
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
         pNextProp = pProp->next;
-        free(pProp->data);
+        PropertyDataFree(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
         pProp = pNextProp;
     }
 
-    if (pWin->optional)
+    if (pWin->optional) {
         pWin->optional->userProps = NULL;
+        free(pWin->optional->propIndex);
+        pWin->optional->propIndex = NULL;
+    }
 }
 
 static int
@@ -449,7 +598,7 @@ NullPropertyReply(ClientPtr client, ATOM propertyType, int format)
 int
 ProcGetProperty(ClientPtr client)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     unsigned long n, len, ind;
     int rc;
     WindowPtr pWin;
@@ -533,7 +682,13 @@ ProcGetProperty(ClientPtr client)
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
 
     WriteReplyToClient(client, sizeof(xGenericReply), &reply);
-    if (len) {
+    if (len >= PROPERTY_REF_MIN &&
+        (!client->swapped || reply.format == 8)) {
+        PropertyDataHeader(pProp->data)->refcnt++;
+        WriteToClientRef(client, len, (char *) pProp->data + ind,
+                         PropertyDataFree, pProp->data);
+    }
+    else if (len) {
         switch (reply.format) {
         case 32:
             client->pSwapReplyFunc = (ReplySwapPtr) CopySwap32Write;
@@ -550,20 +705,8 @@ ProcGetProperty(ClientPtr client)
 
     if (stuff->delete && (reply.bytesAfter == 0)) {
         /* Delete the Property */
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
-
-        free(pProp->data);
+        RemoveProperty(pWin, pProp);
+        PropertyDataFree(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
     }
     return Success;
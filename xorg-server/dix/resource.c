@@ -105,8 +105,9 @@ Equipment Corporation.
  *      A resource ID is a 32 bit quantity, the upper 2 bits of which are
  *	off-limits for client-visible resources.  The next 8 bits are
  *      used as client ID, and the low 22 bits come from the client.
- *	A resource ID is "hashed" by extracting and xoring subfields
- *      (varying with the size of the hash table).
+ *	A resource ID is hashed by multiplying it with a large odd
+ *	constant and keeping the top bits (as many as the size of the
+ *	hash table needs).
  *
  *      It is sometimes necessary for the server to create an ID that looks
  *      like it belongs to a client.  This ID, however,  must not be one
@@ -121,6 +122,7 @@ Equipment Corporation.
 
 #include <X11/X.h>
 
+#include "dix/dix_priv.h"
 #include "dix/colormap_priv.h"
 #include "dix/dixgrabs_priv.h"
 #include "dix/gc_priv.h"
@@ -151,27 +153,51 @@ Equipment Corporation.
 #define TypeNameString(t) LookupResourceName(t)
 #endif
 
-static void RebuildTable(int    /*client */
-    );
-
 #define SERVER_MINID 32
 
-#define INITBUCKETS 64
+/*
+ *      Each client's resources live in an open-addressing table of
+ *      ResourceRecs probed linearly from SlotHash(id).  Several resources
+ *      may share an ID; they are kept newest first along the probe
+ *      sequence so lookups and FreeResource see them in the order the
+ *      old chained buckets did.  Freed slots become tombstones, unless
+ *      nothing probes past them, and are dropped at the next rebuild.
+ *
+ *      Growing the table never rehashes everything at once: the old
+ *      table is kept around and at least REHASH_STEP of its slots are
+ *      moved over on each AddResource, while lookups consult both tables.
+ *      The step is chosen so the old table is empty before the new one
+ *      can need rebuilding in turn.
+ */
+
 #define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+#define INITBUCKETS (1 << INITHASHSIZE)
+#define REHASH_STEP 8
+
+/* slot states, stored in the type field of unused slots */
+#define RT_SLOT_FREE	((RESTYPE)0)
+#define RT_SLOT_DELETED	(~(RESTYPE)0)
 
 typedef struct _Resource {
-    struct _Resource *next;
     XID id;
     RESTYPE type;
     void *value;
 } ResourceRec, *ResourcePtr;
 
+typedef struct _ResourceTable {
+    ResourcePtr slots;
+    int hashsize;               /* log(2)(number of slots) */
+    int used;                   /* live and deleted slots */
+} ResourceTableRec;
+
 typedef struct _ClientResource {
-    ResourcePtr *resources;
+    ResourceTableRec table;     /* receives all new resources */
+    ResourceTableRec old;       /* being drained into table, if slots set */
+    int migrate;                /* next slot of old to move */
+    int migrateStep;            /* slots of old to move per AddResource */
     int elements;
-    int buckets;
-    int hashsize;               /* log(2)(buckets) */
+    int busy;                   /* iterations in progress */
+    unsigned int generation;    /* bumped whenever resources change slots */
     XID fakeID;
     XID endFakeID;
 } ClientResourceRec;
@@ -642,7 +668,7 @@ ResourceClientBits(void)
 Bool
 InitClientResources(ClientPtr client)
 {
-    int i, j;
+    ClientResourceRec *rrec;
 
     if (client == serverClient) {
         lastResourceType = X11_RESTYPE_LASTPREDEF;
@@ -654,24 +680,26 @@ InitClientResources(ClientPtr client)
             return FALSE;
         memcpy(resourceTypes, predefTypes, sizeof(predefTypes));
     }
-    clientTable[i = client->index].resources =
-        malloc(INITBUCKETS * sizeof(ResourcePtr));
-    if (!clientTable[i].resources)
+    rrec = &clientTable[client->index];
+    rrec->table.slots = calloc(INITBUCKETS, sizeof(ResourceRec));
+    if (!rrec->table.slots)
         return FALSE;
-    clientTable[i].buckets = INITBUCKETS;
-    clientTable[i].elements = 0;
-    clientTable[i].hashsize = INITHASHSIZE;
+    rrec->table.hashsize = INITHASHSIZE;
+    rrec->table.used = 0;
+    rrec->old.slots = NULL;
+    rrec->migrate = 0;
+    rrec->migrateStep = REHASH_STEP;
+    rrec->elements = 0;
+    rrec->busy = 0;
+    rrec->generation++;
     /* Many IDs allocated from the server client are visible to clients,
      * so we don't use the SERVER_BIT for them, but we have to start
      * past the magic value constants used in the protocol.  For normal
      * clients, we can start from zero, with SERVER_BIT set.
      */
-    clientTable[i].fakeID = client->clientAsMask |
+    rrec->fakeID = client->clientAsMask |
         (client->index ? SERVER_BIT : SERVER_MINID);
-    clientTable[i].endFakeID = (clientTable[i].fakeID | RESOURCE_ID_MASK) + 1;
-    for (j = 0; j < INITBUCKETS; j++) {
-        clientTable[i].resources[j] = NULL;
-    }
+    rrec->endFakeID = (rrec->fakeID | RESOURCE_ID_MASK) + 1;
     return TRUE;
 }
 
@@ -688,18 +716,221 @@ HashResourceID(XID id, unsigned int numBits)
     return (id ^ (id >> numBits)) & ~((~0U) << numBits);
 }
 
-static XID
-AvailableID(int client, XID id, XID maxid, XID goodid)
+/*
+ * First slot to probe for id.  Unlike HashResourceID this mixes in the
+ * client and server bits, so the FakeClientID range of a client does
+ * not land on the same run of slots as its own sequentially allocated
+ * IDs, which would make linear probing degenerate.
+ */
+static inline unsigned int
+SlotHash(XID id, int hashsize)
+{
+    return ((CARD32) id * 0x9e3779b1U) >> (32 - hashsize);
+}
+
+static inline Bool
+SlotInUse(const ResourceRec *res)
+{
+    return res->type != RT_SLOT_FREE && res->type != RT_SLOT_DELETED;
+}
+
+static inline ResourceTableRec *
+NextTable(ClientResourceRec *rrec, ResourceTableRec *t)
+{
+    return (t == &rrec->table && rrec->old.slots) ? &rrec->old : NULL;
+}
+
+/*
+ * Return the newest resource with the given id and either exactly the
+ * given type or, when type is zero, any type in rclass.  Entries in the
+ * current table are always newer than those still in the old one.
+ */
+static inline ResourcePtr
+LookupSlot(ClientResourceRec *rrec, XID id, RESTYPE type, RESTYPE rclass)
 {
+    ResourceTableRec *t;
     ResourcePtr res;
+    unsigned int i, mask;
+
+    for (t = &rrec->table; t; t = NextTable(rrec, t)) {
+        mask = (1U << t->hashsize) - 1;
+        for (i = SlotHash(id, t->hashsize);; i = (i + 1) & mask) {
+            res = &t->slots[i];
+            if (res->type == RT_SLOT_FREE)
+                break;
+            if (res->id == id && res->type != RT_SLOT_DELETED &&
+                (type ? res->type == type : (res->type & rclass) != 0))
+                return res;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Store a new resource in front of any older ones with the same ID,
+ * shifting those down the probe sequence.  Returns TRUE if existing
+ * resources had to move.
+ */
+static Bool
+TableInsert(ResourceTableRec *t, ResourceRec res)
+{
+    unsigned int i, mask = (1U << t->hashsize) - 1;
+    ResourcePtr slot;
+    ResourceRec tmp;
+    Bool moved = FALSE;
+
+    for (i = SlotHash(res.id, t->hashsize);; i = (i + 1) & mask) {
+        slot = &t->slots[i];
+        if (slot->type == RT_SLOT_FREE)
+            t->used++;
+        else if (slot->type != RT_SLOT_DELETED) {
+            if (slot->id == res.id) {
+                tmp = *slot;
+                *slot = res;
+                res = tmp;
+                moved = TRUE;
+            }
+            continue;
+        }
+        *slot = res;
+        return moved;
+    }
+}
+
+/*
+ * Store a resource behind all others with the same ID; used when moving
+ * resources out of the old table, which are older than anything already
+ * in the new one.
+ */
+static void
+TableAppend(ResourceTableRec *t, const ResourceRec *res)
+{
+    unsigned int i, mask = (1U << t->hashsize) - 1;
+    ResourcePtr slot, avail = NULL;
+
+    for (i = SlotHash(res->id, t->hashsize);; i = (i + 1) & mask) {
+        slot = &t->slots[i];
+        if (slot->type == RT_SLOT_FREE)
+            break;
+        if (slot->type == RT_SLOT_DELETED) {
+            if (!avail)
+                avail = slot;
+        }
+        else if (slot->id == res->id)
+            avail = NULL;
+    }
+    if (!avail) {
+        avail = slot;
+        t->used++;
+    }
+    *avail = *res;
+}
 
+/*
+ * Move up to count slots worth of resources from the old table into the
+ * current one, and drop the old table once it is empty.  Stops early if
+ * the current table has no room left for them.
+ */
+static void
+MigrateResources(ClientResourceRec *rrec, int count)
+{
+    ResourceTableRec *old = &rrec->old;
+    int size = 1 << old->hashsize;
+    unsigned int i, first, mask = size - 1;
+    ResourcePtr res, slot;
+    int n;
+    XID id;
+
+    for (; count > 0 && rrec->migrate < size; count--) {
+        i = rrec->migrate;
+        res = &old->slots[i];
+        if (!SlotInUse(res)) {
+            rrec->migrate++;
+            continue;
+        }
+        /* Move every resource with this ID in one go, newest first, so
+         * their relative order survives.  Slots between the ID's hash
+         * and this one hold nothing of it any more, unless its probe
+         * sequence wrapped around the end of the table. */
+        id = res->id;
+        first = max(SlotHash(id, old->hashsize), i);
+        for (n = 0, i = first; old->slots[i].type != RT_SLOT_FREE;
+             i = (i + 1) & mask)
+            n += old->slots[i].id == id && SlotInUse(&old->slots[i]);
+        if (rrec->table.used + n >= (1 << rrec->table.hashsize))
+            break;
+        for (i = first;; i = (i + 1) & mask) {
+            slot = &old->slots[i];
+            if (slot->type == RT_SLOT_FREE)
+                break;
+            if (slot->id == id && slot->type != RT_SLOT_DELETED) {
+                TableAppend(&rrec->table, slot);
+                slot->type = RT_SLOT_DELETED;
+            }
+        }
+        rrec->migrate++;
+    }
+    if (rrec->migrate == size) {
+        free(old->slots);
+        old->slots = NULL;
+    }
+    rrec->generation++;
+}
+
+/*
+ * Start moving the client's resources into a fresh table sized for four
+ * times the live count.  This also gets rid of tombstones and shrinks
+ * tables that have mostly been emptied again, by at most a factor of 8
+ * at a time so that draining the old table stays cheap per step.
+ *
+ * The old table should be empty by then, see migrateStep.  Should it
+ * not be, it is still not moved over all at once: another step goes and
+ * the current table keeps filling until the old one is empty.
+ */
+static Bool
+RebuildTable(ClientResourceRec *rrec)
+{
+    ResourcePtr slots;
+    int hashsize = max(INITHASHSIZE, rrec->table.hashsize - 3);
+    int room;
+
+    if (rrec->old.slots) {
+        MigrateResources(rrec, rrec->migrateStep);
+        if (rrec->old.slots)
+            return FALSE;
+    }
+
+    while ((rrec->elements + 1) * 4 > (1 << hashsize))
+        hashsize++;
+    slots = calloc(1 << hashsize, sizeof(ResourceRec));
+    if (!slots)
+        return FALSE;
+
+    rrec->old = rrec->table;
+    rrec->migrate = 0;
+    /* Migrating takes at most elements, under a quarter, of the new
+     * slots.  That leaves room for size / 8 insertions before the table
+     * is half full, or between half and 7/8 full when walks held the
+     * drain up until then, so moving this many slots each time empties
+     * the old table before the new one needs rebuilding.  Shrinking by
+     * 8 at most, that is no more than 64 slots. */
+    room = (1 << hashsize) / 8;
+    rrec->migrateStep = max(REHASH_STEP,
+                            ((1 << rrec->old.hashsize) + room - 1) / room);
+    rrec->table.slots = slots;
+    rrec->table.hashsize = hashsize;
+    rrec->table.used = 0;
+    rrec->generation++;
+    return TRUE;
+}
+
+static XID
+AvailableID(int client, XID id, XID maxid, XID goodid)
+{
     if ((goodid >= id) && (goodid <= maxid))
         return goodid;
     for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
+        if (!LookupSlot(&clientTable[client], id, 0, RC_ANY))
             return id;
     }
     return 0;
@@ -709,7 +940,7 @@ void
 GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
 {
     XID id, maxid;
-    ResourcePtr *resp;
+    ResourceTableRec *t;
     ResourcePtr res;
     int i;
     XID goodid;
@@ -719,9 +950,11 @@ GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
         id |= client ? SERVER_BIT : SERVER_MINID;
     maxid = id | RESOURCE_ID_MASK;
     goodid = 0;
-    for (resp = clientTable[client].resources, i = clientTable[client].buckets;
-         --i >= 0;) {
-        for (res = *resp++; res; res = res->next) {
+    for (t = &clientTable[client].table; t; t = NextTable(&clientTable[client], t)) {
+        for (i = 0; i < (1 << t->hashsize); i++) {
+            res = &t->slots[i];
+            if (!SlotInUse(res))
+                continue;
             if ((res->id < id) || (res->id > maxid))
                 continue;
             if (((res->id - id) >= (maxid - res->id)) ?
@@ -806,125 +1039,100 @@ FakeClientID(int client)
 Bool
 AddResource(XID id, RESTYPE type, void *value)
 {
-    int client;
+    int client, size;
     ClientResourceRec *rrec;
-    ResourcePtr res, *head;
+    ResourceRec res;
 
 #ifdef XSERVER_DTRACE
     XSERVER_RESOURCE_ALLOC(id, type, value, TypeNameString(type));
 #endif
     client = CLIENT_ID(id);
     rrec = &clientTable[client];
-    if (!rrec->buckets) {
+    if (!rrec->table.slots) {
         ErrorF("[dix] AddResource(%lx, %x, %lx), client=%d \n",
                (unsigned long) id, type, (unsigned long)(uintptr_t) value, client);
         FatalError("client not in use\n");
     }
-    if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
-        RebuildTable(client);
-    head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
-    res = malloc(sizeof(ResourceRec));
-    if (!res) {
+    /* While someone walks the table in place, leave resources where
+     * they are until it is half full. */
+    size = 1 << rrec->table.hashsize;
+    if (rrec->old.slots && (!rrec->busy || (rrec->table.used + 1) * 2 > size))
+        MigrateResources(rrec, rrec->migrateStep);
+    if ((rrec->table.used + 1) * 2 > size &&
+        (!rrec->busy || (rrec->table.used + 1) * 8 > size * 7) &&
+        !RebuildTable(rrec) && rrec->table.used + 1 >= size) {
         (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
         return FALSE;
     }
-    res->next = *head;
-    res->id = id;
-    res->type = type;
-    res->value = value;
-    *head = res;
+    res.id = id;
+    res.type = type;
+    res.value = value;
+    if (TableInsert(&rrec->table, res))
+        rrec->generation++;
     rrec->elements++;
-    CallResourceStateCallback(ResourceStateAdding, res);
+    CallResourceStateCallback(ResourceStateAdding, &res);
     return TRUE;
 }
 
+/*
+ * Turn a slot into a tombstone, or into a free slot if nothing probes
+ * past it, taking any tombstones right before it along.
+ */
 static void
-RebuildTable(int client)
+ClearSlot(ClientResourceRec *rrec, ResourcePtr slot)
 {
-    int j;
-    ResourcePtr res, next;
-    ResourcePtr **tails, *resources;
-    ResourcePtr **tptr, *rptr;
-
-    /*
-     * For now, preserve insertion order, since some ddx layers depend
-     * on resources being free in the opposite order they are added.
-     */
+    ResourceTableRec *t = &rrec->table;
+    unsigned int i, mask = (1U << t->hashsize) - 1;
 
-    j = 2 * clientTable[client].buckets;
-    tails =  xallocarray(j, sizeof(ResourcePtr *));
-    if (!tails)
-        return;
-    resources =  xallocarray(j, sizeof(ResourcePtr));
-    if (!resources) {
-        free(tails);
-        return;
+    if (slot < t->slots || slot > t->slots + mask) {
+        t = &rrec->old;
+        mask = (1U << t->hashsize) - 1;
     }
-    for (rptr = resources, tptr = tails; --j >= 0; rptr++, tptr++) {
-        *rptr = NULL;
-        *tptr = rptr;
-    }
-    clientTable[client].hashsize++;
-    for (j = clientTable[client].buckets,
-         rptr = clientTable[client].resources; --j >= 0; rptr++) {
-        for (res = *rptr; res; res = next) {
-            next = res->next;
-            res->next = NULL;
-            tptr = &tails[HashResourceID(res->id, clientTable[client].hashsize)];
-            **tptr = res;
-            *tptr = &res->next;
-        }
+    i = slot - t->slots;
+    if (t->slots[(i + 1) & mask].type != RT_SLOT_FREE) {
+        slot->type = RT_SLOT_DELETED;
+        return;
     }
-    free(tails);
-    clientTable[client].buckets *= 2;
-    free(clientTable[client].resources);
-    clientTable[client].resources = resources;
+    do {
+        t->slots[i].type = RT_SLOT_FREE;
+        t->used--;
+        i = (i - 1) & mask;
+    } while (t->slots[i].type == RT_SLOT_DELETED);
 }
 
 static void
-doFreeResource(ResourcePtr res, Bool skip)
+doFreeResource(ClientResourceRec *rrec, ResourcePtr slot, Bool skip)
 {
-    CallResourceStateCallback(ResourceStateFreeing, res);
+    ResourceRec res = *slot;
 
-    if (!skip)
-        resourceTypes[res->type & TypeMask].deleteFunc(res->value, res->id);
+#ifdef XSERVER_DTRACE
+    XSERVER_RESOURCE_FREE(res.id, res.type,
+                          res.value, TypeNameString(res.type));
+#endif
+    ClearSlot(rrec, slot);
+    rrec->elements--;
 
-    free(res);
+    CallResourceStateCallback(ResourceStateFreeing, &res);
+
+    if (!skip)
+        resourceTypes[res.type & TypeMask].deleteFunc(res.value, res.id);
 }
 
 void
 FreeResource(XID id, RESTYPE skipDeleteFuncType)
 {
     int cid;
+    ClientResourceRec *rrec;
     ResourcePtr res;
-    ResourcePtr *prev, *head;
-    int *eltptr;
-    int elements;
-
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-        eltptr = &clientTable[cid].elements;
 
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id) {
-                RESTYPE rtype = res->type;
-
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
-#endif
-                *prev = res->next;
-                elements = --*eltptr;
-
-                doFreeResource(res, rtype == skipDeleteFuncType);
-
-                if (*eltptr != elements)
-                    prev = head;        /* prev may no longer be valid */
-            }
-            else
-                prev = &res->next;
-        }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        if (DispatchThreads)
+            WaitForClientRendering(cid);
+        rrec = &clientTable[cid];
+        /* look the ID up again each time, the delete function may have
+         * freed or added other resources */
+        while ((res = LookupSlot(rrec, id, 0, RC_ANY)))
+            doFreeResource(rrec, res, res->type == skipDeleteFuncType);
     }
 }
 
@@ -933,28 +1141,13 @@ FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
 {
     int cid;
     ResourcePtr res;
-    ResourcePtr *prev, *head;
-
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id && res->type == type) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
-#endif
-                *prev = res->next;
-                clientTable[cid].elements--;
 
-                doFreeResource(res, skipFree);
-
-                break;
-            }
-            else
-                prev = &res->next;
-        }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        if (DispatchThreads)
+            WaitForClientRendering(cid);
+        res = LookupSlot(&clientTable[cid], id, type, 0);
+        if (res)
+            doFreeResource(&clientTable[cid], res, skipFree);
     }
 }
 
@@ -970,49 +1163,157 @@ ChangeResourceValue(XID id, RESTYPE rtype, void *value)
     int cid;
     ResourcePtr res;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        res = LookupSlot(&clientTable[cid], id, rtype, 0);
+        if (res) {
+            res->value = value;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
 
-        for (; res; res = res->next)
-            if ((res->id == id) && (res->type == rtype)) {
-                res->value = value;
+/*
+ * Resource walks that call out to code which may add or free resources
+ * work on a copy of the matching resources, so that slots moving around
+ * underneath them cannot make them visit a resource twice.  Copied
+ * resources that have been freed by the time the walk gets to them are
+ * skipped.  Only if the copy cannot be allocated is the table walked in
+ * place, starting over whenever resources move.
+ */
+
+#define WALK_LOCAL 32
+
+typedef struct _ResourceWalk {
+    ClientResourceRec *rrec;
+    RESTYPE type;               /* 0 for all types */
+    ResourcePtr copy;           /* resources left to visit, or NULL */
+    int count;
+    int next;                   /* into copy, or slot of t */
+    ResourceTableRec *t;        /* table walked in place */
+    unsigned int generation;
+    ResourceRec res;
+    ResourceRec local[WALK_LOCAL];
+} ResourceWalkRec, *ResourceWalkPtr;
+
+static inline Bool
+WalkMatch(const ResourceRec *res, RESTYPE type)
+{
+    return SlotInUse(res) && (!type || res->type == type);
+}
+
+static void
+StartResourceWalk(ResourceWalkPtr w, ClientResourceRec *rrec, RESTYPE type)
+{
+    ResourceTableRec *t;
+    int i, n = 0;
+
+    if (DispatchThreads)
+        WaitForClientRendering(rrec - clientTable);
+    w->rrec = rrec;
+    w->type = type;
+    w->next = 0;
+    for (t = &rrec->table; t && t->slots; t = NextTable(rrec, t))
+        for (i = 0; i < (1 << t->hashsize); i++)
+            n += WalkMatch(&t->slots[i], type);
+    w->copy = n <= WALK_LOCAL ? w->local : xallocarray(n, sizeof(ResourceRec));
+    if (!w->copy) {
+        w->t = &rrec->table;
+        w->generation = rrec->generation;
+        rrec->busy++;
+        return;
+    }
+    w->count = 0;
+    for (t = &rrec->table; t && t->slots; t = NextTable(rrec, t))
+        for (i = 0; i < (1 << t->hashsize); i++)
+            if (WalkMatch(&t->slots[i], type))
+                w->copy[w->count++] = t->slots[i];
+}
+
+/* Whether the exact resource res is still in the table. */
+static Bool
+ResourceStillPresent(ClientResourceRec *rrec, const ResourceRec *res)
+{
+    ResourceTableRec *t;
+    ResourcePtr slot;
+    unsigned int i, mask;
+
+    for (t = &rrec->table; t; t = NextTable(rrec, t)) {
+        mask = (1U << t->hashsize) - 1;
+        for (i = SlotHash(res->id, t->hashsize);; i = (i + 1) & mask) {
+            slot = &t->slots[i];
+            if (slot->type == RT_SLOT_FREE)
+                break;
+            if (slot->id == res->id && slot->type == res->type &&
+                slot->value == res->value)
                 return TRUE;
-            }
+        }
     }
     return FALSE;
 }
 
-/* Note: if func adds or deletes resources, then func can get called
- * more than once for some resources.  If func adds new resources,
- * func might or might not get called for them.  func cannot both
- * add and delete an equal number of resources!
+static ResourcePtr
+NextResource(ResourceWalkPtr w)
+{
+    ClientResourceRec *rrec = w->rrec;
+    ResourcePtr res;
+
+    if (w->copy) {
+        while (w->next < w->count) {
+            res = &w->copy[w->next++];
+            if (rrec->table.slots && ResourceStillPresent(rrec, res))
+                return res;
+        }
+        return NULL;
+    }
+
+    if (rrec->generation != w->generation) {
+        w->t = &rrec->table;    /* start over */
+        w->next = 0;
+        w->generation = rrec->generation;
+    }
+    while (w->t && w->t->slots) {
+        while (w->next < (1 << w->t->hashsize)) {
+            res = &w->t->slots[w->next++];
+            if (WalkMatch(res, w->type)) {
+                w->res = *res;
+                return &w->res;
+            }
+        }
+        w->t = NextTable(rrec, w->t);
+        w->next = 0;
+    }
+    return NULL;
+}
+
+static void
+EndResourceWalk(ResourceWalkPtr w)
+{
+    if (!w->copy)
+        w->rrec->busy--;
+    else if (w->copy != w->local)
+        free(w->copy);
+}
+
+/* Note: func is called once for each resource there was when the walk
+ * started, unless it has been freed before the walk gets to it.  If
+ * func adds new resources, it is not called for them.
  */
 
 void
 FindClientResourcesByType(ClientPtr client,
                           RESTYPE type, FindResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ResourceWalkRec walk;
+    ResourcePtr this;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                elements = *eltptr;
-                (*func) (this->value, this->id, cdata);
-                if (*eltptr != elements)
-                    next = resources[i];        /* start over */
-            }
-        }
-    }
+    StartResourceWalk(&walk, &clientTable[client->index], type);
+    while ((this = NextResource(&walk)))
+        (*func) (this->value, this->id, cdata);
+    EndResourceWalk(&walk);
 }
 
 void FindSubResources(void *resource,
@@ -1027,25 +1328,16 @@ void FindSubResources(void *resource,
 void
 FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ResourceWalkRec walk;
+    ResourcePtr this;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            elements = *eltptr;
-            (*func) (this->value, this->id, this->type, cdata);
-            if (*eltptr != elements)
-                next = resources[i];    /* start over */
-        }
-    }
+    StartResourceWalk(&walk, &clientTable[client->index], 0);
+    while ((this = NextResource(&walk)))
+        (*func) (this->value, this->id, this->type, cdata);
+    EndResourceWalk(&walk);
 }
 
 void *
@@ -1053,74 +1345,61 @@ LookupClientResourceComplex(ClientPtr client,
                             RESTYPE type,
                             FindComplexResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    void *value;
-    int i;
+    ResourceWalkRec walk;
+    ResourcePtr this;
+    void *value = NULL;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                /* workaround func freeing the type as DRI1 does */
-                value = this->value;
-                if ((*func) (value, this->id, cdata))
-                    return value;
-            }
+    StartResourceWalk(&walk, &clientTable[client->index], type);
+    while ((this = NextResource(&walk))) {
+        if ((*func) (this->value, this->id, cdata)) {
+            value = this->value;
+            break;
         }
     }
-    return NULL;
+    EndResourceWalk(&walk);
+    return value;
 }
 
 void
 FreeClientNeverRetainResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceTableRec *t;
     ResourcePtr this;
-    ResourcePtr *prev;
-    int j, elements;
-    int *eltptr;
+    unsigned int generation;
+    int i;
 
     if (!client)
         return;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        prev = &resources[j];
-        while ((this = *prev)) {
-            RESTYPE rtype = this->type;
-
-            if (rtype & RC_NEVERRETAIN) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(this->id, this->type,
-                                      this->value, TypeNameString(this->type));
-#endif
-                *prev = this->next;
-                clientTable[client->index].elements--;
-                elements = *eltptr;
-
-                doFreeResource(this, FALSE);
-
-                if (*eltptr != elements)
-                    prev = &resources[j];       /* prev may no longer be valid */
-            }
-            else
-                prev = &this->next;
+    rrec = &clientTable[client->index];
+    rrec->busy++;
+ restart:
+    generation = rrec->generation;
+    for (t = &rrec->table; t && t->slots; t = NextTable(rrec, t)) {
+        for (i = 0; i < (1 << t->hashsize); i++) {
+            this = &t->slots[i];
+            if (!SlotInUse(this) || !(this->type & RC_NEVERRETAIN))
+                continue;
+            doFreeResource(rrec, this, FALSE);
+            if (rrec->generation != generation)
+                goto restart;   /* slots may have moved */
         }
     }
+    rrec->busy--;
 }
 
 void
 FreeClientResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceTableRec *t;
     ResourcePtr this;
-    int j;
+    unsigned int generation;
+    int i;
 
     /* This routine shouldn't be called with a null client, but just in
        case ... */
@@ -1130,35 +1409,33 @@ FreeClientResources(ClientPtr client)
 
     HandleSaveSet(client);
 
-    resources = clientTable[client->index].resources;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        /* It may seem silly to update the head of this resource list as
-           we delete the members, since the entire list will be deleted any way,
-           but there are some resource deletion functions "FreeClientPixels" for
-           one which do a LookupID on another resource id (a Colormap id in this
-           case), so the resource list must be kept valid up to the point that
-           it is deleted, so every time we delete a resource, we must update the
-           head, just like in FreeResource. I hope that this doesn't slow down
-           mass deletion appreciably. PRH */
-
-        ResourcePtr *head;
-
-        head = &resources[j];
-
-        for (this = *head; this; this = *head) {
-#ifdef XSERVER_DTRACE
-            XSERVER_RESOURCE_FREE(this->id, this->type,
-                                  this->value, TypeNameString(this->type));
-#endif
-            *head = this->next;
-            clientTable[client->index].elements--;
-
-            doFreeResource(this, FALSE);
+    rrec = &clientTable[client->index];
+    rrec->busy++;
+ restart:
+    generation = rrec->generation;
+    for (t = &rrec->table; t && t->slots; t = NextTable(rrec, t)) {
+        for (i = 0; i < (1 << t->hashsize); i++) {
+            /* Some resource deletion functions, "FreeClientPixels" for
+               one, do a LookupID on another resource id (a Colormap id
+               in this case), so the table must stay valid up to the
+               point that it is freed.  Resources sharing an ID go in
+               the same newest-first order FreeResource uses, since some
+               ddx layers depend on that. */
+            this = &t->slots[i];
+            while (SlotInUse(this)) {
+                doFreeResource(rrec, LookupSlot(rrec, this->id, 0, RC_ANY),
+                               FALSE);
+                if (rrec->generation != generation)
+                    goto restart;
+            }
         }
     }
-    free(clientTable[client->index].resources);
-    clientTable[client->index].resources = NULL;
-    clientTable[client->index].buckets = 0;
+    rrec->busy--;
+    free(rrec->table.slots);
+    free(rrec->old.slots);
+    rrec->table.slots = NULL;
+    rrec->old.slots = NULL;
+    rrec->generation++;
 }
 
 void
@@ -1167,7 +1444,7 @@ FreeAllResources(void)
     int i;
 
     for (i = currentMaxClients; --i >= 0;) {
-        if (clientTable[i].buckets)
+        if (clientTable[i].table.slots)
             FreeClientResources(clients[i]);
     }
 }
@@ -1208,13 +1485,8 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
     if ((rtype & TypeMask) > lastResourceType)
         return BadImplementation;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && res->type == rtype)
-                break;
-    }
+    if ((cid < LimitClients) && clientTable[cid].table.slots)
+        res = LookupSlot(&clientTable[cid], id, rtype, 0);
     if (client) {
         client->errorValue = id;
     }
@@ -1230,6 +1502,8 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
             return cid;
     }
 
+    if (DispatchThreads)
+        DispatchResourceAccess(client, id, res->type, res->value);
     *result = res->value;
     return Success;
 }
@@ -1243,13 +1517,8 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
 
     *result = NULL;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && (res->type & rclass))
-                break;
-    }
+    if ((cid < LimitClients) && clientTable[cid].table.slots)
+        res = LookupSlot(&clientTable[cid], id, 0, rclass);
     if (client) {
         client->errorValue = id;
     }
@@ -1263,6 +1532,8 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
             return cid;
     }
 
+    if (DispatchThreads)
+        DispatchResourceAccess(client, id, res->type, res->value);
     *result = res->value;
     return Success;
 }
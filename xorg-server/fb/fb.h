@@ -1100,6 +1100,22 @@ fbSolid(FbBits * dst,
         FbStride dstStride,
         int dstX, int bpp, int width, int height, FbBits and, FbBits xor);
 
+extern _X_EXPORT void
+fbSolidRect(FbBits * dst,
+            FbStride dstStride,
+            int dstBpp,
+            int x, int y, int width, int height, FbBits and, FbBits xor);
+
+/*
+ * fbthread.c
+ */
+
+typedef void (*FbBandProc) (int y, int height, void *closure);
+
+extern _X_EXPORT void
+fbParallelBands(int y, int height, int stride, FbBandProc proc,
+                void *closure);
+
 /*
  * fbtile.c
  */
@@ -51,6 +51,69 @@ fbGlyphIn(RegionPtr pRegion, int x, int y, int width, int height)
     return RegionContainsRect(pRegion, &box) == rgnIN;
 }
 
+/*
+ * Check a whole string against the clip at once: TRUE when every glyph
+ * can be drawn by the fbGlyph routines and the ink of the string lies
+ * inside the clip, so the glyphs can be drawn without clipping.  Text
+ * from terminals nearly always passes.
+ */
+static Bool
+fbGlyphRunIn(RegionPtr pRegion, int x, int y,
+             unsigned int nglyph, CharInfoPtr * ppci)
+{
+    int x1 = INT_MAX, y1 = INT_MAX, x2 = INT_MIN, y2 = INT_MIN;
+    CharInfoPtr pci;
+    int gx, gy, gWidth, gHeight;
+
+    while (nglyph--) {
+        pci = *ppci++;
+        gWidth = GLYPHWIDTHPIXELS(pci);
+        gHeight = GLYPHHEIGHTPIXELS(pci);
+        if (gWidth > sizeof(FbStip) * 8)
+            return FALSE;
+        if (gWidth && gHeight) {
+            gx = x + pci->metrics.leftSideBearing;
+            gy = y - pci->metrics.ascent;
+            x1 = min(x1, gx);
+            y1 = min(y1, gy);
+            x2 = max(x2, gx + gWidth);
+            y2 = max(y2, gy + gHeight);
+        }
+        x += pci->metrics.characterWidth;
+    }
+
+    return x1 < x2 && fbGlyphIn(pRegion, x1, y1, x2 - x1, y2 - y1);
+}
+
+/* Draw a string that passed fbGlyphRunIn */
+static void
+fbGlyphRun(DrawablePtr pDrawable,
+           void (*glyph) (FbBits *, FbStride, int, FbStip *, FbBits, int, int),
+           FbBits fg, int x, int y,
+           unsigned int nglyph, CharInfoPtr * ppci, void *pglyphBase)
+{
+    CharInfoPtr pci;
+    FbBits *dst;
+    FbStride dstStride;
+    int dstBpp;
+    int dstXoff, dstYoff;
+    int gy;
+
+    fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff, dstYoff);
+    while (nglyph--) {
+        pci = *ppci++;
+        if (GLYPHWIDTHPIXELS(pci) && GLYPHHEIGHTPIXELS(pci)) {
+            gy = y - pci->metrics.ascent;
+            (*glyph) (dst + (gy + dstYoff) * dstStride, dstStride, dstBpp,
+                      (FbStip *) FONTGLYPHBITS(pglyphBase, pci), fg,
+                      x + pci->metrics.leftSideBearing + dstXoff,
+                      GLYPHHEIGHTPIXELS(pci));
+        }
+        x += pci->metrics.characterWidth;
+    }
+    fbFinishAccess(pDrawable);
+}
+
 void
 fbPolyGlyphBlt(DrawablePtr pDrawable,
                GCPtr pGC,
@@ -88,6 +151,13 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
     x += pDrawable->x;
     y += pDrawable->y;
 
+    if (glyph &&
+        fbGlyphRunIn(fbGetCompositeClip(pGC), x, y, nglyph, ppci)) {
+        fbGlyphRun(pDrawable, glyph, pPriv->xor, x, y, nglyph, ppci,
+                   pglyphBase);
+        return;
+    }
+
     while (nglyph--) {
         pci = *ppci++;
         pglyph = FONTGLYPHBITS(pglyphBase, pci);
@@ -189,6 +259,13 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
         opaque = FALSE;
     }
 
+    if (glyph &&
+        fbGlyphRunIn(fbGetCompositeClip(pGC), x, y, nglyph, ppciInit)) {
+        fbGlyphRun(pDrawable, glyph, pPriv->fg, x, y, nglyph, ppciInit,
+                   pglyphBase);
+        return;
+    }
+
     ppci = ppciInit;
     while (nglyph--) {
         pci = *ppci++;
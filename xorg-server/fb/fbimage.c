@@ -215,10 +215,16 @@ fbGetImage(DrawablePtr pDrawable,
 
     /*
      * XFree86 DDX empties the root borderClip when the VT is
-     * switched away; this checks for that case
+     * switched away; this checks for that case.  The caller's buffer
+     * is not initialized, so hand back a blank image.
      */
-    if (!fbDrawableEnabled(pDrawable))
+    if (!fbDrawableEnabled(pDrawable)) {
+        if (format == ZPixmap || pDrawable->bitsPerPixel == 1)
+            memset(d, 0, PixmapBytePad(w, pDrawable->depth) * h);
+        else
+            memset(d, 0, BitmapBytePad(w) * h);
         return;
+    }
 
     fbGetDrawable(pDrawable, src, srcStride, srcBpp, srcXoff, srcYoff);
 
@@ -33,6 +33,78 @@
 #include "mipict.h"
 #include "fbpict.h"
 
+typedef struct {
+    CARD8 op;
+    pixman_image_t *src, *mask, *dest;
+    int xSrc, ySrc, xMask, yMask, xDst, yDst;
+    int width;
+} FbCompositeBandRec;
+
+static void
+fbCompositeBand(int y, int height, void *closure)
+{
+    FbCompositeBandRec *b = closure;
+    int dy = y - b->yDst;
+
+    pixman_image_composite32(b->op, b->src, b->mask, b->dest,
+                             b->xSrc, b->ySrc + dy, b->xMask, b->yMask + dy,
+                             b->xDst, y, b->width, height);
+}
+
+/* The bytes holding the pixels of pict's drawable, if it has one */
+static Bool
+fbPictureBytes(PicturePtr pict, uintptr_t *start, uintptr_t *end)
+{
+    PixmapPtr pixmap;
+    intptr_t size;
+
+    if (!pict || !pict->pDrawable)
+        return FALSE;
+    if (pict->pDrawable->type == DRAWABLE_PIXMAP)
+        pixmap = (PixmapPtr) pict->pDrawable;
+    else
+        pixmap = fbGetWindowPixmap(pict->pDrawable);
+
+    size = (intptr_t) pixmap->devKind * pixmap->drawable.height;
+    *start = (uintptr_t) pixmap->devPrivate.ptr;
+    *end = *start + size;
+    if (size < 0) {
+        *start = *end;
+        *end = (uintptr_t) pixmap->devPrivate.ptr;
+    }
+    return TRUE;
+}
+
+/*
+ * Whether compositing could read pixels it writes, or write the same
+ * pixels through the destination and its alpha map.  Pixmaps can share
+ * memory, as with shared memory pixmaps made from one segment, so this
+ * compares the bytes behind the pictures rather than their pixmaps.
+ */
+static Bool
+fbCompositeAliases(PicturePtr pSrc, PicturePtr pMask, PicturePtr pDst)
+{
+    PicturePtr pict[] = {
+        pDst->alphaMap,
+        pSrc, pSrc->alphaMap,
+        pMask, pMask ? pMask->alphaMap : NULL,
+    };
+    PicturePtr dst[] = { pDst, pDst->alphaMap };
+    uintptr_t start, end, dstStart, dstEnd;
+    int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(dst); i++) {
+        if (!fbPictureBytes(dst[i], &dstStart, &dstEnd))
+            continue;
+        /* pict[0] is dst[1], which is not compared with itself */
+        for (j = i; j < ARRAY_SIZE(pict); j++)
+            if (fbPictureBytes(pict[j], &start, &end) &&
+                start < dstEnd && dstStart < end)
+                return TRUE;
+    }
+    return FALSE;
+}
+
 void
 fbComposite(CARD8 op,
             PicturePtr pSrc,
@@ -57,10 +129,36 @@ fbComposite(CARD8 op,
     dest = image_from_pict(pDst, TRUE, &dst_xoff, &dst_yoff);
 
     if (src && dest && !(pMask && !mask)) {
-        pixman_image_composite(op, src, mask, dest,
-                               xSrc + src_xoff, ySrc + src_yoff,
-                               xMask + msk_xoff, yMask + msk_yoff,
-                               xDst + dst_xoff, yDst + dst_yoff, width, height);
+        FbCompositeBandRec b = {
+            .op = op,
+            .src = src,
+            .mask = mask,
+            .dest = dest,
+            .xSrc = xSrc + src_xoff,
+            .ySrc = ySrc + src_yoff,
+            .xMask = xMask + msk_xoff,
+            .yMask = yMask + msk_yoff,
+            .xDst = xDst + dst_xoff,
+            .yDst = yDst + dst_yoff,
+            .width = width,
+        };
+
+        /*
+         * Compositing is done per pixel, so bands give the same result as
+         * one call, unless the source or mask is read from the pixels
+         * being written.
+         *
+         * pixman sets up images, building gradient tables and the like,
+         * the first time they are composited.  fbParallelBands draws the
+         * first band on this thread before any other band starts, so the
+         * workers only ever read the images.
+         */
+        if (fbCompositeAliases(pSrc, pMask, pDst))
+            fbCompositeBand(b.yDst, height, &b);
+        else
+            fbParallelBands(b.yDst, height,
+                            width * (PIXMAN_FORMAT_BPP(pDst->format) / 8),
+                            fbCompositeBand, &b);
     }
 
     free_pixman_pict(pSrc, src);
@@ -276,6 +374,45 @@ create_conical_gradient_image(PictGradient * gradient)
                                                 gradient->nstops);
 }
 
+/*
+ * Gradients cannot change once created, so their pixman image is made the
+ * first time they are used and kept with the SourcePict.  pixman keeps the
+ * gradient's color table in it, which is then built once rather than for
+ * every composite.
+ */
+#define FB_GRADIENT_LUT_SIZE 1024
+
+static pixman_image_t *
+gradient_image(PicturePtr pict)
+{
+    PictGradient *gradient = &pict->pSourcePict->gradient;
+    pixman_image_t *image = gradient->image;
+
+    if (image) {
+        /* set_image_properties only sets these when the picture has them */
+        if (!pict->transform)
+            pixman_image_set_transform(image, NULL);
+        if (!pict->alphaMap)
+            pixman_image_set_alpha_map(image, NULL, 0, 0);
+
+        return pixman_image_ref(image);
+    }
+
+    if (gradient->type == SourcePictTypeLinear)
+        image = create_linear_gradient_image(gradient);
+    else if (gradient->type == SourcePictTypeRadial)
+        image = create_radial_gradient_image(gradient);
+    else if (gradient->type == SourcePictTypeConical)
+        image = create_conical_gradient_image(gradient);
+
+    if (image) {
+        pixman_image_set_gradient_lut_size(image, FB_GRADIENT_LUT_SIZE);
+        gradient->image = pixman_image_ref(image);
+    }
+
+    return image;
+}
+
 static pixman_image_t *
 create_bits_picture(PicturePtr pict, Bool has_clip, int *xoff, int *yoff)
 {
@@ -451,14 +588,7 @@ image_from_pict_internal(PicturePtr pict, Bool has_clip, int *xoff, int *yoff,
             image = create_solid_fill_image(pict);
         }
         else {
-            PictGradient *gradient = &pict->pSourcePict->gradient;
-
-            if (sp->type == SourcePictTypeLinear)
-                image = create_linear_gradient_image(gradient);
-            else if (sp->type == SourcePictTypeRadial)
-                image = create_radial_gradient_image(gradient);
-            else if (sp->type == SourcePictTypeConical)
-                image = create_conical_gradient_image(gradient);
+            image = gradient_image(pict);
         }
         *xoff = *yoff = 0;
     }
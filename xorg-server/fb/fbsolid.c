@@ -61,3 +61,52 @@ fbSolid(FbBits * dst,
         dst += dstStride;
     }
 }
+
+typedef struct {
+    FbBits *dst;
+    FbStride dstStride;
+    int dstBpp;
+    int x;
+    int width;
+    FbBits and;
+    FbBits xor;
+} FbSolidBandRec;
+
+static void
+fbSolidBand(int y, int height, void *closure)
+{
+    FbSolidBandRec *b = closure;
+
+#ifndef FB_ACCESS_WRAPPER
+    if (b->and || !pixman_fill((uint32_t *) b->dst, b->dstStride, b->dstBpp,
+                               b->x, y, b->width, height, b->xor))
+#endif
+        fbSolid(b->dst + y * b->dstStride,
+                b->dstStride,
+                b->x * b->dstBpp,
+                b->dstBpp, b->width * b->dstBpp, height, b->and, b->xor);
+}
+
+/*
+ * Fill a rectangle given in pixels, with pixman_fill where it can and
+ * fbSolid otherwise.  Large rectangles are split into bands that are
+ * filled in parallel.
+ */
+void
+fbSolidRect(FbBits * dst,
+            FbStride dstStride,
+            int dstBpp,
+            int x, int y, int width, int height, FbBits and, FbBits xor)
+{
+    FbSolidBandRec b = {
+        .dst = dst,
+        .dstStride = dstStride,
+        .dstBpp = dstBpp,
+        .x = x,
+        .width = width,
+        .and = and,
+        .xor = xor,
+    };
+
+    fbParallelBands(y, height, width * dstBpp / 8, fbSolidBand, &b);
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The copyright holders make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Band executor for large rendering operations.  fbParallelBands splits
+ * a range of scanlines into bands of roughly FB_BAND_BYTES and runs them
+ * on a small pool of worker threads, with the calling thread taking part.
+ * Small operations, nested calls, calls made while another thread's
+ * operation holds the pool (as with -dispatchthreads) and the access
+ * wrapper build run the whole range serially.
+ */
+
+#include <dix-config.h>
+
+#include "fb.h"
+
+#if defined(FB_THREADS) && !defined(FB_ACCESS_WRAPPER)
+
+#include <pthread.h>
+#include <signal.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+#define FB_MAX_THREADS          8
+#define FB_BAND_BYTES           (128 * 1024)
+#define FB_PARALLEL_MIN_BYTES   (512 * 1024)
+
+typedef struct {
+    FbBandProc proc;
+    void *closure;
+    int y;
+    int height;
+    int band;
+    int nbands;
+    int next;                   /* next band to hand out */
+    int done;                   /* bands finished */
+} FbBandJobRec, *FbBandJobPtr;
+
+static pthread_mutex_t fbBandLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fbBandWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t fbBandDone = PTHREAD_COND_INITIALIZER;
+static pthread_once_t fbBandOnce = PTHREAD_ONCE_INIT;
+static FbBandJobPtr fbBandJob;
+static Bool fbBandBusy;         /* some thread is running a job */
+static int fbBandThreads;       /* workers besides the calling thread */
+
+/* Run the next band of job, if any.  Called and returns with fbBandLock
+ * held, but drops it while the band is drawn. */
+static Bool
+fbRunBand(FbBandJobPtr job)
+{
+    int y, height;
+
+    if (job->next == job->nbands)
+        return FALSE;
+    y = job->y + job->next++ * job->band;
+    height = min(job->band, job->y + job->height - y);
+
+    pthread_mutex_unlock(&fbBandLock);
+    (*job->proc) (y, height, job->closure);
+    pthread_mutex_lock(&fbBandLock);
+
+    if (++job->done == job->nbands)
+        pthread_cond_signal(&fbBandDone);
+    return TRUE;
+}
+
+static void *
+fbBandWorker(void *arg)
+{
+#ifndef WIN32
+    sigset_t set;
+
+    /* Don't handle any signals on this thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+    pthread_mutex_lock(&fbBandLock);
+    for (;;) {
+        if (!fbBandJob || !fbRunBand(fbBandJob))
+            pthread_cond_wait(&fbBandWork, &fbBandLock);
+    }
+    return NULL;
+}
+
+static void
+fbStartBandThreads(void)
+{
+    pthread_t thread;
+    int ncpus;
+
+#ifdef WIN32
+    ncpus = pthread_num_processors_np();
+#else
+    ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    ncpus = min(ncpus, FB_MAX_THREADS);
+
+    for (; fbBandThreads < ncpus - 1; fbBandThreads++) {
+        if (pthread_create(&thread, NULL, fbBandWorker, NULL) != 0)
+            break;
+        pthread_detach(thread);
+    }
+}
+
+void
+fbParallelBands(int y, int height, int stride, FbBandProc proc,
+                void *closure)
+{
+    FbBandJobRec job;
+    Bool busy;
+    int band;
+
+    pthread_once(&fbBandOnce, fbStartBandThreads);
+
+    if (!fbBandThreads || stride <= 0 ||
+        (long) stride * height < FB_PARALLEL_MIN_BYTES) {
+        (*proc) (y, height, closure);
+        return;
+    }
+
+    pthread_mutex_lock(&fbBandLock);
+    busy = fbBandBusy;
+    fbBandBusy = TRUE;
+    pthread_mutex_unlock(&fbBandLock);
+    if (busy) {
+        (*proc) (y, height, closure);
+        return;
+    }
+
+    band = max(FB_BAND_BYTES / stride, 1);
+    band = min(band, (height + fbBandThreads) / (fbBandThreads + 1));
+
+    /* The first band always runs here, before any other starts, so that
+     * proc can leave lazy setup of shared state to its first call. */
+    (*proc) (y, band, closure);
+
+    job.proc = proc;
+    job.closure = closure;
+    job.y = y + band;
+    job.height = height - band;
+    job.band = band;
+    job.nbands = (job.height + band - 1) / band;
+    job.next = 0;
+    job.done = 0;
+
+    pthread_mutex_lock(&fbBandLock);
+    fbBandJob = &job;
+    pthread_cond_broadcast(&fbBandWork);
+    while (fbRunBand(&job))
+        ;
+    while (job.done < job.nbands)
+        pthread_cond_wait(&fbBandDone, &fbBandLock);
+    fbBandJob = NULL;
+    fbBandBusy = FALSE;
+    pthread_mutex_unlock(&fbBandLock);
+}
+
+#else
+
+void
+fbParallelBands(int y, int height, int stride, FbBandProc proc,
+                void *closure)
+{
+    (*proc) (y, height, closure);
+}
+
+#endif
@@ -123,6 +123,10 @@ xnestGetImage(DrawablePtr pDrawable, int x, int y, int w, int h,
 
         XDestroyImage(ximage);
     }
+    else if (format == ZPixmap)
+        memset(pImage, 0, PixmapBytePad(w, pDrawable->depth) * h);
+    else
+        memset(pImage, 0, BitmapBytePad(w) * h);
 }
 
 static Bool
@@ -24,6 +24,8 @@ extern Bool noTestExtensions;
 extern Bool noXFixesExtension;
 extern Bool noXFree86BigfontExtension;
 
+extern Bool ShmPrefaultSegments;
+
 void CompositeExtensionInit(void);
 void DamageExtensionInit(void);
 void DbeExtensionInit(void);
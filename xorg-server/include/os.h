@@ -89,6 +89,13 @@ extern _X_EXPORT int ReadFdFromClient(ClientPtr client);
 extern _X_EXPORT int WriteToClient(ClientPtr /*who */ , int /*count */ ,
                                    const void * /*buf */ );
 
+typedef void (*OutputReleaseProcPtr)(void *closure);
+
+extern _X_EXPORT int WriteToClientRef(ClientPtr who, int count,
+                                      const void *buf,
+                                      OutputReleaseProcPtr release,
+                                      void *closure);
+
 extern _X_EXPORT int TransIsListening(char *protocol);
 
 extern _X_EXPORT void EstablishNewConnections(ClientPtr clientUnused,
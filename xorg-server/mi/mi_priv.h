@@ -73,6 +73,7 @@ void miChangeBorderWidth(WindowPtr pWin, unsigned int width);
 void miMarkUnrealizedWindow(WindowPtr pChild, WindowPtr pWin, Bool fromConfigure);
 WindowPtr miSpriteTrace(SpritePtr pSprite, int x, int y);
 WindowPtr miXYToWindow(ScreenPtr pScreen, SpritePtr pSprite, int x, int y);
+void miPickIndexChanged(ScreenPtr pScreen);
 
 int miExpandDirectColors(ColormapPtr, int, xColorItem *, xColorItem *);
 
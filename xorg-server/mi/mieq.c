@@ -69,6 +69,7 @@ in this Software without prior written authorization from The Open Group.
 #define QUEUE_MAXIMUM_SIZE                4096
 #define QUEUE_DROP_BACKTRACE_FREQUENCY     100
 #define QUEUE_DROP_BACKTRACE_MAX            10
+#define QUEUE_BATCH_SIZE                    16
 
 #define EnqueueScreen(dev) dev->spriteInfo->sprite->pEnqueueScreen
 #define DequeueScreen(dev) dev->spriteInfo->sprite->pDequeueScreen
@@ -79,6 +80,12 @@ typedef struct _Event {
     DeviceIntPtr pDev;          /* device this event _originated_ from */
 } EventRec, *EventPtr;
 
+typedef struct _BatchEvent {
+    InternalEvent event;
+    ScreenPtr pScreen;
+    DeviceIntPtr pDev;
+} BatchEventRec;
+
 typedef struct _EventQueue {
     HWEventQueueType head, tail;        /* long for SetInputCheck */
     CARD32 lastEventTime;       /* to avoid time running backwards */
@@ -87,6 +94,9 @@ typedef struct _EventQueue {
     size_t nevents;             /* the number of buckets in our queue */
     size_t dropped;             /* counter for number of consecutive dropped events */
     mieqHandler handlers[128];  /* custom event handler */
+    /* events taken off the queue but not processed yet */
+    BatchEventRec batch[QUEUE_BATCH_SIZE];
+    int batchHead, batchTail;
 } EventQueueRec, *EventQueuePtr;
 
 static EventQueueRec miEventQueue;
@@ -513,11 +523,40 @@ mieqProcessDeviceEvent(DeviceIntPtr dev, InternalEvent *event, ScreenPtr screen)
     }
 }
 
+/*
+ * Take up to QUEUE_BATCH_SIZE events off the queue, so that the input
+ * thread and the main thread trade the input lock once per batch rather
+ * than once per event.  A nested mieqProcessInputEvents finishes any
+ * batch the outer call was working on first, keeping the events in
+ * order.  Pre-condition: Called with input_lock held
+ */
+static Bool
+mieqFillBatch(EventQueuePtr eventQueue)
+{
+    if (eventQueue->batchHead != eventQueue->batchTail)
+        return TRUE;
+
+    eventQueue->batchHead = eventQueue->batchTail = 0;
+    while (eventQueue->head != eventQueue->tail &&
+           eventQueue->batchTail < QUEUE_BATCH_SIZE) {
+        EventRec *e = &eventQueue->events[eventQueue->head];
+        BatchEventRec *b = &eventQueue->batch[eventQueue->batchTail++];
+
+        memcpy(&b->event, e->events, e->events->any.length);
+        b->pDev = e->pDev;
+        b->pScreen = e->pScreen;
+
+        eventQueue->head = (eventQueue->head + 1) % eventQueue->nevents;
+    }
+
+    return eventQueue->batchTail != 0;
+}
+
 /* Call this from ProcessInputEvents(). */
 void
 mieqProcessInputEvents(void)
 {
-    EventRec *e = NULL;
+    BatchEventRec *b;
     ScreenPtr screen;
     InternalEvent event;
     DeviceIntPtr dev = NULL, master = NULL;
@@ -541,38 +580,40 @@ mieqProcessInputEvents(void)
         miEventQueue.dropped = 0;
     }
 
-    while (miEventQueue.head != miEventQueue.tail) {
-        e = &miEventQueue.events[miEventQueue.head];
-
-        event = *e->events;
-        dev = e->pDev;
-        screen = e->pScreen;
-
-        miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
-
+    while (mieqFillBatch(&miEventQueue)) {
         input_unlock();
 
-        master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
+        while (miEventQueue.batchHead != miEventQueue.batchTail) {
+            /* A nested call may refill the batch, so work on a copy */
+            b = &miEventQueue.batch[miEventQueue.batchHead++];
+            memcpy(&event, &b->event, b->event.any.length);
+            dev = b->pDev;
+            screen = b->pScreen;
 
-        if (screenIsSaved == SCREEN_SAVER_ON)
-            dixSaveScreens(serverClient, SCREEN_SAVER_OFF, ScreenSaverReset);
+            master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
+
+            if (screenIsSaved == SCREEN_SAVER_ON)
+                dixSaveScreens(serverClient, SCREEN_SAVER_OFF,
+                               ScreenSaverReset);
 #ifdef DPMSExtension
-        else if (DPMSPowerLevel != DPMSModeOn)
-            SetScreenSaverTimer();
+            else if (DPMSPowerLevel != DPMSModeOn)
+                SetScreenSaverTimer();
 
-        if (DPMSPowerLevel != DPMSModeOn)
-            DPMSSet(serverClient, DPMSModeOn);
+            if (DPMSPowerLevel != DPMSModeOn)
+                DPMSSet(serverClient, DPMSModeOn);
 #endif
 
-        mieqProcessDeviceEvent(dev, &event, screen);
+            mieqProcessDeviceEvent(dev, &event, screen);
 
-        /* Update the sprite now. Next event may be from different device. */
-        if (master &&
-            (event.any.type == ET_Motion ||
-             ((event.any.type == ET_TouchBegin ||
-               event.any.type == ET_TouchUpdate) &&
-              event.device_event.flags & TOUCH_POINTER_EMULATED)))
-            miPointerUpdateSprite(dev);
+            /* Update the sprite now. Next event may be from different
+             * device. */
+            if (master &&
+                (event.any.type == ET_Motion ||
+                 ((event.any.type == ET_TouchBegin ||
+                   event.any.type == ET_TouchUpdate) &&
+                  event.device_event.flags & TOUCH_POINTER_EMULATED)))
+                miPointerUpdateSprite(dev);
+        }
 
         input_lock();
     }
@@ -729,6 +729,10 @@ miOverlayValidateTree(WindowPtr pParent, WindowPtr pChild,      /* first child e
     Bool overlap;
     WindowPtr newParent;
 
+    /* top-level windows may have moved, restacked, (un)mapped */
+    if (!pParent->parent)
+        miPickIndexChanged(pScreen);
+
     if (!pPriv->underlayMarked)
         goto SKIP_UNDERLAY;
 
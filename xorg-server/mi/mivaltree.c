@@ -177,6 +177,73 @@ miShapedWindowIn(RegionPtr universe, RegionPtr bounding,
 				    HasBorder(w) && \
 				    (w)->backgroundState == ParentRelative)
 
+/*
+ * Windows get marked by bounding box, so in a deep stack most of the
+ * siblings a move or restack marks end up with exactly the borderClip they
+ * had before, typically because they are buried under other windows.  If
+ * such a window (and every marked window below it) did not itself move,
+ * resize or change shape, nothing in its subtree can have changed: give
+ * the marked windows empty exposures and skip the subtree.  VTOther
+ * covers resizes and redirection changes and is always recomputed.
+ */
+static Bool
+miClipsUnchanged(WindowPtr pParent, RegionPtr universe, int oldVis)
+{
+    WindowPtr pChild;
+
+    if (oldVis == VisibilityNotViewable ||
+#ifdef COMPOSITE
+        pParent->redirectDraw != RedirectDrawNone ||
+#endif
+        !RegionEqual(universe, &pParent->borderClip))
+        return FALSE;
+
+    pChild = pParent;
+    while (1) {
+        if (pChild->viewable) {
+            if (pChild->valdata) {
+                if (pChild->valdata == UnmapValData ||
+                    (pChild != pParent &&
+                     pChild->visibility == VisibilityNotViewable) ||
+                    pChild->valdata->before.borderVisible ||
+                    pChild->valdata->before.resized ||
+                    pChild->valdata->before.oldAbsCorner.x != pChild->drawable.x ||
+                    pChild->valdata->before.oldAbsCorner.y != pChild->drawable.y)
+                    return FALSE;
+            }
+            if (pChild->firstChild) {
+                pChild = pChild->firstChild;
+                continue;
+            }
+        }
+        while (!pChild->nextSib && (pChild != pParent))
+            pChild = pChild->parent;
+        if (pChild == pParent)
+            break;
+        pChild = pChild->nextSib;
+    }
+
+    pChild = pParent;
+    while (1) {
+        if (pChild->viewable) {
+            if (pChild->valdata) {
+                RegionNull(&pChild->valdata->after.borderExposed);
+                RegionNull(&pChild->valdata->after.exposed);
+            }
+            if (pChild->firstChild) {
+                pChild = pChild->firstChild;
+                continue;
+            }
+        }
+        while (!pChild->nextSib && (pChild != pParent))
+            pChild = pChild->parent;
+        if (pChild == pParent)
+            break;
+        pChild = pChild->nextSib;
+    }
+    return TRUE;
+}
+
 /*
  *-----------------------------------------------------------------------
  * miComputeClips --
@@ -285,6 +352,10 @@ miComputeClips(WindowPtr pParent,
      * avoid computations when dealing with simple operations
      */
 
+    if (kind != VTOther && kind != VTBroken && !dx && !dy &&
+        miClipsUnchanged(pParent, universe, oldVis))
+        return;
+
     switch (kind) {
     case VTMap:
     case VTStack:
@@ -574,6 +645,10 @@ miValidateTree(WindowPtr pParent,       /* Parent to validate */
     if (pChild == NullWindow)
         pChild = pParent->firstChild;
 
+    /* top-level windows may have moved, restacked, (un)mapped */
+    if (!pParent->parent)
+        miPickIndexChanged(pScreen);
+
     RegionNull(&childClip);
     RegionNull(&exposed);
 
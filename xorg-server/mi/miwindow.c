@@ -748,15 +748,12 @@ miMarkUnrealizedWindow(WindowPtr pChild, WindowPtr pWin, Bool fromConfigure)
     }
 }
 
-WindowPtr
-miSpriteTrace(SpritePtr pSprite, int x, int y)
+static inline Bool
+miSpriteHit(WindowPtr pWin, int x, int y)
 {
-    WindowPtr pWin;
     BoxRec box;
 
-    pWin = DeepestSpriteWin(pSprite)->firstChild;
-    while (pWin) {
-        if ((pWin->mapped) &&
+    return ((pWin->mapped) &&
             (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
             (x < pWin->drawable.x + (int) pWin->drawable.width +
              wBorderWidth(pWin)) &&
@@ -776,14 +773,30 @@ miSpriteTrace(SpritePtr pSprite, int x, int y)
              * they're in X's stack. (E.g. if the native window system
              * implements some form of virtual desktop system).
              */
-            && !pWin->unhittable) {
-            if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
-                pSprite->spriteTraceSize += 10;
-                pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
-                                                    pSprite->spriteTraceSize,
-                                                    sizeof(WindowPtr));
-            }
-            pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
+            && !pWin->unhittable);
+}
+
+static void
+miSpriteTracePush(SpritePtr pSprite, WindowPtr pWin)
+{
+    if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
+        pSprite->spriteTraceSize += 10;
+        pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
+                                            pSprite->spriteTraceSize,
+                                            sizeof(WindowPtr));
+    }
+    pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
+}
+
+WindowPtr
+miSpriteTrace(SpritePtr pSprite, int x, int y)
+{
+    WindowPtr pWin;
+
+    pWin = DeepestSpriteWin(pSprite)->firstChild;
+    while (pWin) {
+        if (miSpriteHit(pWin, x, y)) {
+            miSpriteTracePush(pSprite, pWin);
             pWin = pWin->firstChild;
         }
         else
@@ -792,6 +805,134 @@ miSpriteTrace(SpritePtr pSprite, int x, int y)
     return DeepestSpriteWin(pSprite);
 }
 
+/*
+ * Pointer picking index.  With hundreds of top-level windows, walking all
+ * of the root's children for every motion event shows up in profiles.
+ * Instead, the mapped top-level windows are binned by their bounding
+ * rectangle into a grid of cells over the root window, each cell listing
+ * its windows top to bottom, and only the cell under the pointer is
+ * searched.  Any validation of the root's children invalidates the grid;
+ * it is rebuilt once the stack has settled, since while windows are being
+ * dragged around the walk is cheaper than a rebuild per event.
+ */
+#define PICK_MIN_WINDOWS 32     /* the walk is fast enough below this */
+#define PICK_SETTLE 8           /* walks after a change before a rebuild */
+#define PICK_CELL_SHIFT 7       /* 128x128 pixel cells */
+
+typedef struct {
+    WindowPtr root;
+    unsigned long generation;
+    Bool valid;
+    int settle;
+    int x, y, cols, rows;       /* no grid when cols is 0 */
+    int *cells;                 /* offsets into windows, one per cell + 1 */
+    WindowPtr *windows;
+    int cellsSize, windowsSize;
+} miPickIndexRec;
+
+static miPickIndexRec miPickIndex[MAXSCREENS];
+
+void
+miPickIndexChanged(ScreenPtr pScreen)
+{
+    miPickIndexRec *index = &miPickIndex[pScreen->myNum];
+
+    index->valid = FALSE;
+    index->settle = 0;
+}
+
+/* Cell range covered by the bounding rectangle of a window, if any */
+static Bool
+miPickCells(miPickIndexRec *index, WindowPtr pWin, BoxPtr cells)
+{
+    int bw = wBorderWidth(pWin);
+    int x1 = pWin->drawable.x - bw - index->x;
+    int y1 = pWin->drawable.y - bw - index->y;
+    int x2 = x1 + (int) pWin->drawable.width + 2 * bw;
+    int y2 = y1 + (int) pWin->drawable.height + 2 * bw;
+
+    if (x2 <= 0 || y2 <= 0 ||
+        x1 >= index->cols << PICK_CELL_SHIFT ||
+        y1 >= index->rows << PICK_CELL_SHIFT)
+        return FALSE;
+    cells->x1 = max(x1, 0) >> PICK_CELL_SHIFT;
+    cells->y1 = max(y1, 0) >> PICK_CELL_SHIFT;
+    cells->x2 = min((x2 - 1) >> PICK_CELL_SHIFT, index->cols - 1);
+    cells->y2 = min((y2 - 1) >> PICK_CELL_SHIFT, index->rows - 1);
+    return TRUE;
+}
+
+static void
+miPickIndexBuild(miPickIndexRec *index, WindowPtr pRoot)
+{
+    WindowPtr pWin;
+    BoxRec cells;
+    int n = 0, ncells, cx, cy, i;
+
+    index->valid = TRUE;
+    index->cols = 0;
+
+    for (pWin = pRoot->firstChild; pWin; pWin = pWin->nextSib)
+        if (pWin->mapped)
+            n++;
+    if (n < PICK_MIN_WINDOWS)
+        return;
+
+    index->x = pRoot->drawable.x;
+    index->y = pRoot->drawable.y;
+    index->cols = (pRoot->drawable.width + (1 << PICK_CELL_SHIFT) - 1) >>
+        PICK_CELL_SHIFT;
+    index->rows = (pRoot->drawable.height + (1 << PICK_CELL_SHIFT) - 1) >>
+        PICK_CELL_SHIFT;
+    ncells = index->cols * index->rows;
+    if (ncells + 1 > index->cellsSize) {
+        int *tmp = reallocarray(index->cells, ncells + 1, sizeof(int));
+
+        if (!tmp)
+            goto fail;
+        index->cells = tmp;
+        index->cellsSize = ncells + 1;
+    }
+
+    /* count the windows of each cell, then turn the counts into offsets */
+    memset(index->cells, 0, (ncells + 1) * sizeof(int));
+    for (pWin = pRoot->firstChild; pWin; pWin = pWin->nextSib) {
+        if (!pWin->mapped || !miPickCells(index, pWin, &cells))
+            continue;
+        for (cy = cells.y1; cy <= cells.y2; cy++)
+            for (cx = cells.x1; cx <= cells.x2; cx++)
+                index->cells[cy * index->cols + cx + 1]++;
+    }
+    for (i = 0; i < ncells; i++)
+        index->cells[i + 1] += index->cells[i];
+    if (index->cells[ncells] > index->windowsSize) {
+        WindowPtr *tmp = reallocarray(index->windows, index->cells[ncells],
+                                      sizeof(WindowPtr));
+
+        if (!tmp)
+            goto fail;
+        index->windows = tmp;
+        index->windowsSize = index->cells[ncells];
+    }
+
+    /* fill top to bottom, using the offsets as cursors and shifting
+     * them back afterwards */
+    for (pWin = pRoot->firstChild; pWin; pWin = pWin->nextSib) {
+        if (!pWin->mapped || !miPickCells(index, pWin, &cells))
+            continue;
+        for (cy = cells.y1; cy <= cells.y2; cy++)
+            for (cx = cells.x1; cx <= cells.x2; cx++)
+                index->windows[index->cells[cy * index->cols + cx]++] = pWin;
+    }
+    for (i = ncells; i > 0; i--)
+        index->cells[i] = index->cells[i - 1];
+    index->cells[0] = 0;
+    return;
+
+ fail:
+    index->cols = 0;
+}
+
 /**
  * Traversed from the root window to the window at the position x/y. While
  * traversing, it sets up the traversal history in the spriteTrace array.
@@ -806,6 +947,40 @@ miSpriteTrace(SpritePtr pSprite, int x, int y)
 WindowPtr
 miXYToWindow(ScreenPtr pScreen, SpritePtr pSprite, int x, int y)
 {
+    miPickIndexRec *index = &miPickIndex[pScreen->myNum];
+    WindowPtr pRoot = pSprite->spriteTrace[0];
+    WindowPtr pWin;
+    int cx, cy, cell, i;
+
     pSprite->spriteTraceGood = 1;       /* root window still there */
-    return miSpriteTrace(pSprite, x, y);
+
+    if (pRoot != pScreen->root)
+        return miSpriteTrace(pSprite, x, y);
+    if (index->root != pRoot || index->generation != serverGeneration) {
+        index->root = pRoot;
+        index->generation = serverGeneration;
+        miPickIndexChanged(pScreen);
+    }
+    if (!index->valid) {
+        if (++index->settle < PICK_SETTLE)
+            return miSpriteTrace(pSprite, x, y);
+        miPickIndexBuild(index, pRoot);
+    }
+
+    cx = x - index->x;
+    cy = y - index->y;
+    if (!index->cols || cx < 0 || cy < 0 ||
+        cx >= index->cols << PICK_CELL_SHIFT ||
+        cy >= index->rows << PICK_CELL_SHIFT)
+        return miSpriteTrace(pSprite, x, y);
+
+    cell = (cy >> PICK_CELL_SHIFT) * index->cols + (cx >> PICK_CELL_SHIFT);
+    for (i = index->cells[cell]; i < index->cells[cell + 1]; i++) {
+        pWin = index->windows[i];
+        if (miSpriteHit(pWin, x, y)) {
+            miSpriteTracePush(pSprite, pWin);
+            return miSpriteTrace(pSprite, x, y);
+        }
+    }
+    return pRoot;
 }
@@ -22,7 +22,9 @@
 
 #include <dix-config.h>
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "os/osdep.h"
 
@@ -122,6 +124,158 @@ getDrawableDamageRef(DrawablePtr pDrawable)
     DamagePtr	*pPrev = (DamagePtr *) \
 	dixLookupPrivateAddr(&(pWindow)->devPrivates, damageWinPrivateKey)
 
+/*
+ * Damage coalescing.  Consumers like shadow walk the accumulated damage
+ * box by box, and text or scattered small updates easily leave thousands
+ * of tiny boxes, each costing a call, a blit setup and cache misses.
+ *
+ * DAMAGE_BOX_COST is the rough cost of handling one box, expressed in
+ * pixels: boxes are merged only where the pixels the merge adds cost
+ * less than the boxes it saves, and never into a box that would be
+ * mostly undamaged, which keeps one cost estimate from turning sparse
+ * damage into a handful of huge boxes.  Damage too scattered for that
+ * to pay off is left alone, however many boxes it has.
+ */
+
+typedef struct _damageBand {
+    BoxRec extents;
+    int64_t area;               /* pixels actually damaged */
+    int first, nbox;            /* boxes of the original band */
+} DamageBandRec, *DamageBandPtr;
+
+static inline int64_t
+damageBoxArea(const BoxRec *box)
+{
+    return (int64_t) (box->x2 - box->x1) * (box->y2 - box->y1);
+}
+
+static int
+damageCoalesceBands(const BoxRec *boxes, const DamageBandRec *bands,
+                    int nbands, int64_t cost, BoxPtr out)
+{
+    DamageBandRec group;
+    int64_t groupWaste = 0, bandWaste, waste;
+    int groupBoxes = 0, bandBoxes, n = 0, i;
+    BoxRec merged;
+
+    for (i = 0; i < nbands; i++) {
+        const DamageBandRec *band = &bands[i];
+
+        /* Collapse the band to its extents when that is cheap enough */
+        bandWaste = damageBoxArea(&band->extents) - band->area;
+        bandBoxes = band->nbox;
+        if (bandBoxes > 1 && bandWaste <= band->area &&
+            bandWaste <= cost * (bandBoxes - 1))
+            bandBoxes = 1;
+        else if (bandBoxes > 1)
+            bandWaste = 0;
+
+        /* Then try to merge it with the group above */
+        if (groupBoxes) {
+            merged.x1 = min(group.extents.x1, band->extents.x1);
+            merged.y1 = group.extents.y1;
+            merged.x2 = max(group.extents.x2, band->extents.x2);
+            merged.y2 = band->extents.y2;
+            waste = damageBoxArea(&merged) - group.area - band->area;
+            if (waste <= group.area + band->area &&
+                waste - groupWaste - bandWaste <=
+                cost * (groupBoxes + bandBoxes - 1)) {
+                group.extents = merged;
+                group.area += band->area;
+                group.nbox = 0;
+                groupWaste = waste;
+                groupBoxes = 1;
+                continue;
+            }
+            if (group.nbox > 1 && groupBoxes > 1) {
+                memcpy(out + n, boxes + group.first,
+                       group.nbox * sizeof(BoxRec));
+                n += group.nbox;
+            }
+            else
+                out[n++] = group.extents;
+        }
+        group = *band;
+        groupWaste = bandWaste;
+        groupBoxes = bandBoxes;
+    }
+    if (group.nbox > 1 && groupBoxes > 1) {
+        memcpy(out + n, boxes + group.first, group.nbox * sizeof(BoxRec));
+        n += group.nbox;
+    }
+    else if (groupBoxes)
+        out[n++] = group.extents;
+    return n;
+}
+
+/*
+ * Replace pRegion by a region covering it with the boxes merged where
+ * that is cheaper than keeping them apart.
+ */
+void
+damageCoalesceRegion(RegionPtr pRegion)
+{
+    int nbox = RegionNumRects(pRegion);
+    BoxPtr boxes = RegionRects(pRegion);
+    DamageBandPtr bands;
+    BoxPtr out;
+    RegionRec coalesced;
+    int nbands, n, i;
+
+    if (nbox <= 1)
+        return;
+
+    bands = xallocarray(nbox, sizeof(DamageBandRec));
+    out = xallocarray(nbox, sizeof(BoxRec));
+    if (!bands || !out) {
+        free(bands);
+        free(out);
+        return;
+    }
+
+    /* Regions are stored as y-x banded boxes, gather the bands */
+    for (nbands = 0, i = 0; i < nbox; nbands++) {
+        DamageBandPtr band = &bands[nbands];
+
+        band->extents = boxes[i];
+        band->area = 0;
+        band->first = i;
+        band->nbox = 0;
+        for (; i < nbox && boxes[i].y1 == band->extents.y1; i++) {
+            band->extents.x2 = boxes[i].x2;
+            band->area += damageBoxArea(&boxes[i]);
+            band->nbox++;
+        }
+    }
+
+    n = damageCoalesceBands(boxes, bands, nbands, DAMAGE_BOX_COST, out);
+    if (n < nbox && RegionInitBoxes(&coalesced, out, n)) {
+        RegionUninit(pRegion);
+        *pRegion = coalesced;
+    }
+    free(bands);
+    free(out);
+}
+
+/* Delta reports are computed against the accumulated region, which
+ * therefore has to stay exact.  Coalesced damage is looked at again
+ * once it has doubled, damage that did not even halve is left alone
+ * until it is emptied. */
+static inline void
+damageLimitRegion(DamagePtr pDamage)
+{
+    int nbox = RegionNumRects(&pDamage->damage);
+
+    if (pDamage->coalesceThreshold && pDamage->coalescedBoxes >= 0 &&
+        pDamage->damageLevel != DamageReportDeltaRegion &&
+        nbox > max(pDamage->coalesceThreshold, pDamage->coalescedBoxes * 2)) {
+        damageCoalesceRegion(&pDamage->damage);
+        pDamage->coalescedBoxes = RegionNumRects(&pDamage->damage);
+        if (pDamage->coalescedBoxes > nbox / 2)
+            pDamage->coalescedBoxes = -1;
+    }
+}
+
 #if DAMAGE_DEBUG_ENABLE
 static void
 _damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
@@ -265,8 +419,10 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
         if (!pDamage->reportAfter) {
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, pDamageRegion);
-            else
+            else {
                 RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+                damageLimitRegion(pDamage);
+            }
         }
 
         /*
@@ -293,9 +449,11 @@ damageRegionProcessPending(DrawablePtr pDrawable)
             /* It's possible that there is only interest in postRendering reporting. */
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, &pDamage->pendingDamage);
-            else
+            else {
                 RegionUnion(&pDamage->damage, &pDamage->damage,
                             &pDamage->pendingDamage);
+                damageLimitRegion(pDamage);
+            }
         }
 
         if (pDamage->reportAfter)
@@ -1921,6 +2079,13 @@ DamageSubtract(DamagePtr pDamage, const RegionPtr pRegion)
         if (pDrawable->type != DRAWABLE_WINDOW)
             RegionUninit(&pixmapClip);
     }
+    /* Doubling is measured from what is left, not from an empty region,
+     * so a partial subtract does not coalesce again on the next append.
+     * Damage that did not pay off stays exact until it is emptied. */
+    if (!RegionNotEmpty(&pDamage->damage))
+        pDamage->coalescedBoxes = 0;
+    else if (pDamage->coalescedBoxes > 0)
+        pDamage->coalescedBoxes = RegionNumRects(&pDamage->damage);
     return RegionNotEmpty(&pDamage->damage);
 }
 
@@ -1928,6 +2093,7 @@ void
 DamageEmpty(DamagePtr pDamage)
 {
     RegionEmpty(&pDamage->damage);
+    pDamage->coalescedBoxes = 0;
 }
 
 RegionPtr
@@ -1973,6 +2139,13 @@ DamageSetReportAfterOp(DamagePtr pDamage, Bool reportAfter)
     pDamage->reportAfter = reportAfter;
 }
 
+void
+DamageSetCoalesceThreshold(DamagePtr pDamage, int threshold)
+{
+    pDamage->coalesceThreshold = threshold;
+    damageLimitRegion(pDamage);
+}
+
 DamageScreenFuncsPtr
 DamageGetScreenFuncs(ScreenPtr pScreen)
 {
@@ -2021,4 +2194,6 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
         RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
         break;
     }
+
+    damageLimitRegion(pDamage);
 }
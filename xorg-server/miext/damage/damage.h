@@ -110,6 +110,16 @@ extern _X_EXPORT void
 extern _X_EXPORT void
  DamageSetReportAfterOp(DamagePtr pDamage, Bool reportAfter);
 
+/*
+ * Once the accumulated damage region has more than threshold boxes,
+ * merge nearby boxes where the pixels that adds are cheaper to handle
+ * than the boxes it saves.  This is not a bound: damage too scattered
+ * for merging to pay off keeps all of its boxes.  0 (the default) keeps
+ * the region exact.  Ignored for DamageReportDeltaRegion.
+ */
+extern _X_EXPORT void
+ DamageSetCoalesceThreshold(DamagePtr pDamage, int threshold);
+
 extern _X_EXPORT DamageScreenFuncsPtr DamageGetScreenFuncs(ScreenPtr);
 
 #endif                          /* _DAMAGE_H_ */
@@ -49,6 +49,11 @@ typedef struct _damage {
     Bool reportAfter;
     RegionRec pendingDamage;    /* will be flushed post submission at the latest */
     ScreenPtr pScreen;
+
+    int coalesceThreshold;      /* try coalescing beyond this many boxes,
+                                   0 = never */
+    int coalescedBoxes;         /* boxes left by the last coalescing or
+                                   subtract, -1 when it did not pay off */
 } DamageRec;
 
 typedef struct _damageScrPriv {
@@ -79,6 +84,11 @@ typedef struct _damageGCPriv {
     const GCFuncs *funcs;
 } DamageGCPrivRec, *DamageGCPrivPtr;
 
+/* rough cost of handling one damage box, in pixels */
+#define DAMAGE_BOX_COST 1024
+
+void damageCoalesceRegion(RegionPtr pRegion);
+
 /* XXX should move these into damage.c, damageScrPrivateIndex is static */
 #define damageGetScrPriv(pScr) ((DamageScrPrivPtr) \
     dixLookupPrivate(&(pScr)->devPrivates, damageScrPrivateKey))
@@ -37,6 +37,10 @@
 static DevPrivateKeyRec shadowScrPrivateKeyRec;
 #define shadowScrPrivateKey (&shadowScrPrivateKeyRec)
 
+/* Beyond this many boxes of damage, try merging the ones that are
+ * cheaper to copy together than one by one */
+#define SHADOW_DAMAGE_BOXES 64
+
 #define shadowGetBuf(pScr) ((shadowBufPtr) \
     dixLookupPrivate(&(pScr)->devPrivates, shadowScrPrivateKey))
 #define shadowBuf(pScr)            shadowBufPtr pBuf = shadowGetBuf(pScr)
@@ -129,6 +133,7 @@ shadowSetup(ScreenPtr pScreen)
         free(pBuf);
         return FALSE;
     }
+    DamageSetCoalesceThreshold(pBuf->pDamage, SHADOW_DAMAGE_BOXES);
 
     wrap(pBuf, pScreen, CloseScreen);
     wrap(pBuf, pScreen, GetImage);
@@ -44,6 +44,9 @@ const char *ClientAuthorized(struct _Client *client,
 Bool AddClientOnOpenFD(int fd);
 void ListenOnOpenFD(int fd, int noxauth);
 int ReadRequestFromClient(struct _Client *client);
+
+/* number of complete requests buffered behind the current one */
+int ClientRequestRun(struct _Client *client);
 int WriteFdToClient(struct _Client *client, int fd, Bool do_close);
 Bool InsertFakeRequest(struct _Client *client, char *data, int count);
 void FlushAllOutput(void);
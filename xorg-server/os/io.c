@@ -94,13 +94,32 @@ typedef struct _connectionInput {
     int lenLastReq;
     int size;
     unsigned int ignoreBytes;   /* bytes to ignore before the next request */
+    int runLeft;                /* complete requests known to follow */
 } ConnectionInput;
 
+/*
+ * Output is kept as an ordered ring of segments.  Small writes are copied
+ * into buf and simply extend the last segment; large replies handed over
+ * with WriteToClientRef are queued by reference and released once they
+ * have been written.  FlushClient gathers the whole ring into one writev.
+ */
+typedef struct _outputSegment {
+    const char *data;           /* NULL if the bytes live in buf */
+    int offset;                 /* start of the unwritten bytes */
+    int count;                  /* unwritten bytes */
+    OutputReleaseProcPtr release;
+    void *closure;
+} OutputSegment;
+
 typedef struct _connectionOutput {
-    struct _connectionOutput *next;
     unsigned char *buf;
     int size;
-    int count;
+    int count;                  /* bytes of buf in use */
+    OutputSegment *segs;
+    int first;
+    int numSegs;
+    int maxSegs;                /* power of two */
+    long pending;               /* unwritten bytes in all segments */
 } ConnectionOutput;
 
 static ConnectionInputPtr AllocateInputBuffer(void);
@@ -109,9 +128,13 @@ static ConnectionOutputPtr AllocateOutputBuffer(void);
 static Bool CriticalOutputPending;
 static int timesThisConnection = 0;
 static ConnectionInputPtr FreeInputs = (ConnectionInputPtr) NULL;
-static ConnectionOutputPtr FreeOutputs = (ConnectionOutputPtr) NULL;
 static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 
+/* idle output buffers, reused by the next client that writes */
+#define MAX_FREE_OUTPUTS 16
+static ConnectionOutputPtr FreeOutputs[MAX_FREE_OUTPUTS];
+static int NumFreeOutputs;
+
 #define get_req_len(req,cli) ((cli)->swapped ? \
 			      bswap_16((req)->length) : (req)->length)
 
@@ -123,6 +146,9 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 
 #define BUFSIZE 16384
 #define BUFWATERMARK 32768
+#define REFWATERMARK (256 * 1024)
+#define OUTPUT_SEGMENTS 16
+#define MAX_OUTPUT_IOV 64
 
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
@@ -228,6 +254,37 @@ NextAvailableInput(OsCommPtr oc)
     }
 }
 
+/* Count the complete requests with an ordinary length field that follow
+ * in the buffer, so the next calls of ReadRequestFromClient can hand them
+ * out without going through the checks below again.  Big requests and
+ * partial requests end the run.  The buffer is only scanned again past
+ * the end of a run, after a read or a big request, so each byte is
+ * looked at once; only InsertFakeRequest drops a run. */
+static int
+ScanRequestRun(ClientPtr client, const char *bufptr, unsigned int gotnow)
+{
+    unsigned int needed;
+    int run = 0;
+
+    while (gotnow >= sizeof(xReq)) {
+        needed = get_req_len((const xReq *) bufptr, client) << 2;
+        if (!needed || needed > gotnow)
+            break;
+        bufptr += needed;
+        gotnow -= needed;
+        run++;
+    }
+    return run;
+}
+
+int
+ClientRequestRun(ClientPtr client)
+{
+    OsCommPtr oc = (OsCommPtr) client->osPrivate;
+
+    return (oc && oc->input) ? oc->input->runLeft : 0;
+}
+
 int
 ReadRequestFromClient(ClientPtr client)
 {
@@ -266,6 +323,18 @@ ReadRequestFromClient(ClientPtr client)
 
     oci->bufptr += oci->lenLastReq;
 
+    if (oci->runLeft) {
+        /* already known to be complete, see ScanRequestRun */
+        oci->runLeft--;
+        request = (xReq *) oci->bufptr;
+        client->req_len = get_req_len(request, client);
+        needed = client->req_len << 2;
+        oci->lenLastReq = needed;
+        if (oci->bufcnt + oci->buffer - oci->bufptr == needed)
+            AvailableInput = oc;
+        goto got_request;
+    }
+
     need_header = FALSE;
     move_header = FALSE;
     gotnow = oci->bufcnt + oci->buffer - oci->bufptr;
@@ -440,6 +509,8 @@ ReadRequestFromClient(ClientPtr client)
     gotnow -= needed;
     if (!gotnow)
         AvailableInput = oc;
+    else if (!move_header && client->clientState == ClientStateRunning)
+        oci->runLeft = ScanRequestRun(client, oci->bufptr + needed, gotnow);
     if (move_header) {
         if (client->req_len < bytes_to_int32(sizeof(xBigReq) - sizeof(xReq))) {
             YieldControlDeath();
@@ -452,6 +523,7 @@ ReadRequestFromClient(ClientPtr client)
         oci->lenLastReq -= (sizeof(xBigReq) - sizeof(xReq));
         client->req_len -= bytes_to_int32(sizeof(xBigReq) - sizeof(xReq));
     }
+ got_request:
     client->requestBuffer = (void *) oci->bufptr;
 #ifdef DEBUG_COMMUNICATION
     {
@@ -518,6 +590,7 @@ InsertFakeRequest(ClientPtr client, char *data, int count)
     }
     oci->bufptr += oci->lenLastReq;
     oci->lenLastReq = 0;
+    oci->runLeft = 0;
     gotnow = oci->bufcnt + oci->buffer - oci->bufptr;
     if ((gotnow + count) > oci->size) {
         char *ibuf;
@@ -571,11 +644,19 @@ ResetCurrentRequest(ClientPtr client)
     oci->lenLastReq = 0;
     gotnow = oci->bufcnt + oci->buffer - oci->bufptr;
     if (gotnow < sizeof(xReq)) {
+        oci->runLeft = 0;
         YieldControlNoInput(client);
     }
     else {
         request = (xReq *) oci->bufptr;
         needed = get_req_len(request, client);
+        /* The requests behind this one are unchanged, so a run found by
+         * ScanRequestRun stays valid and this request just rejoins it;
+         * re-executing it must not rescan the whole buffer each time */
+        if (needed && gotnow >= (needed << 2))
+            oci->runLeft++;
+        else
+            oci->runLeft = 0;
         if (!needed && client->big_requests) {
             oci->bufptr -= sizeof(xBigReq) - sizeof(xReq);
             *(xReq *) oci->bufptr = *request;
@@ -666,6 +747,212 @@ AbortClient(ClientPtr client)
     }
 }
 
+#define SegmentAt(oco, i) \
+    (&(oco)->segs[((oco)->first + (i)) & ((oco)->maxSegs - 1)])
+
+static inline char *
+SegmentData(ConnectionOutputPtr oco, OutputSegment *seg)
+{
+    return (seg->data ? (char *) seg->data : (char *) oco->buf) + seg->offset;
+}
+
+static OutputSegment *
+AppendSegment(ConnectionOutputPtr oco)
+{
+    OutputSegment *seg;
+
+    if (oco->numSegs == oco->maxSegs) {
+        OutputSegment *segs;
+        int i;
+
+        segs = xallocarray(oco->maxSegs * 2, sizeof(OutputSegment));
+        if (!segs)
+            return NULL;
+        for (i = 0; i < oco->numSegs; i++)
+            segs[i] = *SegmentAt(oco, i);
+        free(oco->segs);
+        oco->segs = segs;
+        oco->first = 0;
+        oco->maxSegs *= 2;
+    }
+    seg = SegmentAt(oco, oco->numSegs);
+    oco->numSegs++;
+    seg->offset = 0;
+    seg->release = NULL;
+    seg->closure = NULL;
+    return seg;
+}
+
+/* Make room for count more bytes in buf, first by dropping the bytes
+ * that have already been written, then by growing it. */
+static Bool
+GrowOutputBuffer(ConnectionOutputPtr oco, int count)
+{
+    unsigned char *obuf;
+    int i, base = oco->count;
+
+    for (i = 0; i < oco->numSegs; i++) {
+        if (!SegmentAt(oco, i)->data) {
+            base = SegmentAt(oco, i)->offset;
+            break;
+        }
+    }
+    if (base) {
+        memmove(oco->buf, oco->buf + base, oco->count - base);
+        oco->count -= base;
+        for (i = 0; i < oco->numSegs; i++)
+            if (!SegmentAt(oco, i)->data)
+                SegmentAt(oco, i)->offset -= base;
+    }
+    if (oco->count + count <= oco->size)
+        return TRUE;
+
+    if ((long) oco->count + count + BUFSIZE > INT_MAX)
+        return FALSE;
+    obuf = realloc(oco->buf, oco->count + count + BUFSIZE);
+    if (!obuf)
+        return FALSE;
+    oco->size = oco->count + count + BUFSIZE;
+    oco->buf = obuf;
+    return TRUE;
+}
+
+/* Copy count bytes plus padBytes of zeroes to the end of the output. */
+static Bool
+QueueOutputCopy(ConnectionOutputPtr oco, const char *data, int count,
+                int padBytes)
+{
+    OutputSegment *seg = NULL;
+    int total = count + padBytes;
+
+    if (!total)
+        return TRUE;
+    if (oco->count + total > oco->size && !GrowOutputBuffer(oco, total))
+        return FALSE;
+
+    if (oco->numSegs) {
+        seg = SegmentAt(oco, oco->numSegs - 1);
+        if (seg->data || seg->offset + seg->count != oco->count)
+            seg = NULL;
+    }
+    if (seg)
+        seg->count += total;
+    else {
+        if (!(seg = AppendSegment(oco)))
+            return FALSE;
+        seg->data = NULL;
+        seg->offset = oco->count;
+        seg->count = total;
+    }
+
+    if (count)
+        memcpy(oco->buf + oco->count, data, count);
+    if (padBytes)
+        memset(oco->buf + oco->count + count, '\0', padBytes);
+    oco->count += total;
+    oco->pending += total;
+    return TRUE;
+}
+
+/* Drop len written bytes from the front of the output and return how many
+ * of them went beyond the queued segments. */
+static long
+ConsumeOutput(ConnectionOutputPtr oco, long len)
+{
+    while (len && oco->numSegs) {
+        OutputSegment *seg = SegmentAt(oco, 0);
+
+        if (len < seg->count) {
+            seg->offset += len;
+            seg->count -= len;
+            oco->pending -= len;
+            return 0;
+        }
+        len -= seg->count;
+        oco->pending -= seg->count;
+        if (seg->release)
+            seg->release(seg->closure);
+        oco->first = (oco->first + 1) & (oco->maxSegs - 1);
+        oco->numSegs--;
+    }
+    if (!oco->numSegs)
+        oco->count = 0;
+    return len;
+}
+
+static void
+DiscardOutput(ConnectionOutputPtr oco)
+{
+    while (oco->numSegs) {
+        OutputSegment *seg = SegmentAt(oco, 0);
+
+        if (seg->release)
+            seg->release(seg->closure);
+        oco->first = (oco->first + 1) & (oco->maxSegs - 1);
+        oco->numSegs--;
+    }
+    oco->first = 0;
+    oco->count = 0;
+    oco->pending = 0;
+}
+
+static ConnectionOutputPtr
+GetOutputBuffer(OsCommPtr oc)
+{
+    ConnectionOutputPtr oco = oc->output;
+
+    if (!oco) {
+        if (NumFreeOutputs)
+            oco = FreeOutputs[--NumFreeOutputs];
+        else if (!(oco = AllocateOutputBuffer()))
+            return NULL;
+        oc->output = oco;
+    }
+    return oco;
+}
+
+static void
+ReleaseOutputBuffer(ConnectionOutputPtr oco)
+{
+    if (oco->size > BUFWATERMARK || oco->maxSegs > OUTPUT_SEGMENTS ||
+        NumFreeOutputs == MAX_FREE_OUTPUTS) {
+        free(oco->segs);
+        free(oco->buf);
+        free(oco);
+    }
+    else
+        FreeOutputs[NumFreeOutputs++] = oco;
+}
+
+static void
+CallReplyCallback(ClientPtr who, const char *buf, int count, int padBytes)
+{
+    ReplyInfoRec replyinfo;
+
+    replyinfo.client = who;
+    replyinfo.replyData = buf;
+    replyinfo.dataLenBytes = count + padBytes;
+    replyinfo.padBytes = padBytes;
+    if (who->replyBytesRemaining) { /* still sending data of an earlier reply */
+        who->replyBytesRemaining -= count + padBytes;
+        replyinfo.startOfReply = FALSE;
+        replyinfo.bytesRemaining = who->replyBytesRemaining;
+        CallCallbacks((&ReplyCallback), (void *) &replyinfo);
+    }
+    else if (who->clientState == ClientStateRunning && buf[0] == X_Reply) { /* start of new reply */
+        CARD32 replylen;
+        unsigned long bytesleft;
+
+        replylen = ((const xGenericReply *) buf)->length;
+        if (who->swapped)
+            swapl(&replylen);
+        bytesleft = (replylen * 4) + SIZEOF(xReply) - count - padBytes;
+        replyinfo.startOfReply = TRUE;
+        replyinfo.bytesRemaining = who->replyBytesRemaining = bytesleft;
+        CallCallbacks((&ReplyCallback), (void *) &replyinfo);
+    }
+}
+
 /*****************
  * WriteToClient
  *    Copies buf into ClientPtr.buf if it fits (with padding), else
@@ -736,46 +1023,16 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
     }
 #endif
 
-    if (!oco) {
-        if ((oco = FreeOutputs)) {
-            FreeOutputs = oco->next;
-        }
-        else if (!(oco = AllocateOutputBuffer())) {
-            AbortClient(who);
-            MarkClientException(who);
-            return -1;
-        }
-        oc->output = oco;
+    if (!oco && !(oco = GetOutputBuffer(oc))) {
+        AbortClient(who);
+        MarkClientException(who);
+        return -1;
     }
 
     padBytes = padding_for_int32(count);
 
-    if (ReplyCallback) {
-        ReplyInfoRec replyinfo;
-
-        replyinfo.client = who;
-        replyinfo.replyData = buf;
-        replyinfo.dataLenBytes = count + padBytes;
-        replyinfo.padBytes = padBytes;
-        if (who->replyBytesRemaining) { /* still sending data of an earlier reply */
-            who->replyBytesRemaining -= count + padBytes;
-            replyinfo.startOfReply = FALSE;
-            replyinfo.bytesRemaining = who->replyBytesRemaining;
-            CallCallbacks((&ReplyCallback), (void *) &replyinfo);
-        }
-        else if (who->clientState == ClientStateRunning && buf[0] == X_Reply) { /* start of new reply */
-            CARD32 replylen;
-            unsigned long bytesleft;
-
-            replylen = ((const xGenericReply *) buf)->length;
-            if (who->swapped)
-                swapl(&replylen);
-            bytesleft = (replylen * 4) + SIZEOF(xReply) - count - padBytes;
-            replyinfo.startOfReply = TRUE;
-            replyinfo.bytesRemaining = who->replyBytesRemaining = bytesleft;
-            CallCallbacks((&ReplyCallback), (void *) &replyinfo);
-        }
-    }
+    if (ReplyCallback)
+        CallReplyCallback(who, buf, count, padBytes);
 #ifdef DEBUG_COMMUNICATION
     else if (multicount) {
         if (who->replyBytesRemaining) {
@@ -790,7 +1047,7 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         }
     }
 #endif
-    if ((oco->count == 0 && who->local) || oco->count + count + padBytes > oco->size) {
+    if ((oco->pending == 0 && who->local) || oco->count + count + padBytes > oco->size) {
         output_pending_clear(who);
         if (!any_output_pending()) {
             CriticalOutputPending = FALSE;
@@ -800,15 +1057,87 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         return FlushClient(who, oc, buf, count);
     }
 
+    if (!QueueOutputCopy(oco, buf, count, padBytes)) {
+        AbortClient(who);
+        MarkClientException(who);
+        DiscardOutput(oco);
+        return -1;
+    }
     NewOutputPending = TRUE;
     output_pending_mark(who);
-    memmove((char *) oco->buf + oco->count, buf, count);
-    oco->count += count;
-    if (padBytes) {
-        memset(oco->buf + oco->count, '\0', padBytes);
-        oco->count += padBytes;
+    return count;
+}
+
+/*****************
+ * WriteToClientRef
+ *    Like WriteToClient, but queues buf by reference instead of copying
+ *    it.  The caller must not touch buf afterwards; release(closure) is
+ *    called once it has been written, or when the client goes away.
+ *    Queued data is normally flushed with everything else in
+ *    FlushAllOutput, so a reply made of many chunks goes out in a few
+ *    large writev calls.
+ *****************/
+
+int
+WriteToClientRef(ClientPtr who, int count, const void *buf,
+                 OutputReleaseProcPtr release, void *closure)
+{
+    OsCommPtr oc;
+    ConnectionOutputPtr oco;
+    OutputSegment *seg;
+    int padBytes;
+
+    BUG_WARN_MSG(in_input_thread(),
+                 "******** %s called from input thread *********\n",
+                 __FUNCTION__);
+    if (!count || !who || who == serverClient || who->clientGone ||
+        in_input_thread()) {
+        release(closure);
+        return 0;
+    }
+    oc = who->osPrivate;
+    if (!(oco = GetOutputBuffer(oc))) {
+        release(closure);
+        AbortClient(who);
+        MarkClientException(who);
+        return -1;
+    }
+
+    padBytes = padding_for_int32(count);
+
+    if (ReplyCallback)
+        CallReplyCallback(who, buf, count, padBytes);
+
+    if (!(seg = AppendSegment(oco))) {
+        release(closure);
+        goto fail;
+    }
+    seg->data = buf;
+    seg->count = count;
+    seg->release = release;
+    seg->closure = closure;
+    oco->pending += count;
+    if (!QueueOutputCopy(oco, NULL, 0, padBytes))
+        goto fail;
+
+    if (oco->pending > REFWATERMARK) {
+        output_pending_clear(who);
+        if (!any_output_pending()) {
+            CriticalOutputPending = FALSE;
+            NewOutputPending = FALSE;
+        }
+        return FlushClient(who, oc, NULL, 0) < 0 ? -1 : count;
     }
+
+    NewOutputPending = TRUE;
+    output_pending_mark(who);
     return count;
+
+ fail:
+    AbortClient(who);
+    MarkClientException(who);
+    DiscardOutput(oco);
+    return -1;
 }
 
  /********************
@@ -826,19 +1155,20 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
 {
     ConnectionOutputPtr oco = oc->output;
     XtransConnInfo trans_conn = oc->trans_conn;
-    struct iovec iov[3];
+    struct iovec iov[MAX_OUTPUT_IOV];
     static char padBuffer[3];
     const char *extraBuf = __extraBuf;
-    long written;
+    long extraWritten;          /* of extraBuf and its padding */
     long padsize;
     long notWritten;
     long todo;
+    long len;
 
     if (!oco)
 	return 0;
-    written = 0;
+    extraWritten = 0;
     padsize = padding_for_int32(extraCount);
-    notWritten = oco->count + extraCount + padsize;
+    notWritten = oco->pending + extraCount + padsize;
     if (!notWritten)
         return 0;
 
@@ -847,45 +1177,44 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
 
     todo = notWritten;
     while (notWritten) {
-        long before = written;  /* amount of whole thing written */
         long remain = todo;     /* amount to try this time, <= notWritten */
-        int i = 0;
-        long len;
-
-        /* You could be very general here and have "in" and "out" iovecs
-         * and write a loop without using a macro, but what the heck.  This
-         * translates to:
-         *
-         *     how much of this piece is new?
-         *     if more new then we are trying this time, clamp
-         *     if nothing new
-         *         then bump down amount already written, for next piece
-         *         else put new stuff in iovec, will need all of next piece
-         *
+        int i = 0, s;
+
+        /* Gather the queued segments in order, followed by what is left
+         * of the extra data and its padding once all segments fit.
          * Note that todo had better be at least 1 or else we'll end up
          * writing 0 iovecs.
          */
-#define InsertIOV(pointer, length) \
-	len = (length) - before; \
-	if (len > remain) \
-	    len = remain; \
-	if (len <= 0) { \
-	    before = (-len); \
-	} else { \
-	    iov[i].iov_len = len; \
-	    iov[i].iov_base = (pointer) + before;	\
-	    i++; \
-	    remain -= len; \
-	    before = 0; \
-	}
-
-        InsertIOV((char *) oco->buf, oco->count)
-            InsertIOV((char *) extraBuf, extraCount)
-            InsertIOV(padBuffer, padsize)
-
-            errno = 0;
+        for (s = 0; s < oco->numSegs && s < MAX_OUTPUT_IOV - 2 && remain; s++) {
+            OutputSegment *seg = SegmentAt(oco, s);
+
+            len = min(seg->count, remain);
+            iov[i].iov_base = SegmentData(oco, seg);
+            iov[i].iov_len = len;
+            i++;
+            remain -= len;
+        }
+        if (s == oco->numSegs) {
+            long padWritten = max(extraWritten - extraCount, 0);
+
+            if (remain && extraWritten < extraCount) {
+                len = min(extraCount - extraWritten, remain);
+                iov[i].iov_base = (char *) extraBuf + extraWritten;
+                iov[i].iov_len = len;
+                i++;
+                remain -= len;
+            }
+            if (remain && padWritten < padsize) {
+                len = min(padsize - padWritten, remain);
+                iov[i].iov_base = padBuffer + padWritten;
+                iov[i].iov_len = len;
+                i++;
+            }
+        }
+
+        errno = 0;
         if (trans_conn && (len = _XSERVTransWritev(trans_conn, iov, i)) >= 0) {
-            written += len;
+            extraWritten += ConsumeOutput(oco, len);
             notWritten -= len;
             todo = notWritten;
         }
@@ -894,47 +1223,22 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
                  || ((errno == EMSGSIZE) && (todo == 1))
 #endif
             ) {
+            long extraLeft = max(extraCount - extraWritten, 0);
+            long padLeft = padsize - max(extraWritten - extraCount, 0);
+
             /* If we've arrived here, then the client is stuffed to the gills
                and not ready to accept more.  Make a note of it and buffer
-               the rest. */
+               the rest.  Queued segments stay where they are, only the
+               extra data has to be copied. */
             output_pending_mark(who);
 
-            if (written < oco->count) {
-                if (written > 0) {
-                    oco->count -= written;
-                    memmove((char *) oco->buf,
-                            (char *) oco->buf + written, oco->count);
-                    written = 0;
-                }
+            if (!QueueOutputCopy(oco, extraLeft ? extraBuf + extraWritten : NULL,
+                                 extraLeft, padLeft)) {
+                AbortClient(who);
+                MarkClientException(who);
+                DiscardOutput(oco);
+                return -1;
             }
-            else {
-                written -= oco->count;
-                oco->count = 0;
-            }
-
-            if (notWritten > oco->size) {
-                unsigned char *obuf = NULL;
-
-                if (notWritten + BUFSIZE <= INT_MAX) {
-                    obuf = realloc(oco->buf, notWritten + BUFSIZE);
-                }
-                if (!obuf) {
-                    AbortClient(who);
-                    MarkClientException(who);
-                    oco->count = 0;
-                    return -1;
-                }
-                oco->size = notWritten + BUFSIZE;
-                oco->buf = obuf;
-            }
-
-            /* If the amount written extended into the padBuffer, then the
-               difference "extraCount - written" may be less than 0 */
-            if ((len = extraCount - written) > 0)
-                memmove((char *) oco->buf + oco->count,
-                        extraBuf + written, len);
-
-            oco->count = notWritten;    /* this will include the pad */
             ospoll_listen(server_poll, oc->fd, X_NOTIFY_WRITE);
 
             /* return only the amount explicitly requested */
@@ -948,23 +1252,14 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
         else {
             AbortClient(who);
             MarkClientException(who);
-            oco->count = 0;
+            DiscardOutput(oco);
             return -1;
         }
     }
 
     /* everything was flushed out */
-    oco->count = 0;
     output_pending_clear(who);
-
-    if (oco->size > BUFWATERMARK) {
-        free(oco->buf);
-        free(oco);
-    }
-    else {
-        oco->next = FreeOutputs;
-        FreeOutputs = oco;
-    }
+    ReleaseOutputBuffer(oco);
     oc->output = (ConnectionOutputPtr) NULL;
     return extraCount;          /* return only the amount explicitly requested */
 }
@@ -987,6 +1282,7 @@ AllocateInputBuffer(void)
     oci->bufcnt = 0;
     oci->lenLastReq = 0;
     oci->ignoreBytes = 0;
+    oci->runLeft = 0;
     return oci;
 }
 
@@ -1003,8 +1299,18 @@ AllocateOutputBuffer(void)
         free(oco);
         return NULL;
     }
+    oco->segs = xallocarray(OUTPUT_SEGMENTS, sizeof(OutputSegment));
+    if (!oco->segs) {
+        free(oco->buf);
+        free(oco);
+        return NULL;
+    }
     oco->size = BUFSIZE;
     oco->count = 0;
+    oco->first = 0;
+    oco->numSegs = 0;
+    oco->maxSegs = OUTPUT_SEGMENTS;
+    oco->pending = 0;
     return oco;
 }
 
@@ -1028,18 +1334,12 @@ FreeOsBuffers(OsCommPtr oc)
             oci->bufcnt = 0;
             oci->lenLastReq = 0;
             oci->ignoreBytes = 0;
+            oci->runLeft = 0;
         }
     }
     if ((oco = oc->output)) {
-        if (FreeOutputs) {
-            free(oco->buf);
-            free(oco);
-        }
-        else {
-            FreeOutputs = oco;
-            oco->next = (ConnectionOutputPtr) NULL;
-            oco->count = 0;
-        }
+        DiscardOutput(oco);
+        ReleaseOutputBuffer(oco);
     }
 }
 
@@ -1054,8 +1354,9 @@ ResetOsBuffers(void)
         free(oci->buffer);
         free(oci);
     }
-    while ((oco = FreeOutputs)) {
-        FreeOutputs = oco->next;
+    while (NumFreeOutputs) {
+        oco = FreeOutputs[--NumFreeOutputs];
+        free(oco->segs);
         free(oco->buf);
         free(oco);
     }
@@ -93,6 +93,9 @@ __stdcall unsigned long GetTickCount(void);
 #ifndef WIN32
 #include <sys/wait.h>
 #endif
+#ifdef HAVE_POSIX_SPAWN
+#include <spawn.h>
+#endif
 #if !defined(WIN32)
 #include <sys/resource.h>
 #endif
@@ -309,6 +312,7 @@ UseMsg(void)
     ErrorF
         ("-deferglyphs [none|all|16] defer loading of [no|all|16-bit] glyphs\n");
     ErrorF("-f #                   bell base (0-100)\n");
+    ErrorF("-dispatchthreads n     draw to private pixmaps on n threads\n");
     ErrorF("-fakescreenfps #       fake screen default fps (1-600)\n");
     ErrorF("-fp string             default font path\n");
     ErrorF("-help                  prints message with these options\n");
@@ -325,12 +329,16 @@ UseMsg(void)
     ErrorF("-ls int                limit stack space to N Kb\n");
 #endif
     LockServerUseMsg();
+    ErrorF("-glyphcache n          keep up to n KB of glyph pictures realized\n");
     ErrorF("-maxclients n          set maximum number of clients (power of two)\n");
     ErrorF("-nolisten string       don't listen on protocol\n");
     ErrorF("-listen string         listen on protocol\n");
     ErrorF("-noreset               don't reset after last client exists\n");
     ErrorF("-background [none]     create root window with no background\n");
     ErrorF("-reset                 reset after last client exists\n");
+#ifdef MITSHM
+    ErrorF("-shmprefault           fault in large server-created SHM segments up front\n");
+#endif
     ErrorF("-pn                    accept failure to listen on all ports\n");
     ErrorF("-nopn                  reject failure to listen on all ports\n");
     ErrorF("-r                     turns off auto-repeat\n");
@@ -732,6 +740,31 @@ ProcessCommandLine(int argc, char *argv[])
                     UseMsg();
             }
         }
+        else if (strcmp(argv[i], "-dispatchthreads") == 0) {
+            if (++i < argc) {
+                DispatchThreads = atoi(argv[i]);
+                if (DispatchThreads < 0)
+                    UseMsg();
+            }
+            else
+                UseMsg();
+        }
+        else if (strcmp(argv[i], "-glyphcache") == 0) {
+            if (++i < argc) {
+                long kbytes = atol(argv[i]);
+
+                if (kbytes > 0L)
+                    GlyphCacheBudget = kbytes * 1024UL;
+                else
+                    UseMsg();
+            }
+            else
+                UseMsg();
+        }
+#ifdef MITSHM
+        else if (strcmp(argv[i], "-shmprefault") == 0)
+            ShmPrefaultSegments = TRUE;
+#endif
         else if (strcmp(argv[i], "-maxbigreqsize") == 0) {
             if (++i < argc) {
                 long reqSizeArg = atol(argv[i]);
@@ -1153,6 +1186,50 @@ static struct pid {
     int pid;
 } *pidlist;
 
+#ifdef HAVE_POSIX_SPAWN
+extern char **environ;
+
+/*
+ * Run command through the shell with child moved to target and parent
+ * closed, like the fork() path in Popen, but without duplicating the
+ * server's address space first.  POSIX_SPAWN_RESETIDS drops the
+ * effective ids to the real ones and the exec makes the saved ids
+ * follow, which is what the setgid()/setuid() calls there achieve.
+ */
+static int
+PopenSpawn(const char *command, int child, int target, int parent)
+{
+    char *argv[] = { "sh", "-c", (char *) command, NULL };
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    pid_t pid;
+    int ret;
+
+    if (posix_spawn_file_actions_init(&actions) != 0)
+        return -1;
+    if (posix_spawnattr_init(&attr) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return -1;
+    }
+
+    ret = posix_spawnattr_setflags(&attr, POSIX_SPAWN_RESETIDS);
+    if (ret == 0 && child != target) {
+        ret = posix_spawn_file_actions_adddup2(&actions, child, target);
+        if (ret == 0)
+            ret = posix_spawn_file_actions_addclose(&actions, child);
+    }
+    if (ret == 0)
+        ret = posix_spawn_file_actions_addclose(&actions, parent);
+    if (ret == 0)
+        ret = posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    return ret == 0 ? pid : -1;
+}
+#endif
+
 void *
 Popen(const char *command, const char *type)
 {
@@ -1185,7 +1262,15 @@ Popen(const char *command, const char *type)
     }
 #endif
 
-    switch (pid = fork()) {
+#ifdef HAVE_POSIX_SPAWN
+    if (*type == 'r')
+        pid = PopenSpawn(command, pdes[1], 1, pdes[0]);
+    else
+        pid = PopenSpawn(command, pdes[0], 0, pdes[1]);
+#else
+    pid = fork();
+#endif
+    switch (pid) {
     case -1:                   /* error */
         close(pdes[0]);
         close(pdes[1]);
@@ -1195,6 +1280,7 @@ Popen(const char *command, const char *type)
             perror("signal");
 #endif
         return NULL;
+#ifndef HAVE_POSIX_SPAWN
     case 0:                    /* child */
         if (setgid(getgid()) == -1)
             _exit(127);
@@ -1218,6 +1304,7 @@ Popen(const char *command, const char *type)
         }
         execl("/bin/sh", "sh", "-c", command, (char *) NULL);
         _exit(127);
+#endif
     }
 
     /* Avoid EINTR during stdio calls */
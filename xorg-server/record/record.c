@@ -50,6 +50,10 @@ and Jim Haggerty of Metheus.
 #include <stdio.h>
 #include <assert.h>
 
+#ifdef MITSHM
+#include "shmring.h"
+#endif
+
 #ifdef XINERAMA
 #include "globals.h"
 #include "panoramiX.h"
@@ -79,6 +83,9 @@ typedef struct {
     int numBufBytes;            /* number of bytes in replyBuffer */
     char replyBuffer[REPLY_BUF_SIZE];   /* buffered recorded protocol */
     int inFlush;                /*  are we inside RecordFlushReplyBuffer */
+#ifdef MITSHM
+    RecordShmRingRec shm;       /* ring reported into, if shm.shmdesc */
+#endif
 } RecordContextRec, *RecordContextPtr;
 
 /*  RecordMinorOpRec - to hold minor opcode selections for extension requests
@@ -140,6 +147,12 @@ static int numEnabledRCAPs;
 static int RecordDeleteContext(void     *value,
                                XID      id);
 
+#ifdef MITSHM
+#define RecordUsesShm(_pContext) ((_pContext)->shm.shmdesc != NULL)
+#else
+#define RecordUsesShm(_pContext) FALSE
+#endif
+
 /***************************************************************************/
 
 /* client private stuff */
@@ -214,6 +227,31 @@ RecordFindContextOnAllContexts(RecordContextPtr pContext)
 
 /***************************************************************************/
 
+/* RecordWriteData
+ *
+ * Arguments:
+ *	pContext is an enabled context.
+ *	data is a pointer to recorded protocol, and len is its length in
+ *	  bytes.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	The data is sent to the recording client, or appended to the
+ *	context's shared memory ring if it reports into one.
+ */
+static void
+RecordWriteData(RecordContextPtr pContext, void *data, int len)
+{
+#ifdef MITSHM
+    if (RecordUsesShm(pContext)) {
+        RecordShmRingWrite(&pContext->shm, data, len);
+        return;
+    }
+#endif
+    WriteToClient(pContext->pRecordingClient, len, data);
+}                               /* RecordWriteData */
+
 /* RecordFlushReplyBuffer
  *
  * Arguments:
@@ -228,7 +266,7 @@ RecordFindContextOnAllContexts(RecordContextPtr pContext)
  *	to the recording client, and the number of buffered bytes is set to
  *	zero.  If len1 is not zero, data1/len1 are then written to the
  *	recording client, and similarly for data2/len2 (written after
- *	data1/len1).
+ *	data1/len1).  See RecordWriteData.
  */
 static void
 RecordFlushReplyBuffer(RecordContextPtr pContext,
@@ -239,13 +277,13 @@ RecordFlushReplyBuffer(RecordContextPtr pContext,
         return;
     ++pContext->inFlush;
     if (pContext->numBufBytes)
-        WriteToClient(pContext->pRecordingClient, pContext->numBufBytes,
-                      pContext->replyBuffer);
+        RecordWriteData(pContext, pContext->replyBuffer,
+                        pContext->numBufBytes);
     pContext->numBufBytes = 0;
     if (len1)
-        WriteToClient(pContext->pRecordingClient, len1, data1);
+        RecordWriteData(pContext, data1, len1);
     if (len2)
-        WriteToClient(pContext->pRecordingClient, len2, data2);
+        RecordWriteData(pContext, data2, len2);
     --pContext->inFlush;
 }                               /* RecordFlushReplyBuffer */
 
@@ -1863,6 +1901,9 @@ ProcRecordCreateContext(ClientPtr client)
     pContext->pBufClient = NULL;
     pContext->continuedReply = 0;
     pContext->inFlush = 0;
+#ifdef MITSHM
+    pContext->shm.shmdesc = NULL;
+#endif
 
     err = RecordRegisterClients(pContext, client,
                                 (xRecordRegisterClientsReq *) stuff);
@@ -2271,20 +2312,28 @@ ProcRecordGetContext(ClientPtr client)
     return err;
 }                               /* ProcRecordGetContext */
 
+/* RecordEnableContext
+ *
+ * Arguments:
+ *	pContext is the context to enable.
+ *	client is the client that will receive the recorded protocol.
+ *
+ * Returns: Success, or an error if recording hooks could not be
+ *	installed.
+ *
+ * Side Effects:
+ *	Recording hooks for the context are installed, the context is
+ *	moved to the front part of the ppAllContexts array, and StartOfData
+ *	is sent.  Unless the context reports into a shared memory ring,
+ *	request processing for client is suspended until the context is
+ *	disabled.
+ */
 static int
-ProcRecordEnableContext(ClientPtr client)
+RecordEnableContext(RecordContextPtr pContext, ClientPtr client)
 {
-    RecordContextPtr pContext;
-
-    REQUEST(xRecordEnableContextReq);
     int i;
     RecordClientsAndProtocolPtr pRCAP;
 
-    REQUEST_SIZE_MATCH(xRecordGetContextReq);
-    VERIFY_CONTEXT(pContext, stuff->context, client);
-    if (pContext->pRecordingClient)
-        return BadMatch;        /* already enabled */
-
     /* install record hooks for each RCAP */
 
     for (pRCAP = pContext->pListOfRCAP; pRCAP; pRCAP = pRCAP->pNextRCAP) {
@@ -2303,9 +2352,11 @@ ProcRecordEnableContext(ClientPtr client)
     }
 
     /* Disallow further request processing on this connection until
-     * the context is disabled.
+     * the context is disabled.  Recording into shared memory sends
+     * nothing on it, so it stays usable.
      */
-    IgnoreClient(client);
+    if (!RecordUsesShm(pContext))
+        IgnoreClient(client);
     pContext->pRecordingClient = client;
 
     /* Don't allow the data connection to record itself; unregister it. */
@@ -2329,8 +2380,72 @@ ProcRecordEnableContext(ClientPtr client)
     RecordAProtocolElement(pContext, NULL, XRecordStartOfData, NULL, 0, 0, 0);
     RecordFlushReplyBuffer(pContext, NULL, 0, NULL, 0);
     return Success;
+}                               /* RecordEnableContext */
+
+static int
+ProcRecordEnableContext(ClientPtr client)
+{
+    RecordContextPtr pContext;
+
+    REQUEST(xRecordEnableContextReq);
+
+    REQUEST_SIZE_MATCH(xRecordGetContextReq);
+    VERIFY_CONTEXT(pContext, stuff->context, client);
+    if (pContext->pRecordingClient)
+        return BadMatch;        /* already enabled */
+
+    return RecordEnableContext(pContext, client);
 }                               /* ProcRecordEnableContext */
 
+#ifdef MITSHM
+
+static int
+ProcRecordEnableContextShm(ClientPtr client)
+{
+    RecordContextPtr pContext;
+    ShmDescPtr shmdesc;
+    int rc;
+
+    REQUEST(xRecordEnableContextShmReq);
+
+    REQUEST_SIZE_MATCH(xRecordEnableContextShmReq);
+    VERIFY_CONTEXT(pContext, stuff->context, client);
+    if (pContext->pRecordingClient)
+        return BadMatch;        /* already enabled */
+    rc = dixLookupResourceByType((void **) &shmdesc, stuff->shmseg,
+                                 ShmSegType, client, DixWriteAccess);
+    if (rc != Success)
+        return rc;
+    if ((stuff->offset & 3) || stuff->offset > shmdesc->size) {
+        client->errorValue = stuff->offset;
+        return BadValue;
+    }
+    if (!RecordShmRingValidSize(stuff->size)) {
+        client->errorValue = stuff->size;
+        return BadValue;
+    }
+    if (!shmdesc->writable || stuff->size > shmdesc->size - stuff->offset)
+        return BadAccess;
+
+    RecordShmRingAttach(&pContext->shm, shmdesc, stuff->offset, stuff->size,
+                        client->swapped);
+
+    rc = RecordEnableContext(pContext, client);
+    if (rc != Success)
+        RecordShmRingDetach(&pContext->shm);
+    return rc;
+}                               /* ProcRecordEnableContextShm */
+
+#else                           /* !MITSHM */
+
+static int
+ProcRecordEnableContextShm(ClientPtr client)
+{
+    return BadImplementation;
+}                               /* ProcRecordEnableContextShm */
+
+#endif                          /* MITSHM */
+
 /* RecordDisableContext
  *
  * Arguments:
@@ -2360,13 +2475,17 @@ RecordDisableContext(RecordContextPtr pContext)
         RecordFlushReplyBuffer(pContext, NULL, 0, NULL, 0);
     }
     /* Re-enable request processing on this connection. */
-    AttendClient(pContext->pRecordingClient);
+    if (!RecordUsesShm(pContext))
+        AttendClient(pContext->pRecordingClient);
 
     for (pRCAP = pContext->pListOfRCAP; pRCAP; pRCAP = pRCAP->pNextRCAP) {
         RecordUninstallHooks(pRCAP, 0);
     }
 
     pContext->pRecordingClient = NULL;
+#ifdef MITSHM
+    RecordShmRingDetach(&pContext->shm);
+#endif
 
     /* move the newly disabled context to the rear part of ppAllContexts,
      * where all the disabled contexts are
@@ -2478,6 +2597,8 @@ ProcRecordDispatch(ClientPtr client)
         return ProcRecordDisableContext(client);
     case X_RecordFreeContext:
         return ProcRecordFreeContext(client);
+    case X_RecordEnableContextShm:
+        return ProcRecordEnableContextShm(client);
     default:
         return BadRequest;
     }
@@ -2588,6 +2709,18 @@ SProcRecordFreeContext(ClientPtr client)
     return ProcRecordFreeContext(client);
 }                               /* SProcRecordFreeContext */
 
+static int _X_COLD
+SProcRecordEnableContextShm(ClientPtr client)
+{
+    REQUEST(xRecordEnableContextShmReq);
+    REQUEST_SIZE_MATCH(xRecordEnableContextShmReq);
+    swapl(&stuff->context);
+    swapl(&stuff->shmseg);
+    swapl(&stuff->offset);
+    swapl(&stuff->size);
+    return ProcRecordEnableContextShm(client);
+}                               /* SProcRecordEnableContextShm */
+
 static int _X_COLD
 SProcRecordDispatch(ClientPtr client)
 {
@@ -2610,6 +2743,8 @@ SProcRecordDispatch(ClientPtr client)
         return SProcRecordDisableContext(client);
     case X_RecordFreeContext:
         return SProcRecordFreeContext(client);
+    case X_RecordEnableContextShm:
+        return SProcRecordEnableContextShm(client);
     default:
         return BadRequest;
     }
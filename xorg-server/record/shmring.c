@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <dix-config.h>
+
+#ifdef MITSHM
+
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+
+#include "misc.h"
+#include "shmring.h"
+
+#if defined(__GNUC__)
+#define LoadAcquire(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define StoreRelease(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+/* MSVC gives volatile accesses acquire and release semantics */
+#define LoadAcquire(p)          (*(volatile CARD32 *) (p))
+#define StoreRelease(p, v)      (*(volatile CARD32 *) (p) = (v))
+#endif
+
+/*
+ * Head and tail count bytes modulo 2^32, so a count maps to the same
+ * data position before and after it wraps only if the data size divides
+ * 2^32.
+ */
+Bool
+RecordShmRingValidSize(CARD32 size)
+{
+    CARD32 data = size - sizeof(xRecordShmRing);
+
+    return size >= 2 * sizeof(xRecordShmRing) && !(data & (data - 1));
+}
+
+void
+RecordShmRingAttach(RecordShmRingPtr pRing, ShmDescPtr shmdesc,
+                    CARD32 offset, CARD32 size, Bool swapped)
+{
+    xRecordShmRing *ring = (xRecordShmRing *) (shmdesc->addr + offset);
+
+    memset(ring, 0, sizeof(*ring));
+    shmdesc->refcnt++;
+    pRing->shmdesc = shmdesc;
+    pRing->ring = ring;
+    pRing->data = (char *) (ring + 1);
+    pRing->size = size - sizeof(*ring);
+    pRing->head = 0;
+    pRing->replyLeft = 0;
+    pRing->dropping = FALSE;
+    pRing->swapped = swapped;
+    pRing->headerBytes = 0;
+}
+
+void
+RecordShmRingDetach(RecordShmRingPtr pRing)
+{
+    if (!pRing->shmdesc)
+        return;
+    ShmReleaseSegment(pRing->shmdesc);
+    pRing->shmdesc = NULL;
+    pRing->ring = NULL;
+    pRing->data = NULL;
+}
+
+/* Copy n bytes to the ring at head, wrapping around its end */
+static void
+RecordShmRingCopy(RecordShmRingPtr pRing, const char *data, CARD32 n)
+{
+    CARD32 done = 0;
+
+    while (done < n) {
+        CARD32 pos = (pRing->head + done) & (pRing->size - 1);
+        CARD32 chunk = min(n - done, pRing->size - pos);
+
+        memcpy(pRing->data + pos, data + done, chunk);
+        done += chunk;
+    }
+    pRing->head += n;
+}
+
+/*
+ * Space for a whole reply is claimed once its header is complete; if the
+ * recording client has not consumed enough, the reply is dropped and
+ * counted as lost instead.  Headers normally arrive in one piece, but
+ * one that does not is gathered in pRing->header first.  The head is
+ * only advanced past complete replies.
+ */
+void
+RecordShmRingWrite(RecordShmRingPtr pRing, const char *data, int len)
+{
+    xRecordShmRing *ring = pRing->ring;
+
+    while (len > 0) {
+        CARD32 n;
+
+        if (!pRing->replyLeft) {
+            CARD32 length, used;
+            uint64_t total;
+
+            n = min(sizeof(pRing->header) - pRing->headerBytes, (CARD32) len);
+            memcpy((char *) &pRing->header + pRing->headerBytes, data, n);
+            pRing->headerBytes += n;
+            data += n;
+            len -= n;
+            if (pRing->headerBytes < sizeof(pRing->header))
+                return;
+            pRing->headerBytes = 0;
+
+            length = pRing->header.length;
+            if (pRing->swapped)
+                swapl(&length);
+            total = sizeof(pRing->header) + (uint64_t) length * 4;
+
+            used = pRing->head - LoadAcquire(&ring->tail);
+            if (used > pRing->size)     /* bogus tail, treat the ring as full */
+                used = pRing->size;
+            pRing->dropping = total > pRing->size - used;
+            if (pRing->dropping) {
+                ring->lost++;
+                ring->lostBytes += total;
+            }
+            else
+                RecordShmRingCopy(pRing, (char *) &pRing->header,
+                                  sizeof(pRing->header));
+            pRing->replyLeft = total - sizeof(pRing->header);
+        }
+
+        n = min(pRing->replyLeft, (CARD32) len);
+        if (!pRing->dropping)
+            RecordShmRingCopy(pRing, data, n);
+        pRing->replyLeft -= n;
+        data += n;
+        len -= n;
+
+        if (!pRing->replyLeft && !pRing->dropping) {
+            ring->sequence++;
+            StoreRelease(&ring->head, pRing->head);
+        }
+    }
+}
+
+#endif /* MITSHM */
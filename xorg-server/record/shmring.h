@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The shared memory ring RECORD contexts enabled with EnableContextShm
+ * report into; see xRecordEnableContextShmReq for its layout.
+ */
+
+#ifndef _RECORD_SHMRING_H_
+#define _RECORD_SHMRING_H_
+
+#ifdef MITSHM
+
+#include <X11/extensions/recordproto.h>
+#include "resource.h"
+#include "shmint.h"
+
+typedef struct {
+    ShmDescPtr shmdesc;         /* segment holding the ring, or NULL */
+    xRecordShmRing *ring;       /* ring header in the segment */
+    char *data;                 /* ring data, follows the header */
+    CARD32 size;                /* bytes of ring data, a power of two */
+    CARD32 head;                /* head including the reply being written */
+    uint64_t replyLeft;         /* bytes of that reply still to come */
+    Bool dropping;              /* is that reply being dropped? */
+    Bool swapped;               /* are reply lengths byte swapped? */
+    int headerBytes;            /* bytes of the next reply header so far */
+    xRecordEnableContextReply header;
+} RecordShmRingRec, *RecordShmRingPtr;
+
+/* Can a ring of size bytes, header included, be reported into? */
+Bool RecordShmRingValidSize(CARD32 size);
+
+/* Start reporting into size bytes of shmdesc at offset, which the caller
+ * has checked, size with RecordShmRingValidSize; takes a reference on
+ * the segment */
+void RecordShmRingAttach(RecordShmRingPtr pRing, ShmDescPtr shmdesc,
+                         CARD32 offset, CARD32 size, Bool swapped);
+
+/* Drop the reference on the segment, if attached */
+void RecordShmRingDetach(RecordShmRingPtr pRing);
+
+/* Append len bytes of the stream of replies EnableContext would send */
+void RecordShmRingWrite(RecordShmRingPtr pRing, const char *data, int len);
+
+#endif /* MITSHM */
+
+#endif /* _RECORD_SHMRING_H_ */
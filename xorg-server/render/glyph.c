@@ -40,6 +40,7 @@
 #include "dixstruct.h"
 #include "gcstruct.h"
 #include "servermd.h"
+#include "pixmapstr.h"
 #include "picturestr.h"
 #include "glyphstr_priv.h"
 #include "mipict.h"
@@ -81,6 +82,18 @@ static GlyphHashSetRec glyphHashSets[] = {
 
 static GlyphHashRec globalGlyphs[GlyphFormatNum];
 
+/*
+ * Glyphs live as long as any glyph set references them, and fonts with
+ * large repertoires keep thousands around that are hardly ever drawn.
+ * Glyph pictures are kept on an LRU list; once they hold more than
+ * GlyphCacheBudget bytes, the least recently drawn glyphs are evicted down
+ * to their packed bits and realized again the next time they are drawn.
+ */
+unsigned long GlyphCacheBudget = 64 * 1024 * 1024;
+
+static struct xorg_list glyphCacheLRU = { &glyphCacheLRU, &glyphCacheLRU };
+static GlyphCacheStatsRec glyphCacheStats;
+
 void
 GlyphUninit(ScreenPtr pScreen)
 {
@@ -95,6 +108,8 @@ GlyphUninit(ScreenPtr pScreen)
         for (i = 0; i < globalGlyphs[fdepth].hashSet->size; i++) {
             glyph = globalGlyphs[fdepth].table[i].glyph;
             if (glyph && glyph != DeletedGlyph) {
+                if (GlyphCache(glyph)->packed)
+                    continue;
                 if (GetGlyphPicture(glyph, pScreen)) {
                     FreePicture((void *) GetGlyphPicture(glyph, pScreen), 0);
                     SetGlyphPicture(glyph, pScreen, NULL);
@@ -244,6 +259,23 @@ FreeGlyphPicture(GlyphPtr glyph)
     }
 }
 
+static void
+GlyphCacheRemove(GlyphPtr glyph)
+{
+    GlyphCachePtr cache = GlyphCache(glyph);
+
+    if (!xorg_list_is_empty(&cache->lru)) {
+        xorg_list_del(&cache->lru);
+        glyphCacheStats.bytes -= cache->bytes;
+        glyphCacheStats.glyphs--;
+    }
+    if (cache->packed) {
+        free(cache->packed);
+        cache->packed = NULL;
+        glyphCacheStats.evicted--;
+    }
+}
+
 void
 FreeGlyph(GlyphPtr glyph, int format)
 {
@@ -273,11 +305,21 @@ FreeGlyph(GlyphPtr glyph, int format)
             globalGlyphs[format].tableEntries--;
         }
 
-        FreeGlyphPicture(glyph);
-        dixFreeObjectWithPrivates(glyph, PRIVATE_GLYPH);
+        DiscardGlyph(glyph);
     }
 }
 
+/* Frees a glyph that is not, or no longer, in the global hash */
+void
+DiscardGlyph(GlyphPtr glyph)
+{
+    /* evicted glyphs are already unrealized */
+    if (!GlyphCache(glyph)->packed)
+        FreeGlyphPicture(glyph);
+    GlyphCacheRemove(glyph);
+    dixFreeObjectWithPrivates(glyph, PRIVATE_GLYPH);
+}
+
 void
 AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
 {
@@ -344,10 +386,12 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
     PictureScreenPtr ps;
     int size;
     GlyphPtr glyph;
+    GlyphCachePtr cache;
     int i;
     int head_size;
 
-    head_size = sizeof(GlyphRec) + screenInfo.numScreens * sizeof(PicturePtr);
+    head_size = sizeof(GlyphRec) + screenInfo.numScreens * sizeof(PicturePtr) +
+        sizeof(GlyphCacheRec);
     size = (head_size + dixPrivatesSize(PRIVATE_GLYPH));
     glyph = (GlyphPtr) malloc(size);
     if (!glyph)
@@ -357,6 +401,13 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
     glyph->info = *gi;
     dixInitPrivates(glyph, (char *) glyph + head_size, PRIVATE_GLYPH);
 
+    cache = GlyphCache(glyph);
+    xorg_list_init(&cache->lru);
+    cache->glyph = glyph;
+    cache->bytes = 0;
+    cache->packed = NULL;
+    cache->format = NULL;
+
     for (i = 0; i < screenInfo.numScreens; i++) {
         ScreenPtr pScreen = screenInfo.screens[i];
         SetGlyphPicture(glyph, pScreen, NULL);
@@ -381,6 +432,301 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
     return 0;
 }
 
+#define NeedsComponent(f) (PICT_FORMAT_A(f) != 0 && PICT_FORMAT_RGB(f) != 0)
+
+/*
+ * Create the per-screen pictures of a realized glyph from its bits, laid
+ * out as in an AddGlyphs request, and put the glyph on the cache list.
+ */
+int
+CreateGlyphPictures(GlyphPtr glyph, PictFormatPtr format, CARD8 *bits)
+{
+    GlyphCachePtr cache = GlyphCache(glyph);
+    int width = glyph->info.width;
+    int height = glyph->info.height;
+    int depth = format->depth;
+    CARD32 component_alpha = NeedsComponent(format->format);
+    PicturePtr pSrc, pDst;
+    PixmapPtr pSrcPix, pDstPix;
+    int error, screen;
+
+    /* Skip work if it's invisibly small anyway */
+    if (!width || !height)
+        return Success;
+
+    for (screen = 0; screen < screenInfo.numScreens; screen++) {
+        ScreenPtr pScreen = screenInfo.screens[screen];
+
+        pSrcPix = GetScratchPixmapHeader(pScreen, width, height,
+                                         depth, depth, -1, bits);
+        if (!pSrcPix)
+            return BadAlloc;
+
+        pSrc = CreatePicture(0, &pSrcPix->drawable, format, 0, NULL,
+                             serverClient, &error);
+        if (!pSrc) {
+            FreeScratchPixmapHeader(pSrcPix);
+            return BadAlloc;
+        }
+
+        pDstPix = (pScreen->CreatePixmap) (pScreen, width, height, depth,
+                                           CREATE_PIXMAP_USAGE_GLYPH_PICTURE);
+        if (!pDstPix) {
+            FreePicture((void *) pSrc, 0);
+            FreeScratchPixmapHeader(pSrcPix);
+            return BadAlloc;
+        }
+
+        pDst = CreatePicture(0, &pDstPix->drawable, format,
+                             CPComponentAlpha, &component_alpha,
+                             serverClient, &error);
+        SetGlyphPicture(glyph, pScreen, pDst);
+
+        /* The picture takes a reference to the pixmap, so we
+           drop ours. */
+        dixDestroyPixmap(pDstPix, 0);
+
+        if (pDst)
+            CompositePicture(PictOpSrc, pSrc, None, pDst,
+                             0, 0, 0, 0, 0, 0, width, height);
+
+        FreePicture((void *) pSrc, 0);
+        FreeScratchPixmapHeader(pSrcPix);
+
+        if (!pDst)
+            return BadAlloc;
+    }
+
+    cache->format = format;
+    cache->bytes = screenInfo.numScreens *
+        (PixmapBytePad(width, depth) * height +
+         sizeof(PixmapRec) + sizeof(PictureRec));
+    xorg_list_add(&cache->lru, &glyphCacheLRU);
+    glyphCacheStats.bytes += cache->bytes;
+    glyphCacheStats.glyphs++;
+    return Success;
+}
+
+/*
+ * Glyph bits are mostly runs of transparent pixels, so evicted glyphs keep
+ * them PackBits encoded: a header byte n < 128 is followed by n + 1
+ * literal bytes, n > 128 by one byte repeated 257 - n times.
+ */
+int
+GlyphPackBits(const CARD8 *src, int size, CARD8 *dst)
+{
+    CARD8 *out = dst;
+    int i = 0, n;
+
+    while (i < size) {
+        for (n = 1; i + n < size && n < 128 && src[i + n] == src[i]; n++)
+            ;
+        if (n >= 3) {
+            *out++ = 257 - n;
+            *out++ = src[i];
+            i += n;
+            continue;
+        }
+        for (n = 0; i + n < size && n < 128; n++)
+            if (i + n + 2 < size && src[i + n] == src[i + n + 1] &&
+                src[i + n] == src[i + n + 2])
+                break;
+        *out++ = n - 1;
+        memcpy(out, src + i, n);
+        out += n;
+        i += n;
+    }
+    return out - dst;
+}
+
+void
+GlyphUnpackBits(const CARD8 *src, CARD8 *dst, int size)
+{
+    CARD8 *end = dst + size;
+    int n;
+
+    while (dst < end) {
+        n = *src++;
+        if (n < 128) {
+            n = min(n + 1, end - dst);
+            memcpy(dst, src, n);
+            src += n;
+        }
+        else if (n > 128) {
+            n = min(257 - n, end - dst);
+            memset(dst, *src++, n);
+        }
+        else
+            continue;
+        dst += n;
+    }
+}
+
+static int
+GlyphBitsSize(GlyphPtr glyph, PictFormatPtr format)
+{
+    return PixmapBytePad(glyph->info.width, format->depth) *
+        glyph->info.height;
+}
+
+/*
+ * Evict a glyph whose bits, laid out as in an AddGlyphs request, are
+ * given: pack them and free the pictures.
+ */
+Bool
+GlyphCachePack(GlyphPtr glyph, const CARD8 *bits)
+{
+    GlyphCachePtr cache = GlyphCache(glyph);
+    CARD8 *packed;
+    int i, size, len;
+
+    if (cache->packed || xorg_list_is_empty(&cache->lru))
+        return FALSE;
+
+    /* worst case packing */
+    size = GlyphBitsSize(glyph, cache->format);
+    packed = malloc(size + size / 128 + 1);
+    if (!packed)
+        return FALSE;
+    len = GlyphPackBits(bits, size, packed);
+    cache->packed = realloc(packed, max(len, 1));
+    if (!cache->packed)
+        cache->packed = packed;
+
+    FreeGlyphPicture(glyph);
+    for (i = 0; i < screenInfo.numScreens; i++)
+        SetGlyphPicture(glyph, screenInfo.screens[i], NULL);
+
+    xorg_list_del(&cache->lru);
+    glyphCacheStats.bytes -= cache->bytes;
+    glyphCacheStats.glyphs--;
+    glyphCacheStats.evicted++;
+    glyphCacheStats.evictions++;
+    return TRUE;
+}
+
+/* Read back the bits of a glyph from its pictures and evict it */
+static Bool
+GlyphCacheEvict(GlyphPtr glyph)
+{
+    GlyphCachePtr cache = GlyphCache(glyph);
+    PicturePtr pPicture = NULL;
+    DrawablePtr pDrawable;
+    CARD8 *bits;
+    Bool ret;
+    int i;
+
+    for (i = 0; i < screenInfo.numScreens && !pPicture; i++)
+        pPicture = GetGlyphPicture(glyph, screenInfo.screens[i]);
+    if (!pPicture || !pPicture->pDrawable)
+        return FALSE;
+    pDrawable = pPicture->pDrawable;
+
+    bits = malloc(GlyphBitsSize(glyph, cache->format));
+    if (!bits)
+        return FALSE;
+    (*pDrawable->pScreen->GetImage) (pDrawable, 0, 0,
+                                     pDrawable->width, pDrawable->height,
+                                     ZPixmap, ~0, (char *) bits);
+    ret = GlyphCachePack(glyph, bits);
+    free(bits);
+    return ret;
+}
+
+/* Realize an evicted glyph again; it is left evicted if that fails */
+static Bool
+GlyphCacheRestore(GlyphPtr glyph)
+{
+    GlyphCachePtr cache = GlyphCache(glyph);
+    PictureScreenPtr ps;
+    CARD8 *bits;
+    int i, size;
+    Bool ret = FALSE;
+
+    size = GlyphBitsSize(glyph, cache->format);
+    bits = malloc(size);
+    if (!bits)
+        return FALSE;
+    GlyphUnpackBits(cache->packed, bits, size);
+
+    for (i = 0; i < screenInfo.numScreens; i++) {
+        ps = GetPictureScreenIfSet(screenInfo.screens[i]);
+        if (ps && !(*ps->RealizeGlyph) (screenInfo.screens[i], glyph))
+            break;
+    }
+    if (i < screenInfo.numScreens) {
+        while (i--) {
+            ps = GetPictureScreenIfSet(screenInfo.screens[i]);
+            if (ps)
+                (*ps->UnrealizeGlyph) (screenInfo.screens[i], glyph);
+        }
+    }
+    else if (CreateGlyphPictures(glyph, cache->format, bits) == Success) {
+        free(cache->packed);
+        cache->packed = NULL;
+        glyphCacheStats.evicted--;
+        ret = TRUE;
+    }
+    else {
+        FreeGlyphPicture(glyph);
+        for (i = 0; i < screenInfo.numScreens; i++)
+            SetGlyphPicture(glyph, screenInfo.screens[i], NULL);
+    }
+    free(bits);
+    return ret;
+}
+
+/*
+ * Mark a glyph as drawn, realizing it again if it was evicted.  Returns
+ * FALSE if it is evicted and could not be realized.
+ */
+Bool
+GlyphCacheUse(GlyphPtr glyph)
+{
+    GlyphCachePtr cache = GlyphCache(glyph);
+
+    if (cache->packed) {
+        glyphCacheStats.misses++;
+        return GlyphCacheRestore(glyph);
+    }
+    if (!xorg_list_is_empty(&cache->lru)) {
+        glyphCacheStats.hits++;
+        xorg_list_del(&cache->lru);
+        xorg_list_add(&cache->lru, &glyphCacheLRU);
+    }
+    return TRUE;
+}
+
+/* Evict least recently drawn glyphs until the cache is within budget */
+void
+GlyphCacheTrim(void)
+{
+    GlyphCachePtr cache;
+    unsigned long evictions = glyphCacheStats.evictions;
+
+    while (glyphCacheStats.bytes > GlyphCacheBudget &&
+           !xorg_list_is_empty(&glyphCacheLRU)) {
+        cache = xorg_list_last_entry(&glyphCacheLRU, GlyphCacheRec, lru);
+        if (!GlyphCacheEvict(cache->glyph))
+            break;
+    }
+
+    if (glyphCacheStats.evictions != evictions)
+        LogMessageVerb(X_INFO, 4,
+                       "Glyph cache: evicted %lu glyphs, %lu kB in %lu "
+                       "realized glyphs, %lu evicted, %lu hits, %lu misses\n",
+                       glyphCacheStats.evictions - evictions,
+                       glyphCacheStats.bytes >> 10, glyphCacheStats.glyphs,
+                       glyphCacheStats.evicted, glyphCacheStats.hits,
+                       glyphCacheStats.misses);
+}
+
+void
+GetGlyphCacheStats(GlyphCacheStatsPtr stats)
+{
+    *stats = glyphCacheStats;
+}
+
 static Bool
 AllocateGlyphHash(GlyphHashPtr hash, GlyphHashSetPtr hashSet)
 {
@@ -492,6 +838,26 @@ FreeGlyphSet(void *value, XID gid)
     return Success;
 }
 
+/* Reports the glyph pictures a glyph set currently keeps realized */
+void
+GetGlyphSetBytes(void *value, XID id, ResourceSizePtr size)
+{
+    GlyphSetPtr glyphSet = value;
+    CARD32 i, tableSize = glyphSet->hash.hashSet->size;
+    GlyphRefPtr table = glyphSet->hash.table;
+    GlyphPtr glyph;
+
+    size->resourceSize = 0;
+    size->pixmapRefSize = 0;
+    size->refCnt = glyphSet->refcnt;
+
+    for (i = 0; i < tableSize; i++) {
+        glyph = table[i].glyph;
+        if (glyph && glyph != DeletedGlyph)
+            size->resourceSize += GlyphCache(glyph)->bytes;
+    }
+}
+
 static void
 GlyphExtents(int nlist, GlyphListPtr list, GlyphPtr * glyphs, BoxPtr extents)
 {
@@ -539,9 +905,7 @@ GlyphExtents(int nlist, GlyphListPtr list, GlyphPtr * glyphs, BoxPtr extents)
     }
 }
 
-#define NeedsComponent(f) (PICT_FORMAT_A(f) != 0 && PICT_FORMAT_RGB(f) != 0)
-
-void
+int
 CompositeGlyphs(CARD8 op,
                 PicturePtr pSrc,
                 PicturePtr pDst,
@@ -550,11 +914,24 @@ CompositeGlyphs(CARD8 op,
                 INT16 ySrc, int nlist, GlyphListPtr lists, GlyphPtr * glyphs)
 {
     PictureScreenPtr ps = GetPictureScreen(pDst->pDrawable->pScreen);
+    int i, n = 0;
+
+    for (i = 0; i < nlist; i++)
+        n += lists[i].len;
+    for (i = 0; i < n; i++) {
+        if (!GlyphCacheUse(glyphs[i])) {
+            GlyphCacheTrim();
+            return BadAlloc;
+        }
+    }
 
     ValidatePicture(pSrc);
     ValidatePicture(pDst);
     (*ps->Glyphs) (op, pSrc, pDst, maskFormat, xSrc, ySrc, nlist, lists,
                    glyphs);
+
+    GlyphCacheTrim();
+    return Success;
 }
 
 Bool
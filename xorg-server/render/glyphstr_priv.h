@@ -13,9 +13,36 @@
 #include "regionstr.h"
 #include "miscstruct.h"
 #include "privates.h"
+#include "resource.h"
+#include "list.h"
 
 #define GlyphPicture(glyph) ((PicturePtr *) ((glyph) + 1))
 
+/*
+ * Glyph picture cache state, stored after the per-screen pictures.
+ * Glyphs with pictures sit on the cache LRU list; evicted glyphs keep
+ * their bits packed until they are drawn again.
+ */
+typedef struct {
+    struct xorg_list lru;
+    GlyphPtr glyph;
+    unsigned long bytes;        /* memory held by the glyph pictures */
+    CARD8 *packed;              /* bits of an evicted glyph */
+    PictFormatPtr format;       /* picture format to re-realize with */
+} GlyphCacheRec, *GlyphCachePtr;
+
+#define GlyphCache(glyph) \
+    ((GlyphCachePtr) (GlyphPicture(glyph) + screenInfo.numScreens))
+
+typedef struct {
+    unsigned long bytes;        /* bytes held by realized glyph pictures */
+    unsigned long glyphs;       /* glyphs with pictures */
+    unsigned long evicted;      /* glyphs currently evicted */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} GlyphCacheStatsRec, *GlyphCacheStatsPtr;
+
 typedef struct {
     CARD32 signature;
     GlyphPtr glyph;
@@ -60,5 +87,14 @@ void FreeGlyph(GlyphPtr glyph, int format);
 Bool ResizeGlyphSet(GlyphSetPtr glyphSet, CARD32 change);
 GlyphSetPtr AllocateGlyphSet(int fdepth, PictFormatPtr format);
 int FreeGlyphSet(void *value, XID gid);
+void GetGlyphSetBytes(void *value, XID id, ResourceSizePtr size);
+void DiscardGlyph(GlyphPtr glyph);
+int CreateGlyphPictures(GlyphPtr glyph, PictFormatPtr format, CARD8 *bits);
+int GlyphPackBits(const CARD8 *src, int size, CARD8 *dst);
+void GlyphUnpackBits(const CARD8 *src, CARD8 *dst, int size);
+Bool GlyphCachePack(GlyphPtr glyph, const CARD8 *bits);
+Bool GlyphCacheUse(GlyphPtr glyph);
+void GlyphCacheTrim(void);
+void GetGlyphCacheStats(GlyphCacheStatsPtr stats);
 
 #endif /* _XSERVER_GLYPHSTR_PRIV_H_ */
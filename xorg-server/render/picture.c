@@ -626,6 +626,7 @@ PictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
         GlyphSetType = CreateNewResourceType(FreeGlyphSet, "GLYPHSET");
         if (!GlyphSetType)
             return FALSE;
+        SetResourceTypeSizeFunc(GlyphSetType, GetGlyphSetBytes);
         PictureGeneration = serverGeneration;
     }
     if (!dixRegisterPrivateKey(&PictureScreenPrivateKeyRec, PRIVATE_SCREEN, 0))
@@ -811,6 +812,8 @@ initGradient(SourcePictPtr pGradient, int stopCount,
     int i;
     xFixed dpos;
 
+    pGradient->gradient.image = NULL;
+
     if (stopCount <= 0) {
         *error = BadValue;
         return;
@@ -1388,8 +1391,11 @@ FreePicture(void *value, XID pid)
         free(pPicture->filter_params);
 
         if (pPicture->pSourcePict) {
-            if (pPicture->pSourcePict->type != SourcePictTypeSolidFill)
-                free(pPicture->pSourcePict->linear.stops);
+            if (pPicture->pSourcePict->type != SourcePictTypeSolidFill) {
+                free(pPicture->pSourcePict->gradient.stops);
+                if (pPicture->pSourcePict->gradient.image)
+                    pixman_image_unref(pPicture->pSourcePict->gradient.image);
+            }
 
             free(pPicture->pSourcePict);
         }
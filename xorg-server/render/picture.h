@@ -176,6 +176,9 @@ extern int PictureCmapPolicy;
 
 extern int PictureParseCmapPolicy(const char *name);
 
+/* bytes of glyph pictures kept before the least recently used are evicted */
+extern unsigned long GlyphCacheBudget;
+
 extern int RenderErrBase;
 
 /* Fixed point updates from Carl Worth, USC, Information Sciences Institute */
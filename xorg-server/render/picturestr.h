@@ -77,12 +77,14 @@ typedef struct _PictGradient {
     unsigned int type;
     int nstops;
     PictGradientStopPtr stops;
+    pixman_image_t *image;      /* kept by the backend, unref'd with the picture */
 } PictGradient, *PictGradientPtr;
 
 typedef struct _PictLinearGradient {
     unsigned int type;
     int nstops;
     PictGradientStopPtr stops;
+    pixman_image_t *image;
     xPointFixed p1;
     xPointFixed p2;
 } PictLinearGradient, *PictLinearGradientPtr;
@@ -97,6 +99,7 @@ typedef struct _PictRadialGradient {
     unsigned int type;
     int nstops;
     PictGradientStopPtr stops;
+    pixman_image_t *image;
     PictCircle c1;
     PictCircle c2;
 } PictRadialGradient, *PictRadialGradientPtr;
@@ -105,6 +108,7 @@ typedef struct _PictConicalGradient {
     unsigned int type;
     int nstops;
     PictGradientStopPtr stops;
+    pixman_image_t *image;
     xPointFixed center;
     xFixed angle;
 } PictConicalGradient, *PictConicalGradientPtr;
@@ -444,7 +448,7 @@ CompositePicture(CARD8 op,
                  INT16 yMask,
                  INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
 
-extern _X_EXPORT void
+extern _X_EXPORT int
 CompositeGlyphs(CARD8 op,
                 PicturePtr pSrc,
                 PicturePtr pDst,
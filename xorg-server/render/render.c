@@ -992,8 +992,6 @@ typedef struct _GlyphNew {
     unsigned char sha1[20];
 } GlyphNewRec, *GlyphNewPtr;
 
-#define NeedsComponent(f) (PICT_FORMAT_A(f) != 0 && PICT_FORMAT_RGB(f) != 0)
-
 static int
 ProcRenderAddGlyphs(ClientPtr client)
 {
@@ -1008,10 +1006,7 @@ ProcRenderAddGlyphs(ClientPtr client)
     CARD8 *bits;
     unsigned int size;
     int err;
-    int i, screen;
-    PicturePtr pSrc = NULL, pDst = NULL;
-    PixmapPtr pSrcPix = NULL, pDstPix = NULL;
-    CARD32 component_alpha;
+    int i;
 
     REQUEST_AT_LEAST_SIZE(xRenderAddGlyphsReq);
     err =
@@ -1027,8 +1022,6 @@ ProcRenderAddGlyphs(ClientPtr client)
     if (nglyphs > UINT32_MAX / sizeof(GlyphNewRec))
         return BadAlloc;
 
-    component_alpha = NeedsComponent(glyphSet->format->format);
-
     if (nglyphs <= NLOCALGLYPH) {
         memset(glyphsLocal, 0, sizeof(glyphsLocal));
         glyphsBase = glyphsLocal;
@@ -1092,68 +1085,9 @@ ProcRenderAddGlyphs(ClientPtr client)
                 goto bail;
             }
 
-            for (screen = 0; screen < screenInfo.numScreens; screen++) {
-                int width = gi[i].width;
-                int height = gi[i].height;
-                int depth = glyphSet->format->depth;
-                ScreenPtr pScreen;
-                int error;
-
-                /* Skip work if it's invisibly small anyway */
-                if (!width || !height)
-                    break;
-
-                pScreen = screenInfo.screens[screen];
-                pSrcPix = GetScratchPixmapHeader(pScreen,
-                                                 width, height,
-                                                 depth, depth, -1, bits);
-                if (!pSrcPix) {
-                    err = BadAlloc;
-                    goto bail;
-                }
-
-                pSrc = CreatePicture(0, &pSrcPix->drawable,
-                                     glyphSet->format, 0, NULL,
-                                     serverClient, &error);
-                if (!pSrc) {
-                    err = BadAlloc;
-                    goto bail;
-                }
-
-                pDstPix = (pScreen->CreatePixmap) (pScreen,
-                                                   width, height, depth,
-                                                   CREATE_PIXMAP_USAGE_GLYPH_PICTURE);
-
-                if (!pDstPix) {
-                    err = BadAlloc;
-                    goto bail;
-                }
-
-                pDst = CreatePicture(0, &pDstPix->drawable,
-                                  glyphSet->format,
-                                  CPComponentAlpha, &component_alpha,
-                                  serverClient, &error);
-                SetGlyphPicture(glyph, pScreen, pDst);
-
-                /* The picture takes a reference to the pixmap, so we
-                   drop ours. */
-                dixDestroyPixmap(pDstPix, 0);
-                pDstPix = NULL;
-
-                if (!pDst) {
-                    err = BadAlloc;
-                    goto bail;
-                }
-
-                CompositePicture(PictOpSrc,
-                                 pSrc,
-                                 None, pDst, 0, 0, 0, 0, 0, 0, width, height);
-
-                FreePicture((void *) pSrc, 0);
-                pSrc = NULL;
-                FreeScratchPixmapHeader(pSrcPix);
-                pSrcPix = NULL;
-            }
+            err = CreateGlyphPictures(glyph, glyphSet->format, bits);
+            if (err != Success)
+                goto bail;
 
             memcpy(glyph_new->glyph->sha1, glyph_new->sha1, 20);
         }
@@ -1177,20 +1111,17 @@ ProcRenderAddGlyphs(ClientPtr client)
         AddGlyph(glyphSet, glyphs[i].glyph, glyphs[i].id);
         FreeGlyph(glyphs[i].glyph, glyphSet->fdepth);
     }
+    GlyphCacheTrim();
 
     if (glyphsBase != glyphsLocal)
         free(glyphsBase);
     return Success;
  bail:
-    if (pSrc)
-        FreePicture((void *) pSrc, 0);
-    if (pSrcPix)
-        FreeScratchPixmapHeader(pSrcPix);
     for (i = 0; i < nglyphs; i++) {
         if (glyphs[i].glyph) {
             --glyphs[i].glyph->refcnt;
             if (!glyphs[i].found)
-                free(glyphs[i].glyph);
+                DiscardGlyph(glyphs[i].glyph);
         }
     }
     if (glyphsBase != glyphsLocal)
@@ -1385,12 +1316,12 @@ ProcRenderCompositeGlyphs(ClientPtr client)
         goto bail;
     }
 
-    CompositeGlyphs(stuff->op,
-                    pSrc,
-                    pDst,
-                    pFormat,
-                    stuff->xSrc, stuff->ySrc, nlist, listsBase, glyphsBase);
-    rc = Success;
+    rc = CompositeGlyphs(stuff->op,
+                         pSrc,
+                         pDst,
+                         pFormat,
+                         stuff->xSrc, stuff->ySrc, nlist, listsBase,
+                         glyphsBase);
 
  bail:
     if (glyphsBase != glyphsLocal)
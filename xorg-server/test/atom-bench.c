@@ -0,0 +1,131 @@
+/**
+ * Copyright © 2026 The X.Org Foundation
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including the next
+ *  paragraph) shall be included in all copies or substantial portions of the
+ *  Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Atom store benchmark: interns toolkit-like atom names the way a client
+ * does at startup (mostly names that already exist) and compares the
+ * hashed store in dix/atom.c against the fingerprint tree it replaced,
+ * which is reproduced below.
+ */
+
+#include <dix-config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "misc.h"
+#include "dix.h"
+
+typedef struct _Node {
+    struct _Node *left, *right;
+    Atom a;
+    unsigned int fingerPrint;
+    const char *string;
+} NodeRec, *NodePtr;
+
+static NodePtr treeRoot;
+static Atom treeLast;
+
+static Atom
+TreeMakeAtom(const char *string, unsigned len, Bool makeit)
+{
+    NodePtr *np = &treeRoot;
+    unsigned i;
+    int comp;
+    unsigned int fp = 0;
+
+    for (i = 0; i < (len + 1) / 2; i++) {
+        fp = fp * 27 + string[i];
+        fp = fp * 27 + string[len - 1 - i];
+    }
+    while (*np != NULL) {
+        if (fp < (*np)->fingerPrint)
+            np = &((*np)->left);
+        else if (fp > (*np)->fingerPrint)
+            np = &((*np)->right);
+        else {
+            comp = strncmp(string, (*np)->string, (int) len);
+            if ((comp < 0) || ((comp == 0) && (len < strlen((*np)->string))))
+                np = &((*np)->left);
+            else if (comp > 0)
+                np = &((*np)->right);
+            else
+                return (*np)->a;
+        }
+    }
+    if (!makeit)
+        return None;
+    *np = calloc(1, sizeof(NodeRec));
+    (*np)->string = strndup(string, len);
+    (*np)->fingerPrint = fp;
+    return (*np)->a = ++treeLast;
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define NUM_NAMES 2000
+#define ROUNDS 500
+
+static char *names[NUM_NAMES];
+
+static double
+bench(Atom (*make)(const char *, unsigned, Bool))
+{
+    double start = now();
+    int i, r;
+
+    for (r = 0; r < ROUNDS; r++)
+        for (i = 0; i < NUM_NAMES; i++)
+            make(names[i], strlen(names[i]), TRUE);
+    return NUM_NAMES * (double) ROUNDS / (now() - start) / 1e6;
+}
+
+int
+main(int argc, char **argv)
+{
+    static const char *prefixes[] = {
+        "_NET_WM_", "_GTK_", "_KDE_NET_WM_", "WM_", "_XEMBED_", "_QT_",
+    };
+    char name[64];
+    int i;
+
+    for (i = 0; i < NUM_NAMES; i++) {
+        snprintf(name, sizeof(name), "%sPROPERTY_%d",
+                 prefixes[i % ARRAY_SIZE(prefixes)], i);
+        names[i] = strdup(name);
+    }
+
+    InitAtoms();
+    printf("InternAtom, %d names: tree %6.2f Mop/s, hash %6.2f Mop/s\n",
+           NUM_NAMES, bench(TreeMakeAtom), bench(MakeAtom));
+    return 0;
+}
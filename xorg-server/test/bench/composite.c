@@ -0,0 +1,168 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Full-screen RENDER composites: blends a translucent ARGB32 picture OVER
+ * the root window at 1920x1080 and at 3840x2160, plus a solid fill of the
+ * same size, and reports frames per second.  The 4K case is skipped on
+ * smaller screens; run with e.g. Xvfb -screen 0 3840x2160x24.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/render.h>
+
+#define FRAMES 30
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+static xcb_render_pictformat_t
+find_argb32(xcb_render_query_pict_formats_reply_t *formats)
+{
+    xcb_render_pictforminfo_iterator_t i;
+
+    for (i = xcb_render_query_pict_formats_formats_iterator(formats);
+         i.rem; xcb_render_pictforminfo_next(&i)) {
+        if (i.data->type == XCB_RENDER_PICT_TYPE_DIRECT &&
+            i.data->depth == 32 &&
+            i.data->direct.alpha_shift == 24 && i.data->direct.alpha_mask == 0xff &&
+            i.data->direct.red_shift == 16 && i.data->direct.red_mask == 0xff)
+            return i.data->id;
+    }
+    return 0;
+}
+
+static xcb_render_pictformat_t
+find_visual_format(xcb_render_query_pict_formats_reply_t *formats,
+                   xcb_visualid_t visual)
+{
+    xcb_render_pictscreen_iterator_t s;
+    xcb_render_pictdepth_iterator_t d;
+    xcb_render_pictvisual_iterator_t v;
+
+    for (s = xcb_render_query_pict_formats_screens_iterator(formats);
+         s.rem; xcb_render_pictscreen_next(&s))
+        for (d = xcb_render_pictscreen_depths_iterator(s.data);
+             d.rem; xcb_render_pictdepth_next(&d))
+            for (v = xcb_render_pictdepth_visuals_iterator(d.data);
+                 v.rem; xcb_render_pictvisual_next(&v))
+                if (v.data->visual == visual)
+                    return v.data->format;
+    return 0;
+}
+
+static void
+bench(xcb_connection_t *c, xcb_screen_t *screen, xcb_render_picture_t root,
+      xcb_render_pictformat_t argb32, int width, int height)
+{
+    xcb_pixmap_t pixmap = xcb_generate_id(c);
+    xcb_render_picture_t src = xcb_generate_id(c);
+    xcb_render_color_t translucent = { 0x4000, 0x8000, 0x2000, 0x8000 };
+    xcb_render_color_t opaque = { 0x1000, 0x2000, 0x3000, 0xffff };
+    xcb_rectangle_t rect = { 0, 0, width, height };
+    double start, over, fill;
+    int i;
+
+    xcb_create_pixmap(c, 32, pixmap, screen->root, width, height);
+    xcb_render_create_picture(c, src, pixmap, argb32, 0, NULL);
+    xcb_render_fill_rectangles(c, XCB_RENDER_PICT_OP_SRC, src, translucent,
+                               1, &rect);
+    sync_server(c);
+
+    start = now();
+    for (i = 0; i < FRAMES; i++)
+        xcb_render_composite(c, XCB_RENDER_PICT_OP_OVER, src,
+                             XCB_RENDER_PICTURE_NONE, root,
+                             0, 0, 0, 0, 0, 0, width, height);
+    sync_server(c);
+    over = now() - start;
+
+    start = now();
+    for (i = 0; i < FRAMES; i++)
+        xcb_render_fill_rectangles(c, XCB_RENDER_PICT_OP_SRC, root, opaque,
+                                   1, &rect);
+    sync_server(c);
+    fill = now() - start;
+
+    printf("%4dx%-4d: OVER %7.1f frames/s, solid fill %7.1f frames/s\n",
+           width, height, FRAMES / over, FRAMES / fill);
+
+    xcb_render_free_picture(c, src);
+    xcb_free_pixmap(c, pixmap);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct { int width, height; } sizes[] = {
+        { 1920, 1080 }, { 3840, 2160 },
+    };
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_render_query_pict_formats_reply_t *formats;
+    xcb_render_pictformat_t argb32, root_format;
+    xcb_render_picture_t root;
+    xcb_screen_t *screen;
+    int i;
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    free(xcb_render_query_version_reply(c, xcb_render_query_version(c, 0, 11),
+                                        NULL));
+    formats = xcb_render_query_pict_formats_reply(c,
+                                                  xcb_render_query_pict_formats(c),
+                                                  NULL);
+    if (!formats)
+        return 77;
+    argb32 = find_argb32(formats);
+    root_format = find_visual_format(formats, screen->root_visual);
+    free(formats);
+    if (!argb32 || !root_format)
+        return 77;
+
+    root = xcb_generate_id(c);
+    xcb_render_create_picture(c, root, screen->root, root_format, 0, NULL);
+
+    for (i = 0; i < 2; i++)
+        if (screen->width_in_pixels >= sizes[i].width &&
+            screen->height_in_pixels >= sizes[i].height)
+            bench(c, screen, root, argb32, sizes[i].width, sizes[i].height);
+
+    xcb_disconnect(c);
+    return 0;
+}
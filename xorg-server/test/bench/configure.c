@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Window configuration latency with a deep stack: maps 1000 overlapping
+ * top-level windows, each with a couple of children, then drags one from
+ * the middle of the stack around and raises and lowers windows, with a
+ * round trip after every ConfigureWindow.  Reports the mean and worst
+ * latency of each kind of request.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define NUM_WINDOWS 1000
+#define ITERATIONS 2000
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+static xcb_window_t
+create_window(xcb_connection_t *c, xcb_screen_t *screen, xcb_window_t parent,
+              int x, int y, int width, int height, uint32_t pixel)
+{
+    xcb_window_t window = xcb_generate_id(c);
+    uint32_t values[] = { pixel, 1 };
+
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, parent,
+                      x, y, width, height, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, values);
+    return window;
+}
+
+static void
+report(const char *name, double total, double worst)
+{
+    printf("%-10s mean %8.1f us, worst %8.1f us\n", name,
+           total / ITERATIONS * 1e6, worst * 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_window_t windows[NUM_WINDOWS], dragged;
+    double t, total, worst;
+    int i, test;
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    srand(0);
+    for (i = 0; i < NUM_WINDOWS; i++) {
+        int w = 200 + rand() % 400, h = 150 + rand() % 300;
+        int x = rand() % (screen->width_in_pixels - w / 2);
+        int y = rand() % (screen->height_in_pixels - h / 2);
+
+        windows[i] = create_window(c, screen, screen->root, x, y, w, h,
+                                   rand() & screen->white_pixel);
+        create_window(c, screen, windows[i], 0, 0, w, 24, 0);
+        create_window(c, screen, windows[i], 10, 40, w - 20, h - 50,
+                      screen->white_pixel);
+        xcb_map_subwindows(c, windows[i]);
+        xcb_map_window(c, windows[i]);
+    }
+    sync_server(c);
+
+    dragged = windows[NUM_WINDOWS / 2];
+    for (test = 0; test < 3; test++) {
+        static const char *names[] = { "move", "raise", "lower" };
+
+        total = worst = 0;
+        for (i = 0; i < ITERATIONS; i++) {
+            uint32_t values[2];
+
+            t = now();
+            switch (test) {
+            case 0:
+                values[0] = 100 + (i * 7) % (screen->width_in_pixels - 200);
+                values[1] = 100 + (i * 3) % (screen->height_in_pixels - 200);
+                xcb_configure_window(c, dragged,
+                                     XCB_CONFIG_WINDOW_X |
+                                     XCB_CONFIG_WINDOW_Y, values);
+                break;
+            case 1:
+                values[0] = XCB_STACK_MODE_ABOVE;
+                xcb_configure_window(c, windows[(i * 389) % NUM_WINDOWS],
+                                     XCB_CONFIG_WINDOW_STACK_MODE, values);
+                break;
+            case 2:
+                values[0] = XCB_STACK_MODE_BELOW;
+                xcb_configure_window(c, windows[(i * 389) % NUM_WINDOWS],
+                                     XCB_CONFIG_WINDOW_STACK_MODE, values);
+                break;
+            }
+            sync_server(c);
+            t = now() - t;
+            total += t;
+            if (t > worst)
+                worst = t;
+        }
+        report(names[test], total, worst);
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
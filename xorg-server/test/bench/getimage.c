@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * GetImage throughput: maps a 3840x2160 window and reads it back in full
+ * a number of times, reporting frames and megabytes per second.  Run it
+ * against a server with a screen at least that large, e.g.
+ * Xvfb -screen 0 3840x2160x24.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define WIDTH 3840
+#define HEIGHT 2160
+#define FRAMES 50
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_window_t win;
+    uint32_t values[] = { 0x336699 };
+    double start, elapsed, bytes = 0;
+    int i;
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    if (screen->width_in_pixels < WIDTH || screen->height_in_pixels < HEIGHT) {
+        fprintf(stderr, "screen is smaller than %dx%d\n", WIDTH, HEIGHT);
+        return 77;
+    }
+
+    win = xcb_generate_id(c);
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, win, screen->root,
+                      0, 0, WIDTH, HEIGHT, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual, XCB_CW_BACK_PIXEL, values);
+    xcb_map_window(c, win);
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    start = now();
+    for (i = 0; i < FRAMES; i++) {
+        xcb_get_image_reply_t *reply;
+
+        reply = xcb_get_image_reply(c,
+                                    xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                                  win, 0, 0, WIDTH, HEIGHT,
+                                                  ~0),
+                                    NULL);
+        if (!reply)
+            return 1;
+        bytes += xcb_get_image_data_length(reply);
+        free(reply);
+    }
+    elapsed = now() - start;
+
+    printf("GetImage %dx%d: %.1f frames/s, %.1f MB/s\n", WIDTH, HEIGHT,
+           FRAMES / elapsed, bytes / elapsed / 1e6);
+
+    xcb_disconnect(c);
+    return 0;
+}
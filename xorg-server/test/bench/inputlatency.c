@@ -0,0 +1,137 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Input latency: one connection sends XTest motion at 2 kHz while another
+ * listens for the MotionNotify events on a window covering the screen.
+ * Each event's position identifies the motion it came from, so the
+ * receiver can report the time from sending the motion to getting the
+ * event back, as the mean, median and 99th percentile.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/xtest.h>
+
+#define RATE 2000
+#define EVENTS 10000
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+static int
+compare(const void *a, const void *b)
+{
+    double d = *(const double *) a - *(const double *) b;
+
+    return d < 0 ? -1 : d > 0;
+}
+
+int main(int argc, char **argv)
+{
+    xcb_connection_t *sender = xcb_connect(NULL, NULL);
+    xcb_connection_t *receiver = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    xcb_generic_event_t *ev;
+    uint32_t values[3];
+    double *sent, *latency, start, total = 0;
+    int width, sending, received = 0;
+
+    if (xcb_connection_has_error(sender) || xcb_connection_has_error(receiver))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(receiver)).data;
+    width = screen->width_in_pixels;
+    if (EVENTS / width >= screen->height_in_pixels)
+        return 77;
+
+    window = xcb_generate_id(receiver);
+    values[0] = screen->black_pixel;
+    values[1] = 1;
+    values[2] = XCB_EVENT_MASK_POINTER_MOTION;
+    xcb_create_window(receiver, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, screen->width_in_pixels, screen->height_in_pixels,
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT |
+                      XCB_CW_EVENT_MASK, values);
+    xcb_map_window(receiver, window);
+    sync_server(receiver);
+    sync_server(sender);
+
+    sent = calloc(EVENTS, sizeof(double));
+    latency = calloc(EVENTS, sizeof(double));
+
+    start = now();
+    for (sending = 0; sending < EVENTS || now() < sent[EVENTS - 1] + 1;) {
+        if (sending < EVENTS && now() >= start + (double) sending / RATE) {
+            /* event n goes to x = n % width, y = n / width */
+            sent[sending] = now();
+            xcb_test_fake_input(sender, XCB_MOTION_NOTIFY, 0,
+                                XCB_CURRENT_TIME, screen->root,
+                                sending % width, sending / width, 0);
+            xcb_flush(sender);
+            sending++;
+        }
+
+        while ((ev = xcb_poll_for_event(receiver))) {
+            if ((ev->response_type & ~0x80) == XCB_MOTION_NOTIFY) {
+                xcb_motion_notify_event_t *motion = (void *) ev;
+                int n = motion->event_y * width + motion->event_x;
+
+                if (n < sending && received < EVENTS) {
+                    latency[received] = now() - sent[n];
+                    total += latency[received++];
+                }
+            }
+            free(ev);
+        }
+    }
+
+    if (!received)
+        return 1;
+    qsort(latency, received, sizeof(double), compare);
+    printf("%d of %d motion events at %d Hz: mean %6.1f us, "
+           "median %6.1f us, 99%% %6.1f us\n",
+           received, EVENTS, RATE, total / received * 1e6,
+           latency[received / 2] * 1e6, latency[received * 99 / 100] * 1e6);
+
+    free(sent);
+    free(latency);
+    xcb_disconnect(sender);
+    xcb_disconnect(receiver);
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Pointer picking throughput: maps a stack of small top-level windows
+ * (100, 1000 and 5000 of them) and sends XTest motion to pseudo-random
+ * positions, with a round trip after each burst, so that the server
+ * looks up the window under the pointer for every event.  Reports motion
+ * events per second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/xtest.h>
+
+#define BURST 1000
+#define BURSTS 50
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+int main(int argc, char **argv)
+{
+    static const int counts[] = { 100, 1000, 5000 };
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_window_t *windows;
+    double start;
+    int i, j, n, test, mapped = 0;
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    windows = calloc(counts[2], sizeof(xcb_window_t));
+
+    srand(0);
+    for (test = 0; test < 3; test++) {
+        for (; mapped < counts[test]; mapped++) {
+            uint32_t values[] = { screen->white_pixel, 1 };
+            int w = 50 + rand() % 250, h = 50 + rand() % 250;
+
+            windows[mapped] = xcb_generate_id(c);
+            xcb_create_window(c, XCB_COPY_FROM_PARENT, windows[mapped],
+                              screen->root,
+                              rand() % screen->width_in_pixels,
+                              rand() % screen->height_in_pixels,
+                              w, h, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                              screen->root_visual,
+                              XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT,
+                              values);
+            xcb_map_window(c, windows[mapped]);
+        }
+        sync_server(c);
+
+        n = 0;
+        start = now();
+        for (i = 0; i < BURSTS; i++) {
+            for (j = 0; j < BURST; j++, n++)
+                xcb_test_fake_input(c, XCB_MOTION_NOTIFY, 0, XCB_CURRENT_TIME,
+                                    screen->root,
+                                    (n * 7919u) % screen->width_in_pixels,
+                                    (n * 104729u) % screen->height_in_pixels,
+                                    0);
+            sync_server(c);
+        }
+        printf("%5d windows: %10.0f motion events/s\n", counts[test],
+               BURST * (double) BURSTS / (now() - start));
+    }
+
+    free(windows);
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Multi-client scaling: forks 1, 2, 4, 8 and 16 clients that each render
+ * to a private pixmap (PutImage plus a batch of PolyFillRectangle, then a
+ * round trip) and reports the aggregate rounds per second together with
+ * the worst round trip any client saw, which is how long one client's
+ * rendering kept the others waiting.  Run it against a server started
+ * with and without -dispatchthreads to compare.
+ *
+ * The colours alternate between two GCs rather than changing one, since
+ * a ChangeGC has to wait for the rendering already queued with that GC.
+ * Each client reads back a pixel at the end, so all of its rendering is
+ * included in the time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <xcb/xcb.h>
+
+#define SIZE 256
+#define ROUNDS 200
+#define RECTS 100
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* returns the worst round trip in seconds, or a negative value on error */
+static double
+render_client(void)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_pixmap_t pixmap;
+    xcb_gcontext_t gc[2];
+    xcb_rectangle_t rects[RECTS];
+    uint8_t *image;
+    double worst = 0, t;
+    int i, r;
+
+    if (xcb_connection_has_error(c))
+        return -1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    if (screen->root_depth != 24)
+        return -1;
+
+    pixmap = xcb_generate_id(c);
+    xcb_create_pixmap(c, 24, pixmap, screen->root, SIZE, SIZE);
+    for (i = 0; i < 2; i++) {
+        uint32_t foreground = i ? 0xff8040 : 0x4080ff;
+
+        gc[i] = xcb_generate_id(c);
+        xcb_create_gc(c, gc[i], pixmap, XCB_GC_FOREGROUND, &foreground);
+    }
+
+    /* a quarter of the pixmap per PutImage */
+    image = malloc(SIZE * SIZE * 4);
+    for (i = 0; i < SIZE * SIZE * 4; i++)
+        image[i] = i * 7;
+    for (i = 0; i < RECTS; i++) {
+        rects[i].x = (i * 37) % SIZE;
+        rects[i].y = (i * 91) % SIZE;
+        rects[i].width = 64;
+        rects[i].height = 64;
+    }
+
+    for (r = 0; r < ROUNDS; r++) {
+        xcb_put_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap, gc[0], SIZE,
+                      SIZE / 4, 0, (r % 4) * SIZE / 4, 0, 24,
+                      SIZE * SIZE / 4 * 4, image);
+        xcb_poly_fill_rectangle(c, pixmap, gc[r & 1], RECTS, rects);
+
+        t = now();
+        free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+        t = now() - t;
+        if (t > worst)
+            worst = t;
+    }
+
+    free(xcb_get_image_reply(c, xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                              pixmap, 0, 0, 1, 1, ~0),
+                             NULL));
+    free(image);
+    xcb_disconnect(c);
+    return worst;
+}
+
+static int
+run(int nclients)
+{
+    int fds[2];
+    double start, elapsed, worst = 0, w;
+    int i, status, ok = 1;
+
+    if (pipe(fds) < 0)
+        return 0;
+
+    start = now();
+    for (i = 0; i < nclients; i++) {
+        if (fork() == 0) {
+            w = render_client();
+            if (write(fds[1], &w, sizeof(w)) != sizeof(w))
+                _exit(1);
+            _exit(0);
+        }
+    }
+    close(fds[1]);
+    for (i = 0; i < nclients; i++) {
+        if (read(fds[0], &w, sizeof(w)) != sizeof(w) || w < 0)
+            ok = 0;
+        else if (w > worst)
+            worst = w;
+    }
+    elapsed = now() - start;
+    while (wait(&status) > 0)
+        ;
+    close(fds[0]);
+
+    if (ok)
+        printf("%2d clients: %8.1f rounds/s, worst round trip %7.2f ms\n",
+               nclients, nclients * ROUNDS / elapsed, worst * 1e3);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    int n;
+
+    for (n = 1; n <= 16; n *= 2)
+        if (!run(n))
+            return 1;
+    return 0;
+}
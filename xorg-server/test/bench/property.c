@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Property lookup and transfer: gives a window 50 properties, the way a
+ * managed top-level ends up with dozens of _NET_WM_* and WM_* ones, and
+ * times pipelined GetProperty requests for them.  Then times fetching a
+ * 1 MB property, the size of a large icon or clipboard transfer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define NUM_PROPS 50
+#define SMALL_ROUNDS 200
+#define LARGE_SIZE (1024 * 1024)
+#define LARGE_ROUNDS 100
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static xcb_atom_t
+intern(xcb_connection_t *c, const char *name)
+{
+    xcb_intern_atom_reply_t *reply =
+        xcb_intern_atom_reply(c, xcb_intern_atom(c, 0, strlen(name), name),
+                              NULL);
+    xcb_atom_t atom = reply ? reply->atom : XCB_NONE;
+
+    free(reply);
+    return atom;
+}
+
+int main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_get_property_cookie_t cookies[NUM_PROPS];
+    xcb_atom_t atoms[NUM_PROPS], large;
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    char name[64], *data;
+    double start;
+    int i, r;
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    window = xcb_generate_id(c);
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, 100, 100, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual, 0, NULL);
+
+    for (i = 0; i < NUM_PROPS; i++) {
+        uint32_t value = i;
+
+        snprintf(name, sizeof(name), "_BENCH_PROPERTY_%d", i);
+        atoms[i] = intern(c, name);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, atoms[i],
+                            XCB_ATOM_CARDINAL, 32, 1, &value);
+    }
+
+    start = now();
+    for (r = 0; r < SMALL_ROUNDS; r++) {
+        for (i = 0; i < NUM_PROPS; i++)
+            cookies[i] = xcb_get_property(c, 0, window, atoms[i],
+                                          XCB_ATOM_ANY, 0, 1);
+        for (i = 0; i < NUM_PROPS; i++)
+            free(xcb_get_property_reply(c, cookies[i], NULL));
+    }
+    printf("GetProperty, %d properties: %8.0f requests/s\n", NUM_PROPS,
+           NUM_PROPS * (double) SMALL_ROUNDS / (now() - start));
+
+    large = intern(c, "_BENCH_LARGE_PROPERTY");
+    data = calloc(1, LARGE_SIZE);
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, large,
+                        XCB_ATOM_CARDINAL, 8, LARGE_SIZE, data);
+    free(data);
+
+    start = now();
+    for (r = 0; r < LARGE_ROUNDS; r++)
+        free(xcb_get_property_reply(c,
+                                    xcb_get_property(c, 0, window, large,
+                                                     XCB_ATOM_ANY, 0,
+                                                     LARGE_SIZE / 4),
+                                    NULL));
+    printf("GetProperty, %d bytes: %8.1f MB/s\n", LARGE_SIZE,
+           LARGE_SIZE * (double) LARGE_ROUNDS / (now() - start) / 1e6);
+
+    xcb_disconnect(c);
+    return 0;
+}
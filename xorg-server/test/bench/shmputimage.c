@@ -0,0 +1,175 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * ShmPutImage throughput for 3840x2160 frames, the way a video player
+ * uploads them: the client renders each frame into a MIT-SHM segment and
+ * puts it into a window.  Segments passed in with ShmAttachFd from a
+ * client memfd are compared with segments the server hands out through
+ * ShmCreateSegment.  The time of the first frame, which faults the
+ * segment in, is reported separately.  Run it against a server with a
+ * screen at least that large, e.g. Xvfb -screen 0 3840x2160x24.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <xcb/xcb.h>
+#include <xcb/shm.h>
+
+#define WIDTH 3840
+#define HEIGHT 2160
+#define FRAMES 100
+#define SEGMENTS 4
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+static uint32_t *
+create_segment(xcb_connection_t *c, xcb_shm_seg_t seg, size_t size,
+               int server)
+{
+    void *addr;
+    int fd;
+
+    if (server) {
+        xcb_shm_create_segment_reply_t *reply;
+
+        reply = xcb_shm_create_segment_reply(c,
+                    xcb_shm_create_segment(c, seg, size, 0), NULL);
+        if (!reply)
+            return NULL;
+        fd = xcb_shm_create_segment_reply_fds(c, reply)[0];
+        free(reply);
+    }
+    else {
+        fd = memfd_create("shmputimage", MFD_CLOEXEC);
+        if (fd < 0 || ftruncate(fd, size) < 0)
+            return NULL;
+        xcb_shm_attach_fd(c, seg, dup(fd), 0);
+    }
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return addr == MAP_FAILED ? NULL : addr;
+}
+
+static void
+bench(xcb_connection_t *c, xcb_window_t win, xcb_gcontext_t gc, int depth,
+      int server)
+{
+    size_t size = (size_t) WIDTH * HEIGHT * 4;
+    xcb_shm_seg_t segs[SEGMENTS];
+    uint32_t *frames[SEGMENTS];
+    double start, first = 0;
+    int i, j;
+
+    for (i = 0; i < SEGMENTS; i++) {
+        segs[i] = xcb_generate_id(c);
+        frames[i] = create_segment(c, segs[i], size, server);
+        if (!frames[i]) {
+            fprintf(stderr, "could not create segment\n");
+            exit(1);
+        }
+    }
+    sync_server(c);
+
+    start = now();
+    for (i = 0; i < FRAMES; i++) {
+        uint32_t *frame = frames[i % SEGMENTS];
+
+        for (j = 0; j < WIDTH * HEIGHT; j++)
+            frame[j] = i * 0x010203 + j;
+        xcb_shm_put_image(c, win, gc, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT,
+                          0, 0, depth, XCB_IMAGE_FORMAT_Z_PIXMAP, 0,
+                          segs[i % SEGMENTS], 0);
+        sync_server(c);
+        if (i == SEGMENTS - 1)
+            first = now() - start;
+    }
+
+    printf("%-14s first %d frames %6.1f ms, then %5.1f frames/s, %7.1f MB/s\n",
+           server ? "CreateSegment" : "AttachFd", SEGMENTS, first * 1e3,
+           (FRAMES - SEGMENTS) / (now() - start - first),
+           (FRAMES - SEGMENTS) * (double) size / (now() - start - first) / 1e6);
+
+    for (i = 0; i < SEGMENTS; i++) {
+        xcb_shm_detach(c, segs[i]);
+        munmap(frames[i], size);
+    }
+    sync_server(c);
+}
+
+int main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_shm_query_version_reply_t *version;
+    xcb_screen_t *screen;
+    xcb_window_t win;
+    xcb_gcontext_t gc;
+    uint32_t values[] = { 0x336699 };
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    if (screen->width_in_pixels < WIDTH || screen->height_in_pixels < HEIGHT) {
+        fprintf(stderr, "screen is smaller than %dx%d\n", WIDTH, HEIGHT);
+        return 77;
+    }
+    version = xcb_shm_query_version_reply(c, xcb_shm_query_version(c), NULL);
+    if (!version || version->major_version < 1 ||
+        (version->major_version == 1 && version->minor_version < 2)) {
+        fprintf(stderr, "MIT-SHM 1.2 is required\n");
+        return 77;
+    }
+    free(version);
+
+    win = xcb_generate_id(c);
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, win, screen->root,
+                      0, 0, WIDTH, HEIGHT, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual, XCB_CW_BACK_PIXEL, values);
+    xcb_map_window(c, win);
+    gc = xcb_generate_id(c);
+    xcb_create_gc(c, gc, win, 0, NULL);
+
+    bench(c, win, gc, screen->root_depth, 0);
+    bench(c, win, gc, screen->root_depth, 1);
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Small request throughput, in the spirit of x11perf -dot/-rect1: sends
+ * long bursts of tiny PolyPoint, PolyRectangle and ChangeGC requests to
+ * a pixmap, with a round trip at the end of each burst, and reports
+ * requests per second for each kind.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define BURST 10000
+#define BURSTS 50
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+int main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_pixmap_t pixmap;
+    xcb_gcontext_t gc;
+    double start;
+    int i, j, test;
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    pixmap = xcb_generate_id(c);
+    xcb_create_pixmap(c, screen->root_depth, pixmap, screen->root, 256, 256);
+    gc = xcb_generate_id(c);
+    xcb_create_gc(c, gc, pixmap, 0, NULL);
+    sync_server(c);
+
+    for (test = 0; test < 3; test++) {
+        static const char *names[] = { "PolyPoint", "PolyRectangle", "ChangeGC" };
+
+        start = now();
+        for (i = 0; i < BURSTS; i++) {
+            for (j = 0; j < BURST; j++) {
+                xcb_point_t point = { j & 255, (j >> 8) & 255 };
+                xcb_rectangle_t rect = { j & 127, (j >> 7) & 127, 8, 8 };
+                uint32_t foreground = j;
+
+                switch (test) {
+                case 0:
+                    xcb_poly_point(c, XCB_COORD_MODE_ORIGIN, pixmap, gc,
+                                   1, &point);
+                    break;
+                case 1:
+                    xcb_poly_rectangle(c, pixmap, gc, 1, &rect);
+                    break;
+                case 2:
+                    xcb_change_gc(c, gc, XCB_GC_FOREGROUND, &foreground);
+                    break;
+                }
+            }
+            sync_server(c);
+        }
+        printf("%-14s %10.0f requests/s\n", names[test],
+               BURST * (double) BURSTS / (now() - start));
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Core text throughput in the style of x11perf -ftext/-f8itext: draws
+ * 80-character lines in the "fixed" font down a window with PolyText8,
+ * ImageText8 and ImageText16, the way a terminal redraws its screen, and
+ * reports characters per second for each.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define COLUMNS 80
+#define LINES 20000
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+enum { POLY_TEXT8, IMAGE_TEXT8, IMAGE_TEXT16 };
+
+static void
+draw_lines(xcb_connection_t *c, xcb_window_t window, xcb_gcontext_t gc,
+           int height, int kind)
+{
+    /* a PolyText8 item: length, delta, string */
+    uint8_t item[2 + COLUMNS];
+    xcb_char2b_t wide[COLUMNS];
+    char line[COLUMNS];
+    double start;
+    int i, j, y;
+
+    start = now();
+    for (i = 0; i < LINES; i++) {
+        for (j = 0; j < COLUMNS; j++)
+            line[j] = ' ' + 1 + (i + j) % 94;
+        y = 13 + (i * 13) % (height - 13);
+
+        switch (kind) {
+        case POLY_TEXT8:
+            item[0] = COLUMNS;
+            item[1] = 0;
+            memcpy(item + 2, line, COLUMNS);
+            xcb_poly_text_8(c, window, gc, 0, y, sizeof(item), item);
+            break;
+        case IMAGE_TEXT8:
+            xcb_image_text_8(c, COLUMNS, window, gc, 0, y, line);
+            break;
+        case IMAGE_TEXT16:
+            for (j = 0; j < COLUMNS; j++) {
+                wide[j].byte1 = 0;
+                wide[j].byte2 = line[j];
+            }
+            xcb_image_text_16(c, COLUMNS, window, gc, 0, y, wide);
+            break;
+        }
+    }
+    sync_server(c);
+
+    printf("%-12s %10.0f chars/s\n",
+           kind == POLY_TEXT8 ? "PolyText8" :
+           kind == IMAGE_TEXT8 ? "ImageText8" : "ImageText16",
+           COLUMNS * (double) LINES / (now() - start));
+}
+
+int main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    xcb_gcontext_t gc;
+    xcb_font_t font;
+    uint32_t values[3];
+    int kind;
+
+    if (xcb_connection_has_error(c))
+        return 1;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    font = xcb_generate_id(c);
+    if (xcb_request_check(c, xcb_open_font_checked(c, font, 5, "fixed")))
+        return 77;
+
+    window = xcb_generate_id(c);
+    values[0] = screen->white_pixel;
+    values[1] = 1;
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, screen->width_in_pixels, screen->height_in_pixels,
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, values);
+    xcb_map_window(c, window);
+
+    gc = xcb_generate_id(c);
+    values[0] = screen->black_pixel;
+    values[1] = screen->white_pixel;
+    values[2] = font;
+    xcb_create_gc(c, gc, window,
+                  XCB_GC_FOREGROUND | XCB_GC_BACKGROUND | XCB_GC_FONT, values);
+    sync_server(c);
+
+    for (kind = POLY_TEXT8; kind <= IMAGE_TEXT16; kind++)
+        draw_lines(c, window, gc, screen->height_in_pixels, kind);
+
+    xcb_disconnect(c);
+    return 0;
+}
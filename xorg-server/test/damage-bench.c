@@ -0,0 +1,197 @@
+/**
+ * Copyright © 2026 The X.Org Foundation
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including the next
+ *  paragraph) shall be included in all copies or substantial portions of the
+ *  Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Damage coalescing benchmark: accumulates the damage a terminal or
+ * editor leaves between two shadow updates (rows of glyph cells, a
+ * cursor, some scattered small updates), then times copying it box by
+ * box from a shadow buffer to a frame buffer the way shadowUpdatePacked
+ * does, once with the exact region and once coalesced to the shadow box
+ * limit.
+ */
+
+#include <dix-config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "misc.h"
+#include "scrnintstr.h"
+#include "damagestr.h"
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define ROUNDS 200
+
+static uint32_t shadow[WIDTH * HEIGHT], fb[WIDTH * HEIGHT];
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+damage_box(RegionPtr damage, int x, int y, int w, int h)
+{
+    BoxRec box = { x, y, x + w, y + h };
+    RegionRec region;
+
+    RegionInit(&region, &box, 1);
+    RegionUnion(damage, damage, &region);
+    RegionUninit(&region);
+}
+
+/* Glyphs of 9x18 cells, words separated by blanks, lines of varying
+ * length; every fourth line is left untouched. */
+static void
+text_damage(RegionPtr damage, int columns)
+{
+    int row, col, len;
+
+    srand(1);
+    for (row = 0; row < HEIGHT / 18; row++) {
+        if ((row & 3) == 3)
+            continue;
+        len = rand() % columns;
+        for (col = 0; col < len; col++)
+            if (rand() % 6)
+                damage_box(damage, col * 9 + 1, row * 18 + 3, 7, 13);
+    }
+}
+
+static void
+scattered_damage(RegionPtr damage)
+{
+    int i;
+
+    srand(2);
+    for (i = 0; i < 2000; i++)
+        damage_box(damage, rand() % (WIDTH - 16), rand() % (HEIGHT - 16),
+                   1 + rand() % 16, 1 + rand() % 16);
+}
+
+static int64_t
+region_area(RegionPtr region)
+{
+    BoxPtr box = RegionRects(region);
+    int n = RegionNumRects(region);
+    int64_t area = 0;
+
+    while (n--) {
+        area += (int64_t) (box->x2 - box->x1) * (box->y2 - box->y1);
+        box++;
+    }
+    return area;
+}
+
+/* what walking the region costs, in the units damage coalescing uses */
+static int64_t
+region_cost(RegionPtr region)
+{
+    return region_area(region) +
+        (int64_t) RegionNumRects(region) * DAMAGE_BOX_COST;
+}
+
+static double
+shadow_update(RegionPtr damage)
+{
+    double start = now();
+    int r, n, y;
+    BoxPtr box;
+
+    for (r = 0; r < ROUNDS; r++) {
+        box = RegionRects(damage);
+        for (n = RegionNumRects(damage); n--; box++)
+            for (y = box->y1; y < box->y2; y++)
+                memcpy(fb + y * WIDTH + box->x1, shadow + y * WIDTH + box->x1,
+                       (box->x2 - box->x1) * sizeof(uint32_t));
+    }
+    return (now() - start) / ROUNDS;
+}
+
+static void
+bench(const char *name, void (*build)(RegionPtr damage))
+{
+    RegionRec exact, coalesced, missing;
+    double t_exact, t_coalesced, t_coalesce;
+    int r;
+
+    RegionNull(&exact);
+    build(&exact);
+
+    RegionNull(&coalesced);
+    t_coalesce = now();
+    for (r = 0; r < ROUNDS; r++) {
+        RegionCopy(&coalesced, &exact);
+        damageCoalesceRegion(&coalesced);
+    }
+    t_coalesce = (now() - t_coalesce) / ROUNDS;
+
+    RegionNull(&missing);
+    RegionSubtract(&missing, &exact, &coalesced);
+    if (RegionNotEmpty(&missing) ||
+        region_cost(&coalesced) > region_cost(&exact))
+        FatalError("%s: coalesced region is wrong\n", name);
+
+    t_exact = shadow_update(&exact);
+    t_coalesced = shadow_update(&coalesced);
+
+    printf("%-10s exact %5d boxes %8lld px %7.1f us, "
+           "coalesced %3d boxes %8lld px %7.1f us (+%5.1f us to coalesce)\n",
+           name, RegionNumRects(&exact), (long long) region_area(&exact),
+           t_exact * 1e6, RegionNumRects(&coalesced),
+           (long long) region_area(&coalesced), t_coalesced * 1e6,
+           t_coalesce * 1e6);
+
+    RegionUninit(&exact);
+    RegionUninit(&coalesced);
+    RegionUninit(&missing);
+}
+
+static void
+terminal(RegionPtr damage)
+{
+    text_damage(damage, 80);
+}
+
+static void
+editor(RegionPtr damage)
+{
+    text_damage(damage, WIDTH / 9);
+}
+
+int
+main(int argc, char **argv)
+{
+    bench("terminal", terminal);
+    bench("editor", editor);
+    bench("scattered", scattered_damage);
+    return 0;
+}
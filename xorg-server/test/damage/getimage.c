@@ -0,0 +1,394 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Tests for DamageGetImage: the offset and size of the shared memory
+ * range are checked against the segment, damage that does not fit is
+ * left for the next request, and with a tile size set, tiles whose
+ * contents did not change since they were last returned are left out.
+ *
+ * xcb has no binding for the request, so it is sent by hand.
+ */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+#include <xcb/damage.h>
+#include <xcb/shm.h>
+
+#define WIDTH 64
+#define HEIGHT 64
+#define SEG_SIZE (WIDTH * HEIGHT * 4)
+
+/* Request number private to this server, see damageextint.h */
+#define X_DamageGetImage 128
+
+struct damage_get_image_req {
+    uint8_t major_opcode;
+    uint8_t minor_opcode;
+    uint16_t length;
+    uint32_t damage;
+    uint32_t shmseg;
+    uint32_t offset;
+    uint32_t size;
+    uint16_t tile_size;
+    uint16_t pad;
+};
+
+struct damage_get_image_reply {
+    uint8_t response_type;
+    uint8_t depth;
+    uint16_t sequence;
+    uint32_t length;
+    uint32_t visual;
+    uint32_t size;
+    uint32_t n_rects;
+    uint8_t more;
+    uint8_t pad1;
+    uint16_t pad2;
+    uint32_t pad3;
+    uint32_t pad4;
+};
+
+struct test_setup {
+    xcb_connection_t *c;
+    xcb_screen_t *screen;
+    xcb_pixmap_t pixmap;
+    xcb_gc_t gc;
+    xcb_damage_damage_t damage;
+    xcb_shm_seg_t shmseg;
+    uint32_t *shm;
+};
+
+/**
+ * Sends a DamageGetImage request, returning the reply or, in *error,
+ * the error it caused.
+ */
+static struct damage_get_image_reply *
+damage_get_image(struct test_setup *setup, xcb_shm_seg_t shmseg,
+                 uint32_t offset, uint32_t size, uint16_t tile_size,
+                 xcb_generic_error_t **error)
+{
+    static const xcb_protocol_request_t xcb_req = {
+        .count = 1,
+        .ext = &xcb_damage_id,
+        .opcode = X_DamageGetImage,
+        .isvoid = 0,
+    };
+    struct damage_get_image_req req = {
+        .damage = setup->damage,
+        .shmseg = shmseg,
+        .offset = offset,
+        .size = size,
+        .tile_size = tile_size,
+    };
+    struct iovec parts[3];
+    unsigned int sequence;
+
+    parts[2].iov_base = &req;
+    parts[2].iov_len = sizeof(req);
+    sequence = xcb_send_request(setup->c, XCB_REQUEST_CHECKED, parts + 2,
+                                &xcb_req);
+    *error = NULL;
+    return xcb_wait_for_reply(setup->c, sequence, error);
+}
+
+static xcb_rectangle_t *
+reply_rects(struct damage_get_image_reply *reply)
+{
+    return (xcb_rectangle_t *) (reply + 1);
+}
+
+/** Expects DamageGetImage to fail with the given error code. */
+static void
+expect_error(struct test_setup *setup, xcb_shm_seg_t shmseg,
+             uint32_t offset, uint32_t size, uint16_t tile_size,
+             uint8_t error_code)
+{
+    xcb_generic_error_t *error;
+    struct damage_get_image_reply *reply =
+        damage_get_image(setup, shmseg, offset, size, tile_size, &error);
+
+    assert(!reply);
+    assert(error);
+    if (error_code)
+        assert(error->error_code == error_code);
+    free(error);
+}
+
+/** Expects DamageGetImage to succeed, returning its reply. */
+static struct damage_get_image_reply *
+expect_reply(struct test_setup *setup, uint32_t offset, uint32_t size,
+             uint16_t tile_size)
+{
+    xcb_generic_error_t *error;
+    struct damage_get_image_reply *reply =
+        damage_get_image(setup, setup->shmseg, offset, size, tile_size,
+                         &error);
+
+    assert(!error);
+    assert(reply);
+    assert(reply->length * 4 == reply->n_rects * sizeof(xcb_rectangle_t));
+    return reply;
+}
+
+static void
+fill(struct test_setup *setup, uint32_t color, int16_t x, int16_t y,
+     uint16_t width, uint16_t height)
+{
+    xcb_rectangle_t rect = { x, y, width, height };
+
+    xcb_change_gc(setup->c, setup->gc, XCB_GC_FOREGROUND, &color);
+    xcb_poly_fill_rectangle(setup->c, setup->pixmap, setup->gc, 1, &rect);
+}
+
+/** Reads out and drops whatever damage is left. */
+static void
+drain(struct test_setup *setup)
+{
+    struct damage_get_image_reply *reply;
+
+    reply = expect_reply(setup, 0, SEG_SIZE, 0);
+    assert(!reply->more);
+    free(reply);
+    reply = expect_reply(setup, 0, SEG_SIZE, 0);
+    assert(reply->n_rects == 0);
+    free(reply);
+}
+
+static void
+test_bounds(struct test_setup *setup)
+{
+    struct damage_get_image_reply *reply;
+
+    fill(setup, 0x112233, 0, 0, WIDTH, HEIGHT);
+
+    /* offset has to be aligned and inside the segment */
+    expect_error(setup, setup->shmseg, 2, 4, 0, XCB_VALUE);
+    expect_error(setup, setup->shmseg, SEG_SIZE + 4, 0, 0, XCB_VALUE);
+    expect_error(setup, setup->shmseg, 0xfffffffc, 0, 0, XCB_VALUE);
+
+    /* and so has offset + size, without wrapping around */
+    expect_error(setup, setup->shmseg, 0, SEG_SIZE + 4, 0, XCB_ACCESS);
+    expect_error(setup, setup->shmseg, 4, SEG_SIZE, 0, XCB_ACCESS);
+    expect_error(setup, setup->shmseg, 4, 0xfffffffc, 0, XCB_ACCESS);
+    expect_error(setup, setup->shmseg, SEG_SIZE, 4, 0, XCB_ACCESS);
+
+    /* tiny tiles are refused */
+    expect_error(setup, setup->shmseg, 0, SEG_SIZE, 1, XCB_VALUE);
+    expect_error(setup, setup->shmseg, 0, SEG_SIZE, 7, XCB_VALUE);
+
+    /* unknown segment, BadShmSeg */
+    expect_error(setup, xcb_generate_id(setup->c), 0, SEG_SIZE, 0, 0);
+
+    /* An empty range at the very end is fine, nothing fits in it */
+    reply = expect_reply(setup, SEG_SIZE, 0, 0);
+    assert(reply->n_rects == 0);
+    assert(reply->size == 0);
+    assert(reply->more);
+    free(reply);
+
+    /* None of the above consumed any damage */
+    reply = expect_reply(setup, 0, SEG_SIZE, 0);
+    assert(reply->n_rects == 1);
+    assert(reply->size == SEG_SIZE);
+    assert(!reply->more);
+    free(reply);
+}
+
+static void
+test_copy(struct test_setup *setup)
+{
+    struct damage_get_image_reply *reply;
+    xcb_rectangle_t *rects;
+
+    /* Two bands of damage, only the first fits the range */
+    fill(setup, 0x445566, 0, 0, WIDTH, 32);
+    fill(setup, 0x778899, 0, 40, WIDTH, 8);
+    memset(setup->shm, 0, SEG_SIZE);
+
+    reply = expect_reply(setup, 4, WIDTH * 32 * 4, 0);
+    assert(reply->n_rects == 1);
+    assert(reply->size == WIDTH * 32 * 4);
+    assert(reply->more);
+    rects = reply_rects(reply);
+    assert(rects[0].x == 0 && rects[0].y == 0);
+    assert(rects[0].width == WIDTH && rects[0].height == 32);
+    assert(setup->shm[0] == 0);
+    for (int i = 0; i < WIDTH * 32; i++)
+        assert((setup->shm[1 + i] & 0xffffff) == 0x445566);
+    assert(setup->shm[1 + WIDTH * 32] == 0);
+    free(reply);
+
+    /* The rest stayed damaged */
+    reply = expect_reply(setup, 0, SEG_SIZE, 0);
+    assert(reply->n_rects == 1);
+    assert(!reply->more);
+    rects = reply_rects(reply);
+    assert(rects[0].x == 0 && rects[0].y == 40);
+    assert(rects[0].width == WIDTH && rects[0].height == 8);
+    for (int i = 0; i < WIDTH * 8; i++)
+        assert((setup->shm[i] & 0xffffff) == 0x778899);
+    free(reply);
+
+    /* And now nothing is */
+    reply = expect_reply(setup, 0, SEG_SIZE, 0);
+    assert(reply->n_rects == 0);
+    assert(reply->size == 0);
+    assert(!reply->more);
+    free(reply);
+}
+
+static void
+test_tiles(struct test_setup *setup)
+{
+    struct damage_get_image_reply *reply;
+    xcb_rectangle_t *rects;
+
+    /* The first time round every damaged tile is returned */
+    fill(setup, 0xaabbcc, 0, 0, WIDTH, HEIGHT);
+    reply = expect_reply(setup, 0, SEG_SIZE, 16);
+    assert(reply->n_rects == (WIDTH / 16) * (HEIGHT / 16));
+    assert(reply->size == SEG_SIZE);
+    assert(!reply->more);
+    free(reply);
+
+    /* Drawing the same contents again leaves every tile unchanged */
+    fill(setup, 0xaabbcc, 0, 0, WIDTH, HEIGHT);
+    reply = expect_reply(setup, 0, SEG_SIZE, 16);
+    assert(reply->n_rects == 0);
+    assert(reply->size == 0);
+    assert(!reply->more);
+    free(reply);
+
+    /* but the unchanged tiles are no longer damaged */
+    reply = expect_reply(setup, 0, SEG_SIZE, 0);
+    assert(reply->n_rects == 0);
+    free(reply);
+
+    /* A changed pixel returns its tile, rounded out to the grid */
+    fill(setup, 0x010203, 20, 21, 1, 1);
+    reply = expect_reply(setup, 0, SEG_SIZE, 16);
+    assert(reply->n_rects == 1);
+    assert(reply->size == 16 * 16 * 4);
+    rects = reply_rects(reply);
+    assert(rects[0].x == 16 && rects[0].y == 16);
+    assert(rects[0].width == 16 && rects[0].height == 16);
+    assert((setup->shm[5 * 16 + 4] & 0xffffff) == 0x010203);
+    assert((setup->shm[0] & 0xffffff) == 0xaabbcc);
+    free(reply);
+
+    /* Damage over changed and unchanged tiles only returns the changed */
+    fill(setup, 0xaabbcc, 0, 0, WIDTH, HEIGHT);
+    reply = expect_reply(setup, 0, SEG_SIZE, 16);
+    assert(reply->n_rects == 1);
+    rects = reply_rects(reply);
+    assert(rects[0].x == 16 && rects[0].y == 16);
+    free(reply);
+
+    /* A different tile size starts over */
+    fill(setup, 0xaabbcc, 0, 0, WIDTH, HEIGHT);
+    reply = expect_reply(setup, 0, SEG_SIZE, 32);
+    assert(reply->n_rects == (WIDTH / 32) * (HEIGHT / 32));
+    free(reply);
+
+    drain(setup);
+}
+
+int main(int argc, char **argv)
+{
+    int screen, shmid;
+    xcb_connection_t *c = xcb_connect(NULL, &screen);
+    const xcb_query_extension_reply_t *damage_ext =
+        xcb_get_extension_data(c, &xcb_damage_id);
+    const xcb_query_extension_reply_t *shm_ext =
+        xcb_get_extension_data(c, &xcb_shm_id);
+    xcb_damage_query_version_reply_t *version;
+    xcb_generic_error_t *error;
+    xcb_screen_iterator_t iter;
+    struct test_setup setup = { .c = c };
+
+    if (!damage_ext->present || !shm_ext->present) {
+        printf("No XDamage or MIT-SHM present\n");
+        exit(77);
+    }
+
+    version = xcb_damage_query_version_reply(c,
+                  xcb_damage_query_version(c, 1, 1), NULL);
+    assert(version);
+    free(version);
+
+    shmid = shmget(IPC_PRIVATE, SEG_SIZE, IPC_CREAT | 0600);
+    assert(shmid != -1);
+    setup.shm = shmat(shmid, NULL, 0);
+    shmctl(shmid, IPC_RMID, NULL);
+    assert(setup.shm != (void *) -1);
+
+    iter = xcb_setup_roots_iterator(xcb_get_setup(c));
+    setup.screen = iter.data;
+    assert(setup.screen->root_depth == 24);
+
+    setup.shmseg = xcb_generate_id(c);
+    xcb_shm_attach(c, setup.shmseg, shmid, 0);
+
+    setup.pixmap = xcb_generate_id(c);
+    xcb_create_pixmap(c, setup.screen->root_depth, setup.pixmap,
+                      setup.screen->root, WIDTH, HEIGHT);
+    setup.gc = xcb_generate_id(c);
+    xcb_create_gc(c, setup.gc, setup.pixmap, 0, NULL);
+
+    setup.damage = xcb_generate_id(c);
+    xcb_damage_create(c, setup.damage, setup.pixmap,
+                      XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+
+    /* Other servers do not know the request */
+    free(damage_get_image(&setup, 0, 0, 0, 0, &error));
+    assert(error);
+    if (error->error_code == XCB_REQUEST) {
+        printf("No DamageGetImage\n");
+        exit(77);
+    }
+    free(error);
+
+    test_bounds(&setup);
+    test_copy(&setup);
+    test_tiles(&setup);
+
+    xcb_damage_destroy(c, setup.damage);
+    xcb_shm_detach(c, setup.shmseg);
+    shmdt(setup.shm);
+    xcb_disconnect(c);
+    return 0;
+}
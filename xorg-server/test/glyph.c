@@ -0,0 +1,206 @@
+/**
+ * Copyright © 2026 The X.Org Foundation
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including the next
+ *  paragraph) shall be included in all copies or substantial portions of the
+ *  Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+/*
+ * The render glyph cache: PackBits encoding of evicted glyph bits, and a
+ * glyph going through eviction and being realized again.  There are no
+ * screens, so the glyph has no pictures and only the cache state and the
+ * packed bits are looked at.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "servermd.h"
+#include "glyphstr_priv.h"
+#include "picturestr.h"
+#include "scrnintstr.h"
+
+#include "tests-common.h"
+
+/* Packs size bytes of src, checks the size of the result and unpacks it */
+static void
+pack_and_unpack(const CARD8 *src, int size)
+{
+    CARD8 *packed = malloc(size + size / 128 + 1);
+    CARD8 *dst = malloc(size + 1);
+    int len;
+
+    assert(packed && dst);
+    len = GlyphPackBits(src, size, packed);
+    assert(len <= size + size / 128 + 1);
+
+    dst[size] = 0xa5;
+    GlyphUnpackBits(packed, dst, size);
+    assert(memcmp(src, dst, size) == 0);
+    assert(dst[size] == 0xa5);
+
+    free(dst);
+    free(packed);
+}
+
+static void
+glyph_packbits(void)
+{
+    CARD8 bits[1000];
+    int i, size, run, seed;
+
+    /* empty, single bytes and long runs across the 128 byte limit */
+    memset(bits, 0, sizeof(bits));
+    pack_and_unpack(bits, 0);
+    pack_and_unpack(bits, 1);
+    pack_and_unpack(bits, 2);
+    pack_and_unpack(bits, 3);
+    pack_and_unpack(bits, 128);
+    pack_and_unpack(bits, 129);
+    pack_and_unpack(bits, sizeof(bits));
+
+    /* a run compresses */
+    {
+        CARD8 packed[16];
+
+        assert(GlyphPackBits(bits, 100, packed) == 2);
+    }
+
+    /* no repeats at all, literals across the 128 byte limit */
+    for (i = 0; i < sizeof(bits); i++)
+        bits[i] = i * 7 + (i >> 8);
+    for (size = 126; size < 260; size++)
+        pack_and_unpack(bits, size);
+
+    /* runs of every length up to past the limit between literals */
+    for (run = 1; run < 140; run++) {
+        for (i = 0; i < sizeof(bits); i++)
+            bits[i] = (i % (run + 3)) < run ? 0x80 : i;
+        pack_and_unpack(bits, sizeof(bits));
+    }
+
+    /* random bytes from a small alphabet, to get short runs everywhere */
+    for (seed = 1; seed < 50; seed++) {
+        srand(seed);
+        for (i = 0; i < sizeof(bits); i++)
+            bits[i] = rand() % (1 + seed % 4) ? 0 : rand();
+        pack_and_unpack(bits, 1 + rand() % sizeof(bits));
+    }
+}
+
+static void
+glyph_evict_restore(void)
+{
+    static PictFormatRec format = {
+        .depth = 8,
+        .format = PICT_a8,
+    };
+    xGlyphInfo gi = {
+        .width = 13,
+        .height = 7,
+    };
+    GlyphCacheStatsRec before, stats;
+    CARD8 bits[16 * 7], unpacked[16 * 7];
+    GlyphPtr glyph;
+    int i;
+
+    /* depth 8 scanlines padded to 32 bits, so 16 bytes for 13 pixels */
+    PixmapWidthPaddingInfo[8].padRoundUp = 3;
+    PixmapWidthPaddingInfo[8].padPixelsLog2 = 2;
+    PixmapWidthPaddingInfo[8].padBytesLog2 = 2;
+    PixmapWidthPaddingInfo[8].bitsPerPixel = 8;
+    assert(PixmapBytePad(gi.width, 8) == 16);
+
+    for (i = 0; i < sizeof(bits); i++)
+        bits[i] = (i % 16) < gi.width && (i / 16) % 3 ? i : 0;
+
+    screenInfo.numScreens = 0;
+    GetGlyphCacheStats(&before);
+
+    glyph = AllocateGlyph(&gi, GlyphFormat8);
+    assert(glyph);
+    assert(CreateGlyphPictures(glyph, &format, bits) == Success);
+    GetGlyphCacheStats(&stats);
+    assert(stats.glyphs == before.glyphs + 1);
+
+    /* drawing a realized glyph is a hit */
+    assert(GlyphCacheUse(glyph));
+    GetGlyphCacheStats(&stats);
+    assert(stats.hits == before.hits + 1);
+    assert(stats.misses == before.misses);
+
+    assert(GlyphCachePack(glyph, bits));
+    GetGlyphCacheStats(&stats);
+    assert(stats.glyphs == before.glyphs);
+    assert(stats.evicted == before.evicted + 1);
+    assert(stats.evictions == before.evictions + 1);
+    assert(stats.bytes == before.bytes);
+
+    /* an evicted glyph is not evicted again */
+    assert(!GlyphCachePack(glyph, bits));
+
+    memset(unpacked, 0xff, sizeof(unpacked));
+    GlyphUnpackBits(GlyphCache(glyph)->packed, unpacked, sizeof(unpacked));
+    assert(memcmp(bits, unpacked, sizeof(bits)) == 0);
+
+    /* drawing it again realizes it */
+    assert(GlyphCacheUse(glyph));
+    assert(!GlyphCache(glyph)->packed);
+    GetGlyphCacheStats(&stats);
+    assert(stats.misses == before.misses + 1);
+    assert(stats.glyphs == before.glyphs + 1);
+    assert(stats.evicted == before.evicted);
+
+    /* and it can go round again */
+    assert(GlyphCachePack(glyph, bits));
+    assert(GlyphCacheUse(glyph));
+
+    DiscardGlyph(glyph);
+    GetGlyphCacheStats(&stats);
+    assert(stats.glyphs == before.glyphs);
+    assert(stats.evicted == before.evicted);
+    assert(stats.bytes == before.bytes);
+
+    /* an evicted glyph can be freed too */
+    glyph = AllocateGlyph(&gi, GlyphFormat8);
+    assert(glyph);
+    assert(CreateGlyphPictures(glyph, &format, bits) == Success);
+    assert(GlyphCachePack(glyph, bits));
+    DiscardGlyph(glyph);
+    GetGlyphCacheStats(&stats);
+    assert(stats.glyphs == before.glyphs);
+    assert(stats.evicted == before.evicted);
+}
+
+const testfunc_t*
+glyph_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        glyph_packbits,
+        glyph_evict_restore,
+        NULL,
+    };
+    return testfuncs;
+}
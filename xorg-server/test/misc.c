@@ -27,6 +27,9 @@
 #include <dix-config.h>
 
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <X11/Xatom.h>
 
 #include "dix/input_priv.h"
 #include "os/fmt.h"
@@ -224,6 +227,46 @@ bswap_test(void)
     assert(result_64 == expect_64);
 }
 
+static void
+dix_atoms(void)
+{
+    char name[32];
+    Atom atom, first = None;
+    int i;
+
+    InitAtoms();
+    assert(MakeAtom("PRIMARY", 7, FALSE) == XA_PRIMARY);
+    assert(strcmp(NameForAtom(XA_WM_NAME), "WM_NAME") == 0);
+    assert(MakeAtom("PRIMARY_", 8, FALSE) == None);
+    assert(MakeAtom("PRIM", 4, FALSE) == None);
+    assert(!ValidAtom(None));
+    assert(NameForAtom(XA_LAST_PREDEFINED + 1) == NULL);
+
+    /* enough to replace the initial tables a few times */
+    for (i = 0; i < 20000; i++) {
+        snprintf(name, sizeof(name), "_TEST_ATOM_%d", i);
+        atom = MakeAtom(name, strlen(name), TRUE);
+        assert(atom > XA_LAST_PREDEFINED);
+        if (!first)
+            first = atom;
+        assert(atom == first + i);
+    }
+    for (i = 0; i < 20000; i++) {
+        snprintf(name, sizeof(name), "_TEST_ATOM_%d", i);
+        assert(MakeAtom(name, strlen(name), FALSE) == first + i);
+        assert(strcmp(NameForAtom(first + i), name) == 0);
+        assert(ValidAtom(first + i));
+    }
+    assert(!ValidAtom(first + i));
+
+    /* names are compared by length, not up to the first NUL */
+    atom = MakeAtom("_TEST_ATOM_1x", 12, FALSE);
+    assert(atom == first + 1);
+
+    FreeAllAtoms();
+    assert(!ValidAtom(XA_PRIMARY));
+}
+
 const testfunc_t*
 misc_test(void)
 {
@@ -232,6 +275,7 @@ misc_test(void)
         dix_update_desktop_dimensions,
         dix_request_size_checks,
         bswap_test,
+        dix_atoms,
         NULL,
     };
     return testfuncs;
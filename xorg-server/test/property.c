@@ -0,0 +1,279 @@
+/**
+ * Copyright © 2026 The X.Org Foundation
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including the next
+ *  paragraph) shall be included in all copies or substantial portions of the
+ *  Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+/*
+ * Window property values: appending and prepending, their size checks,
+ * and large GetProperty replies queued by reference to the value.
+ *
+ * WriteToClient and WriteToClientRef are wrapped to see what a reply
+ * would send; a value queued by reference is held until the test
+ * releases it, as the output code would once it has been written.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xatom.h>
+#include <X11/Xproto.h>
+
+#include "dix/property_priv.h"
+
+#include "windowstr.h"
+#include "propertyst.h"
+#include "dispatch.h"
+#include "protocol-common.h"
+
+DECLARE_WRAP_FUNCTION(WriteToClient, void, ClientPtr client, int len, void *data);
+DECLARE_WRAP_FUNCTION(WriteToClientRef, int, ClientPtr client, int count,
+                      const void *buf, OutputReleaseProcPtr release,
+                      void *closure);
+
+WRAP_FUNCTION(WriteToClientRef, int, ClientPtr client, int count,
+              const void *buf, OutputReleaseProcPtr release, void *closure)
+{
+    IMPLEMENT_WRAP_FUNCTION_WITH_RETURN(WriteToClientRef, client, count, buf,
+                                        release, closure);
+}
+
+static struct {
+    int copied;                 /* bytes written by WriteToClient */
+    const void *buf;            /* value queued by reference */
+    int count;
+    OutputReleaseProcPtr release;
+    void *closure;
+} written;
+
+static void
+record_write(ClientPtr client, int len, void *data)
+{
+    written.copied += len;
+}
+
+static int
+record_write_ref(ClientPtr client, int count, const void *buf,
+                 OutputReleaseProcPtr release, void *closure)
+{
+    assert(!written.release);
+    written.buf = buf;
+    written.count = count;
+    written.release = release;
+    written.closure = closure;
+    return 0;
+}
+
+static PropertyPtr
+lookup(Atom name)
+{
+    ClientRec client = init_client(0, NULL);
+    PropertyPtr pProp;
+
+    if (dixLookupProperty(&pProp, &window, name, &client,
+                          DixReadAccess) != Success)
+        return NULL;
+    return pProp;
+}
+
+static int
+change(Atom name, int format, int mode, unsigned long len, const void *value)
+{
+    ClientRec client = init_client(0, NULL);
+
+    return dixChangeWindowProperty(&client, &window, name, XA_INTEGER,
+                                   format, mode, len, value, FALSE);
+}
+
+static void
+test_append_prepend(void)
+{
+    Atom name;
+    CARD32 first[] = { 1, 2 }, tail[] = { 3, 4 }, head[] = { 0 };
+    PropertyPtr pProp;
+    CARD32 *data;
+
+    init_simple();
+    name = MakeAtom("TEST_APPEND", strlen("TEST_APPEND"), TRUE);
+    assert(change(name, 32, PropModeReplace, 2, first) == Success);
+
+    assert(change(name, 32, PropModeAppend, 2, tail) == Success);
+    pProp = lookup(name);
+    assert(pProp->size == 4);
+    data = pProp->data;
+    assert(data[0] == 1 && data[1] == 2 && data[2] == 3 && data[3] == 4);
+
+    assert(change(name, 32, PropModePrepend, 1, head) == Success);
+    pProp = lookup(name);
+    assert(pProp->size == 5);
+    data = pProp->data;
+    for (int i = 0; i < 5; i++)
+        assert(data[i] == i);
+
+    /* nothing to add */
+    assert(change(name, 32, PropModeAppend, 0, NULL) == Success);
+    assert(change(name, 32, PropModePrepend, 0, NULL) == Success);
+    assert(lookup(name)->size == 5);
+
+    /* the format has to match */
+    assert(change(name, 8, PropModeAppend, 1, tail) == BadMatch);
+    assert(lookup(name)->size == 5);
+}
+
+static void
+test_append_prepend_overflow(void)
+{
+    Atom name;
+    CARD32 value[] = { 1, 2 };
+    PropertyPtr pProp;
+
+    init_simple();
+    name = MakeAtom("TEST_OVERFLOW", strlen("TEST_OVERFLOW"), TRUE);
+    assert(change(name, 32, PropModeReplace, 2, value) == Success);
+    pProp = lookup(name);
+
+    /* The element count itself wraps around */
+    assert(change(name, 32, PropModeAppend, ULONG_MAX - 1, value) ==
+           BadAlloc);
+    assert(change(name, 32, PropModePrepend, ULONG_MAX, value) == BadAlloc);
+
+    /* Beyond this the values below would fit in size_t, be allocated
+     * and then read past the end of value */
+    if (sizeof(unsigned long) < sizeof(size_t))
+        return;
+
+    /* The byte count wraps around */
+    assert(change(name, 32, PropModeAppend, ULONG_MAX / 4, value) ==
+           BadAlloc);
+    assert(change(name, 32, PropModePrepend, ULONG_MAX / 2, value) ==
+           BadAlloc);
+
+    /* The byte count only wraps with the value header added */
+    assert(change(name, 8, PropModeReplace, 2, value) == Success);
+    assert(change(name, 8, PropModeAppend, ULONG_MAX - 3, value) ==
+           BadAlloc);
+    assert(change(name, 8, PropModePrepend, ULONG_MAX - 3, value) ==
+           BadAlloc);
+
+    /* and nothing was touched */
+    assert(lookup(name) == pProp);
+    assert(pProp->size == 2);
+    assert(((CARD8 *) pProp->data)[0] == ((CARD8 *) value)[0]);
+}
+
+static int
+get_property(Atom name, CARD32 offset, CARD32 length, Bool swapped)
+{
+    xGetPropertyReq req = {
+        .reqType = X_GetProperty,
+        .delete = xFalse,
+        .length = sz_xGetPropertyReq >> 2,
+        .window = CLIENT_WINDOW_ID,
+        .property = name,
+        .type = AnyPropertyType,
+        .longOffset = offset,
+        .longLength = length,
+    };
+    ClientRec client = init_client(req.length, &req);
+
+    client.swapped = swapped;
+    written.copied = 0;
+    return ProcGetProperty(&client);
+}
+
+static void
+test_get_property_ref(void)
+{
+    Atom name;
+    static CARD8 value[8192], other[8192];
+    PropertyPtr pProp;
+
+    init_simple();
+    name = MakeAtom("TEST_REF", strlen("TEST_REF"), TRUE);
+    for (int i = 0; i < sizeof(value); i++) {
+        value[i] = i;
+        other[i] = ~i;
+    }
+
+    wrapped_WriteToClient = record_write;
+    wrapped_WriteToClientRef = record_write_ref;
+
+    /* Small values are copied into the reply */
+    assert(change(name, 8, PropModeReplace, 100, value) == Success);
+    assert(get_property(name, 0, 100, FALSE) == Success);
+    assert(!written.release);
+    assert(written.copied == sizeof(xGetPropertyReply) + 100);
+
+    /* Large ones are queued by reference, from the requested offset */
+    assert(change(name, 8, PropModeReplace, sizeof(value), value) == Success);
+    pProp = lookup(name);
+    assert(get_property(name, 1, sizeof(value) / 4, FALSE) == Success);
+    assert(written.copied == sizeof(xGetPropertyReply));
+    assert(written.release);
+    assert(written.buf == (CARD8 *) pProp->data + 4);
+    assert(written.count == sizeof(value) - 4);
+
+    /* The value outlives the property changing or going away before the
+     * reply is written */
+    assert(change(name, 8, PropModeReplace, sizeof(other), other) == Success);
+    assert(lookup(name)->data != written.buf);
+    assert(memcmp(written.buf, value + 4, written.count) == 0);
+    assert(change(name, 8, PropModeAppend, sizeof(other), other) == Success);
+    assert(memcmp(written.buf, value + 4, written.count) == 0);
+    written.release(written.closure);
+    written.release = NULL;
+
+    /* Once written, a value that has not changed stays around */
+    assert(get_property(name, 0, sizeof(other) / 4, FALSE) == Success);
+    assert(written.release);
+    pProp = lookup(name);
+    assert(written.buf == pProp->data);
+    written.release(written.closure);
+    written.release = NULL;
+    assert(memcmp(pProp->data, other, sizeof(other)) == 0);
+
+    /* Values that have to be swapped are copied */
+    assert(change(name, 32, PropModeReplace, sizeof(value) / 4, value) ==
+           Success);
+    assert(get_property(name, 0, sizeof(value) / 4, TRUE) == Success);
+    assert(!written.release);
+    assert(written.copied == sizeof(xGetPropertyReply) + sizeof(value));
+
+    wrapped_WriteToClient = NULL;
+    wrapped_WriteToClientRef = NULL;
+}
+
+const testfunc_t*
+property_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        test_append_prepend,
+        test_append_prepend_overflow,
+        test_get_property_ref,
+        NULL,
+    };
+    return testfuncs;
+}
@@ -0,0 +1,464 @@
+/**
+ * Copyright © 2026 The X.Org Foundation
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including the next
+ *  paragraph) shall be included in all copies or substantial portions of the
+ *  Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+/*
+ * The shared memory ring RECORD reports into: replies wrapping around
+ * the end of the ring, headers written in pieces, replies dropped while
+ * the ring is full, and the reference held on the segment.
+ *
+ * The test plays the recording client, consuming replies from the ring
+ * and advancing its tail.  ShmReleaseSegment is wrapped, the segment is
+ * plain memory.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+
+#include "misc.h"
+#include "record/shmring.h"
+
+#include "tests.h"
+
+#ifdef MITSHM
+
+#define RING_DATA 128           /* bytes of ring data in the segment */
+#define RING_OFFSET 64          /* where in the segment the ring is */
+
+DECLARE_WRAP_FUNCTION(ShmReleaseSegment, void, ShmDescPtr shmdesc);
+
+WRAP_FUNCTION(ShmReleaseSegment, void, ShmDescPtr shmdesc)
+{
+    IMPLEMENT_WRAP_FUNCTION(ShmReleaseSegment, shmdesc);
+}
+
+static int released;
+
+static void
+release_segment(ShmDescPtr shmdesc)
+{
+    shmdesc->refcnt--;
+    released++;
+}
+
+static ShmDescPtr
+create_segment(void)
+{
+    ShmDescPtr shmdesc = calloc(1, sizeof(ShmDescRec));
+
+    assert(shmdesc);
+    shmdesc->size = RING_OFFSET + sz_xRecordShmRing + RING_DATA;
+    shmdesc->addr = malloc(shmdesc->size);
+    assert(shmdesc->addr);
+    memset(shmdesc->addr, 0xaa, shmdesc->size);
+    shmdesc->writable = TRUE;
+    shmdesc->refcnt = 1;
+    return shmdesc;
+}
+
+static void
+destroy_segment(ShmDescPtr shmdesc)
+{
+    free(shmdesc->addr);
+    free(shmdesc);
+    wrapped_ShmReleaseSegment = NULL;
+}
+
+static void
+attach(RecordShmRingPtr pRing, ShmDescPtr shmdesc, Bool swapped)
+{
+    wrapped_ShmReleaseSegment = release_segment;
+    memset(pRing, 0, sizeof(*pRing));
+    RecordShmRingAttach(pRing, shmdesc, RING_OFFSET,
+                        sz_xRecordShmRing + RING_DATA, swapped);
+}
+
+/* A reply with nwords of data, each byte of which is fill */
+static char *
+make_reply(int nwords, char fill, Bool swapped, int *len)
+{
+    char *reply;
+    xRecordEnableContextReply *rep;
+
+    *len = sz_xRecordEnableContextReply + nwords * 4;
+    reply = malloc(*len);
+    assert(reply);
+    memset(reply, fill, *len);
+    rep = (xRecordEnableContextReply *) reply;
+    rep->type = X_Reply;
+    rep->length = nwords;
+    if (swapped)
+        swapl(&rep->length);
+    return reply;
+}
+
+/* Take the next reply out of the ring, as the recording client would */
+static int
+consume(RecordShmRingPtr pRing, char *buf, int buflen, Bool swapped)
+{
+    xRecordShmRing *ring = pRing->ring;
+    CARD32 length;
+    int len;
+
+    if (ring->head == ring->tail)
+        return 0;
+    for (int i = 0; i < sz_xRecordEnableContextReply; i++)
+        buf[i] = pRing->data[(CARD32) (ring->tail + i) % RING_DATA];
+    length = ((xRecordEnableContextReply *) buf)->length;
+    if (swapped)
+        swapl(&length);
+    len = sz_xRecordEnableContextReply + length * 4;
+    assert(len <= buflen);
+    assert(ring->head - ring->tail >= len);
+    for (int i = sz_xRecordEnableContextReply; i < len; i++)
+        buf[i] = pRing->data[(CARD32) (ring->tail + i) % RING_DATA];
+    ring->tail += len;
+    return len;
+}
+
+static void
+test_wrap_around(void)
+{
+    ShmDescPtr shmdesc = create_segment();
+    RecordShmRingRec ring;
+    char buf[RING_DATA];
+
+    attach(&ring, shmdesc, FALSE);
+    assert(ring.ring->head == 0 && ring.ring->tail == 0);
+    assert(ring.ring->sequence == 0 && ring.ring->lost == 0);
+
+    /* 48 byte replies start at every multiple of 16 as the ring wraps,
+     * some of them are split across its end */
+    for (int i = 0; i < 20; i++) {
+        int len, got;
+        char *reply = make_reply(4, 'a' + i, FALSE, &len);
+
+        RecordShmRingWrite(&ring, reply, len);
+        assert(ring.ring->head == (i + 1) * len);
+        assert(ring.ring->sequence == i + 1);
+
+        got = consume(&ring, buf, sizeof(buf), FALSE);
+        assert(got == len);
+        assert(memcmp(buf, reply, len) == 0);
+        free(reply);
+    }
+    assert(ring.ring->lost == 0);
+
+    /* The data of a reply may come in several pieces, its header in one */
+    for (int i = 0; i < 3; i++) {
+        int len;
+        char *reply = make_reply(8, 'A' + i, FALSE, &len);
+
+        RecordShmRingWrite(&ring, reply, sz_xRecordEnableContextReply + 4);
+        RecordShmRingWrite(&ring, reply + sz_xRecordEnableContextReply + 4,
+                           len - sz_xRecordEnableContextReply - 4);
+        assert(consume(&ring, buf, sizeof(buf), FALSE) == len);
+        assert(memcmp(buf, reply, len) == 0);
+        free(reply);
+    }
+    assert(ring.ring->lost == 0);
+
+    RecordShmRingDetach(&ring);
+    destroy_segment(shmdesc);
+}
+
+static void
+test_short_header(void)
+{
+    ShmDescPtr shmdesc = create_segment();
+    RecordShmRingRec ring;
+    char buf[RING_DATA], stream[2 * RING_DATA];
+    int len1, len2, len3;
+    char *reply1 = make_reply(2, 'x', FALSE, &len1);
+    char *reply2 = make_reply(0, 'y', FALSE, &len2);
+    char *reply3 = make_reply(5, 'z', FALSE, &len3);
+
+    memcpy(stream, reply1, len1);
+    memcpy(stream + len1, reply2, len2);
+    memcpy(stream + len1 + len2, reply3, len3);
+
+    /* Written a byte at a time, nothing is published before a reply is
+     * complete, and the header of one does not need to be whole to be
+     * written */
+    attach(&ring, shmdesc, FALSE);
+    for (int i = 0; i < len1 + len2 + len3; i++) {
+        RecordShmRingWrite(&ring, stream + i, 1);
+        if (i + 1 < len1)
+            assert(ring.ring->head == 0);
+        else if (i + 1 < len1 + len2)
+            assert(ring.ring->head == len1);
+        else if (i + 1 < len1 + len2 + len3)
+            assert(ring.ring->head == len1 + len2);
+        else
+            assert(ring.ring->head == len1 + len2 + len3);
+    }
+    assert(ring.ring->sequence == 3);
+    assert(ring.ring->lost == 0);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len1);
+    assert(memcmp(buf, reply1, len1) == 0);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len2);
+    assert(memcmp(buf, reply2, len2) == 0);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len3);
+    assert(memcmp(buf, reply3, len3) == 0);
+
+    /* A header split across two writes, the second also holding the
+     * start of the next reply */
+    RecordShmRingWrite(&ring, stream, 5);
+    assert(ring.ring->head == len1 + len2 + len3);
+    RecordShmRingWrite(&ring, stream + 5, len1 + 7);
+    assert(ring.ring->sequence == 4);
+    RecordShmRingWrite(&ring, stream + len1 + 12, len2 + len3 - 12);
+    assert(ring.ring->sequence == 6);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len1);
+    assert(memcmp(buf, reply1, len1) == 0);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len2);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len3);
+    assert(memcmp(buf, reply3, len3) == 0);
+    assert(ring.ring->lost == 0);
+
+    RecordShmRingDetach(&ring);
+    destroy_segment(shmdesc);
+    free(reply1);
+    free(reply2);
+    free(reply3);
+}
+
+static void
+test_full_ring(void)
+{
+    ShmDescPtr shmdesc = create_segment();
+    RecordShmRingRec ring;
+    char buf[RING_DATA], *reply, *small, *large;
+    int len, smalllen, largelen;
+    CARD32 head;
+
+    attach(&ring, shmdesc, FALSE);
+    reply = make_reply(8, 'f', FALSE, &len);            /* 64 bytes */
+    small = make_reply(0, 's', FALSE, &smalllen);       /* 32 bytes */
+
+    /* Fill the ring without consuming anything */
+    RecordShmRingWrite(&ring, reply, len);
+    RecordShmRingWrite(&ring, small, smalllen);
+    assert(ring.ring->head == len + smalllen);
+    head = ring.ring->head;
+
+    /* The next reply does not fit; it is dropped, counted and its data,
+     * however it is written, is skipped */
+    RecordShmRingWrite(&ring, reply, 7);
+    RecordShmRingWrite(&ring, reply + 7, len - 7);
+    assert(ring.ring->lost == 1);
+    assert(ring.ring->lostBytes == len);
+    assert(ring.ring->head == head);
+    assert(ring.ring->sequence == 2);
+
+    /* One that fits exactly still goes in */
+    RecordShmRingWrite(&ring, small, smalllen);
+    assert(ring.ring->head == RING_DATA);
+    assert(ring.ring->lost == 1);
+
+    /* Now nothing does */
+    RecordShmRingWrite(&ring, small, smalllen);
+    assert(ring.ring->lost == 2);
+    assert(ring.ring->lostBytes == len + smalllen);
+    assert(ring.ring->head == RING_DATA);
+
+    /* What was there is intact */
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len);
+    assert(memcmp(buf, reply, len) == 0);
+
+    /* Once the client has made room, replies are accepted again */
+    RecordShmRingWrite(&ring, reply, len);
+    assert(ring.ring->head == RING_DATA + len);
+    assert(ring.ring->lost == 2);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == smalllen);
+    assert(memcmp(buf, small, smalllen) == 0);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == smalllen);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == len);
+    assert(memcmp(buf, reply, len) == 0);
+
+    /* A reply larger than the whole ring never fits */
+    large = make_reply(RING_DATA / 4, 'L', FALSE, &largelen);
+    RecordShmRingWrite(&ring, large, largelen);
+    assert(ring.ring->lost == 3);
+    assert(ring.ring->lostBytes == len + smalllen + largelen);
+    assert(ring.ring->head == ring.ring->tail);
+
+    /* nor does anything while the client's tail is bogus */
+    ring.ring->tail = ring.ring->head + 4;
+    RecordShmRingWrite(&ring, small, smalllen);
+    assert(ring.ring->lost == 4);
+    ring.ring->tail = ring.ring->head;
+    RecordShmRingWrite(&ring, small, smalllen);
+    assert(ring.ring->lost == 4);
+    assert(consume(&ring, buf, sizeof(buf), FALSE) == smalllen);
+
+    RecordShmRingDetach(&ring);
+    destroy_segment(shmdesc);
+    free(reply);
+    free(small);
+    free(large);
+}
+
+static void
+test_count_wrap(void)
+{
+    ShmDescPtr shmdesc = create_segment();
+    RecordShmRingRec ring;
+    char buf[RING_DATA];
+    CARD32 start = 0xffffffff - 100;
+
+    /* Only data sizes that divide 2^32 keep positions continuous */
+    assert(RecordShmRingValidSize(sz_xRecordShmRing + RING_DATA));
+    assert(RecordShmRingValidSize(sz_xRecordShmRing + 32));
+    assert(RecordShmRingValidSize(sz_xRecordShmRing + 0x80000000));
+    assert(!RecordShmRingValidSize(sz_xRecordShmRing + 1000));
+    assert(!RecordShmRingValidSize(sz_xRecordShmRing + 96));
+    assert(!RecordShmRingValidSize(sz_xRecordShmRing + 16));
+    assert(!RecordShmRingValidSize(sz_xRecordShmRing));
+    assert(!RecordShmRingValidSize(0));
+    assert(!RecordShmRingValidSize(sz_xRecordShmRing - 1));
+
+    /* A long session: head and tail wrap past 2^32 with data still
+     * unread, and nothing is overwritten */
+    attach(&ring, shmdesc, FALSE);
+    ring.head = ring.ring->head = ring.ring->tail = start;
+    for (int i = 0; i < 12; i++) {
+        int len1, len2;
+        char *reply1 = make_reply(4, 'a' + i, FALSE, &len1);
+        char *reply2 = make_reply(3, 'A' + i, FALSE, &len2);
+
+        /* two replies in the ring at once, 76 of 128 bytes */
+        RecordShmRingWrite(&ring, reply1, len1);
+        RecordShmRingWrite(&ring, reply2, len2);
+        assert(ring.ring->head == (CARD32) (start + (i + 1) * (len1 + len2)));
+        assert(consume(&ring, buf, sizeof(buf), FALSE) == len1);
+        assert(memcmp(buf, reply1, len1) == 0);
+        assert(consume(&ring, buf, sizeof(buf), FALSE) == len2);
+        assert(memcmp(buf, reply2, len2) == 0);
+        free(reply1);
+        free(reply2);
+    }
+    assert(ring.ring->head < start);
+    assert(ring.ring->lost == 0);
+
+    /* A full ring is still full across the wrap */
+    ring.head = ring.ring->head = ring.ring->tail = 0xffffffff - 31;
+    for (int i = 0; i < 5; i++) {
+        int len;
+        char *reply = make_reply(0, 'f', FALSE, &len);
+
+        RecordShmRingWrite(&ring, reply, len);
+        free(reply);
+    }
+    assert(ring.ring->head == (CARD32) (0xffffffff - 31 + RING_DATA));
+    assert(ring.ring->lost == 1);
+
+    RecordShmRingDetach(&ring);
+    destroy_segment(shmdesc);
+}
+
+static void
+test_swapped(void)
+{
+    ShmDescPtr shmdesc = create_segment();
+    RecordShmRingRec ring;
+    char buf[RING_DATA], *reply;
+    int len;
+
+    /* Reply lengths are in the recording client's byte order */
+    attach(&ring, shmdesc, TRUE);
+    reply = make_reply(3, 'w', TRUE, &len);
+    for (int i = 0; i < 10; i++) {
+        RecordShmRingWrite(&ring, reply, len);
+        assert(ring.ring->head == (i + 1) * len);
+        assert(consume(&ring, buf, sizeof(buf), TRUE) == len);
+        assert(memcmp(buf, reply, len) == 0);
+    }
+    assert(ring.ring->lost == 0);
+
+    RecordShmRingDetach(&ring);
+    destroy_segment(shmdesc);
+    free(reply);
+}
+
+static void
+test_segment_reference(void)
+{
+    ShmDescPtr shmdesc = create_segment();
+    RecordShmRingRec ring;
+    xRecordShmRing *header =
+        (xRecordShmRing *) (shmdesc->addr + RING_OFFSET);
+
+    released = 0;
+
+    /* Attaching resets the ring header and nothing before it */
+    attach(&ring, shmdesc, FALSE);
+    assert(shmdesc->refcnt == 2);
+    assert(ring.shmdesc == shmdesc);
+    assert(ring.ring == header);
+    assert(ring.data == (char *) (header + 1));
+    assert(ring.size == RING_DATA);
+    assert(header->head == 0 && header->tail == 0 && header->lost == 0);
+    assert((CARD8) shmdesc->addr[RING_OFFSET - 1] == 0xaa);
+
+    /* Detaching releases the segment once */
+    RecordShmRingDetach(&ring);
+    assert(released == 1);
+    assert(shmdesc->refcnt == 1);
+    assert(ring.shmdesc == NULL);
+    RecordShmRingDetach(&ring);
+    assert(released == 1);
+
+    /* and a ring that was never attached has nothing to release */
+    memset(&ring, 0, sizeof(ring));
+    RecordShmRingDetach(&ring);
+    assert(released == 1);
+
+    destroy_segment(shmdesc);
+}
+
+#endif /* MITSHM */
+
+const testfunc_t*
+record_shm_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+#ifdef MITSHM
+        test_wrap_around,
+        test_short_header,
+        test_full_ring,
+        test_count_wrap,
+        test_swapped,
+        test_segment_reference,
+#endif
+        NULL,
+    };
+    return testfuncs;
+}
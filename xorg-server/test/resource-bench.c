@@ -0,0 +1,116 @@
+/**
+ * Copyright © 2026 The X.Org Foundation
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including the next
+ *  paragraph) shall be included in all copies or substantial portions of the
+ *  Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Resource table microbenchmark: insert, look up and free 1k, 100k and
+ * 1M resources of one client and report operations per second.  The
+ * worst single AddResource is reported too, since that is where a full
+ * table rebuild used to stall dispatch.
+ */
+
+#include <dix-config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "dix/dix_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "resource.h"
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+nop_delete(void *value, XID id)
+{
+    return Success;
+}
+
+static void
+bench(RESTYPE type, int count)
+{
+    XID base = FakeClientID(0);
+    double start, t, worst = 0, insert, lookup, release;
+    void *value;
+    int i, rounds, r;
+
+    start = now();
+    for (i = 0; i < count; i++) {
+        t = now();
+        AddResource(base + i, type, (void *) (uintptr_t) i);
+        t = now() - t;
+        if (t > worst)
+            worst = t;
+    }
+    insert = now() - start;
+
+    /* look up in a scattered order, like a client touching many
+     * drawables, and enough times to get a stable number */
+    rounds = count < 1000000 ? 1000000 / count : 1;
+    start = now();
+    for (r = 0; r < rounds; r++)
+        for (i = 0; i < count; i++)
+            dixLookupResourceByType(&value, base + (i * 7919) % count, type,
+                                    NULL, 0);
+    lookup = now() - start;
+
+    start = now();
+    for (i = 0; i < count; i++)
+        FreeResource(base + i, X11_RESTYPE_NONE);
+    release = now() - start;
+
+    printf("%8d resources: insert %6.2f Mop/s (worst %7.1f us), "
+           "lookup %6.2f Mop/s, free %6.2f Mop/s\n",
+           count, count / insert / 1e6, worst * 1e6,
+           (double) count * rounds / lookup / 1e6, count / release / 1e6);
+}
+
+int
+main(int argc, char **argv)
+{
+    static ClientRec server_client;
+    RESTYPE type;
+
+    serverClient = &server_client;
+    InitClient(serverClient, 0, (void *) NULL);
+    if (!InitClientResources(serverClient))
+        FatalError("couldn't init server resources");
+    type = CreateNewResourceType(nop_delete, "BenchResource");
+
+    bench(type, 1000);
+    bench(type, 100000);
+    bench(type, 1000000);
+
+    FreeClientResources(serverClient);
+    return 0;
+}
@@ -0,0 +1,337 @@
+/**
+ * Copyright © 2026 The X.Org Foundation
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including the next
+ *  paragraph) shall be included in all copies or substantial portions of the
+ *  Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dix/dix_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "resource.h"
+#include "tests-common.h"
+
+#define NUM_RESOURCES 100000
+
+static RESTYPE type_a, type_b, type_c;
+
+static XID deleted[16];
+static int num_deleted;
+
+static int
+record_delete(void *value, XID id)
+{
+    if (num_deleted < (int) ARRAY_SIZE(deleted))
+        deleted[num_deleted] = (XID) (uintptr_t) value;
+    num_deleted++;
+    return Success;
+}
+
+static void
+resource_init(void)
+{
+    static ClientRec server_client;
+
+    if (serverClient == &server_client)
+        FreeClientResources(serverClient);
+    serverClient = &server_client;
+    InitClient(serverClient, 0, (void *) NULL);
+    if (!InitClientResources(serverClient))
+        FatalError("couldn't init server resources");
+
+    type_a = CreateNewResourceType(record_delete, "TestA");
+    type_b = CreateNewResourceType(record_delete, "TestB");
+    type_c = CreateNewResourceType(record_delete, "TestC");
+    assert(type_a && type_b && type_c);
+    num_deleted = 0;
+}
+
+static void *
+lookup(XID id, RESTYPE type)
+{
+    void *value;
+
+    if (dixLookupResourceByType(&value, id, type, NULL, 0) != Success)
+        return NULL;
+    return value;
+}
+
+/* Add enough resources to go through several incremental rebuilds,
+ * free every other one and check all lookups along the way. */
+static void
+resource_add_lookup_free(void)
+{
+    XID base;
+    int i;
+
+    resource_init();
+    base = FakeClientID(0);
+
+    for (i = 0; i < NUM_RESOURCES; i++) {
+        assert(AddResource(base + i, type_a, (void *) (uintptr_t) (i + 1)));
+        assert(lookup(base + i / 2, type_a) == (void *) (uintptr_t) (i / 2 + 1));
+    }
+
+    for (i = 0; i < NUM_RESOURCES; i++)
+        assert(lookup(base + i, type_a) == (void *) (uintptr_t) (i + 1));
+    assert(lookup(base + NUM_RESOURCES, type_a) == NULL);
+    assert(lookup(base, type_b) == NULL);
+
+    for (i = 0; i < NUM_RESOURCES; i += 2)
+        FreeResource(base + i, X11_RESTYPE_NONE);
+    assert(num_deleted == NUM_RESOURCES / 2);
+
+    for (i = 0; i < NUM_RESOURCES; i++)
+        assert(lookup(base + i, type_a) ==
+               ((i & 1) ? (void *) (uintptr_t) (i + 1) : NULL));
+
+    assert(ChangeResourceValue(base + 1, type_a, (void *) 7));
+    assert(lookup(base + 1, type_a) == (void *) 7);
+    assert(!ChangeResourceValue(base, type_a, (void *) 7));
+
+    FreeClientResources(serverClient);
+    assert(num_deleted == NUM_RESOURCES);
+}
+
+/* Resources sharing an ID are found and freed newest first, also when
+ * the table is rebuilt in between. */
+static void
+resource_shared_id(void)
+{
+    XID id, other;
+    void *value;
+    int i;
+
+    resource_init();
+    other = FakeClientID(0);
+    id = FakeClientID(0);
+
+    assert(AddResource(id, type_a, (void *) 1));
+    assert(AddResource(id, type_b, (void *) 2));
+    assert(AddResource(id, type_c, (void *) 3));
+
+    assert(dixLookupResourceByClass(&value, id, RC_ANY, NULL, 0) == Success);
+    assert(value == (void *) 3);
+
+    for (i = 0; i < NUM_RESOURCES; i++)
+        assert(AddResource(other + 2 + i, type_a, (void *) 0));
+
+    assert(lookup(id, type_a) == (void *) 1);
+    assert(lookup(id, type_b) == (void *) 2);
+
+    FreeResource(id, X11_RESTYPE_NONE);
+    assert(num_deleted == 3);
+    assert(deleted[0] == 3 && deleted[1] == 2 && deleted[2] == 1);
+    assert(lookup(id, type_a) == NULL);
+
+    num_deleted = 0;
+    assert(AddResource(id, type_a, (void *) 4));
+    assert(AddResource(id, type_a, (void *) 5));
+    assert(lookup(id, type_a) == (void *) 5);
+    FreeResourceByType(id, type_a, FALSE);
+    assert(num_deleted == 1 && deleted[0] == 5);
+    assert(lookup(id, type_a) == (void *) 4);
+}
+
+/* Empty most of a large table, then keep adding and freeing resources
+ * in it while checking the few old ones are still found. */
+static void
+resource_churn(void)
+{
+    XID base, churn;
+    int i, j;
+
+    resource_init();
+    base = FakeClientID(0);
+    churn = base + NUM_RESOURCES;
+
+    for (i = 0; i < NUM_RESOURCES; i++)
+        assert(AddResource(base + i, type_a, (void *) (uintptr_t) (i + 1)));
+    for (i = 0; i < NUM_RESOURCES; i++)
+        if (i % 10000)
+            FreeResource(base + i, X11_RESTYPE_NONE);
+
+    for (i = 0; i < 4 * NUM_RESOURCES; i++) {
+        assert(AddResource(churn + i, type_b, (void *) (uintptr_t) (i + 1)));
+        if (i >= 20)
+            FreeResource(churn + i - 20, X11_RESTYPE_NONE);
+        j = i % 10;
+        assert(lookup(base + j * 10000, type_a) ==
+               (void *) (uintptr_t) (j * 10000 + 1));
+        j = i - i % 20;
+        assert(lookup(churn + j, type_b) == (void *) (uintptr_t) (j + 1));
+    }
+
+    for (i = 0; i < NUM_RESOURCES; i++)
+        assert(lookup(base + i, type_a) ==
+               ((i % 10000) ? NULL : (void *) (uintptr_t) (i + 1)));
+    for (i = 0; i < 4 * NUM_RESOURCES; i++)
+        assert(lookup(churn + i, type_b) ==
+               ((i < 4 * NUM_RESOURCES - 20) ? NULL : (void *) (uintptr_t) (i + 1)));
+
+    num_deleted = 0;
+    FreeClientResources(serverClient);
+    assert(num_deleted == 10 + 20);
+}
+
+static XID grow_base;
+static int grown;
+
+static int
+grow_on_delete(void *value, XID id)
+{
+    int i;
+
+    for (i = 0; i < NUM_RESOURCES; i++)
+        assert(AddResource(grow_base + grown++, type_a, (void *) 0));
+    return Success;
+}
+
+/* FreeClientResources walks the table in place, which holds migration
+ * back, and a delete function adding resources meanwhile makes the table
+ * go through several rebuilds before the walk is over. */
+static void
+resource_add_while_freeing(void)
+{
+    RESTYPE type_grow;
+    XID base;
+    int i;
+
+    resource_init();
+    type_grow = CreateNewResourceType(grow_on_delete, "TestGrow");
+    assert(type_grow);
+    base = FakeClientID(0);
+    grow_base = base + 1000;
+    grown = 0;
+
+    /* just past a rebuild, so there is an old table to drain */
+    for (i = 0; i < 40; i++)
+        assert(AddResource(base + i, type_a, (void *) 0));
+    assert(AddResource(base + 40, type_grow, (void *) 0));
+
+    FreeClientResources(serverClient);
+    assert(grown == NUM_RESOURCES);
+    assert(num_deleted == 40 + NUM_RESOURCES);
+}
+
+static int visited;
+
+static void
+count_resource(void *value, XID id, void *cdata)
+{
+    visited++;
+}
+
+static void
+free_resource(void *value, XID id, void *cdata)
+{
+    visited++;
+    FreeResource(id, X11_RESTYPE_NONE);
+}
+
+static XID add_base;
+static int added;
+
+/* Add resources sharing IDs with existing ones, which moves those
+ * around, and enough new ones to have the table rebuilt. */
+static void
+add_resources(void *value, XID id, void *cdata)
+{
+    int i;
+
+    visited++;
+    assert(AddResource(id, type_b, (void *) 0));
+    for (i = 0; i < 100; i++)
+        assert(AddResource(add_base + added++, type_c, (void *) 0));
+}
+
+static Bool
+find_value(void *value, XID id, void *cdata)
+{
+    visited++;
+    return value == cdata;
+}
+
+static void
+resource_iterate(void)
+{
+    XID base;
+    int i;
+
+    resource_init();
+    base = FakeClientID(0);
+
+    for (i = 0; i < 1000; i++)
+        assert(AddResource(base + i, (i & 1) ? type_a : type_b, (void *) 0));
+
+    visited = 0;
+    FindClientResourcesByType(serverClient, type_a, count_resource, NULL);
+    assert(visited == 500);
+
+    visited = 0;
+    FindClientResourcesByType(serverClient, type_b, free_resource, NULL);
+    assert(visited == 500);
+    assert(num_deleted == 500);
+
+    visited = 0;
+    FindClientResourcesByType(serverClient, 0, count_resource, NULL);
+    assert(visited == 500);
+
+    /* each resource is visited once, even though the callback moves
+     * them around, and none of the ones it adds */
+    add_base = base + 100000;
+    added = 0;
+    visited = 0;
+    FindClientResourcesByType(serverClient, type_a, add_resources, NULL);
+    assert(visited == 500);
+    assert(added == 50000);
+
+    visited = 0;
+    FindClientResourcesByType(serverClient, type_b, count_resource, NULL);
+    assert(visited == 500);
+
+    visited = 0;
+    assert(LookupClientResourceComplex(serverClient, type_a, find_value,
+                                       (void *) 1) == NULL);
+    assert(visited == 500);
+}
+
+const testfunc_t*
+resource_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        resource_add_lookup_free,
+        resource_shared_id,
+        resource_churn,
+        resource_add_while_freeing,
+        resource_iterate,
+        NULL,
+    };
+    return testfuncs;
+}
@@ -12,8 +12,10 @@ main(int argc, char **argv)
 
 #ifdef XORG_TESTS
     run_test(fixes_test);
+    run_test(glyph_test);
     run_test(input_test);
     run_test(misc_test);
+    run_test(resource_test);
     run_test(signal_logging_test);
     run_test(touch_test);
     run_test(xfree86_test);
@@ -38,6 +40,9 @@ main(int argc, char **argv)
     run_test(protocol_xiwarppointer_test);
     run_test(protocol_eventconvert_test);
     run_test(xi2_test);
+
+    run_test(property_test);
+    run_test(record_shm_test);
 #endif
 
 #endif /* XORG_TESTS */
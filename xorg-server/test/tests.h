@@ -24,10 +24,14 @@ extern int verbose;
 typedef void (*testfunc_t)(void);
 
 const testfunc_t* fixes_test(void);
+const testfunc_t* glyph_test(void);
 const testfunc_t* hashtabletest_test(void);
 const testfunc_t* input_test(void);
 const testfunc_t* list_test(void);
 const testfunc_t* misc_test(void);
+const testfunc_t* property_test(void);
+const testfunc_t* record_shm_test(void);
+const testfunc_t* resource_test(void);
 const testfunc_t* signal_logging_test(void);
 const testfunc_t* string_test(void);
 const testfunc_t* touch_test(void);
@@ -31,6 +31,12 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <time.h>
+#ifndef WIN32
+#include <fcntl.h>
+#endif
 #include <X11/X.h>
 #include <X11/Xos.h>
 #include <X11/Xproto.h>
@@ -43,6 +49,7 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "xkb/xkbfile_priv.h"
 #include "xkb/xkbfmisc_priv.h"
 #include "xkb/xkbrules_priv.h"
+#include "xkb/xkbsrv_priv.h"
 
 #include "inputstr.h"
 #include "scrnintstr.h"
@@ -61,7 +68,13 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #endif
 
 static unsigned
-LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn);
+ReadXKM(unsigned want, unsigned need, FILE *file, const char *keymap,
+        XkbDescPtr *xkbRtrn);
+
+static unsigned
+XkbDDXLoadCachedKeymap(const char *source, size_t len,
+                       unsigned want, unsigned need, XkbDescPtr *xkbRtrn,
+                       Bool *compiledRtrn, char *nameRtrn, int nameRtrnLen);
 
 static void
 OutputDirectory(char *outdir, size_t size)
@@ -105,13 +118,21 @@ typedef void (*xkbcomp_buffer_callback)(FILE *out, void *userdata);
 
 /**
  * Start xkbcomp, let the callback write into xkbcomp's stdin. When done,
- * return a strdup'd copy of the file name we've written to.
+ * return the compiled keymap, positioned at its start.
+ *
+ * xkbcomp writes the keymap to an unnamed temporary file it inherits,
+ * so nothing is left behind in the output directory and no other server
+ * can get at it.  The shell execs xkbcomp rather than forking it.
+ *
+ * This is still one process start per compile.  Building xkbcomp into
+ * the server would avoid that, but it is written against Xlib's XKB
+ * types and libxkbfile, and exits on fatal errors.
  */
-static char *
+static FILE *
 RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 {
-    FILE *out;
-    char *buf = NULL, keymap[PATH_MAX], xkm_output_dir[PATH_MAX];
+    FILE *out, *xkm;
+    char *buf = NULL, keymap[PATH_MAX], output[PATH_MAX + 16];
 
     const char *emptystring = "";
     char *xkbbasedirflag = NULL;
@@ -121,20 +142,33 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 #ifdef WIN32
     /* WIN32 has no popen. The input must be stored in a file which is
        used as input for xkbcomp. xkbcomp does not read from stdin. */
-    char tmpname[PATH_MAX];
+    char tmpname[PATH_MAX], xkm_output_dir[PATH_MAX], xkmpath[PATH_MAX];
     const char *xkmfile = tmpname;
+    const char *prefix = "\"", *suffix = "\"";
 #else
     const char *xkmfile = "-";
+    const char *prefix = "exec ", *suffix = "";
 #endif
 
     snprintf(keymap, sizeof(keymap), "server-%s", display);
 
+#ifdef WIN32
     OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
+    snprintf(xkmpath, sizeof(xkmpath), "%s%s.xkm", xkm_output_dir, keymap);
+    snprintf(output, sizeof(output), "\"%s\"", xkmpath);
 
-#ifdef WIN32
     strcpy(tmpname, Win32TempDir());
     strcat(tmpname, "\\xkb_XXXXXX");
     (void) mktemp(tmpname);
+#else
+    xkm = tmpfile();
+    if (!xkm || fcntl(fileno(xkm), F_SETFD, 0) == -1) {
+        LogMessage(X_ERROR, "XKB: Could not create keymap output file\n");
+        if (xkm)
+            fclose(xkm);
+        return NULL;
+    }
+    snprintf(output, sizeof(output), "\"/dev/fd/%d\"", fileno(xkm));
 #endif
 
     if (XkbBaseDirectory != NULL) {
@@ -154,14 +188,14 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     }
 
     if (asprintf(&buf,
-                 "\"\"%s%sxkbcomp\" -w %d %s -xkm \"%s\" "
-                 "-em1 %s -emp %s -eml %s \"%s%s.xkm\"\"",
-                 xkbbindir, xkbbindirsep,
+                 "%s\"%s%sxkbcomp\" -w %d %s -xkm \"%s\" "
+                 "-em1 %s -emp %s -eml %s %s%s",
+                 prefix, xkbbindir, xkbbindirsep,
                  ((xkbDebugFlags < 2) ? 1 :
                   ((xkbDebugFlags > 10) ? 10 : (int) xkbDebugFlags)),
                  xkbbasedirflag ? xkbbasedirflag : "", xkmfile,
                  PRE_ERROR_MSG, ERROR_PREFIX, POST_ERROR_MSG1,
-                 xkm_output_dir, keymap) == -1)
+                 output, suffix) == -1)
         buf = NULL;
 
     free(xkbbasedirflag);
@@ -169,6 +203,9 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     if (!buf) {
         LogMessage(X_ERROR,
                    "XKB: Could not invoke xkbcomp: not enough memory\n");
+#ifndef WIN32
+        fclose(xkm);
+#endif
         return NULL;
     }
 
@@ -193,8 +230,15 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
             free(buf);
 #ifdef WIN32
             unlink(tmpname);
+            /* Deleted once closed */
+            xkm = fopen(xkmpath, "rbD");
+            if (!xkm)
+                LogMessage(X_ERROR, "Couldn't open compiled keymap file %s\n",
+                           xkmpath);
+#else
+            rewind(xkm);
 #endif
-            return XNFstrdup(keymap);
+            return xkm;
         }
         else {
             LogMessage(X_ERROR, "Error compiling keymap (%s) executing '%s'\n",
@@ -213,6 +257,9 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 #endif
     }
     free(buf);
+#ifndef WIN32
+    fclose(xkm);
+#endif
     return NULL;
 }
 
@@ -236,14 +283,13 @@ xkb_write_keymap_for_names_cb(FILE *out, void *userdata)
     XkbWriteXKBKeymapForNames(out, ctx->names, ctx->xkb, ctx->want, ctx->need);
 }
 
-static Bool
+static FILE *
 XkbDDXCompileKeymapByNames(XkbDescPtr xkb,
                            XkbComponentNamesPtr names,
                            unsigned want,
                            unsigned need, char *nameRtrn, int nameRtrnLen)
 {
-    char *keymap;
-    Bool rc = FALSE;
+    FILE *file;
     XkbKeymapNamesCtx ctx = {
         .xkb = xkb,
         .names = names,
@@ -251,18 +297,16 @@ XkbDDXCompileKeymapByNames(XkbDescPtr xkb,
         .need = need
     };
 
-    keymap = RunXkbComp(xkb_write_keymap_for_names_cb, &ctx);
+    file = RunXkbComp(xkb_write_keymap_for_names_cb, &ctx);
 
-    if (keymap) {
-        if(nameRtrn)
-            strlcpy(nameRtrn, keymap, nameRtrnLen);
-
-        free(keymap);
-        rc = TRUE;
-    } else if (nameRtrn)
-        *nameRtrn = '\0';
+    if (nameRtrn) {
+        if (file)
+            snprintf(nameRtrn, nameRtrnLen, "server-%s", display);
+        else
+            *nameRtrn = '\0';
+    }
 
-    return rc;
+    return file;
 }
 
 typedef struct {
@@ -284,8 +328,9 @@ XkbDDXLoadKeymapFromString(DeviceIntPtr keybd,
                           unsigned int need,
                           XkbDescPtr *xkbRtrn)
 {
+    FILE *file;
     unsigned int have;
-    char *map_name;
+    Bool compiled;
     XkbKeymapString map = {
         .keymap = keymap,
         .len = keymap_length
@@ -293,81 +338,377 @@ XkbDDXLoadKeymapFromString(DeviceIntPtr keybd,
 
     *xkbRtrn = NULL;
 
-    map_name = RunXkbComp(xkb_write_keymap_string_cb, &map);
-    if (!map_name) {
+    have = XkbDDXLoadCachedKeymap(keymap, keymap_length, want, need, xkbRtrn,
+                                  &compiled, NULL, 0);
+    if (*xkbRtrn || compiled)
+        return have;
+
+    file = RunXkbComp(xkb_write_keymap_string_cb, &map);
+    if (!file) {
         LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
         return 0;
     }
 
-    have = LoadXKM(want, need, map_name, xkbRtrn);
-    free(map_name);
+    return ReadXKM(want, need, file, "from string", xkbRtrn);
+}
 
-    return have;
+/* Read and close a keymap compiled by RunXkbComp */
+static unsigned
+ReadXKM(unsigned want, unsigned need, FILE *file, const char *keymap,
+        XkbDescPtr *xkbRtrn)
+{
+    unsigned missing;
+
+    missing = XkmReadFile(file, need, want, xkbRtrn);
+    fclose(file);
+    if (*xkbRtrn == NULL) {
+        LogMessage(X_ERROR, "Error loading keymap %s\n", keymap);
+        return 0;
+    }
+    DebugF("Loaded XKB keymap %s, defined=0x%x\n", keymap,
+           (*xkbRtrn)->defined);
+    return (need | want) & (~missing);
 }
 
-static FILE *
-XkbDDXOpenConfigFile(const char *mapName, char *fileNameRtrn, int fileNameRtrnLen)
+/*
+ * Compiled keymaps are kept in the output directory under a name made
+ * from a hash of the keymap source handed to xkbcomp, the path, size
+ * and modification time of every file in the keyboard data directories,
+ * and those of the compiler.  A later start, or a switch back to a
+ * layout used before, reads the compiled keymap straight from there
+ * instead of running xkbcomp again.  Installing or changing any layout
+ * file changes the name, so stale entries are never looked up again;
+ * PruneCachedXKM removes them eventually.  -noxkbcache turns this off.
+ */
+static const char *xkbCacheDirs[] = {
+    "rules", "keycodes", "types", "compat", "symbols", "geometry",
+};
+
+#define XKB_CACHE_HASH_INIT 0xcbf29ce484222325ULL
+
+/* Deepest directory level under the data directories that is looked at */
+#define XKB_CACHE_MAX_DEPTH 8
+
+static uint64_t
+XkbCacheHash(uint64_t h, const void *data, size_t len)
 {
-    char buf[PATH_MAX], xkm_output_dir[PATH_MAX];
-    FILE *file;
+    const unsigned char *p = data;
 
-    buf[0] = '\0';
-    if (mapName != NULL) {
-        OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
-        if ((XkbBaseDirectory != NULL) && (xkm_output_dir[0] != '/')
-#ifdef WIN32
-            && (!isalpha(xkm_output_dir[0]) || xkm_output_dir[1] != ':')
+    while (len--)
+        h = (h ^ *p++) * 0x100000001b3ULL;
+    return h;
+}
+
+static uint64_t
+XkbCacheHashFile(uint64_t h, const char *path, struct stat *st)
+{
+    int64_t mtime = st->st_mtime, size = st->st_size;
+
+    h = XkbCacheHash(h, path, strlen(path) + 1);
+    h = XkbCacheHash(h, &mtime, sizeof(mtime));
+    return XkbCacheHash(h, &size, sizeof(size));
+}
+
+/*
+ * Sum of the hashes of all files under path, which does not depend on
+ * the order readdir returns them in.  Symlinks to files are followed,
+ * symlinks to directories are not, so a loop cannot make this recurse.
+ */
+static uint64_t
+XkbCacheHashTree(const char *path, int depth)
+{
+    char sub[PATH_MAX];
+    struct dirent *ent;
+    struct stat st;
+    uint64_t sum = 0;
+    DIR *d;
+
+    if (depth > XKB_CACHE_MAX_DEPTH || !(d = opendir(path)))
+        return 0;
+    while ((ent = readdir(d))) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0 ||
+            snprintf(sub, sizeof(sub), "%s/%s", path, ent->d_name) >=
+            sizeof(sub))
+            continue;
+#ifndef WIN32
+        if (lstat(sub, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            sum += XkbCacheHashTree(sub, depth + 1);
+        else if (!S_ISLNK(st.st_mode) || stat(sub, &st) == 0)
+            sum += XkbCacheHashFile(XKB_CACHE_HASH_INIT, sub, &st);
+#else
+        if (stat(sub, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            sum += XkbCacheHashTree(sub, depth + 1);
+        else
+            sum += XkbCacheHashFile(XKB_CACHE_HASH_INIT, sub, &st);
 #endif
-            ) {
-            if (snprintf(buf, PATH_MAX, "%s/%s%s.xkm", XkbBaseDirectory,
-                         xkm_output_dir, mapName) >= PATH_MAX)
-                buf[0] = '\0';
-        }
-        else {
-            if (snprintf(buf, PATH_MAX, "%s%s.xkm", xkm_output_dir, mapName)
-                >= PATH_MAX)
-                buf[0] = '\0';
+    }
+    closedir(d);
+    return sum;
+}
+
+static void
+XkbKeymapCacheName(const char *source, size_t len, char *name, size_t size)
+{
+    char path[PATH_MAX];
+    struct stat st;
+    uint64_t h = XKB_CACHE_HASH_INIT, tree;
+    int i;
+
+    h = XkbCacheHash(h, source, len);
+    if (XkbBaseDirectory) {
+        for (i = 0; i < ARRAY_SIZE(xkbCacheDirs); i++) {
+            snprintf(path, sizeof(path), "%s/%s", XkbBaseDirectory,
+                     xkbCacheDirs[i]);
+            tree = XkbCacheHashTree(path, 0);
+            h = XkbCacheHash(h, path, strlen(path) + 1);
+            h = XkbCacheHash(h, &tree, sizeof(tree));
         }
-        if (buf[0] != '\0')
-            file = fopen(buf, "rb");
-        else
-            file = NULL;
     }
-    else
-        file = NULL;
-    if ((fileNameRtrn != NULL) && (fileNameRtrnLen > 0)) {
-        strlcpy(fileNameRtrn, buf, fileNameRtrnLen);
+    snprintf(path, sizeof(path), "%s%sxkbcomp",
+             XkbBinDirectory ? XkbBinDirectory : "",
+             XkbBinDirectory ? PATHSEPARATOR : "");
+    if (stat(path, &st) == 0)
+        h = XkbCacheHashFile(h, path, &st);
+
+    snprintf(name, size, "cache-%016llx", (unsigned long long) h);
+}
+
+/*
+ * Anyone who can write to the cache directory can plant keymaps for the
+ * server to load, so it has to be a real directory, owned by the user
+ * the server runs as and not writable by anyone else.  The /tmp fallback
+ * of OutputDirectory never qualifies, and neither does a symlink.
+ * Returns the directory with a trailing separator, or FALSE.
+ */
+static Bool
+XkbCacheDirectory(char *dir, size_t size)
+{
+#ifndef WIN32
+    struct stat st;
+    size_t len;
+    int rc;
+#endif
+
+    OutputDirectory(dir, size);
+#ifndef WIN32
+    len = strlen(dir);
+    if (dir[0] != '/' || len < 2)
+        return FALSE;
+    dir[len - 1] = '\0';
+    rc = lstat(dir, &st);
+    dir[len - 1] = '/';
+    if (rc != 0 || !S_ISDIR(st.st_mode) || st.st_uid != geteuid() ||
+        (st.st_mode & (S_IWGRP | S_IWOTH)))
+        return FALSE;
+#endif
+    return TRUE;
+}
+
+static Bool
+XkbCachePath(const char *dir, const char *name, char *path, size_t size)
+{
+    return snprintf(path, size, "%s%s.xkm", dir, name) < size;
+}
+
+/* Cache entries not written for this long are removed */
+#define XKB_CACHE_MAX_AGE (30 * 24 * 60 * 60)
+
+/*
+ * Remove cache entries, and temporary files left behind by a server
+ * that died while storing one, that have not been written for a while.
+ * Those of earlier keyboard data or compilers are never looked up again.
+ */
+static void
+PruneCachedXKM(const char *dir)
+{
+    char path[PATH_MAX];
+    struct dirent *ent;
+    struct stat st;
+    time_t now = time(NULL);
+    DIR *d;
+
+    d = opendir(dir);
+    if (!d)
+        return;
+    while ((ent = readdir(d))) {
+        if (strncmp(ent->d_name, "cache-", 6) != 0 ||
+            snprintf(path, sizeof(path), "%s%s", dir, ent->d_name) >=
+            sizeof(path))
+            continue;
+#ifndef WIN32
+        if (lstat(path, &st) == 0 && S_ISREG(st.st_mode) &&
+#else
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode) &&
+#endif
+            now - st.st_mtime > XKB_CACHE_MAX_AGE)
+            (void) unlink(path);
     }
-    return file;
+    closedir(d);
 }
 
 static unsigned
-LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn)
+LoadCachedXKM(unsigned want, unsigned need, const char *dir,
+              const char *name, XkbDescPtr *xkbRtrn)
 {
     FILE *file;
     char fileName[PATH_MAX];
     unsigned missing;
+#ifndef WIN32
+    struct stat st;
+    int fd;
+#endif
 
-    file = XkbDDXOpenConfigFile(keymap, fileName, PATH_MAX);
-    if (file == NULL) {
-        LogMessage(X_ERROR, "Couldn't open compiled keymap file %s\n",
-                   fileName);
+    if (!XkbCachePath(dir, name, fileName, sizeof(fileName)))
+        return 0;
+#ifndef WIN32
+    fd = open(fileName, O_RDONLY | O_NOFOLLOW);
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_uid != geteuid() || !(file = fdopen(fd, "rb"))) {
+        close(fd);
         return 0;
     }
+#else
+    file = fopen(fileName, "rb");
+    if (file == NULL)
+        return 0;
+#endif
     missing = XkmReadFile(file, need, want, xkbRtrn);
+    fclose(file);
     if (*xkbRtrn == NULL) {
-        LogMessage(X_ERROR, "Error loading keymap %s\n", fileName);
-        fclose(file);
         (void) unlink(fileName);
         return 0;
     }
-    else {
-        DebugF("Loaded XKB keymap %s, defined=0x%x\n", fileName,
-               (*xkbRtrn)->defined);
+    DebugF("Loaded cached XKB keymap %s, defined=0x%x\n", fileName,
+           (*xkbRtrn)->defined);
+    return (need | want) & (~missing);
+}
+
+/*
+ * Copy a freshly compiled keymap into the cache.  It is written to a new
+ * file private to this server and then renamed into place, which is
+ * atomic, so servers sharing the directory never see a partial entry.
+ */
+static void
+StoreCachedXKM(FILE *file, const char *dir, const char *name)
+{
+    char path[PATH_MAX], tmp[PATH_MAX], buf[4096];
+    FILE *cache;
+    size_t n;
+    Bool ok = TRUE;
+#ifndef WIN32
+    int fd;
+#endif
+
+    PruneCachedXKM(dir);
+
+    if (!XkbCachePath(dir, name, path, sizeof(path)))
+        return;
+#ifndef WIN32
+    if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= sizeof(tmp))
+        return;
+    fd = mkstemp(tmp);
+    if (fd < 0)
+        return;
+    cache = fdopen(fd, "wb");
+    if (!cache) {
+        close(fd);
+        (void) unlink(tmp);
+        return;
+    }
+#else
+    if (snprintf(tmp, sizeof(tmp), "%s-%s", path, display) >= sizeof(tmp))
+        return;
+    cache = fopen(tmp, "wbx");
+    if (!cache)
+        return;
+#endif
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+        if (fwrite(buf, 1, n, cache) != n)
+            ok = FALSE;
+    if (ferror(file))
+        ok = FALSE;
+    if (fclose(cache) != 0)
+        ok = FALSE;
+    if (!ok || rename(tmp, path) != 0)
+        (void) unlink(tmp);
+    rewind(file);
+}
+
+/*
+ * Load the keymap for the given source from the cache, compiling it and
+ * adding it to the cache if it is not there yet.  *compiledRtrn tells
+ * whether xkbcomp was run; if it was and failed, running it again would
+ * fail the same way.  If the cache is off or unusable, *xkbRtrn is left
+ * NULL and *compiledRtrn FALSE, for the caller to compile the keymap on
+ * its own.
+ */
+static unsigned
+XkbDDXLoadCachedKeymap(const char *source, size_t len,
+                       unsigned want, unsigned need, XkbDescPtr *xkbRtrn,
+                       Bool *compiledRtrn, char *nameRtrn, int nameRtrnLen)
+{
+    char name[32], dir[PATH_MAX];
+    XkbKeymapString map = {
+        .keymap = source,
+        .len = len
+    };
+    unsigned have;
+    FILE *file;
+
+    *xkbRtrn = NULL;
+    *compiledRtrn = FALSE;
+    if (!XkbKeymapCacheEnabled || !XkbCacheDirectory(dir, sizeof(dir)))
+        return 0;
+    XkbKeymapCacheName(source, len, name, sizeof(name));
+
+    have = LoadCachedXKM(want, need, dir, name, xkbRtrn);
+    if (!*xkbRtrn) {
+        *compiledRtrn = TRUE;
+        file = RunXkbComp(xkb_write_keymap_string_cb, &map);
+        if (!file) {
+            LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
+            return 0;
+        }
+        StoreCachedXKM(file, dir, name);
+        have = ReadXKM(want, need, file, name, xkbRtrn);
+        if (!*xkbRtrn)
+            return 0;
+    }
+
+    if (nameRtrn)
+        strlcpy(nameRtrn, name, nameRtrnLen);
+    return have;
+}
+
+/* The source xkbcomp would be given for the names, or NULL */
+static char *
+XkbKeymapSourceForNames(XkbDescPtr xkb, XkbComponentNamesPtr names,
+                        unsigned want, unsigned need, size_t *lenRtrn)
+{
+    FILE *file = tmpfile();
+    char *source = NULL;
+    long len;
+
+    if (!file)
+        return NULL;
+    if (XkbWriteXKBKeymapForNames(file, names, xkb, want, need) &&
+        fflush(file) == 0 && (len = ftell(file)) > 0 &&
+        fseek(file, 0, SEEK_SET) == 0 && (source = malloc(len))) {
+        if (fread(source, 1, len, file) == len)
+            *lenRtrn = len;
+        else {
+            free(source);
+            source = NULL;
+        }
     }
     fclose(file);
-    (void) unlink(fileName);
-    return (need | want) & (~missing);
+    return source;
 }
 
 unsigned
@@ -378,6 +719,11 @@ XkbDDXLoadKeymapByNames(DeviceIntPtr keybd,
                         XkbDescPtr *xkbRtrn, char *nameRtrn, int nameRtrnLen)
 {
     XkbDescPtr xkb;
+    unsigned have;
+    char *source;
+    size_t len;
+    FILE *file;
+    Bool compiled = FALSE;
 
     *xkbRtrn = NULL;
     if ((keybd == NULL) || (keybd->key == NULL) ||
@@ -392,13 +738,24 @@ XkbDDXLoadKeymapByNames(DeviceIntPtr keybd,
                    keybd->name ? keybd->name : "(unnamed keyboard)");
         return 0;
     }
-    else if (!XkbDDXCompileKeymapByNames(xkb, names, want, need,
-                                         nameRtrn, nameRtrnLen)) {
+
+    source = XkbKeymapSourceForNames(xkb, names, want, need, &len);
+    if (source) {
+        have = XkbDDXLoadCachedKeymap(source, len, want, need, xkbRtrn,
+                                      &compiled, nameRtrn, nameRtrnLen);
+        free(source);
+        if (*xkbRtrn || compiled)
+            return have;
+    }
+
+    file = XkbDDXCompileKeymapByNames(xkb, names, want, need,
+                                      nameRtrn, nameRtrnLen);
+    if (!file) {
         LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
         return 0;
     }
 
-    return LoadXKM(want, need, nameRtrn, xkbRtrn);
+    return ReadXKM(want, need, file, "for names", xkbRtrn);
 }
 
 Bool
@@ -84,6 +84,7 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 const char *XkbBaseDirectory = XKB_BASE_DIRECTORY;
 const char *XkbBinDirectory = XKB_BIN_DIRECTORY;
 static int XkbWantAccessX = 0;
+Bool XkbKeymapCacheEnabled = TRUE;
 
 static char *XkbRulesDflt = NULL;
 static char *XkbModelDflt = NULL;
@@ -762,6 +763,10 @@ XkbProcessArguments(int argc, char *argv[], int i)
             return -1;
         }
     }
+    else if (strcmp(argv[i], "-noxkbcache") == 0) {
+        XkbKeymapCacheEnabled = FALSE;
+        return 1;
+    }
     else if ((strncmp(argv[i], "-accessx", 8) == 0) ||
              (strncmp(argv[i], "+accessx", 8) == 0)) {
         int j = 1;
@@ -826,6 +831,7 @@ XkbUseMsg(void)
     ErrorF
         ("[+-]accessx [ timeout [ timeout_mask [ feedback [ options_mask] ] ] ]\n");
     ErrorF("                       enable/disable accessx key sequences\n");
+    ErrorF("-noxkbcache            always run xkbcomp for keymaps\n");
 #ifndef _MSC_VER
     ErrorF("-ardelay               set XKB autorepeat delay\n");
     ErrorF("-arinterval            set XKB autorepeat interval\n");
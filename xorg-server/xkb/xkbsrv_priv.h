@@ -24,4 +24,7 @@ void XkbMergeLockedPtrBtns(DeviceIntPtr master);
 
 void XkbFakeDeviceButton(DeviceIntPtr dev, int press, int button);
 
+/* Whether compiled keymaps are kept in the output directory, -noxkbcache */
+extern Bool XkbKeymapCacheEnabled;
+
 #endif /* _XSERVER_XKBSRV_PRIV_H_ */